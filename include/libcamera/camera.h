@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <array>
 #include <initializer_list>
 #include <memory>
 #include <optional>
@@ -111,6 +112,20 @@ protected:
 	std::vector<StreamConfiguration> config_;
 };
 
+struct RequestQueueStatistics {
+	static constexpr unsigned int kHistogramSize = 16;
+	using Histogram = std::array<uint64_t, kHistogramSize>;
+
+	uint64_t queuedRequests = 0;
+	uint64_t underruns = 0;
+	uint64_t droppedFrames = 0;
+	unsigned int queueDepth = 0;
+
+	Histogram depthHistogram = {};
+	Histogram prepareTimeHistogram = {};
+	Histogram waitTimeHistogram = {};
+};
+
 class Camera final : public Object, public std::enable_shared_from_this<Camera>,
 		     public Extensible
 {
@@ -124,6 +139,7 @@ public:
 	const std::string &id() const;
 
 	Signal<Request *, FrameBuffer *> bufferCompleted;
+	Signal<Request *, const ControlList &> metadataAvailable;
 	Signal<Request *> requestCompleted;
 	Signal<> disconnected;
 
@@ -132,6 +148,7 @@ public:
 
 	const ControlInfoMap &controls() const;
 	const ControlList &properties() const;
+	RequestQueueStatistics requestQueueStatistics() const;
 
 	const std::set<Stream *> &streams() const;
 
@@ -148,6 +165,7 @@ public:
 
 	std::unique_ptr<Request> createRequest(uint64_t cookie = 0);
 	int queueRequest(Request *request);
+	int queueRequests(Span<Request *const> requests);
 
 	int start(const ControlList *controls = nullptr);
 	int stop();
@@ -167,6 +185,7 @@ private:
 	int exportFrameBuffers(Stream *stream,
 			       std::vector<std::unique_ptr<FrameBuffer>> *buffers);
 
+	int validateRequest(Request *request);
 	void patchControlList(ControlList &controls);
 };
 
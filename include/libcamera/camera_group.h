@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Synchronised capture from multiple cameras
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+#include <libcamera/base/class.h>
+#include <libcamera/base/signal.h>
+#include <libcamera/base/span.h>
+
+namespace libcamera {
+
+class Camera;
+class ControlList;
+class Request;
+
+class CameraGroup : public Extensible
+{
+	LIBCAMERA_DECLARE_PRIVATE()
+
+public:
+	enum class DropPolicy {
+		DropUnmatched,
+		DeliverPartial,
+	};
+
+	struct Statistics {
+		uint64_t completeSets = 0;
+		uint64_t partialSets = 0;
+		uint64_t droppedRequests = 0;
+
+		std::chrono::nanoseconds meanSkew{ 0 };
+		std::chrono::nanoseconds maxSkew{ 0 };
+		std::chrono::nanoseconds meanLatency{ 0 };
+		std::chrono::nanoseconds maxLatency{ 0 };
+	};
+
+	CameraGroup(Span<const std::shared_ptr<Camera>> cameras);
+	~CameraGroup();
+
+	const std::vector<std::shared_ptr<Camera>> &cameras() const;
+
+	void setTolerance(std::chrono::nanoseconds tolerance);
+	std::chrono::nanoseconds tolerance() const;
+
+	void setDropPolicy(DropPolicy policy);
+	DropPolicy dropPolicy() const;
+
+	int start(const ControlList *controls = nullptr);
+	int stop();
+
+	Statistics statistics() const;
+
+	Signal<Span<Request *const>> requestSetCompleted;
+	Signal<Request *> requestDropped;
+
+private:
+	LIBCAMERA_DISABLE_COPY(CameraGroup)
+};
+
+} /* namespace libcamera */
@@ -8,12 +8,15 @@
 #pragma once
 
 #include <assert.h>
+#include <iterator>
 #include <map>
 #include <optional>
 #include <stdint.h>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <libcamera/base/class.h>
@@ -164,6 +167,8 @@ public:
 
 	ControlValue(const ControlValue &other);
 	ControlValue &operator=(const ControlValue &other);
+	ControlValue(ControlValue &&other) noexcept;
+	ControlValue &operator=(ControlValue &&other) noexcept;
 
 	ControlType type() const { return type_; }
 	bool isNone() const { return type_ == ControlTypeNone; }
@@ -408,7 +413,87 @@ private:
 class ControlList
 {
 private:
-	using ControlListMap = std::unordered_map<unsigned int, ControlValue>;
+	struct Entry {
+		Entry()
+			: control(0, ControlValue{})
+		{
+		}
+
+		Entry(unsigned int id, ControlValue &&val)
+			: control(id, std::move(val))
+		{
+		}
+
+		Entry(const Entry &other) = default;
+		Entry(Entry &&other) noexcept = default;
+
+		Entry &operator=(const Entry &other);
+		Entry &operator=(Entry &&other) noexcept;
+
+		std::pair<const unsigned int, ControlValue> control;
+	};
+
+	using ControlListMap = std::vector<Entry>;
+
+	template<typename Iter, typename Value>
+	class Iterator
+	{
+	public:
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = std::pair<const unsigned int, ControlValue>;
+		using difference_type = std::ptrdiff_t;
+		using pointer = Value *;
+		using reference = Value &;
+
+		Iterator() = default;
+		explicit Iterator(Iter iter)
+			: iter_(iter)
+		{
+		}
+
+		template<typename OtherIter, typename OtherValue,
+			 std::enable_if_t<std::is_convertible_v<OtherIter, Iter>> * = nullptr>
+		Iterator(const Iterator<OtherIter, OtherValue> &other)
+			: iter_(other.base())
+		{
+		}
+
+		reference operator*() const { return iter_->control; }
+		pointer operator->() const { return &iter_->control; }
+
+		Iterator &operator++()
+		{
+			++iter_;
+			return *this;
+		}
+
+		Iterator operator++(int)
+		{
+			Iterator it = *this;
+			++iter_;
+			return it;
+		}
+
+		Iterator &operator--()
+		{
+			--iter_;
+			return *this;
+		}
+
+		Iterator operator--(int)
+		{
+			Iterator it = *this;
+			--iter_;
+			return it;
+		}
+
+		bool operator==(const Iterator &other) const { return iter_ == other.iter_; }
+
+		Iter base() const { return iter_; }
+
+	private:
+		Iter iter_;
+	};
 
 public:
 	enum class MergePolicy {
@@ -420,18 +505,21 @@ public:
 	ControlList(const ControlIdMap &idmap, const ControlValidator *validator = nullptr);
 	ControlList(const ControlInfoMap &infoMap, const ControlValidator *validator = nullptr);
 
-	using iterator = ControlListMap::iterator;
-	using const_iterator = ControlListMap::const_iterator;
+	using iterator = Iterator<ControlListMap::iterator,
+				  std::pair<const unsigned int, ControlValue>>;
+	using const_iterator = Iterator<ControlListMap::const_iterator,
+					const std::pair<const unsigned int, ControlValue>>;
 
-	iterator begin() { return controls_.begin(); }
-	iterator end() { return controls_.end(); }
-	const_iterator begin() const { return controls_.begin(); }
-	const_iterator end() const { return controls_.end(); }
+	iterator begin() { return iterator(controls_.begin()); }
+	iterator end() { return iterator(controls_.end()); }
+	const_iterator begin() const { return const_iterator(controls_.begin()); }
+	const_iterator end() const { return const_iterator(controls_.end()); }
 
 	bool empty() const { return controls_.empty(); }
 	std::size_t size() const { return controls_.size(); }
 
 	void clear() { controls_.clear(); }
+	void reserve(std::size_t size) { controls_.reserve(size); }
 	void merge(const ControlList &source, MergePolicy policy = MergePolicy::KeepExisting);
 
 	bool contains(unsigned int id) const;
@@ -439,12 +527,11 @@ public:
 	template<typename T>
 	std::optional<T> get(const Control<T> &ctrl) const
 	{
-		const auto entry = controls_.find(ctrl.id());
-		if (entry == controls_.end())
+		const ControlValue *val = lookup(ctrl.id());
+		if (!val)
 			return std::nullopt;
 
-		const ControlValue &val = entry->second;
-		return val.get<T>();
+		return val->get<T>();
 	}
 
 	template<typename T, typename V>
@@ -474,6 +561,7 @@ public:
 	const ControlIdMap *idMap() const { return idmap_; }
 
 private:
+	const ControlValue *lookup(unsigned int id) const;
 	const ControlValue *find(unsigned int id) const;
 	ControlValue *find(unsigned int id);
 
@@ -10,12 +10,14 @@
 #include <atomic>
 #include <list>
 #include <memory>
+#include <optional>
 #include <queue>
 #include <set>
 #include <stdint.h>
 #include <string>
 
 #include <libcamera/base/class.h>
+#include <libcamera/base/mutex.h>
 
 #include <libcamera/camera.h>
 
@@ -45,6 +47,12 @@ public:
 
 	const CameraControlValidator *validator() const { return validator_.get(); }
 
+	mutable Mutex queueStatsMutex_;
+	RequestQueueStatistics queueStats_ LIBCAMERA_TSA_GUARDED_BY(queueStatsMutex_);
+	unsigned int queueDepth_;
+	unsigned int queueStableCount_;
+	std::optional<uint32_t> lastSequence_;
+
 private:
 	enum State {
 		CameraAvailable,
@@ -0,0 +1,83 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Camera group private data
+ */
+
+#pragma once
+
+#include <libcamera/camera_group.h>
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+#include <libcamera/base/class.h>
+#include <libcamera/base/mutex.h>
+#include <libcamera/base/thread_annotations.h>
+
+#include "libcamera/internal/clock_recovery.h"
+
+namespace libcamera {
+
+class Camera;
+class Request;
+
+class CameraGroup::Private : public Extensible::Private
+{
+	LIBCAMERA_DECLARE_PUBLIC(CameraGroup)
+
+public:
+	Private();
+
+	void requestCompleted(unsigned int index, Request *request);
+
+private:
+	friend class CameraGroup;
+
+	static constexpr std::chrono::nanoseconds kDefaultTolerance = std::chrono::milliseconds(2);
+	static constexpr unsigned int kMaxPendingRequests = 4;
+	static constexpr unsigned int kMinClockSamples = 10;
+
+	struct PendingRequest {
+		Request *request;
+		int64_t timestamp;
+		int64_t completionTime;
+	};
+
+	struct CameraState {
+		std::shared_ptr<Camera> camera;
+		std::deque<PendingRequest> pending;
+		ClockRecovery clock;
+		unsigned int clockSamples;
+	};
+
+	struct Delivery {
+		std::vector<Request *> requests;
+		bool complete;
+		bool cancelled;
+	};
+
+	void matchRequests(int64_t now, bool flush, std::vector<Delivery> *deliveries)
+		LIBCAMERA_TSA_REQUIRES(mutex_);
+	bool canMatch(const CameraState &state, int64_t timestamp, int64_t now) const
+		LIBCAMERA_TSA_REQUIRES(mutex_);
+	void deliver(std::vector<Delivery> &deliveries);
+
+	std::vector<std::shared_ptr<Camera>> cameras_;
+
+	mutable Mutex mutex_;
+	std::vector<CameraState> states_ LIBCAMERA_TSA_GUARDED_BY(mutex_);
+	std::chrono::nanoseconds tolerance_ LIBCAMERA_TSA_GUARDED_BY(mutex_);
+	DropPolicy policy_ LIBCAMERA_TSA_GUARDED_BY(mutex_);
+	bool running_;
+
+	Statistics stats_ LIBCAMERA_TSA_GUARDED_BY(mutex_);
+	int64_t totalSkew_ LIBCAMERA_TSA_GUARDED_BY(mutex_);
+	int64_t totalLatency_ LIBCAMERA_TSA_GUARDED_BY(mutex_);
+};
+
+} /* namespace libcamera */
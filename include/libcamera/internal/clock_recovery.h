@@ -22,7 +22,7 @@ public:
 	void addSample();
 	void addSample(uint64_t input, uint64_t output);
 
-	uint64_t getOutput(uint64_t input);
+	uint64_t getOutput(uint64_t input) const;
 
 private:
 	/* Approximate number of samples over which the model state persists. */
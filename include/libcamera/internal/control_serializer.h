@@ -9,6 +9,7 @@
 
 #include <map>
 #include <memory>
+#include <stdint.h>
 #include <vector>
 
 #include <libcamera/controls.h>
@@ -34,6 +35,8 @@ public:
 
 	int serialize(const ControlInfoMap &infoMap, ByteStreamBuffer &buffer);
 	int serialize(const ControlList &list, ByteStreamBuffer &buffer);
+	int serialize(const ControlList &list, unsigned int session,
+		      ByteStreamBuffer &buffer);
 
 	template<typename T>
 	T deserialize(ByteStreamBuffer &buffer);
@@ -41,6 +44,17 @@ public:
 	bool isCached(const ControlInfoMap &infoMap);
 
 private:
+	struct DeltaSession {
+		bool valid = false;
+		uint32_t generation = 0;
+		unsigned int deltas = 0;
+		unsigned int handle = 0;
+		const ControlIdMap *idmap = nullptr;
+		std::map<unsigned int, ControlValue> values;
+	};
+
+	static constexpr unsigned int kSyncInterval = 30;
+
 	static size_t binarySize(const ControlValue &value);
 	static size_t binarySize(const ControlInfo &info);
 
@@ -51,6 +65,8 @@ private:
 				       const ControlValue &value,
 				       uint32_t offset);
 
+	int infoMapHandle(const ControlList &list, unsigned int *handle) const;
+
 	ControlValue loadControlValue(ByteStreamBuffer &buffer,
 				      ControlType type,
 				      bool isArray, unsigned int count);
@@ -61,6 +77,8 @@ private:
 	std::vector<std::unique_ptr<ControlIdMap>> controlIdMaps_;
 	std::map<unsigned int, ControlInfoMap> infoMaps_;
 	std::map<const ControlInfoMap *, unsigned int> infoMapHandles_;
+	std::map<unsigned int, DeltaSession> txSessions_;
+	std::map<unsigned int, DeltaSession> rxSessions_;
 };
 
 } /* namespace libcamera */
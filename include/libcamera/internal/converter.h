@@ -110,6 +110,7 @@ public:
 	const std::vector<std::string> &compatibles() const { return compatibles_; }
 
 	static std::unique_ptr<Converter> create(std::shared_ptr<MediaDevice> media);
+	static std::unique_ptr<Converter> create(const std::string &name);
 	static std::vector<ConverterFactoryBase *> &factories();
 	static std::vector<std::string> names();
 
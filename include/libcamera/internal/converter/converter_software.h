@@ -0,0 +1,115 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * CPU based format converter
+ */
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <libcamera/base/object.h>
+#include <libcamera/base/span.h>
+
+#include <libcamera/geometry.h>
+#include <libcamera/pixel_format.h>
+
+#include "libcamera/internal/converter.h"
+#include "libcamera/internal/dma_buf_allocator.h"
+
+namespace libcamera {
+
+class FrameBuffer;
+class MediaDevice;
+class Stream;
+struct StreamConfiguration;
+
+class SoftwareConverter : public Converter, public Object
+{
+public:
+	SoftwareConverter(std::shared_ptr<MediaDevice> media);
+	~SoftwareConverter();
+
+	int loadConfiguration([[maybe_unused]] const std::string &filename) override { return 0; }
+	bool isValid() const override { return !workers_.empty(); }
+
+	std::vector<PixelFormat> formats(PixelFormat input) override;
+	SizeRange sizes(const Size &input) override;
+
+	std::tuple<unsigned int, unsigned int>
+	strideAndFrameSize(const PixelFormat &pixelFormat, const Size &size) override;
+
+	Size adjustInputSize(const PixelFormat &pixFmt,
+			     const Size &size, Alignment align = Alignment::Down) override;
+	Size adjustOutputSize(const PixelFormat &pixFmt,
+			      const Size &size, Alignment align = Alignment::Down) override;
+
+	int configure(const StreamConfiguration &inputCfg,
+		      const std::vector<std::reference_wrapper<const StreamConfiguration>>
+		      &outputCfg) override;
+	bool isConfigured(const Stream *stream) const override;
+	int exportBuffers(const Stream *stream, unsigned int count,
+			  std::vector<std::unique_ptr<FrameBuffer>> *buffers) override;
+
+	int start() override;
+	void stop() override;
+
+	int validateOutput(StreamConfiguration *cfg, bool *adjusted,
+			   Alignment align = Alignment::Down) override;
+
+	int queueBuffers(FrameBuffer *input,
+			 const std::map<const Stream *, FrameBuffer *> &outputs,
+			 const V4L2Request *request = nullptr) override;
+
+	int setInputCrop(const Stream *stream, Rectangle *rect) override;
+	std::pair<Rectangle, Rectangle> inputCropBounds() override;
+	std::pair<Rectangle, Rectangle> inputCropBounds(const Stream *stream) override;
+
+private:
+	class Worker;
+	struct Frame;
+	struct Layout;
+	struct Maps;
+
+	struct OutputStream {
+		const Layout *layout;
+		PixelFormat format;
+		Size size;
+		unsigned int stride;
+		unsigned int frameSize;
+		Rectangle crop;
+		std::shared_ptr<const Maps> maps;
+	};
+
+	static Span<const Layout> layouts();
+	static const Layout *findLayout(const PixelFormat &format);
+
+	std::shared_ptr<const Maps> createMaps(const OutputStream &stream) const;
+	void convert(const Frame &frame, unsigned int index, uint8_t *lineBuffer) const;
+	void frameDone(Frame *frame);
+
+	static constexpr unsigned int kMaxThreads = 4;
+
+	const Layout *inputLayout_;
+	PixelFormat inputFormat_;
+	Size inputSize_;
+	unsigned int inputStride_;
+
+	std::map<const Stream *, OutputStream> streams_;
+	std::vector<std::unique_ptr<Worker>> workers_;
+	std::deque<std::unique_ptr<Frame>> queue_;
+	std::atomic<bool> stopping_;
+
+	DmaBufAllocator dmaHeap_;
+};
+
+} /* namespace libcamera */
@@ -7,8 +7,10 @@
 
 #pragma once
 
+#include <array>
 #include <stdint.h>
 #include <unordered_map>
+#include <vector>
 
 #include <libcamera/base/object.h>
 
@@ -31,8 +33,8 @@ public:
 
 	void reset();
 
-	bool push(const ControlList &controls);
-	ControlList get(uint32_t sequence);
+	bool push(const ControlList &controls, uint32_t *sequence = nullptr);
+	const ControlList &get(uint32_t sequence);
 
 	void applyControls(uint32_t sequence);
 
@@ -69,15 +71,27 @@ private:
 		}
 	};
 
+	struct ControlState {
+		const ControlId *id;
+		ControlParams params;
+		ControlRingBuffer values;
+	};
+
+	ControlState *findControl(unsigned int id);
+
 	V4L2Device *device_;
-	/* \todo Evaluate if we should index on ControlId * or unsigned int */
-	std::unordered_map<const ControlId *, ControlParams> controlParams_;
 	unsigned int maxDelay_;
 
 	uint32_t queueCount_;
 	uint32_t writeCount_;
-	/* \todo Evaluate if we should index on ControlId * or unsigned int */
-	std::unordered_map<const ControlId *, ControlRingBuffer> values_;
+
+	/* Controls sorted by numerical id. */
+	std::vector<ControlState> controls_;
+
+	/* Lists reused by get() and applyControls() to avoid per-frame allocations. */
+	ControlList current_;
+	ControlList batch_;
+	ControlList priority_;
 };
 
 } /* namespace libcamera */
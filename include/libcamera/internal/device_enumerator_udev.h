@@ -59,7 +59,8 @@ private:
 
 	LIBCAMERA_DISABLE_COPY_AND_MOVE(DeviceEnumeratorUdev)
 
-	int addUdevDevice(struct udev_device *dev);
+	int addUdevDevice(struct udev_device *dev,
+			  std::unique_ptr<MediaDevice> media = nullptr);
 	void removeUdevDevice(struct udev_device *dev);
 	int populateMediaDevice(MediaDevice *media, DependencyMap *deps);
 	std::string lookupDeviceNode(dev_t devnum);
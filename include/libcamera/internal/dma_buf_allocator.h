@@ -7,12 +7,16 @@
 
 #pragma once
 
+#include <functional>
+#include <list>
 #include <memory>
 #include <stdint.h>
 #include <string>
 #include <vector>
 
+#include <libcamera/base/class.h>
 #include <libcamera/base/flags.h>
+#include <libcamera/base/mutex.h>
 #include <libcamera/base/shared_fd.h>
 #include <libcamera/base/unique_fd.h>
 
@@ -50,6 +54,56 @@ private:
 	DmaBufAllocatorFlag type_;
 };
 
+class DmaBufPool
+{
+public:
+	struct Statistics {
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t evictions;
+		std::size_t usedSize;
+		std::size_t pooledSize;
+		std::size_t peakSize;
+	};
+
+	using Allocator = std::function<UniqueFD(std::size_t size)>;
+
+	static std::shared_ptr<DmaBufPool> instance();
+
+	DmaBufPool();
+	~DmaBufPool();
+
+	void setMaxSize(std::size_t size);
+	std::size_t maxSize() const;
+	bool isEnabled() const { return maxSize() != 0; }
+
+	static std::size_t sizeClass(std::size_t size);
+
+	SharedFD acquire(DmaBufAllocator::DmaBufAllocatorFlag type,
+			 std::size_t size, const Allocator &allocate);
+	void release(DmaBufAllocator::DmaBufAllocatorFlag type,
+		     std::size_t size, SharedFD fd);
+
+	void trim();
+	Statistics statistics() const;
+
+private:
+	LIBCAMERA_DISABLE_COPY_AND_MOVE(DmaBufPool)
+
+	struct Entry {
+		DmaBufAllocator::DmaBufAllocatorFlag type;
+		std::size_t size;
+		SharedFD fd;
+	};
+
+	void evict(std::size_t size) LIBCAMERA_TSA_REQUIRES(mutex_);
+
+	mutable Mutex mutex_;
+	std::size_t maxSize_ LIBCAMERA_TSA_GUARDED_BY(mutex_);
+	std::list<Entry> entries_ LIBCAMERA_TSA_GUARDED_BY(mutex_);
+	Statistics stats_ LIBCAMERA_TSA_GUARDED_BY(mutex_);
+};
+
 class DmaSyncer final
 {
 public:
@@ -69,10 +123,11 @@ public:
 private:
 	LIBCAMERA_DISABLE_COPY(DmaSyncer)
 
-	void sync(uint64_t step);
+	bool sync(uint64_t step);
 
 	SharedFD fd_;
 	uint64_t flags_ = 0;
+	bool active_ = false;
 };
 
 LIBCAMERA_FLAGS_ENABLE_OPERATORS(DmaBufAllocator::DmaBufAllocatorFlag)
@@ -0,0 +1,241 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Indexed tracking of in-flight frame information
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+#include <libcamera/base/log.h>
+
+#include <libcamera/framebuffer.h>
+#include <libcamera/request.h>
+
+namespace libcamera {
+
+class FrameInfoIndex
+{
+public:
+	static constexpr unsigned int kInvalid = ~0u;
+
+	FrameInfoIndex();
+
+	void reserve(unsigned int size);
+	void clear();
+
+	void insert(uint64_t key, unsigned int value);
+	void erase(uint64_t key);
+	unsigned int find(uint64_t key) const;
+
+	unsigned int size() const { return size_; }
+
+private:
+	struct Entry {
+		uint64_t key;
+		unsigned int value;
+	};
+
+	unsigned int home(uint64_t key) const;
+	void rehash(unsigned int capacity);
+
+	std::vector<Entry> entries_;
+	unsigned int size_;
+};
+
+template<typename Info>
+class FrameInfoTracker
+{
+public:
+	using CompletionCheck = std::function<bool(const Info &)>;
+
+	FrameInfoTracker(CompletionCheck check = {})
+		: check_(std::move(check))
+	{
+	}
+
+	void reserve(unsigned int size)
+	{
+		while (slots_.size() < size) {
+			freeSlots_.push_back(slots_.size());
+			slots_.push_back(std::make_unique<Slot>());
+		}
+
+		bySequence_.reserve(size);
+		byRequest_.reserve(size);
+		byBuffer_.reserve(size * 4);
+	}
+
+	void clear()
+	{
+		for (unsigned int i = 0; i < slots_.size(); ++i) {
+			if (slots_[i]->used)
+				release(i);
+		}
+	}
+
+	Info *create(unsigned int sequence, Request *request)
+	{
+		ASSERT(bySequence_.find(sequenceKey(sequence)) == FrameInfoIndex::kInvalid);
+
+		if (freeSlots_.empty()) {
+			freeSlots_.push_back(slots_.size());
+			slots_.push_back(std::make_unique<Slot>());
+		}
+
+		unsigned int index = freeSlots_.back();
+		freeSlots_.pop_back();
+
+		Slot &slot = *slots_[index];
+		slot.info = {};
+		slot.sequence = sequence;
+		slot.request = request;
+		slot.buffers.clear();
+		slot.used = true;
+
+		bySequence_.insert(sequenceKey(sequence), index);
+
+		if (request) {
+			byRequest_.insert(pointerKey(request), index);
+			for (const auto &[stream, buffer] : request->buffers())
+				addSlotBuffer(index, buffer);
+		}
+
+		return &slot.info;
+	}
+
+	void addBuffer(unsigned int sequence, FrameBuffer *buffer)
+	{
+		unsigned int index = bySequence_.find(sequenceKey(sequence));
+		if (index == FrameInfoIndex::kInvalid)
+			return;
+
+		addSlotBuffer(index, buffer);
+	}
+
+	bool remove(unsigned int sequence)
+	{
+		unsigned int index = bySequence_.find(sequenceKey(sequence));
+		if (index == FrameInfoIndex::kInvalid)
+			return false;
+
+		release(index);
+		return true;
+	}
+
+	bool tryComplete(unsigned int sequence)
+	{
+		unsigned int index = bySequence_.find(sequenceKey(sequence));
+		if (index == FrameInfoIndex::kInvalid)
+			return false;
+
+		Slot &slot = *slots_[index];
+		if (slot.request && slot.request->hasPendingBuffers())
+			return false;
+
+		if (check_ && !check_(slot.info))
+			return false;
+
+		release(index);
+		return true;
+	}
+
+	Info *find(unsigned int sequence)
+	{
+		return lookup(bySequence_, sequenceKey(sequence));
+	}
+
+	Info *find(const FrameBuffer *buffer)
+	{
+		return lookup(byBuffer_, pointerKey(buffer));
+	}
+
+	Info *find(const Request *request)
+	{
+		return lookup(byRequest_, pointerKey(request));
+	}
+
+	template<typename Func>
+	void forEach(Func func)
+	{
+		for (std::unique_ptr<Slot> &slot : slots_) {
+			if (slot->used)
+				func(slot->info);
+		}
+	}
+
+	unsigned int size() const { return bySequence_.size(); }
+	bool empty() const { return size() == 0; }
+
+private:
+	struct Slot {
+		Info info = {};
+		unsigned int sequence = 0;
+		Request *request = nullptr;
+		std::vector<const FrameBuffer *> buffers;
+		bool used = false;
+	};
+
+	static uint64_t sequenceKey(unsigned int sequence)
+	{
+		/* Offset by one as a zero key denotes an empty index entry. */
+		return static_cast<uint64_t>(sequence) + 1;
+	}
+
+	static uint64_t pointerKey(const void *ptr)
+	{
+		return reinterpret_cast<uintptr_t>(ptr);
+	}
+
+	Info *lookup(const FrameInfoIndex &index, uint64_t key)
+	{
+		unsigned int slot = key ? index.find(key) : FrameInfoIndex::kInvalid;
+		if (slot == FrameInfoIndex::kInvalid)
+			return nullptr;
+
+		return &slots_[slot]->info;
+	}
+
+	void addSlotBuffer(unsigned int index, const FrameBuffer *buffer)
+	{
+		if (!buffer)
+			return;
+
+		slots_[index]->buffers.push_back(buffer);
+		byBuffer_.insert(pointerKey(buffer), index);
+	}
+
+	void release(unsigned int index)
+	{
+		Slot &slot = *slots_[index];
+
+		for (const FrameBuffer *buffer : slot.buffers) {
+			if (byBuffer_.find(pointerKey(buffer)) == index)
+				byBuffer_.erase(pointerKey(buffer));
+		}
+
+		if (slot.request)
+			byRequest_.erase(pointerKey(slot.request));
+
+		bySequence_.erase(sequenceKey(slot.sequence));
+
+		slot.used = false;
+		freeSlots_.push_back(index);
+	}
+
+	std::vector<std::unique_ptr<Slot>> slots_;
+	std::vector<unsigned int> freeSlots_;
+
+	FrameInfoIndex bySequence_;
+	FrameInfoIndex byRequest_;
+	FrameInfoIndex byBuffer_;
+
+	CompletionCheck check_;
+};
+
+} /* namespace libcamera */
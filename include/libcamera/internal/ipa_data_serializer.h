@@ -84,6 +84,10 @@ public:
 			     ControlSerializer *cs = nullptr);
 };
 
+std::tuple<std::vector<uint8_t>, std::vector<SharedFD>>
+serializeControlListDelta(const ControlList &data, unsigned int session,
+			  ControlSerializer *cs);
+
 #ifndef __DOXYGEN__
 
 /*
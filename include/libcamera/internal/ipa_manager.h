@@ -7,11 +7,14 @@
 
 #pragma once
 
+#include <map>
 #include <memory>
 #include <stdint.h>
+#include <string>
 #include <vector>
 
 #include <libcamera/base/log.h>
+#include <libcamera/base/span.h>
 
 #include <libcamera/ipa/ipa_interface.h>
 #include <libcamera/ipa/ipa_module_info.h>
@@ -25,6 +28,8 @@ LOG_DECLARE_CATEGORY(IPAManager)
 class CameraManager;
 class GlobalConfiguration;
 class IPAModule;
+class IPAModuleCache;
+class IPCPipeUnixSocket;
 class PipelineHandler;
 
 class IPAManager
@@ -37,25 +42,19 @@ public:
 	std::unique_ptr<T> createIPA(PipelineHandler *pipe, uint32_t minVersion,
 				     uint32_t maxVersion)
 	{
-		IPAModule *m = module(pipe, minVersion, maxVersion);
-		if (!m)
-			return nullptr;
-
-		auto proxy = [&]() -> std::unique_ptr<T> {
-			if (isSignatureValid(m))
-				return std::make_unique<typename T::Threaded>(m, cm_);
-			else
-				return std::make_unique<typename T::Isolated>(m, cm_);
-		}();
-
-		if (!proxy->isValid()) {
-			LOG(IPAManager, Error) << "Failed to load proxy";
-			return nullptr;
-		}
+		return createProxy<T>(module(pipe, minVersion, maxVersion));
+	}
 
-		return proxy;
+	template<typename T>
+	std::unique_ptr<T> createIPA(const char *pipelineName, uint32_t minVersion,
+				     uint32_t maxVersion)
+	{
+		return createProxy<T>(module(pipelineName, minVersion, maxVersion));
 	}
 
+	std::unique_ptr<IPCPipeUnixSocket>
+	acquireProxyWorker(const IPAModule *ipam, const std::string &workerPath);
+
 #if HAVE_IPA_PUBKEY
 	static const PubKey &pubKey()
 	{
@@ -64,19 +63,56 @@ public:
 #endif
 
 private:
+	struct ProxyWorkerPool {
+		std::string workerPath;
+		std::vector<std::unique_ptr<IPCPipeUnixSocket>> workers;
+	};
+
 	void parseDir(const char *libDir, unsigned int maxDepth,
 		      std::vector<std::string> &files);
 	unsigned int addDir(const char *libDir, unsigned int maxDepth = 0);
 
 	IPAModule *module(PipelineHandler *pipe, uint32_t minVersion,
 			  uint32_t maxVersion);
+	IPAModule *module(const char *pipelineName, uint32_t minVersion,
+			  uint32_t maxVersion);
+
+	template<typename T>
+	std::unique_ptr<T> createProxy(IPAModule *m)
+	{
+		if (!m)
+			return nullptr;
+
+		auto proxy = [&]() -> std::unique_ptr<T> {
+			if (isSignatureValid(m))
+				return std::make_unique<typename T::Threaded>(m, cm_);
+			else
+				return std::make_unique<typename T::Isolated>(m, cm_, this);
+		}();
+
+		if (!proxy->isValid()) {
+			LOG(IPAManager, Error) << "Failed to load proxy";
+			return nullptr;
+		}
+
+		return proxy;
+	}
 
 	bool isSignatureValid(IPAModule *ipa) const;
 
+	void spawnProxyWorkers(const GlobalConfiguration &configuration);
+	void fillProxyWorkerPool(const IPAModule *ipam, ProxyWorkerPool &pool);
+
 	const CameraManager &cm_;
 	std::vector<std::unique_ptr<IPAModule>> modules_;
+	std::unique_ptr<IPAModuleCache> moduleCache_;
+
+	unsigned int proxyPoolSize_;
+	std::map<const IPAModule *, ProxyWorkerPool> proxyPools_;
 
 #if HAVE_IPA_PUBKEY
+	static Span<const uint8_t> publicKeyData();
+
 	static const uint8_t publicKeyData_[];
 	static const PubKey pubKey_;
 	bool forceIsolation_;
@@ -24,6 +24,7 @@ class IPAModule : public Loggable
 {
 public:
 	explicit IPAModule(const std::string &libPath);
+	IPAModule(const std::string &libPath, const struct IPAModuleInfo &info);
 	~IPAModule();
 
 	bool isValid() const;
@@ -38,12 +39,16 @@ public:
 
 	bool match(PipelineHandler *pipe,
 		   uint32_t minVersion, uint32_t maxVersion) const;
+	bool match(const char *pipelineName,
+		   uint32_t minVersion, uint32_t maxVersion) const;
 
 protected:
 	std::string logPrefix() const override;
 
 private:
 	int loadIPAModuleInfo();
+	int validateIPAModuleInfo() const;
+	void loadSignature();
 
 	struct IPAModuleInfo info_;
 	std::vector<uint8_t> signature_;
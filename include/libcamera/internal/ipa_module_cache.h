@@ -0,0 +1,74 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Persistent cache of IPA module information
+ */
+
+#pragma once
+
+#include <map>
+#include <optional>
+#include <stdint.h>
+#include <string>
+
+#include <libcamera/base/span.h>
+
+#include <libcamera/ipa/ipa_module_info.h>
+
+namespace libcamera {
+
+class IPAModuleCache
+{
+public:
+	struct FileStamp {
+		uint64_t dev;
+		uint64_t ino;
+		int64_t size;
+		int64_t mtime;
+		int64_t ctime;
+
+		bool operator==(const FileStamp &other) const = default;
+	};
+
+	struct Stamp {
+		FileStamp module;
+		FileStamp signature;
+
+		bool operator==(const Stamp &other) const = default;
+	};
+
+	struct Entry {
+		struct IPAModuleInfo info;
+		std::optional<bool> signatureValid;
+	};
+
+	IPAModuleCache(const std::string &path, Span<const uint8_t> publicKey);
+
+	static std::string defaultPath();
+	static Stamp stamp(const std::string &modulePath);
+
+	const Entry *find(const std::string &modulePath, const Stamp &stamp) const;
+	void update(const std::string &modulePath, const Stamp &stamp,
+		    const struct IPAModuleInfo &info);
+	void setSignatureValid(const std::string &modulePath, const Stamp &stamp,
+			       bool valid);
+
+	int save();
+
+private:
+	struct Record {
+		Stamp stamp;
+		Entry entry;
+	};
+
+	void load();
+	bool parseRecord(const std::string &line);
+
+	std::string path_;
+	std::string header_;
+	std::map<std::string, Record> records_;
+	bool dirty_;
+};
+
+} /* namespace libcamera */
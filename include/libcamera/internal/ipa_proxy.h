@@ -17,6 +17,7 @@
 
 namespace libcamera {
 
+class IPAManager;
 class IPAModule;
 
 class IPAProxy : public IPAInterface
@@ -36,8 +37,14 @@ public:
 	std::string configurationFile(const std::string &name,
 				      const std::string &fallbackName = std::string()) const;
 
+	static std::string resolvePath(const std::string &file,
+				       const std::vector<std::string> &execPaths);
+
 protected:
-	std::string resolvePath(const std::string &file) const;
+	std::string resolvePath(const std::string &file) const
+	{
+		return resolvePath(file, execPaths_);
+	}
 
 	bool valid_;
 	ProxyState state_;
@@ -59,8 +59,10 @@ public:
 
 	void registerRequest(Request *request);
 	void queueRequest(Request *request);
+	void queueRequests(const std::vector<Request *> &requests);
 
 	bool completeBuffer(Request *request, FrameBuffer *buffer);
+	void metadataAvailable(Request *request, const ControlList &metadata);
 	void completeRequest(Request *request);
 	void cancelRequest(Request *request);
 
@@ -79,6 +81,14 @@ public:
 		return ipaManager->createIPA<T>(this, minVersion, maxVersion);
 	}
 
+	template<typename T>
+	std::unique_ptr<T> createIPA(const char *pipelineName, uint32_t minVersion,
+				     uint32_t maxVersion)
+	{
+		IPAManager *ipaManager = manager_->_d()->ipaManager();
+		return ipaManager->createIPA<T>(pipelineName, minVersion, maxVersion);
+	}
+
 protected:
 	void registerCamera(std::shared_ptr<Camera> camera);
 	void hotplugMediaDevice(std::shared_ptr<MediaDevice> media);
@@ -101,12 +111,23 @@ private:
 
 	void doQueueRequest(Request *request);
 	void doQueueRequests(Camera *camera);
+	void reportRemainingMetadata(Request *request);
+	void resetQueueStatistics(Camera *camera);
+	void updateQueueStatistics(Request *request);
+	void updateCompletionStatistics(Request *request);
+
+	static constexpr unsigned int kDefaultMinQueueDepth = 2;
+	static constexpr unsigned int kQueueDepthStablePeriod = 30;
 
 	std::vector<std::shared_ptr<MediaDevice>> mediaDevices_;
 	std::vector<std::weak_ptr<Camera>> cameras_;
 
 	const char *name_;
 	unsigned int useCount_;
+	bool batchQueueing_;
+
+	bool autoQueueDepth_;
+	unsigned int minQueueDepth_;
 
 	friend class PipelineHandlerFactoryBase;
 };
@@ -11,7 +11,7 @@
 #include <map>
 #include <memory>
 #include <stdint.h>
-#include <unordered_set>
+#include <vector>
 
 #include <libcamera/base/event_notifier.h>
 #include <libcamera/base/timer.h>
@@ -60,10 +60,15 @@ private:
 	uint32_t sequence_ = 0;
 	bool prepared_ = false;
 
-	std::unordered_set<FrameBuffer *> pending_;
+	std::vector<FrameBuffer *> pending_;
+	std::vector<BufferMap::node_type> spareBufferNodes_;
 	std::map<FrameBuffer *, EventNotifier> notifiers_;
 	std::unique_ptr<Timer> timer_;
 	ControlList metadata_;
+	std::vector<unsigned int> reportedMetadata_;
+
+	std::chrono::steady_clock::time_point queueTime_;
+	std::chrono::steady_clock::time_point prepareTime_;
 };
 
 } /* namespace libcamera */
@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Worker thread for CPU based processing stages
+ */
+
+#pragma once
+
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <libcamera/base/mutex.h>
+#include <libcamera/base/object.h>
+#include <libcamera/base/thread.h>
+
+namespace libcamera {
+
+class WorkerThread : public Thread, public Object
+{
+public:
+	WorkerThread(const std::string &name, unsigned int index);
+
+	static unsigned int idealCount(unsigned int max);
+
+	unsigned int index() const { return index_; }
+
+	template<typename T, typename R, typename... FuncArgs, typename... Args,
+		 std::enable_if_t<std::is_base_of<WorkerThread, T>::value> * = nullptr>
+	void queue(R (T::*func)(FuncArgs...), Args &&...args)
+	{
+		{
+			MutexLocker locker(mutex_);
+			queued_++;
+		}
+
+		invokeMethod(func, ConnectionTypeQueued, std::forward<Args>(args)...);
+		invokeMethod(&WorkerThread::jobDone, ConnectionTypeQueued);
+	}
+
+	void waitIdle();
+
+private:
+	void jobDone();
+
+	unsigned int index_;
+
+	Mutex mutex_;
+	ConditionVariable idle_;
+	unsigned int queued_ LIBCAMERA_TSA_GUARDED_BY(mutex_);
+};
+
+} /* namespace libcamera */
@@ -15,7 +15,9 @@ namespace libcamera {
 extern "C" {
 #endif
 
-#define IPA_CONTROLS_FORMAT_VERSION	2
+#define IPA_CONTROLS_FORMAT_VERSION	3
+
+#define IPA_CONTROLS_FLAG_DELTA		(1 << 0)
 
 enum ipa_controls_id_map_type {
 	IPA_CONTROL_ID_MAP_CONTROLS,
@@ -30,7 +32,9 @@ struct ipa_controls_header {
 	uint32_t size;
 	uint32_t data_offset;
 	enum ipa_controls_id_map_type id_map_type;
-	uint32_t reserved[2];
+	uint16_t session;
+	uint16_t flags;
+	uint32_t generation;
 };
 
 struct ipa_control_value_entry {
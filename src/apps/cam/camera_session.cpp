@@ -7,9 +7,12 @@
 
 #include "camera_session.h"
 
+#include <algorithm>
+#include <chrono>
 #include <iomanip>
 #include <iostream>
 #include <limits.h>
+#include <numeric>
 #include <optional>
 #include <sstream>
 
@@ -37,7 +40,8 @@ CameraSession::CameraSession(CameraManager *cm,
 			     const OptionsParser::Options &options)
 	: options_(options), cameraIndex_(cameraIndex), last_(0),
 	  queueCount_(0), captureCount_(0), captureLimit_(0),
-	  printMetadata_(false)
+	  printMetadata_(false), benchmark_(false), droppedFrames_(0),
+	  firstTimestamp_(0), lastTimestamp_(0)
 {
 	char *endptr;
 	unsigned long index = strtoul(cameraId.c_str(), &endptr, 10);
@@ -142,6 +146,11 @@ CameraSession::CameraSession(CameraManager *cm,
 	}
 #endif
 
+	if (options_.isSet(OptRecord) && !options_.isSet(OptFile)) {
+		std::cerr << "--record requires the --file option" << std::endl;
+		return;
+	}
+
 	if (options_.isSet(OptCaptureScript)) {
 		std::string scriptName = options_[OptCaptureScript].toString();
 		script_ = std::make_unique<CaptureScript>(camera_, scriptName);
@@ -279,6 +288,14 @@ int CameraSession::start()
 	captureCount_ = 0;
 	captureLimit_ = options_[OptCapture].toInteger();
 	printMetadata_ = options_.isSet(OptMetadata);
+	benchmark_ = options_.isSet(OptBenchmark);
+
+	latencies_.clear();
+	latencies_.reserve(captureLimit_);
+	lastSequence_.reset();
+	droppedFrames_ = 0;
+	firstTimestamp_ = 0;
+	lastTimestamp_ = 0;
 
 	ret = camera_->configure(config_.get());
 	if (ret < 0) {
@@ -315,6 +332,12 @@ int CameraSession::start()
 				return ret;
 		}
 
+		if (options_.isSet(OptRecord)) {
+			ret = sink->setRecording();
+			if (ret)
+				return ret;
+		}
+
 		sink_ = std::move(sink);
 	}
 
@@ -340,6 +363,9 @@ void CameraSession::stop()
 	if (ret)
 		std::cout << "Failed to stop capture" << std::endl;
 
+	if (benchmark_)
+		printBenchmark();
+
 	if (sink_) {
 		ret = sink_->stop();
 		if (ret)
@@ -460,6 +486,13 @@ void CameraSession::requestComplete(Request *request)
 	if (request->status() == Request::RequestCancelled)
 		return;
 
+	/*
+	 * Record the latency before deferring processing, to avoid accounting
+	 * for the event loop delay.
+	 */
+	if (benchmark_)
+		recordLatency(request);
+
 	/*
 	 * Defer processing of the completed request to the event loop, to avoid
 	 * blocking the camera manager thread.
@@ -517,7 +550,8 @@ void CameraSession::processRequest(Request *request)
 			requeue = false;
 	}
 
-	std::cout << info.str() << std::endl;
+	if (!benchmark_)
+		std::cout << info.str() << std::endl;
 
 	if (printMetadata_) {
 		const ControlList &requestMetadata = request->metadata();
@@ -554,3 +588,62 @@ void CameraSession::sinkRelease(Request *request)
 	request->reuse(Request::ReuseBuffers);
 	queueRequest(request);
 }
+
+void CameraSession::recordLatency(Request *request)
+{
+	int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+
+	if (captureLimit_ && latencies_.size() >= captureLimit_)
+		return;
+
+	const auto &timestamp = request->metadata().get(controls::SensorTimestamp);
+	if (!timestamp)
+		return;
+
+	latencies_.push_back(now - *timestamp);
+
+	if (!firstTimestamp_)
+		firstTimestamp_ = *timestamp;
+	lastTimestamp_ = *timestamp;
+
+	/* Sequence gaps indicate frames dropped by the camera. */
+	uint32_t sequence = request->buffers().begin()->second->metadata().sequence;
+	if (lastSequence_ && sequence > *lastSequence_ + 1)
+		droppedFrames_ += sequence - *lastSequence_ - 1;
+	lastSequence_ = sequence;
+}
+
+void CameraSession::printBenchmark() const
+{
+	if (latencies_.empty()) {
+		std::cout << "cam" << cameraIndex_
+			  << ": No frame captured with a sensor timestamp"
+			  << std::endl;
+		return;
+	}
+
+	std::vector<int64_t> latencies = latencies_;
+	std::sort(latencies.begin(), latencies.end());
+
+	auto percentile = [&](unsigned int p) {
+		return latencies[(latencies.size() - 1) * p / 100] / 1e6;
+	};
+
+	double mean = std::accumulate(latencies.begin(), latencies.end(), 0.0) /
+		      latencies.size() / 1e6;
+	double duration = (lastTimestamp_ - firstTimestamp_) / 1e9;
+	double fps = duration > 0 ? (latencies.size() - 1) / duration : 0.0;
+
+	std::cout << std::fixed << std::setprecision(3)
+		  << "cam" << cameraIndex_ << ": " << latencies.size()
+		  << " frames in " << duration << "s ("
+		  << std::setprecision(2) << fps << " fps), "
+		  << droppedFrames_ << " frames dropped" << std::endl;
+
+	std::cout << std::setprecision(3)
+		  << "cam" << cameraIndex_ << ": Latency (ms): min "
+		  << latencies.front() / 1e6 << ", mean " << mean
+		  << ", p50 " << percentile(50) << ", p99 " << percentile(99)
+		  << ", max " << latencies.back() / 1e6 << std::endl;
+}
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <stdint.h>
 #include <string>
 #include <vector>
@@ -57,6 +58,9 @@ private:
 	void processRequest(libcamera::Request *request);
 	void sinkRelease(libcamera::Request *request);
 
+	void recordLatency(libcamera::Request *request);
+	void printBenchmark() const;
+
 	const OptionsParser::Options &options_;
 	std::shared_ptr<libcamera::Camera> camera_;
 	std::unique_ptr<libcamera::CameraConfiguration> config_;
@@ -74,6 +78,14 @@ private:
 	unsigned int captureLimit_;
 	bool printMetadata_;
 
+	/* Benchmark statistics, updated in the camera manager thread. */
+	bool benchmark_;
+	std::vector<int64_t> latencies_;
+	std::optional<uint32_t> lastSequence_;
+	unsigned int droppedFrames_;
+	int64_t firstTimestamp_;
+	int64_t lastTimestamp_;
+
 	std::unique_ptr<libcamera::FrameBufferAllocator> allocator_;
 	std::vector<std::unique_ptr<libcamera::Request>> requests_;
 };
@@ -10,6 +10,7 @@
 #include <array>
 #include <assert.h>
 #include <fcntl.h>
+#include <filesystem>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -32,6 +33,7 @@ FileSink::FileSink([[maybe_unused]] const libcamera::Camera *camera,
 	  camera_(camera),
 #endif
 	  pattern_(kDefaultFilePattern), fileType_(FileType::Binary),
+	  recording_(false),
 	  streamNames_(streamNames)
 {
 }
@@ -75,12 +77,45 @@ int FileSink::setFilePattern(const std::string &pattern)
 	return 0;
 }
 
+/*
+ * Record the frames for replay by the virtual pipeline handler. Frames are
+ * written in binary format, and an index named after the stream is written to
+ * the directory of the frames, listing for each frame the file and offset it
+ * is stored at, its sequence number, timestamp, request controls and metadata.
+ */
+int FileSink::setRecording()
+{
+	if (fileType_ != FileType::Binary) {
+		std::cerr << "Recording requires binary output files" << std::endl;
+		return -EINVAL;
+	}
+
+	recording_ = true;
+
+	return 0;
+}
+
 int FileSink::configure(const libcamera::CameraConfiguration &config)
 {
 	int ret = FrameSink::configure(config);
 	if (ret < 0)
 		return ret;
 
+	if (!recording_)
+		return 0;
+
+	std::filesystem::path directory = std::filesystem::path(pattern_).parent_path();
+	recorders_.clear();
+
+	for (const StreamConfiguration &cfg : config) {
+		std::filesystem::path path =
+			directory / (streamNames_[cfg.stream()] + ".yaml");
+
+		ret = recorders_[cfg.stream()].open(path, cfg);
+		if (ret < 0)
+			return ret;
+	}
+
 	return 0;
 }
 
@@ -96,16 +131,18 @@ void FileSink::mapBuffer(FrameBuffer *buffer)
 bool FileSink::processRequest(Request *request)
 {
 	for (auto [stream, buffer] : request->buffers())
-		writeBuffer(stream, buffer, request->metadata());
+		writeBuffer(stream, buffer, request);
 
 	return true;
 }
 
 void FileSink::writeBuffer(const Stream *stream, FrameBuffer *buffer,
-			   [[maybe_unused]] const ControlList &metadata)
+			   Request *request)
 {
+	[[maybe_unused]] const ControlList &metadata = request->metadata();
 	std::string filename = pattern_;
 	size_t pos;
+	off_t offset;
 	int fd, ret = 0;
 
 	pos = filename.find_first_of('#');
@@ -150,6 +187,9 @@ void FileSink::writeBuffer(const Stream *stream, FrameBuffer *buffer,
 		return;
 	}
 
+	/* Frames appended to a single file are located by their offset. */
+	offset = lseek(fd, 0, SEEK_END);
+
 	for (unsigned int i = 0; i < buffer->planes().size(); ++i) {
 		/*
 		 * This was formerly a local "const FrameMetadata::Plane &"
@@ -176,9 +216,13 @@ void FileSink::writeBuffer(const Stream *stream, FrameBuffer *buffer,
 			std::cerr << "write error: only " << ret
 				  << " bytes written instead of "
 				  << length << std::endl;
+			ret = -EIO;
 			break;
 		}
 	}
 
 	close(fd);
+
+	if (recording_ && ret >= 0 && offset >= 0)
+		recorders_[stream].write(buffer, request, filename, offset);
 }
@@ -14,6 +14,8 @@
 #include <libcamera/controls.h>
 #include <libcamera/stream.h>
 
+#include "../common/recording_writer.h"
+
 #include "frame_sink.h"
 
 class Image;
@@ -26,6 +28,7 @@ public:
 	~FileSink();
 
 	int setFilePattern(const std::string &pattern);
+	int setRecording();
 
 	int configure(const libcamera::CameraConfiguration &config) override;
 
@@ -44,7 +47,7 @@ private:
 
 	void writeBuffer(const libcamera::Stream *stream,
 			 libcamera::FrameBuffer *buffer,
-			 const libcamera::ControlList &metadata);
+			 libcamera::Request *request);
 
 #ifdef HAVE_TIFF
 	const libcamera::Camera *camera_;
@@ -52,7 +55,9 @@ private:
 
 	std::string pattern_;
 	FileType fileType_;
+	bool recording_;
 
 	std::map<const libcamera::Stream *, std::string> streamNames_;
 	std::map<libcamera::FrameBuffer *, std::unique_ptr<Image>> mappedBuffers_;
+	std::map<const libcamera::Stream *, RecordingWriter> recorders_;
 };
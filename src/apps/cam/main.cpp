@@ -189,6 +189,21 @@ int CamApp::parseOptions(int argc, char *argv[])
 			 "Load a capture session configuration script from a file",
 			 "script", ArgumentRequired, "script", false,
 			 OptCamera);
+	parser.addOption(OptBenchmark, OptionNone,
+			 "Measure the frame rate and the latency from the start of\n"
+			 "exposure to request completion, and print a summary instead\n"
+			 "of per-frame information. Combine with a capture count for\n"
+			 "reproducible runs",
+			 "benchmark", ArgumentNone, nullptr, false,
+			 OptCamera);
+	parser.addOption(OptRecord, OptionNone,
+			 "Record the captured frames for replay by the virtual pipeline\n"
+			 "handler. Requires frames to be written to binary files with\n"
+			 "--file, and writes a '<stream>.yaml' index listing the frames\n"
+			 "with their timestamp, request controls and metadata in the\n"
+			 "same directory",
+			 "record", ArgumentNone, nullptr, false,
+			 OptCamera);
 
 	options_ = parser.parse(argc, argv);
 	if (!options_.valid())
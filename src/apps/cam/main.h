@@ -25,4 +25,6 @@ enum {
 	OptStrictFormats = 257,
 	OptMetadata = 258,
 	OptCaptureScript = 259,
+	OptBenchmark = 260,
+	OptRecord = 261,
 };
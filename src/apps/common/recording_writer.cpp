@@ -0,0 +1,107 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Recording index writer
+ */
+
+#include "recording_writer.h"
+
+#include <errno.h>
+#include <filesystem>
+#include <iostream>
+
+#include <libcamera/control_ids.h>
+#include <libcamera/controls.h>
+
+using namespace libcamera;
+
+/*
+ * The recording index lists the frames of a stream recorded for replay by the
+ * virtual pipeline handler. It is a YAML document storing the format of the
+ * stream, and for each frame the file and offset it is stored at, its sequence
+ * number, timestamp, request controls and metadata.
+ */
+
+namespace {
+
+void writeControls(std::ostream &out, const char *key, const ControlList &list)
+{
+	bool empty = true;
+
+	for (const auto &[id, value] : list) {
+		/* The timestamp of the frame is recorded separately. */
+		if (id == controls::SensorTimestamp.id())
+			continue;
+
+		/* Only numerical and boolean values can be replayed. */
+		switch (value.type()) {
+		case ControlTypeBool:
+		case ControlTypeByte:
+		case ControlTypeUnsigned16:
+		case ControlTypeUnsigned32:
+		case ControlTypeInteger32:
+		case ControlTypeInteger64:
+		case ControlTypeFloat:
+			break;
+		default:
+			continue;
+		}
+
+		auto ctrl = list.idMap()->find(id);
+		if (ctrl == list.idMap()->end())
+			continue;
+
+		if (empty)
+			out << "    " << key << ":" << std::endl;
+		empty = false;
+
+		out << "      " << ctrl->second->name() << ": " << value.toString()
+		    << std::endl;
+	}
+}
+
+} /* namespace */
+
+int RecordingWriter::open(const std::string &path,
+			  const StreamConfiguration &config)
+{
+	index_.close();
+	index_.open(path, std::ios::trunc);
+	if (!index_) {
+		std::cerr << "failed to open recording index " << path
+			  << std::endl;
+		return -EIO;
+	}
+
+	index_ << "format: " << config.pixelFormat << std::endl
+	       << "width: " << config.size.width << std::endl
+	       << "height: " << config.size.height << std::endl
+	       << "stride: " << config.stride << std::endl
+	       << "frames:" << std::endl;
+
+	return 0;
+}
+
+/*
+ * Record a frame stored in \a filename at \a offset. The file name is recorded
+ * relative to the directory of the index.
+ */
+void RecordingWriter::write(const FrameBuffer *buffer, Request *request,
+			    const std::string &filename, off_t offset)
+{
+	const ControlList &metadata = request->metadata();
+
+	uint64_t timestamp = metadata.get(controls::SensorTimestamp)
+				     .value_or(buffer->metadata().timestamp);
+
+	index_ << "  - file: " << std::filesystem::path(filename).filename().string() << std::endl
+	       << "    offset: " << offset << std::endl
+	       << "    sequence: " << buffer->metadata().sequence << std::endl
+	       << "    timestamp: " << timestamp << std::endl;
+
+	writeControls(index_, "controls", request->controls());
+	writeControls(index_, "metadata", metadata);
+
+	index_.flush();
+}
@@ -0,0 +1,30 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Recording index writer
+ */
+
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <sys/types.h>
+
+#include <libcamera/framebuffer.h>
+#include <libcamera/request.h>
+#include <libcamera/stream.h>
+
+class RecordingWriter
+{
+public:
+	int open(const std::string &path,
+		 const libcamera::StreamConfiguration &config);
+
+	void write(const libcamera::FrameBuffer *buffer,
+		   libcamera::Request *request,
+		   const std::string &filename, off_t offset);
+
+private:
+	std::ofstream index_;
+};
@@ -129,7 +129,8 @@ struct GstLibcameraSrcState {
 	guint group_id_;
 	GstCameraControls controls_;
 
-	int queueRequest();
+	int createRequest(std::unique_ptr<RequestWrap> *wrap);
+	int queueRequests();
 	void requestCompleted(Request *request);
 	int processRequest();
 	void clearRequests();
@@ -180,7 +181,7 @@ GstStaticPadTemplate request_src_template = {
 };
 
 /* Must be called with stream_lock held. */
-int GstLibcameraSrcState::queueRequest()
+int GstLibcameraSrcState::createRequest(std::unique_ptr<RequestWrap> *wrap)
 {
 	std::unique_ptr<Request> request = cam_->createRequest();
 	if (!request)
@@ -189,8 +190,7 @@ int GstLibcameraSrcState::queueRequest()
 	/* Apply controls */
 	controls_.applyControls(request);
 
-	std::unique_ptr<RequestWrap> wrap =
-		std::make_unique<RequestWrap>(std::move(request));
+	*wrap = std::make_unique<RequestWrap>(std::move(request));
 
 	for (GstPad *srcpad : srcpads_) {
 		GstLibcameraPool *pool = gst_libcamera_pad_get_pool(srcpad);
@@ -207,18 +207,48 @@ int GstLibcameraSrcState::queueRequest()
 			return -ENOBUFS;
 		}
 
-		wrap->attachBuffer(srcpad, buffer);
+		(*wrap)->attachBuffer(srcpad, buffer);
 	}
 
-	GST_TRACE_OBJECT(src_, "Requesting buffers");
+	return 0;
+}
+
+/* Must be called with stream_lock held. */
+int GstLibcameraSrcState::queueRequests()
+{
+	std::vector<std::unique_ptr<RequestWrap>> wraps;
+	std::vector<Request *> requests;
+	int ret;
+
+	/*
+	 * Create as many requests as buffers are available, and queue them to
+	 * the camera in a single batch.
+	 */
+	while (true) {
+		std::unique_ptr<RequestWrap> wrap;
+
+		ret = createRequest(&wrap);
+		if (ret)
+			break;
+
+		requests.push_back(wrap->request_.get());
+		wraps.push_back(std::move(wrap));
+	}
+
+	if (wraps.empty())
+		return ret;
+
+	GST_TRACE_OBJECT(src_, "Requesting buffers for %zu requests",
+			 requests.size());
 
 	{
 		GLibLocker locker(&lock_);
-		cam_->queueRequest(wrap->request_.get());
-		queuedRequests_.push(std::move(wrap));
+		cam_->queueRequests(requests);
+		for (std::unique_ptr<RequestWrap> &wrap : wraps)
+			queuedRequests_.push(std::move(wrap));
 	}
 
-	/* The RequestWrap will be deleted in the completion handler. */
+	/* The RequestWrap instances will be deleted in the completion handler. */
 	return 0;
 }
 
@@ -760,16 +790,16 @@ gst_libcamera_src_task_run(gpointer user_data)
 	}
 
 	/*
-	 * Create and queue one request. If no buffers are available the
-	 * function returns -ENOBUFS, which we ignore here as that's not a
-	 * fatal error.
+	 * Create and queue requests for all available buffers. If no buffers
+	 * are available the function returns -ENOBUFS, which we ignore here as
+	 * that's not a fatal error.
 	 */
-	int ret = state->queueRequest();
+	int ret = state->queueRequests();
 	switch (ret) {
 	case 0:
 		/*
-		 * The request was successfully queued, there may be enough
-		 * buffers to create a new one. Don't pause the task to give it
+		 * Requests were successfully queued, more buffers may have been
+		 * released in the meantime. Don't pause the task to give it
 		 * another try.
 		 */
 		doResume = true;
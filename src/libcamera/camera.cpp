@@ -7,6 +7,7 @@
 
 #include <libcamera/camera.h>
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <ios>
@@ -589,7 +590,8 @@ CameraConfiguration::Status CameraConfiguration::validateColorSpaces(ColorSpaceF
  */
 Camera::Private::Private(PipelineHandler *pipe)
 	: controlInfo_({}, controls::controls), properties_(properties::properties),
-	  requestSequence_(0), pipe_(pipe->shared_from_this()),
+	  requestSequence_(0), queueDepth_(0), queueStableCount_(0),
+	  pipe_(pipe->shared_from_this()),
 	  disconnected_(false), state_(CameraAvailable)
 {
 }
@@ -748,6 +750,52 @@ void Camera::Private::setState(State state)
 }
 #endif /* __DOXYGEN_PUBLIC__ */
 
+/**
+ * \struct RequestQueueStatistics
+ * \brief Statistics about the flow of requests through a camera
+ *
+ * Requests queued by the application wait in the camera until they are
+ * prepared, which includes waiting for the fences of their buffers, and until
+ * the number of requests queued to the device drops below the queue depth.
+ * The RequestQueueStatistics structure records how deep the device queue was,
+ * how long requests waited, and how often the device ran out of requests.
+ *
+ * Histograms of durations use logarithmic buckets: bucket 0 counts durations
+ * shorter than 1µs, and bucket n counts durations in the [2^(n-1), 2^n[ µs
+ * range. The last bucket of all histograms also counts all larger values.
+ *
+ * \var RequestQueueStatistics::kHistogramSize
+ * \brief The number of buckets in the histograms
+ *
+ * \typedef RequestQueueStatistics::Histogram
+ * \brief A histogram of kHistogramSize buckets
+ *
+ * \var RequestQueueStatistics::queuedRequests
+ * \brief The number of requests queued to the device
+ *
+ * \var RequestQueueStatistics::underruns
+ * \brief The number of times a request was queued to the device after the
+ * device ran out of requests
+ *
+ * \var RequestQueueStatistics::droppedFrames
+ * \brief The number of sensor frames missing in the sequence numbers of
+ * completed requests
+ *
+ * \var RequestQueueStatistics::queueDepth
+ * \brief The current maximum number of requests queued to the device
+ *
+ * \var RequestQueueStatistics::depthHistogram
+ * \brief Histogram of the number of requests already queued to the device when
+ * queuing a new request
+ *
+ * \var RequestQueueStatistics::prepareTimeHistogram
+ * \brief Histogram of the time spent by requests waiting to be prepared
+ *
+ * \var RequestQueueStatistics::waitTimeHistogram
+ * \brief Histogram of the time spent by prepared requests waiting for the
+ * device queue to have room for them
+ */
+
 /**
  * \class Camera
  * \brief Camera device
@@ -907,6 +955,35 @@ const std::string &Camera::id() const
  * \var Camera::bufferCompleted
  * \brief Signal emitted when a buffer for a request queued to the camera has
  * completed
+ *
+ * Buffers are delivered as soon as they complete, independently for each
+ * stream, before the request they belong to completes. Applications can
+ * use the buffer immediately, for instance to display a viewfinder stream
+ * while other streams of the same request are still being processed.
+ */
+
+/**
+ * \var Camera::metadataAvailable
+ * \brief Signal emitted when metadata for a request queued to the camera is
+ * available
+ *
+ * Pipeline handlers report request metadata as soon as it becomes available,
+ * possibly in multiple parts, without waiting for the request to complete.
+ * Early metadata related to the sensor frame, such as
+ * controls::SensorTimestamp, is typically available before the image buffers
+ * complete, while metadata produced by the image processing algorithms is
+ * available later. Together with the bufferCompleted signal, this allows
+ * applications to process streams and metadata as soon as they are ready,
+ * without waiting for the slowest part of the request.
+ *
+ * The ControlList passed to the signal contains only the newly available
+ * metadata. Each control is reported at most once for a request, and all the
+ * request metadata is reported before the requestCompleted signal is emitted
+ * for successfully completed requests. The full metadata is also available
+ * from Request::metadata() at any time.
+ *
+ * Unlike the requestCompleted signal, the signal is not guaranteed to be
+ * emitted in request submission order.
  */
 
 /**
@@ -1088,6 +1165,26 @@ const ControlList &Camera::properties() const
 	return _d()->properties_;
 }
 
+/**
+ * \brief Retrieve the request queue statistics of the camera
+ *
+ * The statistics describe how requests have flowed through the camera since
+ * the first request was queued after the last call to start(). They help
+ * diagnosing frame drops caused by the device running out of requests, and
+ * tuning the number of requests queued by the application.
+ *
+ * \context This function is \threadsafe.
+ *
+ * \return The request queue statistics
+ */
+RequestQueueStatistics Camera::requestQueueStatistics() const
+{
+	const Private *const d = _d();
+
+	MutexLocker locker(d->queueStatsMutex_);
+	return d->queueStats_;
+}
+
 /**
  * \brief Retrieve all the camera's stream information
  *
@@ -1335,6 +1432,95 @@ int Camera::queueRequest(Request *request)
 	if (ret < 0)
 		return ret;
 
+	/*
+	 * The camera state may change until the end of the function. No locking
+	 * is however needed as PipelineHandler::queueRequest() will handle
+	 * this.
+	 */
+
+	ret = validateRequest(request);
+	if (ret < 0)
+		return ret;
+
+	/* Pre-process AeEnable. */
+	patchControlList(request->controls());
+
+	d->pipe_->invokeMethod(&PipelineHandler::queueRequest,
+			       ConnectionTypeQueued, request);
+
+	return 0;
+}
+
+/**
+ * \brief Queue multiple requests to the camera
+ * \param[in] requests The requests to queue to the camera
+ *
+ * This function queues a batch of \a requests to the camera for capture. It
+ * is equivalent to calling queueRequest() for each request in order, but
+ * hands all requests over to the pipeline handler at once, which reduces the
+ * per-request overhead when queuing many requests, for instance when starting
+ * the camera or after a burst of completions.
+ *
+ * All requests are validated before any of them is queued. If any request is
+ * invalid or appears multiple times in \a requests, none of the requests is
+ * queued and an error is returned.
+ *
+ * Once the requests have been queued, the camera will notify the completion of
+ * each of them through the \ref requestCompleted signal, in the order they
+ * have been queued.
+ *
+ * \context This function is \threadsafe. It may only be called when the camera
+ * is in the Running state as defined in \ref camera_operation.
+ *
+ * \return 0 on success or a negative error code otherwise
+ * \retval -ENODEV The camera has been disconnected from the system
+ * \retval -EACCES The camera is not running so requests can't be queued
+ * \retval -EXDEV A request does not belong to this camera
+ * \retval -EINVAL A request is invalid or is duplicated in \a requests
+ */
+int Camera::queueRequests(Span<Request *const> requests)
+{
+	Private *const d = _d();
+
+	int ret = d->isAccessAllowed(Private::CameraRunning);
+	if (ret < 0)
+		return ret;
+
+	for (auto it = requests.begin(); it != requests.end(); ++it) {
+		ret = validateRequest(*it);
+		if (ret < 0)
+			return ret;
+
+		/* Batches are small, a linear search is cheap enough. */
+		if (std::find(requests.begin(), it, *it) != it) {
+			LOG(Camera, Error)
+				<< (*it)->toString() << " is queued multiple times";
+			return -EINVAL;
+		}
+	}
+
+	if (requests.empty())
+		return 0;
+
+	for (Request *request : requests)
+		patchControlList(request->controls());
+
+	d->pipe_->invokeMethod(&PipelineHandler::queueRequests,
+			       ConnectionTypeQueued,
+			       std::vector<Request *>(requests.begin(), requests.end()));
+
+	return 0;
+}
+
+/**
+ * \brief Validate a request before queuing it
+ * \param[in] request The request to validate
+ * \return 0 if the request is valid or a negative error code otherwise
+ */
+int Camera::validateRequest(Request *request)
+{
+	Private *const d = _d();
+
 	/* Requests can only be queued to the camera that created them. */
 	if (request->_d()->camera() != this) {
 		LOG(Camera, Error) << "Request was not created by this camera";
@@ -1352,12 +1538,6 @@ int Camera::queueRequest(Request *request)
 		return -EINVAL;
 	}
 
-	/*
-	 * The camera state may change until the end of the function. No locking
-	 * is however needed as PipelineHandler::queueRequest() will handle
-	 * this.
-	 */
-
 	if (request->buffers().empty()) {
 		LOG(Camera, Error) << "Request contains no buffers";
 		return -EINVAL;
@@ -1370,12 +1550,6 @@ int Camera::queueRequest(Request *request)
 		}
 	}
 
-	/* Pre-process AeEnable. */
-	patchControlList(request->controls());
-
-	d->pipe_->invokeMethod(&PipelineHandler::queueRequest,
-			       ConnectionTypeQueued, request);
-
 	return 0;
 }
 
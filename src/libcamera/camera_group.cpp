@@ -0,0 +1,566 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Synchronised capture from multiple cameras
+ */
+
+#include "libcamera/internal/camera_group.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <time.h>
+
+#include <libcamera/base/log.h>
+
+#include <libcamera/camera.h>
+#include <libcamera/control_ids.h>
+#include <libcamera/framebuffer.h>
+#include <libcamera/request.h>
+
+/**
+ * \file camera_group.h
+ * \brief Synchronised capture from multiple cameras
+ */
+
+namespace libcamera {
+
+LOG_DEFINE_CATEGORY(CameraGroup)
+
+namespace {
+
+int64_t currentTime()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+} /* namespace */
+
+/**
+ * \class CameraGroup
+ * \brief Capture synchronised sets of frames from multiple cameras
+ *
+ * Applications that capture from several cameras simultaneously, such as
+ * stereo or surround view systems, need to process frames captured at the
+ * same time together. The CameraGroup class groups multiple cameras, starts
+ * and stops them together, and pairs their completed requests based on the
+ * SensorTimestamp metadata to deliver matched sets of requests.
+ *
+ * The cameras shall be acquired and configured by the application before
+ * the group is started. Once started, the application queues requests to each
+ * camera individually as usual. Completed requests are not reported to the
+ * application through the Camera::requestCompleted signal of each camera
+ * anymore, but through the requestSetCompleted signal, which delivers one
+ * request per camera, in the order of the cameras in the group. The
+ * application shall not connect to the Camera::requestCompleted signal of the
+ * grouped cameras.
+ *
+ * Two requests are considered to match if their sensor timestamps differ by
+ * no more than the tolerance set with setTolerance(). Requests that can't be
+ * matched with a request from every other camera of the group are handled
+ * according to the drop policy set with setDropPolicy().
+ *
+ * To decide whether a request can still be matched while a camera hasn't
+ * completed the corresponding request yet, the group models the delay between
+ * the sensor timestamp and the request completion time of every camera with a
+ * ClockRecovery instance. Once a camera is late past the expected completion
+ * time of a matching frame, the request is considered unmatched. The number
+ * of completed requests waiting for a match is also bounded per camera, to
+ * avoid stalling the other cameras when a camera stops delivering frames.
+ *
+ * Sensor timestamps are compared directly, and thus need to be expressed in
+ * the same clock domain for all cameras of the group. The SensorTimestamp
+ * control specifies CLOCK_BOOTTIME, but not all pipeline handlers comply yet.
+ * Many of them report the V4L2 buffer timestamp, which uses CLOCK_MONOTONIC.
+ * The two clocks diverge by the time the system has spent suspended. Grouping
+ * cameras from pipeline handlers using different clocks is thus not supported.
+ */
+
+/**
+ * \enum CameraGroup::DropPolicy
+ * \brief Policy for handling requests that can't be matched
+ * \var CameraGroup::DropUnmatched
+ * \brief Return unmatched requests through the requestDropped signal
+ * \var CameraGroup::DeliverPartial
+ * \brief Deliver unmatched requests in partial sets through the
+ * requestSetCompleted signal, with null entries for the missing cameras.
+ * Cancelled requests are still returned through the requestDropped signal
+ */
+
+/**
+ * \struct CameraGroup::Statistics
+ * \brief Synchronisation statistics of a camera group
+ *
+ * \var CameraGroup::Statistics::completeSets
+ * \brief Number of sets delivered with a request from every camera
+ *
+ * \var CameraGroup::Statistics::partialSets
+ * \brief Number of sets delivered with requests missing for some cameras
+ *
+ * \var CameraGroup::Statistics::droppedRequests
+ * \brief Number of requests returned through the requestDropped signal
+ *
+ * \var CameraGroup::Statistics::meanSkew
+ * \brief Mean difference between the earliest and latest sensor timestamps of
+ * complete sets
+ *
+ * \var CameraGroup::Statistics::maxSkew
+ * \brief Maximum difference between the earliest and latest sensor timestamps
+ * of complete sets
+ *
+ * \var CameraGroup::Statistics::meanLatency
+ * \brief Mean time between the completion of the first request of a set and
+ * the delivery of the set
+ *
+ * \var CameraGroup::Statistics::maxLatency
+ * \brief Maximum time between the completion of the first request of a set
+ * and the delivery of the set
+ */
+
+/**
+ * \class CameraGroup::Private
+ * \brief Private data of the CameraGroup class
+ */
+
+CameraGroup::Private::Private()
+	: tolerance_(kDefaultTolerance), policy_(DropPolicy::DropUnmatched),
+	  running_(false), totalSkew_(0), totalLatency_(0)
+{
+}
+
+/**
+ * \brief Handle the completion of a request by a camera of the group
+ * \param[in] index The index of the camera in the group
+ * \param[in] request The completed request
+ */
+void CameraGroup::Private::requestCompleted(unsigned int index, Request *request)
+{
+	std::vector<Delivery> deliveries;
+	int64_t now = currentTime();
+
+	{
+		MutexLocker locker(mutex_);
+
+		if (request->status() == Request::RequestCancelled) {
+			std::vector<Request *> requests(states_.size(), nullptr);
+			requests[index] = request;
+			deliveries.push_back({ std::move(requests), false, true });
+		} else {
+			CameraState &state = states_[index];
+			int64_t timestamp;
+
+			const auto sensorTimestamp =
+				request->metadata().get(controls::SensorTimestamp);
+			if (sensorTimestamp)
+				timestamp = *sensorTimestamp;
+			else
+				timestamp = request->buffers().begin()->second->metadata().timestamp;
+
+			state.clock.addSample(timestamp, now);
+			state.clockSamples++;
+
+			state.pending.push_back({ request, timestamp, now });
+		}
+
+		matchRequests(now, false, &deliveries);
+	}
+
+	deliver(deliveries);
+}
+
+/*
+ * Check if a camera may still complete a request matching \a timestamp. This
+ * is the case if the expected completion time of a frame captured at the end
+ * of the tolerance window hasn't passed yet, with a margin equal to the
+ * tolerance to account for jitter. Until the completion delay model has
+ * settled, assume a match may still come.
+ */
+bool CameraGroup::Private::canMatch(const CameraState &state, int64_t timestamp,
+				    int64_t now) const
+{
+	if (state.clockSamples < kMinClockSamples)
+		return true;
+
+	int64_t deadline = state.clock.getOutput(timestamp + tolerance_.count()) +
+			   tolerance_.count();
+
+	return now <= deadline;
+}
+
+void CameraGroup::Private::matchRequests(int64_t now, bool flush,
+					 std::vector<Delivery> *deliveries)
+{
+	int64_t tolerance = tolerance_.count();
+
+	while (true) {
+		/* Find the oldest pending request across all cameras. */
+		const PendingRequest *oldest = nullptr;
+		bool overflow = false;
+
+		for (const CameraState &state : states_) {
+			if (state.pending.empty())
+				continue;
+
+			if (!oldest || state.pending.front().timestamp < oldest->timestamp)
+				oldest = &state.pending.front();
+
+			if (state.pending.size() > kMaxPendingRequests)
+				overflow = true;
+		}
+
+		if (!oldest)
+			return;
+
+		/*
+		 * Gather the requests matching the oldest one. As requests
+		 * complete in order for each camera, a camera whose oldest
+		 * pending request is outside of the tolerance window will never
+		 * deliver a match.
+		 */
+		int64_t timestamp = oldest->timestamp;
+		bool complete = true;
+		bool waiting = false;
+
+		for (const CameraState &state : states_) {
+			if (!state.pending.empty()) {
+				if (state.pending.front().timestamp > timestamp + tolerance)
+					complete = false;
+				continue;
+			}
+
+			complete = false;
+			if (canMatch(state, timestamp, now))
+				waiting = true;
+		}
+
+		if (!complete && waiting && !overflow && !flush)
+			return;
+
+		Delivery delivery{ std::vector<Request *>(states_.size(), nullptr),
+				   complete, false };
+		int64_t minTimestamp = timestamp;
+		int64_t maxTimestamp = timestamp;
+		int64_t firstCompletion = now;
+
+		for (unsigned int i = 0; i < states_.size(); ++i) {
+			std::deque<PendingRequest> &queue = states_[i].pending;
+			if (queue.empty())
+				continue;
+
+			const PendingRequest &pending = queue.front();
+			if (pending.timestamp > timestamp + tolerance)
+				continue;
+
+			delivery.requests[i] = pending.request;
+			maxTimestamp = std::max(maxTimestamp, pending.timestamp);
+			firstCompletion = std::min(firstCompletion, pending.completionTime);
+
+			queue.pop_front();
+		}
+
+		if (complete) {
+			int64_t skew = maxTimestamp - minTimestamp;
+			int64_t latency = now - firstCompletion;
+
+			stats_.completeSets++;
+			totalSkew_ += skew;
+			totalLatency_ += latency;
+			stats_.maxSkew = std::max(stats_.maxSkew, std::chrono::nanoseconds(skew));
+			stats_.maxLatency = std::max(stats_.maxLatency,
+						     std::chrono::nanoseconds(latency));
+		} else {
+			LOG(CameraGroup, Debug)
+				<< "Unmatched requests at timestamp " << timestamp;
+		}
+
+		deliveries->push_back(std::move(delivery));
+	}
+}
+
+void CameraGroup::Private::deliver(std::vector<Delivery> &deliveries)
+{
+	CameraGroup *const o = _o<CameraGroup>();
+
+	if (deliveries.empty())
+		return;
+
+	DropPolicy policy;
+
+	{
+		MutexLocker locker(mutex_);
+
+		policy = policy_;
+
+		for (const Delivery &delivery : deliveries) {
+			if (delivery.complete)
+				continue;
+
+			if (!delivery.cancelled && policy == DropPolicy::DeliverPartial)
+				stats_.partialSets++;
+			else
+				stats_.droppedRequests +=
+					std::count_if(delivery.requests.begin(),
+						      delivery.requests.end(),
+						      [](Request *r) { return r; });
+		}
+	}
+
+	for (const Delivery &delivery : deliveries) {
+		if (delivery.complete ||
+		    (!delivery.cancelled && policy == DropPolicy::DeliverPartial)) {
+			o->requestSetCompleted.emit(delivery.requests);
+			continue;
+		}
+
+		for (Request *request : delivery.requests) {
+			if (request)
+				o->requestDropped.emit(request);
+		}
+	}
+}
+
+/**
+ * \brief Construct a group of cameras
+ * \param[in] cameras The cameras to group
+ *
+ * The order of the \a cameras determines the order of the requests in the sets
+ * delivered through the requestSetCompleted signal.
+ */
+CameraGroup::CameraGroup(Span<const std::shared_ptr<Camera>> cameras)
+	: Extensible(std::make_unique<Private>())
+{
+	Private *const d = _d();
+
+	d->cameras_.assign(cameras.begin(), cameras.end());
+}
+
+CameraGroup::~CameraGroup()
+{
+	if (_d()->running_)
+		stop();
+}
+
+/**
+ * \brief Retrieve the cameras of the group
+ * \return The cameras in the group, in the order they were specified at
+ * construction time
+ */
+const std::vector<std::shared_ptr<Camera>> &CameraGroup::cameras() const
+{
+	return _d()->cameras_;
+}
+
+/**
+ * \brief Set the maximum sensor timestamp difference between matched requests
+ * \param[in] tolerance The tolerance
+ *
+ * The tolerance should be smaller than half of the frame duration, to avoid
+ * ambiguous matches. It defaults to 2ms.
+ */
+void CameraGroup::setTolerance(std::chrono::nanoseconds tolerance)
+{
+	Private *const d = _d();
+
+	MutexLocker locker(d->mutex_);
+	d->tolerance_ = tolerance;
+}
+
+/**
+ * \brief Retrieve the maximum sensor timestamp difference between matched
+ * requests
+ * \return The tolerance
+ */
+std::chrono::nanoseconds CameraGroup::tolerance() const
+{
+	const Private *const d = _d();
+
+	MutexLocker locker(d->mutex_);
+	return d->tolerance_;
+}
+
+/**
+ * \brief Set the policy for requests that can't be matched
+ * \param[in] policy The drop policy
+ *
+ * The default policy is DropPolicy::DropUnmatched.
+ */
+void CameraGroup::setDropPolicy(DropPolicy policy)
+{
+	Private *const d = _d();
+
+	MutexLocker locker(d->mutex_);
+	d->policy_ = policy;
+}
+
+/**
+ * \brief Retrieve the policy for requests that can't be matched
+ * \return The drop policy
+ */
+CameraGroup::DropPolicy CameraGroup::dropPolicy() const
+{
+	const Private *const d = _d();
+
+	MutexLocker locker(d->mutex_);
+	return d->policy_;
+}
+
+/**
+ * \brief Start capture from all cameras of the group
+ * \param[in] controls Controls to be applied before starting the cameras
+ *
+ * Start all cameras of the group, in order, with the same set of \a controls.
+ * If any camera fails to start, the cameras that have already been started
+ * are stopped and an error is returned.
+ *
+ * The synchronisation statistics are reset.
+ *
+ * \return 0 on success or a negative error code otherwise
+ */
+int CameraGroup::start(const ControlList *controls)
+{
+	Private *const d = _d();
+
+	if (d->running_)
+		return -EBUSY;
+
+	if (d->cameras_.empty())
+		return -EINVAL;
+
+	{
+		MutexLocker locker(d->mutex_);
+
+		d->states_.clear();
+		for (const std::shared_ptr<Camera> &camera : d->cameras_) {
+			Private::CameraState &state =
+				d->states_.emplace_back(Private::CameraState{ camera, {}, {}, 0 });
+
+			/*
+			 * The completion delay jitters by much more than the
+			 * wall clock drift ClockRecovery is tuned for by
+			 * default. Allow for scheduling delays of a few
+			 * milliseconds.
+			 */
+			state.clock.configure(100, 2000000, Private::kMinClockSamples,
+					      20000000);
+		}
+
+		d->stats_ = {};
+		d->totalSkew_ = 0;
+		d->totalLatency_ = 0;
+	}
+
+	for (unsigned int i = 0; i < d->cameras_.size(); ++i) {
+		d->cameras_[i]->requestCompleted.connect(d, [d, i](Request *request) {
+			d->requestCompleted(i, request);
+		});
+	}
+
+	for (auto it = d->cameras_.begin(); it != d->cameras_.end(); ++it) {
+		int ret = (*it)->start(controls);
+		if (ret < 0) {
+			LOG(CameraGroup, Error)
+				<< "Failed to start camera " << (*it)->id();
+
+			while (it != d->cameras_.begin())
+				(*--it)->stop();
+
+			for (const std::shared_ptr<Camera> &camera : d->cameras_)
+				camera->requestCompleted.disconnect(d);
+
+			return ret;
+		}
+	}
+
+	d->running_ = true;
+
+	return 0;
+}
+
+/**
+ * \brief Stop capture from all cameras of the group
+ *
+ * Stop all cameras of the group. Requests that complete while stopping, as
+ * well as requests that were waiting for a match, are delivered according to
+ * the drop policy before this function returns.
+ *
+ * \return 0 on success or a negative error code if any camera failed to stop
+ */
+int CameraGroup::stop()
+{
+	Private *const d = _d();
+	int ret = 0;
+
+	if (!d->running_)
+		return 0;
+
+	for (const std::shared_ptr<Camera> &camera : d->cameras_) {
+		int err = camera->stop();
+		if (err < 0) {
+			LOG(CameraGroup, Error)
+				<< "Failed to stop camera " << camera->id();
+			ret = err;
+		}
+	}
+
+	for (const std::shared_ptr<Camera> &camera : d->cameras_)
+		camera->requestCompleted.disconnect(d);
+
+	std::vector<Private::Delivery> deliveries;
+
+	{
+		MutexLocker locker(d->mutex_);
+		d->matchRequests(currentTime(), true, &deliveries);
+	}
+
+	d->deliver(deliveries);
+
+	d->running_ = false;
+
+	return ret;
+}
+
+/**
+ * \brief Retrieve the synchronisation statistics of the group
+ * \return The statistics accumulated since the group was last started
+ */
+CameraGroup::Statistics CameraGroup::statistics() const
+{
+	const Private *const d = _d();
+
+	MutexLocker locker(d->mutex_);
+
+	Statistics stats = d->stats_;
+	if (stats.completeSets) {
+		stats.meanSkew = std::chrono::nanoseconds(d->totalSkew_ / stats.completeSets);
+		stats.meanLatency = std::chrono::nanoseconds(d->totalLatency_ / stats.completeSets);
+	}
+
+	return stats;
+}
+
+/**
+ * \var CameraGroup::requestSetCompleted
+ * \brief Signal emitted when a set of matching requests has completed
+ *
+ * The set contains one entry per camera, in the order of the cameras in the
+ * group. When the drop policy is DropPolicy::DeliverPartial, entries for
+ * cameras that didn't produce a matching request are null.
+ *
+ * The signal is emitted from the thread that completes the requests. The set
+ * is only valid for the duration of the signal emission.
+ */
+
+/**
+ * \var CameraGroup::requestDropped
+ * \brief Signal emitted when a request couldn't be matched
+ *
+ * Cancelled requests are returned to the application through this signal,
+ * regardless of the drop policy, so that they can be reused. When the drop
+ * policy is DropPolicy::DropUnmatched, requests that can't be matched with
+ * requests from all other cameras are returned through this signal as well.
+ */
+
+} /* namespace libcamera */
@@ -7,6 +7,8 @@
 
 #include "libcamera/internal/camera_manager.h"
 
+#include <chrono>
+
 #include <libcamera/base/log.h>
 #include <libcamera/base/utils.h>
 
@@ -15,6 +17,7 @@
 
 #include "libcamera/internal/camera.h"
 #include "libcamera/internal/device_enumerator.h"
+#include "libcamera/internal/dma_buf_allocator.h"
 #include "libcamera/internal/global_configuration.h"
 #include "libcamera/internal/ipa_manager.h"
 #include "libcamera/internal/pipeline_handler.h"
@@ -94,15 +97,39 @@ void CameraManager::Private::run()
 int CameraManager::Private::init()
 {
 	CameraManager *const o = LIBCAMERA_O_PTR();
+
+	/* Measure the duration of the startup phases to report them. */
+	const auto start = std::chrono::steady_clock::now();
+
+	const unsigned int poolSize =
+		configuration().option<unsigned int>({ "dma_buf_pool", "max_size" })
+			.value_or(0);
+	DmaBufPool::instance()->setMaxSize(static_cast<std::size_t>(poolSize) << 20);
+
 	ipaManager_ = std::make_unique<IPAManager>(*o);
 
+	const auto ipaDone = std::chrono::steady_clock::now();
+
 	enumerator_ = DeviceEnumerator::create();
 	if (!enumerator_ || enumerator_->enumerate())
 		return -ENODEV;
 
+	const auto enumerationDone = std::chrono::steady_clock::now();
+
 	createPipelineHandlers();
 	enumerator_->devicesAdded.connect(this, &Private::createPipelineHandlers);
 
+	const auto matchDone = std::chrono::steady_clock::now();
+
+	LOG(Camera, Debug)
+		<< "Startup timings: IPA modules "
+		<< utils::Duration(ipaDone - start)
+		<< ", device enumeration "
+		<< utils::Duration(enumerationDone - ipaDone)
+		<< ", pipeline handlers matching "
+		<< utils::Duration(matchDone - enumerationDone)
+		<< ", total " << utils::Duration(matchDone - start);
+
 	return 0;
 }
 
@@ -154,6 +181,7 @@ void CameraManager::Private::createPipelineHandlers()
 void CameraManager::Private::pipelineFactoryMatch(const PipelineHandlerFactoryBase *factory)
 {
 	CameraManager *const o = LIBCAMERA_O_PTR();
+	const auto start = std::chrono::steady_clock::now();
 
 	/* Provide as many matching pipelines as possible. */
 	while (1) {
@@ -165,6 +193,11 @@ void CameraManager::Private::pipelineFactoryMatch(const PipelineHandlerFactoryBa
 			<< "Pipeline handler \"" << factory->name()
 			<< "\" matched";
 	}
+
+	LOG(Camera, Debug)
+		<< "Pipeline handler \"" << factory->name()
+		<< "\" matching took "
+		<< utils::Duration(std::chrono::steady_clock::now() - start);
 }
 
 void CameraManager::Private::cleanup()
@@ -216,7 +216,7 @@ void ClockRecovery::addSample(uint64_t input, uint64_t output)
  *
  * \return Output clock value
  */
-uint64_t ClockRecovery::getOutput(uint64_t input)
+uint64_t ClockRecovery::getOutput(uint64_t input) const
 {
 	double x = static_cast<int64_t>(input - inputBase_);
 	double y = slope_ * x + offset_;
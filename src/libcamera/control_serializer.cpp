@@ -9,10 +9,12 @@
 
 #include <algorithm>
 #include <memory>
+#include <sstream>
 #include <vector>
 
 #include <libcamera/base/log.h>
 #include <libcamera/base/span.h>
+#include <libcamera/base/utils.h>
 
 #include <libcamera/control_ids.h>
 #include <libcamera/controls.h>
@@ -31,6 +33,20 @@ namespace libcamera {
 
 LOG_DEFINE_CATEGORY(Serializer)
 
+namespace {
+
+enum ipa_controls_id_map_type idMapType(const ControlIdMap *idmap)
+{
+	if (idmap == &controls::controls)
+		return IPA_CONTROL_ID_MAP_CONTROLS;
+	else if (idmap == &properties::properties)
+		return IPA_CONTROL_ID_MAP_PROPERTIES;
+	else
+		return IPA_CONTROL_ID_MAP_V4L2;
+}
+
+} /* namespace */
+
 /**
  * \class ControlSerializer
  * \brief Serializer and deserializer for control-related classes
@@ -77,6 +93,27 @@ LOG_DEFINE_CATEGORY(Serializer)
  * that constraint results in serialization or deserialization failure of the
  * ControlList.
  *
+ * Control lists that are transferred repeatedly, such as per-frame metadata,
+ * can additionally be serialized as part of a delta session, identified by a
+ * non-zero session number. The serializer then records the contents of the
+ * last list serialized in the session, and only stores the controls that have
+ * been added, modified or removed since then. The deserializer keeps the
+ * corresponding state on the other side of the IPC boundary, and reconstructs
+ * the full control list from the differences. Each packet carries a generation
+ * number that the deserializer uses to verify that no packet has been missed.
+ * The serializer falls back to a full synchronization packet when the session
+ * is new or has been invalidated, when the ControlInfoMap associated with the
+ * list changes, and when the differences would not be smaller than the full
+ * list.
+ *
+ * A deserializer that misses or rejects a packet can't reconstruct the full
+ * lists of the session anymore. Until the session is resynchronized, it returns
+ * partial lists that only contain the controls carried by the delta packets,
+ * and logs the controls that have been dropped. As the serializer isn't
+ * notified of deserialization failures, it also sends a full synchronization
+ * packet after every 30 delta packets, which bounds the number of partial lists
+ * after an error.
+ *
  * The serializer can be reset() to clear its internal state. This may be
  * performed when reconfiguring an IPA to avoid constant growth of the internal
  * state, especially if the contents of the ControlInfoMap instances change at
@@ -130,7 +167,8 @@ ControlSerializer::ControlSerializer(Role role)
  * \brief Reset the serializer
  *
  * Reset the internal state of the serializer. This invalidates all the
- * ControlList and ControlInfoMap that have been previously deserialized.
+ * ControlList and ControlInfoMap that have been previously deserialized, as
+ * well as all delta sessions.
  */
 void ControlSerializer::reset()
 {
@@ -140,6 +178,8 @@ void ControlSerializer::reset()
 	infoMaps_.clear();
 	controlIds_.clear();
 	controlIdMaps_.clear();
+	txSessions_.clear();
+	rxSessions_.clear();
 }
 
 size_t ControlSerializer::binarySize(const ControlValue &value)
@@ -177,7 +217,8 @@ size_t ControlSerializer::binarySize(const ControlInfoMap &infoMap)
  * \param[in] list The control list
  *
  * Compute and return the size in bytes required to store the serialized
- * ControlList.
+ * ControlList. The size is also an upper bound of the size of the ControlList
+ * when serialized as part of a delta session.
  *
  * \return The size in bytes required to store the serialized ControlList
  */
@@ -238,15 +279,6 @@ int ControlSerializer::serialize(const ControlInfoMap &infoMap,
 	for (const auto &ctrl : infoMap)
 		valuesSize += binarySize(ctrl.second);
 
-	const ControlIdMap *idmap = &infoMap.idmap();
-	enum ipa_controls_id_map_type idMapType;
-	if (idmap == &controls::controls)
-		idMapType = IPA_CONTROL_ID_MAP_CONTROLS;
-	else if (idmap == &properties::properties)
-		idMapType = IPA_CONTROL_ID_MAP_PROPERTIES;
-	else
-		idMapType = IPA_CONTROL_ID_MAP_V4L2;
-
 	/* Prepare the packet header. */
 	struct ipa_controls_header hdr;
 	hdr.version = IPA_CONTROLS_FORMAT_VERSION;
@@ -254,7 +286,10 @@ int ControlSerializer::serialize(const ControlInfoMap &infoMap,
 	hdr.entries = infoMap.size();
 	hdr.size = sizeof(hdr) + entriesSize + valuesSize;
 	hdr.data_offset = sizeof(hdr) + entriesSize;
-	hdr.id_map_type = idMapType;
+	hdr.id_map_type = idMapType(&infoMap.idmap());
+	hdr.session = 0;
+	hdr.flags = 0;
+	hdr.generation = 0;
 
 	buffer.write(&hdr);
 
@@ -307,6 +342,29 @@ int ControlSerializer::serialize(const ControlInfoMap &infoMap,
 	return 0;
 }
 
+int ControlSerializer::infoMapHandle(const ControlList &list,
+				     unsigned int *handle) const
+{
+	/*
+	 * Find the ControlInfoMap handle for the ControlList if it has one, or
+	 * use 0 for ControlList without a ControlInfoMap.
+	 */
+	if (!list.infoMap()) {
+		*handle = 0;
+		return 0;
+	}
+
+	auto iter = infoMapHandles_.find(list.infoMap());
+	if (iter == infoMapHandles_.end()) {
+		LOG(Serializer, Error)
+			<< "Can't serialize ControlList: unknown ControlInfoMap";
+		return -ENOENT;
+	}
+
+	*handle = iter->second;
+	return 0;
+}
+
 /**
  * \brief Serialize a ControlList in a buffer
  * \param[in] list The control list to serialize
@@ -322,32 +380,10 @@ int ControlSerializer::serialize(const ControlInfoMap &infoMap,
 int ControlSerializer::serialize(const ControlList &list,
 				 ByteStreamBuffer &buffer)
 {
-	/*
-	 * Find the ControlInfoMap handle for the ControlList if it has one, or
-	 * use 0 for ControlList without a ControlInfoMap.
-	 */
-	unsigned int infoMapHandle;
-	if (list.infoMap()) {
-		auto iter = infoMapHandles_.find(list.infoMap());
-		if (iter == infoMapHandles_.end()) {
-			LOG(Serializer, Error)
-				<< "Can't serialize ControlList: unknown ControlInfoMap";
-			return -ENOENT;
-		}
-
-		infoMapHandle = iter->second;
-	} else {
-		infoMapHandle = 0;
-	}
-
-	const ControlIdMap *idmap = list.idMap();
-	enum ipa_controls_id_map_type idMapType;
-	if (idmap == &controls::controls)
-		idMapType = IPA_CONTROL_ID_MAP_CONTROLS;
-	else if (idmap == &properties::properties)
-		idMapType = IPA_CONTROL_ID_MAP_PROPERTIES;
-	else
-		idMapType = IPA_CONTROL_ID_MAP_V4L2;
+	unsigned int handle;
+	int ret = infoMapHandle(list, &handle);
+	if (ret)
+		return ret;
 
 	size_t entriesSize = list.size() * sizeof(struct ipa_control_list_entry);
 	size_t valuesSize = 0;
@@ -357,11 +393,14 @@ int ControlSerializer::serialize(const ControlList &list,
 	/* Prepare the packet header. */
 	struct ipa_controls_header hdr;
 	hdr.version = IPA_CONTROLS_FORMAT_VERSION;
-	hdr.handle = infoMapHandle;
+	hdr.handle = handle;
 	hdr.entries = list.size();
 	hdr.size = sizeof(hdr) + entriesSize + valuesSize;
 	hdr.data_offset = sizeof(hdr) + entriesSize;
-	hdr.id_map_type = idMapType;
+	hdr.id_map_type = idMapType(list.idMap());
+	hdr.session = 0;
+	hdr.flags = 0;
+	hdr.generation = 0;
 
 	buffer.write(&hdr);
 
@@ -387,6 +426,150 @@ int ControlSerializer::serialize(const ControlList &list,
 	return 0;
 }
 
+/**
+ * \brief Serialize a ControlList in a buffer as part of a delta session
+ * \param[in] list The control list to serialize
+ * \param[in] session The delta session number
+ * \param[in] buffer The memory buffer where to serialize the ControlList
+ *
+ * Serialize the \a list into the \a buffer using the serialization format
+ * defined by the IPA context interface in ipa_controls.h, storing only the
+ * differences with the list previously serialized in the same \a session when
+ * possible. The \a session number shall be non-zero and fit in 16 bits, and
+ * shall be used for a single stream of control lists. The deserializer
+ * reconstructs the full \a list.
+ *
+ * The serialized data is never larger than binarySize(const ControlList &).
+ * Its exact size is reported by the buffer offset after serialization.
+ *
+ * Control lists without a ControlIdMap can't be reconstructed by the
+ * deserializer, and are serialized without using the session.
+ *
+ * \return 0 on success, a negative error code otherwise
+ * \retval -ENOENT The ControlList is related to an unknown ControlInfoMap
+ * \retval -ENOSPC Not enough space is available in the buffer
+ */
+int ControlSerializer::serialize(const ControlList &list, unsigned int session,
+				 ByteStreamBuffer &buffer)
+{
+	ASSERT(session > 0 && session <= UINT16_MAX);
+
+	DeltaSession &state = txSessions_[session];
+
+	if (!list.idMap()) {
+		state.valid = false;
+		return serialize(list, buffer);
+	}
+
+	unsigned int handle;
+	int ret = infoMapHandle(list, &handle);
+	if (ret)
+		return ret;
+
+	/*
+	 * Collect the controls that have been added or modified since the
+	 * previous packet of the session, as well as the controls that have
+	 * been removed.
+	 */
+	std::vector<ControlList::const_iterator> changed;
+	std::vector<unsigned int> removed;
+	size_t valuesSize = 0;
+
+	bool sync = !state.valid || state.handle != handle ||
+		    state.idmap != list.idMap() || state.deltas >= kSyncInterval;
+	if (!sync) {
+		for (auto iter = list.begin(); iter != list.end(); ++iter) {
+			auto prev = state.values.find(iter->first);
+			if (prev != state.values.end() && prev->second == iter->second)
+				continue;
+
+			changed.push_back(iter);
+			valuesSize += binarySize(iter->second);
+		}
+
+		for (const auto &[id, value] : state.values) {
+			if (!list.contains(id))
+				removed.push_back(id);
+		}
+
+		size_t size = sizeof(struct ipa_controls_header)
+			    + (changed.size() + removed.size())
+			    * sizeof(struct ipa_control_list_entry)
+			    + valuesSize;
+		sync = size >= binarySize(list);
+	}
+
+	if (sync) {
+		changed.clear();
+		removed.clear();
+		valuesSize = 0;
+
+		for (auto iter = list.begin(); iter != list.end(); ++iter) {
+			changed.push_back(iter);
+			valuesSize += binarySize(iter->second);
+		}
+	}
+
+	size_t numEntries = changed.size() + removed.size();
+	size_t entriesSize = numEntries * sizeof(struct ipa_control_list_entry);
+
+	/* Prepare the packet header. */
+	struct ipa_controls_header hdr;
+	hdr.version = IPA_CONTROLS_FORMAT_VERSION;
+	hdr.handle = handle;
+	hdr.entries = numEntries;
+	hdr.size = sizeof(hdr) + entriesSize + valuesSize;
+	hdr.data_offset = sizeof(hdr) + entriesSize;
+	hdr.id_map_type = idMapType(list.idMap());
+	hdr.session = session;
+	hdr.flags = sync ? 0 : IPA_CONTROLS_FLAG_DELTA;
+	hdr.generation = state.generation + 1;
+
+	buffer.write(&hdr);
+
+	ByteStreamBuffer entries = buffer.carveOut(entriesSize);
+	ByteStreamBuffer values = buffer.carveOut(valuesSize);
+
+	for (const auto &iter : changed) {
+		struct ipa_control_list_entry entry;
+		entry.id = iter->first;
+		populateControlValueEntry(entry.value, iter->second, values.offset());
+		entries.write(&entry);
+
+		store(iter->second, values);
+	}
+
+	/* Removed controls are signalled with an empty value. */
+	for (unsigned int id : removed) {
+		struct ipa_control_list_entry entry;
+		entry.id = id;
+		populateControlValueEntry(entry.value, ControlValue(), values.offset());
+		entries.write(&entry);
+	}
+
+	if (buffer.overflow()) {
+		state.valid = false;
+		return -ENOSPC;
+	}
+
+	/* Update the session state to match the receiver's. */
+	if (sync)
+		state.values.clear();
+
+	for (const auto &iter : changed)
+		state.values.insert_or_assign(iter->first, iter->second);
+	for (unsigned int id : removed)
+		state.values.erase(id);
+
+	state.valid = true;
+	state.generation = hdr.generation;
+	state.deltas = sync ? 0 : state.deltas + 1;
+	state.handle = handle;
+	state.idmap = list.idMap();
+
+	return 0;
+}
+
 ControlValue ControlSerializer::loadControlValue(ByteStreamBuffer &buffer,
 						 ControlType type,
 						 bool isArray,
@@ -559,7 +742,8 @@ ControlInfoMap ControlSerializer::deserialize<ControlInfoMap>(ByteStreamBuffer &
  * \param[in] buffer The memory buffer that contains the serialized list
  *
  * Re-construct a ControlList from a binary \a buffer containing data
- * serialized using the serialize() function.
+ * serialized using the serialize() function. If the data belongs to a delta
+ * session, the full ControlList is reconstructed from the session state.
  *
  * \return The deserialized ControlList
  */
@@ -630,6 +814,27 @@ ControlList ControlSerializer::deserialize<ControlList>(ByteStreamBuffer &buffer
 		}
 	}
 
+	/*
+	 * For delta sessions, validate the packet sequence. The state is
+	 * invalidated until the packet has been fully applied. An out of
+	 * sequence delta packet can't be applied to the state, and only the
+	 * controls it carries are returned.
+	 */
+	DeltaSession *state = nullptr;
+	bool partial = false;
+	if (hdr->session) {
+		state = &rxSessions_[hdr->session];
+
+		if (hdr->flags & IPA_CONTROLS_FLAG_DELTA) {
+			partial = !state->valid || state->handle != hdr->handle ||
+				  hdr->generation != state->generation + 1;
+		} else {
+			state->values.clear();
+		}
+
+		state->valid = false;
+	}
+
 	/*
 	 * \todo When available, initialize the list with the ControlInfoMap
 	 * so that controls can be validated against their limits.
@@ -653,9 +858,49 @@ ControlList ControlSerializer::deserialize<ControlList>(ByteStreamBuffer &buffer
 			return {};
 		}
 
-		ctrls.set(list_entry->id,
-			  loadControlValue(values, static_cast<ControlType>(entry->type),
-					   entry->is_array, entry->count));
+		ControlValue value =
+			loadControlValue(values, static_cast<ControlType>(entry->type),
+					 entry->is_array, entry->count);
+
+		if (!state) {
+			ctrls.set(list_entry->id, value);
+		} else if (partial) {
+			if (value.type() != ControlTypeNone)
+				ctrls.set(list_entry->id, value);
+		} else if (value.type() == ControlTypeNone) {
+			state->values.erase(list_entry->id);
+		} else {
+			state->values.insert_or_assign(list_entry->id, std::move(value));
+		}
+	}
+
+	if (partial) {
+		std::ostringstream dropped;
+		for (const auto &[id, value] : state->values) {
+			if (ctrls.contains(id))
+				continue;
+
+			auto it = idMap->find(id);
+			if (it != idMap->end())
+				dropped << " " << it->second->name();
+			else
+				dropped << " " << utils::hex(id);
+		}
+
+		LOG(Serializer, Warning)
+			<< "Out of sequence packet for session " << hdr->session
+			<< ", dropped controls:" << dropped.str();
+
+		return ctrls;
+	}
+
+	if (state) {
+		state->valid = true;
+		state->generation = hdr->generation;
+		state->handle = hdr->handle;
+
+		for (const auto &[id, value] : state->values)
+			ctrls.set(id, value);
 	}
 
 	return ctrls;
@@ -7,6 +7,8 @@
 
 #include <libcamera/controls.h>
 
+#include <algorithm>
+#include <memory>
 #include <sstream>
 #include <string.h>
 #include <string>
@@ -156,6 +158,51 @@ ControlValue &ControlValue::operator=(const ControlValue &other)
 	return *this;
 }
 
+/**
+ * \brief Construct a ControlValue by moving the content of \a other
+ * \param[in] other The ControlValue to move content from
+ *
+ * The \a other ControlValue is left empty.
+ */
+ControlValue::ControlValue(ControlValue &&other) noexcept
+	: type_(other.type_), isArray_(other.isArray_),
+	  numElements_(other.numElements_)
+{
+	memcpy(&value_, &other.value_, sizeof(value_));
+
+	other.type_ = ControlTypeNone;
+	other.isArray_ = false;
+	other.numElements_ = 0;
+}
+
+/**
+ * \brief Replace the content of the ControlValue by moving the content of
+ * \a other
+ * \param[in] other The ControlValue to move content from
+ *
+ * The \a other ControlValue is left empty.
+ *
+ * \return The ControlValue with its content replaced with the one of \a other
+ */
+ControlValue &ControlValue::operator=(ControlValue &&other) noexcept
+{
+	if (this == &other)
+		return *this;
+
+	release();
+
+	type_ = other.type_;
+	isArray_ = other.isArray_;
+	numElements_ = other.numElements_;
+	memcpy(&value_, &other.value_, sizeof(value_));
+
+	other.type_ = ControlTypeNone;
+	other.isArray_ = false;
+	other.numElements_ = 0;
+
+	return *this;
+}
+
 /**
  * \fn ControlValue::type()
  * \brief Retrieve the data type of the value
@@ -889,6 +936,12 @@ ControlInfoMap::const_iterator ControlInfoMap::find(unsigned int id) const
  * Control lists are constructed with a map of all the controls supported by
  * their object, and an optional ControlValidator to further validate the
  * controls.
+ *
+ * Controls are stored contiguously, sorted by numerical ID. Lookups are
+ * performed with a binary search, and copying or merging lists are linear
+ * operations. The storage is retained when the list is cleared, allowing lists
+ * that are filled repeatedly, such as request metadata, to operate without
+ * memory allocation once their capacity has been reached.
  */
 
 /**
@@ -926,11 +979,20 @@ ControlList::ControlList(const ControlInfoMap &infoMap,
 			 const ControlValidator *validator)
 	: validator_(validator), idmap_(&infoMap.idmap()), infoMap_(&infoMap)
 {
+	/*
+	 * The list can't contain more controls than the info map, reserve
+	 * storage upfront to avoid reallocations.
+	 */
+	controls_.reserve(infoMap.size());
 }
 
 /**
  * \typedef ControlList::iterator
  * \brief Iterator for the controls contained within the list
+ *
+ * Controls are iterated in increasing numerical ID order. The iterator
+ * dereferences to a std::pair<const unsigned int, ControlValue>, whose control
+ * ID can't be modified.
  */
 
 /**
@@ -979,8 +1041,42 @@ ControlList::ControlList(const ControlInfoMap &infoMap,
 /**
  * \fn ControlList::clear()
  * \brief Removes all controls from the list
+ *
+ * The memory used to store the controls is not released, and is reused when
+ * controls are added to the list.
  */
 
+/**
+ * \fn ControlList::reserve()
+ * \brief Reserve storage for controls
+ * \param[in] size The number of controls to reserve storage for
+ *
+ * Reserve storage for at least \a size controls, avoiding memory allocations
+ * when adding controls to the list until its size exceeds \a size.
+ */
+
+ControlList::Entry &ControlList::Entry::operator=(const Entry &other)
+{
+	/* The control ID is constant, replace the whole entry. */
+	if (this != &other) {
+		std::destroy_at(&control);
+		std::construct_at(&control, other.control);
+	}
+
+	return *this;
+}
+
+ControlList::Entry &ControlList::Entry::operator=(Entry &&other) noexcept
+{
+	if (this != &other) {
+		std::destroy_at(&control);
+		std::construct_at(&control, other.control.first,
+				  std::move(other.control.second));
+	}
+
+	return *this;
+}
+
 /**
  * \enum ControlList::MergePolicy
  * \brief The policy used by the merge function
@@ -1006,8 +1102,8 @@ ControlList::ControlList(const ControlInfoMap &infoMap,
  * Only control lists created from the same ControlIdMap or ControlInfoMap may
  * be merged. Attempting to do otherwise results in undefined behaviour.
  *
- * \todo Reimplement or implement an overloaded version which internally uses
- * std::unordered_map::merge() and accepts a non-const argument.
+ * As both lists are sorted, merging is a linear operation that doesn't
+ * allocate memory when the list has enough capacity to store the result.
  */
 void ControlList::merge(const ControlList &source, MergePolicy policy)
 {
@@ -1023,15 +1119,71 @@ void ControlList::merge(const ControlList &source, MergePolicy policy)
 	 * See https://bugs.libcamera.org/show_bug.cgi?id=31 for further details
 	 */
 
+	/* Fast path for the common case of merging into an empty list. */
+	if (controls_.empty() && !validator_) {
+		controls_ = source.controls_;
+		return;
+	}
+
+	/*
+	 * Update the controls already present in the list, and count the new
+	 * controls.
+	 */
+	std::size_t added = 0;
 	for (const auto &ctrl : source) {
-		if (policy == MergePolicy::KeepExisting && contains(ctrl.first)) {
+		auto iter = std::lower_bound(controls_.begin(), controls_.end(), ctrl.first,
+					     [](const auto &entry, unsigned int id) {
+						     return entry.control.first < id;
+					     });
+		if (iter == controls_.end() || iter->control.first != ctrl.first) {
+			if (validator_ && !validator_->validate(ctrl.first)) {
+				LOG(Controls, Error)
+					<< "Control " << utils::hex(ctrl.first)
+					<< " is not valid for " << validator_->name();
+				continue;
+			}
+
+			added++;
+			continue;
+		}
+
+		if (policy == MergePolicy::KeepExisting) {
 			const ControlId *id = idmap_->at(ctrl.first);
 			LOG(Controls, Warning)
 				<< "Control " << id->name() << " not overwritten";
 			continue;
 		}
 
-		set(ctrl.first, ctrl.second);
+		iter->control.second = ctrl.second;
+	}
+
+	if (!added)
+		return;
+
+	/*
+	 * Insert the new controls by merging both lists from the end, moving
+	 * the existing controls to their final position.
+	 */
+	std::size_t pos = controls_.size();
+	controls_.resize(pos + added);
+
+	auto dst = controls_.rbegin();
+	auto src = source.controls_.rbegin();
+	auto cur = controls_.rbegin() + added;
+
+	while (added) {
+		if (cur != controls_.rend() && cur->control.first > src->control.first) {
+			*dst++ = std::move(*cur++);
+			continue;
+		}
+
+		if ((cur == controls_.rend() || cur->control.first != src->control.first) &&
+		    (!validator_ || validator_->validate(src->control.first))) {
+			*dst++ = *src;
+			added--;
+		}
+
+		src++;
 	}
 }
 
@@ -1043,7 +1195,7 @@ void ControlList::merge(const ControlList &source, MergePolicy policy)
  */
 bool ControlList::contains(unsigned int id) const
 {
-	return controls_.find(id) != controls_.end();
+	return lookup(id) != nullptr;
 }
 
 /**
@@ -1138,17 +1290,29 @@ void ControlList::set(unsigned int id, const ControlValue &value)
  * nullptr is returned in that case.
  */
 
+const ControlValue *ControlList::lookup(unsigned int id) const
+{
+	auto iter = std::lower_bound(controls_.begin(), controls_.end(), id,
+				     [](const auto &entry, unsigned int key) {
+					     return entry.control.first < key;
+				     });
+	if (iter == controls_.end() || iter->control.first != id)
+		return nullptr;
+
+	return &iter->control.second;
+}
+
 const ControlValue *ControlList::find(unsigned int id) const
 {
-	const auto iter = controls_.find(id);
-	if (iter == controls_.end()) {
+	const ControlValue *val = lookup(id);
+	if (!val) {
 		LOG(Controls, Error)
 			<< "Control " << utils::hex(id) << " not found";
 
 		return nullptr;
 	}
 
-	return &iter->second;
+	return val;
 }
 
 ControlValue *ControlList::find(unsigned int id)
@@ -1160,7 +1324,14 @@ ControlValue *ControlList::find(unsigned int id)
 		return nullptr;
 	}
 
-	return &controls_[id];
+	auto iter = std::lower_bound(controls_.begin(), controls_.end(), id,
+				     [](const auto &entry, unsigned int key) {
+					     return entry.control.first < key;
+				     });
+	if (iter == controls_.end() || iter->control.first != id)
+		iter = controls_.emplace(iter, id, ControlValue{});
+
+	return &iter->control.second;
 }
 
 } /* namespace libcamera */
@@ -68,9 +68,17 @@ LOG_DEFINE_CATEGORY(Converter)
  *
  * This searches for the entity implementing the data streaming function in the
  * media graph entities and use its device node as the converter device node.
+ *
+ * Converters that are not backed by a media device, such as software
+ * converters, pass a null \a media and have no device node.
  */
 Converter::Converter(std::shared_ptr<MediaDevice> media, Features features)
 {
+	if (!media) {
+		features_ = features;
+		return;
+	}
+
 	const std::vector<MediaEntity *> &entities = media->entities();
 	auto it = std::find_if(entities.begin(), entities.end(),
 			       [](MediaEntity *entity) {
@@ -280,7 +288,8 @@ Converter::~Converter()
 /**
  * \fn Converter::deviceNode()
  * \brief The converter device node attribute accessor
- * \return The converter device node string
+ * \return The converter device node string, or an empty string for converters
+ * not backed by a media device
  */
 
 /**
@@ -361,6 +370,38 @@ std::unique_ptr<Converter> ConverterFactoryBase::create(std::shared_ptr<MediaDev
 	return nullptr;
 }
 
+/**
+ * \brief Create an instance of the converter corresponding to a factory name
+ * \param[in] name The converter factory name
+ *
+ * This function creates converters that are not backed by a media device, such
+ * as software converters. The converter is created without a media device.
+ *
+ * \return A new instance of the converter subclass corresponding to \a name,
+ * or null if no factory matches \a name or the converter is not valid
+ */
+std::unique_ptr<Converter> ConverterFactoryBase::create(const std::string &name)
+{
+	const std::vector<ConverterFactoryBase *> &factories =
+		ConverterFactoryBase::factories();
+
+	for (const ConverterFactoryBase *factory : factories) {
+		if (factory->name_ != name)
+			continue;
+
+		LOG(Converter, Debug)
+			<< "Creating converter from " << name << " factory";
+
+		std::unique_ptr<Converter> converter = factory->createInstance(nullptr);
+		if (converter->isValid())
+			return converter;
+
+		break;
+	}
+
+	return nullptr;
+}
+
 /**
  * \brief Add a converter factory to the registry
  * \param[in] factory Factory to use to construct the converter class
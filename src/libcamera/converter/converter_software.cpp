@@ -0,0 +1,814 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * CPU based format converter
+ */
+
+#include "libcamera/internal/converter/converter_software.h"
+
+#include <algorithm>
+#include <array>
+#include <errno.h>
+#include <string.h>
+
+#include <libcamera/base/log.h>
+#include <libcamera/base/thread.h>
+
+#include <libcamera/formats.h>
+#include <libcamera/framebuffer.h>
+#include <libcamera/stream.h>
+
+#include "libcamera/internal/formats.h"
+#include "libcamera/internal/framebuffer.h"
+#include "libcamera/internal/mapped_framebuffer.h"
+#include "libcamera/internal/worker_thread.h"
+
+/**
+ * \file converter/converter_software.h
+ * \brief CPU based converter
+ */
+
+namespace libcamera {
+
+LOG_DECLARE_CATEGORY(Converter)
+
+namespace {
+
+constexpr Size kMinSize{ 16, 16 };
+constexpr Size kMaxSize{ 8192, 8192 };
+
+Size alignSize(const Size &size, Converter::Alignment align)
+{
+	Size aligned = align == Converter::Alignment::Up
+			     ? size.alignedUpTo(2, 2)
+			     : size.alignedDownTo(2, 2);
+
+	return aligned.boundedTo(kMaxSize).expandedTo(kMinSize);
+}
+
+unsigned int planeStride(const PixelFormatInfo &info, unsigned int stride,
+			 unsigned int plane)
+{
+	return stride * info.planes[plane].bytesPerGroup /
+	       info.planes[0].bytesPerGroup;
+}
+
+/*
+ * Retrieve the address and stride of all planes of a mapped frame buffer. The
+ * planes of multi-planar formats may be stored in a single frame buffer plane,
+ * in which case their offsets are computed from the format.
+ */
+bool mapPlanes(const MappedFrameBuffer &mapped, const PixelFormatInfo &info,
+	       unsigned int stride, unsigned int height,
+	       std::array<uint8_t *, 3> *planes,
+	       std::array<unsigned int, 3> *strides)
+{
+	const std::vector<Span<uint8_t>> &maps = mapped.planes();
+	const unsigned int numPlanes = info.numPlanes();
+
+	if (maps.size() != numPlanes && maps.size() != 1)
+		return false;
+
+	unsigned int offset = 0;
+	for (unsigned int i = 0; i < numPlanes; i++) {
+		unsigned int planeSize = info.planeSize(height, i, planeStride(info, stride, i));
+
+		(*strides)[i] = planeStride(info, stride, i);
+
+		if (maps.size() == numPlanes) {
+			if (maps[i].size() < planeSize)
+				return false;
+
+			(*planes)[i] = maps[i].data();
+		} else {
+			if (maps[0].size() < offset + planeSize)
+				return false;
+
+			(*planes)[i] = maps[0].data() + offset;
+			offset += planeSize;
+		}
+	}
+
+	return true;
+}
+
+} /* namespace */
+
+/*
+ * Describe the memory layout of the supported formats. For YUV formats, the
+ * samples of the Y, U and V components are stored in the planes[] planes, at
+ * offsets[] bytes from the start of the pixel group, with a distance of step[0]
+ * bytes between two luma samples and step[1] bytes between two chroma samples.
+ * For RGB formats, all components are stored in the first plane, and step[0]
+ * is the number of bytes per pixel.
+ */
+struct SoftwareConverter::Layout {
+	PixelFormat format;
+	bool rgb;
+	unsigned int hSubSampling;
+	unsigned int vSubSampling;
+	std::array<unsigned int, 3> planes;
+	std::array<unsigned int, 2> step;
+	std::array<unsigned int, 3> offsets;
+};
+
+/*
+ * Sampling tables of an output stream, computed from the input crop rectangle
+ * and the output size. They are shared with the frames being processed, to
+ * allow changing the crop rectangle while streaming.
+ */
+struct SoftwareConverter::Maps {
+	/* Input byte offsets of the samples of each output pixel */
+	std::vector<unsigned int> yOffsets;
+	std::vector<unsigned int> uOffsets;
+	std::vector<unsigned int> vOffsets;
+	/* Input line of each output line */
+	std::vector<unsigned int> lines;
+	/* The output is a plain copy of the input */
+	bool copy;
+};
+
+struct SoftwareConverter::Frame {
+	struct Output {
+		const OutputStream *stream;
+		std::shared_ptr<const Maps> maps;
+		FrameBuffer *buffer;
+		std::unique_ptr<MappedFrameBuffer> mapped;
+		std::array<uint8_t *, 3> planes;
+		std::array<unsigned int, 3> strides;
+	};
+
+	FrameBuffer *input;
+	std::unique_ptr<MappedFrameBuffer> mapped;
+	std::array<uint8_t *, 3> planes;
+	std::array<unsigned int, 3> strides;
+
+	std::vector<Output> outputs;
+
+	/* CPU access windows of the input and output dma-bufs */
+	std::vector<DmaSyncer> syncers;
+
+	std::atomic<unsigned int> pending;
+	std::atomic<bool> skipped;
+};
+
+/*
+ * Each worker thread converts a horizontal stripe of all the output frames.
+ * The last worker to complete a frame reports it to the converter.
+ */
+class SoftwareConverter::Worker : public WorkerThread
+{
+public:
+	Worker(SoftwareConverter *converter, unsigned int index)
+		: WorkerThread("SwConverter", index), converter_(converter)
+	{
+	}
+
+	void configure(unsigned int width)
+	{
+		lineBuffer_.resize(width * 3);
+	}
+
+	void process(Frame *frame)
+	{
+		if (!converter_->stopping_.load(std::memory_order_relaxed))
+			converter_->convert(*frame, index(), lineBuffer_.data());
+		else
+			frame->skipped.store(true, std::memory_order_relaxed);
+
+		if (frame->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			converter_->invokeMethod(&SoftwareConverter::frameDone,
+						 ConnectionTypeQueued, frame);
+	}
+
+private:
+	SoftwareConverter *converter_;
+	std::vector<uint8_t> lineBuffer_;
+};
+
+/**
+ * \class libcamera::SoftwareConverter
+ * \brief The software converter implements the converter interface on the CPU
+ *
+ * The SoftwareConverter is a fallback for platforms that lack a hardware
+ * converter. It converts packed, semi-planar and planar YUV input frames to
+ * YUV and RGB output frames, with cropping and nearest-neighbour scaling.
+ *
+ * Frames are processed asynchronously by a pool of worker threads, each of them
+ * handling a horizontal stripe of the output images. Output lines are produced
+ * by sampling the input line in a planar YUV 4:4:4 line buffer, and packing it
+ * to the output format. When the output format and size match the input, lines
+ * are copied instead.
+ *
+ * As the converter isn't backed by a media device, it is instantiated by name
+ * with ConverterFactoryBase::create(const std::string &).
+ */
+
+/**
+ * \brief Construct a SoftwareConverter instance
+ * \param[in] media Unused, the software converter has no media device
+ */
+SoftwareConverter::SoftwareConverter(std::shared_ptr<MediaDevice> media)
+	: Converter(media, Feature::InputCrop), inputLayout_(nullptr),
+	  inputStride_(0), stopping_(false),
+	  dmaHeap_(DmaBufAllocator::DmaBufAllocatorFlag::CmaHeap |
+		   DmaBufAllocator::DmaBufAllocatorFlag::SystemHeap |
+		   DmaBufAllocator::DmaBufAllocatorFlag::UDmaBuf)
+{
+	unsigned int threadCount = WorkerThread::idealCount(kMaxThreads);
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		workers_.push_back(std::make_unique<Worker>(this, i));
+
+	LOG(Converter, Debug)
+		<< "Software converter using " << threadCount << " threads";
+}
+
+SoftwareConverter::~SoftwareConverter() = default;
+
+/**
+ * \fn libcamera::SoftwareConverter::loadConfiguration
+ * \details \copydetails libcamera::Converter::loadConfiguration
+ */
+
+/**
+ * \fn libcamera::SoftwareConverter::isValid
+ * \details \copydetails libcamera::Converter::isValid
+ */
+
+/**
+ * \copydoc libcamera::Converter::formats
+ */
+std::vector<PixelFormat> SoftwareConverter::formats(PixelFormat input)
+{
+	const Layout *layout = findLayout(input);
+	if (!layout || layout->rgb)
+		return {};
+
+	std::vector<PixelFormat> pixelFormats;
+	for (const Layout &output : layouts())
+		pixelFormats.push_back(output.format);
+
+	return pixelFormats;
+}
+
+/**
+ * \copydoc libcamera::Converter::sizes
+ */
+SizeRange SoftwareConverter::sizes(const Size &input)
+{
+	Size max = input.alignedDownTo(2, 2).boundedTo(kMaxSize);
+	if (max.width < kMinSize.width || max.height < kMinSize.height)
+		return {};
+
+	return SizeRange(kMinSize, max, 2, 2);
+}
+
+/**
+ * \copydoc libcamera::Converter::strideAndFrameSize
+ */
+std::tuple<unsigned int, unsigned int>
+SoftwareConverter::strideAndFrameSize(const PixelFormat &pixelFormat,
+				      const Size &size)
+{
+	if (!findLayout(pixelFormat))
+		return std::make_tuple(0, 0);
+
+	const PixelFormatInfo &info = PixelFormatInfo::info(pixelFormat);
+	return std::make_tuple(info.stride(size.width, 0), info.frameSize(size));
+}
+
+/**
+ * \copydoc libcamera::Converter::adjustInputSize
+ */
+Size SoftwareConverter::adjustInputSize(const PixelFormat &pixFmt,
+					const Size &size, Alignment align)
+{
+	const Layout *layout = findLayout(pixFmt);
+	if (!layout || layout->rgb) {
+		LOG(Converter, Info)
+			<< "Unsupported pixel format " << pixFmt;
+		return {};
+	}
+
+	return alignSize(size, align);
+}
+
+/**
+ * \copydoc libcamera::Converter::adjustOutputSize
+ */
+Size SoftwareConverter::adjustOutputSize(const PixelFormat &pixFmt,
+					 const Size &size, Alignment align)
+{
+	if (!findLayout(pixFmt)) {
+		LOG(Converter, Info)
+			<< "Unsupported pixel format " << pixFmt;
+		return {};
+	}
+
+	return alignSize(size, align);
+}
+
+/**
+ * \copydoc libcamera::Converter::configure
+ */
+int SoftwareConverter::configure(const StreamConfiguration &inputCfg,
+				 const std::vector<std::reference_wrapper<const StreamConfiguration>> &outputCfgs)
+{
+	streams_.clear();
+
+	inputLayout_ = findLayout(inputCfg.pixelFormat);
+	if (!inputLayout_ || inputLayout_->rgb) {
+		LOG(Converter, Error)
+			<< "Unsupported input format " << inputCfg.pixelFormat;
+		inputLayout_ = nullptr;
+		return -EINVAL;
+	}
+
+	inputFormat_ = inputCfg.pixelFormat;
+	inputSize_ = inputCfg.size;
+	inputStride_ = inputCfg.stride;
+
+	const SizeRange outputSizes = sizes(inputSize_);
+	unsigned int maxWidth = 0;
+
+	for (const StreamConfiguration &cfg : outputCfgs) {
+		OutputStream stream;
+
+		stream.layout = findLayout(cfg.pixelFormat);
+		stream.format = cfg.pixelFormat;
+		stream.size = cfg.size;
+		std::tie(stream.stride, stream.frameSize) =
+			strideAndFrameSize(cfg.pixelFormat, cfg.size);
+
+		if (!stream.layout || !outputSizes.contains(cfg.size) ||
+		    (cfg.stride && cfg.stride != stream.stride)) {
+			LOG(Converter, Error)
+				<< "Invalid output configuration " << cfg.toString()
+				<< " stride " << cfg.stride << " for input "
+				<< inputSize_ << "-" << inputFormat_;
+			streams_.clear();
+			return -EINVAL;
+		}
+
+		stream.crop = Rectangle(inputSize_);
+		stream.maps = createMaps(stream);
+		maxWidth = std::max(maxWidth, cfg.size.width);
+
+		streams_[cfg.stream()] = std::move(stream);
+	}
+
+	for (std::unique_ptr<Worker> &worker : workers_)
+		worker->configure(maxWidth);
+
+	return 0;
+}
+
+/**
+ * \copydoc libcamera::Converter::isConfigured
+ */
+bool SoftwareConverter::isConfigured(const Stream *stream) const
+{
+	return streams_.find(stream) != streams_.end();
+}
+
+/**
+ * \copydoc libcamera::Converter::exportBuffers
+ */
+int SoftwareConverter::exportBuffers(const Stream *stream, unsigned int count,
+				     std::vector<std::unique_ptr<FrameBuffer>> *buffers)
+{
+	auto iter = streams_.find(stream);
+	if (iter == streams_.end())
+		return -EINVAL;
+
+	const OutputStream &output = iter->second;
+	const PixelFormatInfo &info = PixelFormatInfo::info(output.format);
+
+	std::vector<unsigned int> planeSizes;
+	for (unsigned int i = 0; i < info.numPlanes(); i++)
+		planeSizes.push_back(info.planeSize(output.size.height, i,
+						    planeStride(info, output.stride, i)));
+
+	return dmaHeap_.exportBuffers(count, planeSizes, buffers);
+}
+
+/**
+ * \copydoc libcamera::Converter::start
+ */
+int SoftwareConverter::start()
+{
+	stopping_.store(false, std::memory_order_relaxed);
+
+	for (std::unique_ptr<Worker> &worker : workers_)
+		worker->start();
+
+	return 0;
+}
+
+/**
+ * \copydoc libcamera::Converter::stop
+ *
+ * Frames that haven't been converted yet are completed with their buffers
+ * marked as cancelled.
+ */
+void SoftwareConverter::stop()
+{
+	stopping_.store(true, std::memory_order_relaxed);
+
+	/*
+	 * Wait for the workers to go through their queue of frames before
+	 * stopping them, and complete the frames they have reported.
+	 */
+	for (std::unique_ptr<Worker> &worker : workers_) {
+		if (worker->isRunning())
+			worker->waitIdle();
+	}
+
+	for (std::unique_ptr<Worker> &worker : workers_) {
+		worker->exit();
+		worker->wait();
+	}
+
+	Thread::current()->dispatchMessages(Message::Type::InvokeMessage, this);
+
+	ASSERT(queue_.empty());
+}
+
+/**
+ * \copydoc libcamera::Converter::validateOutput
+ */
+int SoftwareConverter::validateOutput(StreamConfiguration *cfg, bool *adjusted,
+				      Alignment align)
+{
+	if (adjusted)
+		*adjusted = false;
+
+	if (!findLayout(cfg->pixelFormat)) {
+		cfg->pixelFormat = layouts()[0].format;
+
+		if (adjusted)
+			*adjusted = true;
+
+		LOG(Converter, Info)
+			<< "Converter output pixel format adjusted to "
+			<< cfg->pixelFormat;
+	}
+
+	const Size cfgSize = cfg->size;
+	cfg->size = alignSize(cfgSize, align);
+	std::tie(cfg->stride, cfg->frameSize) =
+		strideAndFrameSize(cfg->pixelFormat, cfg->size);
+
+	if (cfg->size != cfgSize) {
+		LOG(Converter, Info)
+			<< "Converter size adjusted to "
+			<< cfg->size;
+		if (adjusted)
+			*adjusted = true;
+	}
+
+	return 0;
+}
+
+/**
+ * \copydoc libcamera::Converter::queueBuffers
+ */
+int SoftwareConverter::queueBuffers(FrameBuffer *input,
+				    const std::map<const Stream *, FrameBuffer *> &outputs,
+				    [[maybe_unused]] const V4L2Request *request)
+{
+	if (outputs.empty())
+		return -EINVAL;
+
+	for (auto [stream, buffer] : outputs) {
+		if (!buffer || !isConfigured(stream))
+			return -EINVAL;
+	}
+
+	std::unique_ptr<Frame> frame = std::make_unique<Frame>();
+	frame->input = input;
+	frame->mapped = std::make_unique<MappedFrameBuffer>(input, MappedFrameBuffer::MapFlag::Read);
+	if (!frame->mapped->isValid() ||
+	    !mapPlanes(*frame->mapped, PixelFormatInfo::info(inputFormat_),
+		       inputStride_, inputSize_.height, &frame->planes,
+		       &frame->strides)) {
+		LOG(Converter, Error) << "Failed to map input buffer";
+		return -EINVAL;
+	}
+
+	for (auto [stream, buffer] : outputs) {
+		const OutputStream &output = streams_.at(stream);
+		Frame::Output &out = frame->outputs.emplace_back();
+
+		out.stream = &output;
+		out.maps = output.maps;
+		out.buffer = buffer;
+		out.mapped = std::make_unique<MappedFrameBuffer>(buffer, MappedFrameBuffer::MapFlag::Write);
+		if (!out.mapped->isValid() ||
+		    !mapPlanes(*out.mapped, PixelFormatInfo::info(output.format),
+			       output.stride, output.size.height, &out.planes,
+			       &out.strides)) {
+			LOG(Converter, Error) << "Failed to map output buffer";
+			return -EINVAL;
+		}
+	}
+
+	/* Keep CPU access to the buffers open until the frame completes. */
+	for (const FrameBuffer::Plane &plane : input->planes())
+		frame->syncers.emplace_back(plane.fd, DmaSyncer::SyncType::Read);
+
+	for (const Frame::Output &out : frame->outputs) {
+		for (const FrameBuffer::Plane &plane : out.buffer->planes())
+			frame->syncers.emplace_back(plane.fd, DmaSyncer::SyncType::Write);
+	}
+
+	frame->pending = workers_.size();
+	frame->skipped = false;
+
+	Frame *queued = frame.get();
+	queue_.push_back(std::move(frame));
+
+	for (std::unique_ptr<Worker> &worker : workers_)
+		worker->queue(&Worker::process, queued);
+
+	return 0;
+}
+
+/**
+ * \copydoc libcamera::Converter::setInputCrop
+ *
+ * The crop rectangle is aligned to even coordinates and sizes, and takes effect
+ * from the next queued frame.
+ */
+int SoftwareConverter::setInputCrop(const Stream *stream, Rectangle *rect)
+{
+	auto iter = streams_.find(stream);
+	if (iter == streams_.end()) {
+		LOG(Converter, Error) << "Invalid output stream";
+		return -EINVAL;
+	}
+
+	OutputStream &output = iter->second;
+	const Size size = Size(rect->width, rect->height)
+				  .alignedDownTo(2, 2)
+				  .boundedTo(inputSize_)
+				  .expandedTo(kMinSize);
+	Rectangle crop = size.centeredTo(rect->center())
+				 .enclosedIn(Rectangle(inputSize_));
+	crop.x &= ~1;
+	crop.y &= ~1;
+
+	*rect = crop;
+
+	if (crop == output.crop)
+		return 0;
+
+	output.crop = crop;
+	output.maps = createMaps(output);
+
+	return 0;
+}
+
+/**
+ * \copydoc libcamera::Converter::inputCropBounds()
+ */
+std::pair<Rectangle, Rectangle> SoftwareConverter::inputCropBounds()
+{
+	return { Rectangle(kMinSize),
+		 Rectangle(inputSize_.isNull() ? kMaxSize : inputSize_) };
+}
+
+/**
+ * \copydoc libcamera::Converter::inputCropBounds(const Stream *stream)
+ */
+std::pair<Rectangle, Rectangle>
+SoftwareConverter::inputCropBounds(const Stream *stream)
+{
+	if (!isConfigured(stream)) {
+		LOG(Converter, Error) << "Invalid output stream";
+		return {};
+	}
+
+	return { Rectangle(kMinSize), Rectangle(inputSize_) };
+}
+
+Span<const SoftwareConverter::Layout> SoftwareConverter::layouts()
+{
+	static const std::array<Layout, 15> layouts = { {
+		{ formats::YUYV, false, 2, 1, { 0, 0, 0 }, { 2, 4 }, { 0, 1, 3 } },
+		{ formats::YVYU, false, 2, 1, { 0, 0, 0 }, { 2, 4 }, { 0, 3, 1 } },
+		{ formats::UYVY, false, 2, 1, { 0, 0, 0 }, { 2, 4 }, { 1, 0, 2 } },
+		{ formats::VYUY, false, 2, 1, { 0, 0, 0 }, { 2, 4 }, { 1, 2, 0 } },
+		{ formats::NV12, false, 2, 2, { 0, 1, 1 }, { 1, 2 }, { 0, 0, 1 } },
+		{ formats::NV21, false, 2, 2, { 0, 1, 1 }, { 1, 2 }, { 0, 1, 0 } },
+		{ formats::NV16, false, 2, 1, { 0, 1, 1 }, { 1, 2 }, { 0, 0, 1 } },
+		{ formats::NV61, false, 2, 1, { 0, 1, 1 }, { 1, 2 }, { 0, 1, 0 } },
+		{ formats::YUV420, false, 2, 2, { 0, 1, 2 }, { 1, 1 }, { 0, 0, 0 } },
+		{ formats::YVU420, false, 2, 2, { 0, 2, 1 }, { 1, 1 }, { 0, 0, 0 } },
+		{ formats::YUV422, false, 2, 1, { 0, 1, 2 }, { 1, 1 }, { 0, 0, 0 } },
+		{ formats::RGB888, true, 1, 1, { 0, 0, 0 }, { 3, 0 }, { 2, 1, 0 } },
+		{ formats::BGR888, true, 1, 1, { 0, 0, 0 }, { 3, 0 }, { 0, 1, 2 } },
+		{ formats::XRGB8888, true, 1, 1, { 0, 0, 0 }, { 4, 0 }, { 2, 1, 0 } },
+		{ formats::XBGR8888, true, 1, 1, { 0, 0, 0 }, { 4, 0 }, { 0, 1, 2 } },
+	} };
+
+	return layouts;
+}
+
+const SoftwareConverter::Layout *SoftwareConverter::findLayout(const PixelFormat &format)
+{
+	Span<const Layout> all = layouts();
+	auto it = std::find_if(all.begin(), all.end(),
+			       [&](const Layout &layout) {
+				       return layout.format == format;
+			       });
+	if (it == all.end())
+		return nullptr;
+
+	return &*it;
+}
+
+std::shared_ptr<const SoftwareConverter::Maps>
+SoftwareConverter::createMaps(const OutputStream &stream) const
+{
+	std::shared_ptr<Maps> maps = std::make_shared<Maps>();
+	const Rectangle &crop = stream.crop;
+	const Size &size = stream.size;
+	const Layout &in = *inputLayout_;
+
+	maps->copy = stream.format == inputFormat_ && size == inputSize_ &&
+		     crop == Rectangle(inputSize_);
+	if (maps->copy)
+		return maps;
+
+	/* Sample the input at the centre of each output pixel. */
+	maps->yOffsets.resize(size.width);
+	maps->uOffsets.resize(size.width);
+	maps->vOffsets.resize(size.width);
+
+	for (unsigned int x = 0; x < size.width; x++) {
+		unsigned int sx = crop.x + (2 * x + 1) * crop.width / (2 * size.width);
+		unsigned int cx = sx / in.hSubSampling;
+
+		maps->yOffsets[x] = sx * in.step[0] + in.offsets[0];
+		maps->uOffsets[x] = cx * in.step[1] + in.offsets[1];
+		maps->vOffsets[x] = cx * in.step[1] + in.offsets[2];
+	}
+
+	maps->lines.resize(size.height);
+
+	for (unsigned int y = 0; y < size.height; y++)
+		maps->lines[y] = crop.y + (2 * y + 1) * crop.height / (2 * size.height);
+
+	return maps;
+}
+
+void SoftwareConverter::convert(const Frame &frame, unsigned int index,
+				uint8_t *lineBuffer) const
+{
+	const unsigned int count = workers_.size();
+	const Layout &in = *inputLayout_;
+
+	for (const Frame::Output &output : frame.outputs) {
+		const OutputStream &stream = *output.stream;
+		const Maps &maps = *output.maps;
+		const Layout &out = *stream.layout;
+		const unsigned int width = stream.size.width;
+		const unsigned int height = stream.size.height;
+
+		/*
+		 * Split the frame in stripes of an even number of lines, to
+		 * produce the chroma lines of vertically subsampled formats
+		 * within a single stripe.
+		 */
+		const unsigned int yStart = (height * index / count) & ~1U;
+		const unsigned int yEnd = index == count - 1
+					? height
+					: (height * (index + 1) / count) & ~1U;
+
+		if (maps.copy) {
+			const PixelFormatInfo &info = PixelFormatInfo::info(stream.format);
+
+			for (unsigned int i = 0; i < info.numPlanes(); i++) {
+				const unsigned int sub = info.planes[i].verticalSubSampling;
+				const unsigned int length = info.stride(width, i);
+
+				for (unsigned int y = yStart / sub; y < yEnd / sub; y++)
+					memcpy(output.planes[i] + y * output.strides[i],
+					       frame.planes[i] + y * frame.strides[i],
+					       length);
+			}
+
+			continue;
+		}
+
+		uint8_t *lineY = lineBuffer;
+		uint8_t *lineU = lineY + width;
+		uint8_t *lineV = lineU + width;
+
+		for (unsigned int y = yStart; y < yEnd; y++) {
+			/* Sample the input line in the planar YUV 4:4:4 buffer. */
+			const unsigned int sy = maps.lines[y];
+			const uint8_t *srcY = frame.planes[in.planes[0]] +
+					      sy * frame.strides[in.planes[0]];
+			const uint8_t *srcU = frame.planes[in.planes[1]] +
+					      sy / in.vSubSampling * frame.strides[in.planes[1]];
+			const uint8_t *srcV = frame.planes[in.planes[2]] +
+					      sy / in.vSubSampling * frame.strides[in.planes[2]];
+
+			for (unsigned int x = 0; x < width; x++) {
+				lineY[x] = srcY[maps.yOffsets[x]];
+				lineU[x] = srcU[maps.uOffsets[x]];
+				lineV[x] = srcV[maps.vOffsets[x]];
+			}
+
+			if (out.rgb) {
+				uint8_t *dst = output.planes[0] + y * output.strides[0];
+				const unsigned int bpp = out.step[0];
+
+				/* BT.601 full range, matching the sYCC colour space. */
+				for (unsigned int x = 0; x < width; x++) {
+					const int c = lineY[x];
+					const int u = lineU[x] - 128;
+					const int v = lineV[x] - 128;
+
+					dst[out.offsets[0]] = std::clamp(c + ((359 * v) >> 8), 0, 255);
+					dst[out.offsets[1]] = std::clamp(c - ((88 * u + 183 * v) >> 8), 0, 255);
+					dst[out.offsets[2]] = std::clamp(c + ((454 * u) >> 8), 0, 255);
+					dst += bpp;
+				}
+
+				continue;
+			}
+
+			/* Pack the luma samples, and the chroma samples of co-sited pixels. */
+			uint8_t *dstY = output.planes[out.planes[0]] +
+					y * output.strides[out.planes[0]] + out.offsets[0];
+
+			for (unsigned int x = 0; x < width; x++)
+				dstY[x * out.step[0]] = lineY[x];
+
+			if (y % out.vSubSampling)
+				continue;
+
+			const unsigned int cy = y / out.vSubSampling;
+			uint8_t *dstU = output.planes[out.planes[1]] +
+					cy * output.strides[out.planes[1]] + out.offsets[1];
+			uint8_t *dstV = output.planes[out.planes[2]] +
+					cy * output.strides[out.planes[2]] + out.offsets[2];
+
+			for (unsigned int x = 0; x < width / out.hSubSampling; x++) {
+				dstU[x * out.step[1]] = lineU[x * out.hSubSampling];
+				dstV[x * out.step[1]] = lineV[x * out.hSubSampling];
+			}
+		}
+	}
+}
+
+void SoftwareConverter::frameDone(Frame *frame)
+{
+	ASSERT(!queue_.empty() && queue_.front().get() == frame);
+
+	std::unique_ptr<Frame> done = std::move(queue_.front());
+	queue_.pop_front();
+
+	const bool cancelled = done->skipped.load(std::memory_order_relaxed);
+	FrameBuffer *input = done->input;
+
+	done->syncers.clear();
+
+	for (Frame::Output &output : done->outputs) {
+		FrameBuffer *buffer = output.buffer;
+
+		/* Unmap the buffer before handing it back. */
+		output.mapped.reset();
+
+		if (cancelled) {
+			buffer->_d()->cancel();
+		} else {
+			FrameMetadata &metadata = buffer->_d()->metadata();
+			metadata.status = input->metadata().status;
+			metadata.sequence = input->metadata().sequence;
+			metadata.timestamp = input->metadata().timestamp;
+
+			Span<const FrameBuffer::Plane> planes = buffer->planes();
+			for (unsigned int i = 0; i < planes.size(); i++)
+				metadata.planes()[i].bytesused = planes[i].length;
+		}
+
+		outputBufferReady.emit(buffer);
+	}
+
+	done->mapped.reset();
+
+	if (cancelled)
+		input->_d()->cancel();
+
+	inputBufferReady.emit(input);
+}
+
+REGISTER_CONVERTER("software", SoftwareConverter, {})
+
+} /* namespace libcamera */
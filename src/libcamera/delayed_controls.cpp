@@ -7,6 +7,8 @@
 
 #include "libcamera/internal/delayed_controls.h"
 
+#include <algorithm>
+
 #include <libcamera/base/log.h>
 
 #include <libcamera/controls.h>
@@ -73,13 +75,13 @@ LOG_DEFINE_CATEGORY(DelayedControls)
  */
 DelayedControls::DelayedControls(V4L2Device *device,
 				 const std::unordered_map<uint32_t, ControlParams> &controlParams)
-	: device_(device), maxDelay_(0)
+	: device_(device), maxDelay_(0), current_(device->controls()),
+	  batch_(device->controls()), priority_(device->controls())
 {
 	const ControlInfoMap &controls = device_->controls();
 
 	/*
-	 * Create a map of control ids to delays for controls exposed by the
-	 * device.
+	 * Create the list of controls exposed by the device with their delays.
 	 */
 	for (const auto &param : controlParams) {
 		auto it = controls.find(param.first);
@@ -94,19 +96,44 @@ DelayedControls::DelayedControls(V4L2Device *device,
 
 		const ControlId *id = it->first;
 
-		controlParams_[id] = param.second;
+		controls_.push_back({ id, param.second, {} });
 
 		LOG(DelayedControls, Debug)
-			<< "Set a delay of " << controlParams_[id].delay
-			<< " and priority write flag " << controlParams_[id].priorityWrite
+			<< "Set a delay of " << param.second.delay
+			<< " and priority write flag " << param.second.priorityWrite
 			<< " for " << id->name();
 
-		maxDelay_ = std::max(maxDelay_, controlParams_[id].delay);
+		maxDelay_ = std::max(maxDelay_, param.second.delay);
 	}
 
+	/*
+	 * Sort the controls by id to look them up with a binary search, and to
+	 * produce sorted lists that ControlList can fill without reordering.
+	 */
+	std::sort(controls_.begin(), controls_.end(),
+		  [](const ControlState &a, const ControlState &b) {
+			  return a.id->id() < b.id->id();
+		  });
+
+	current_.reserve(controls_.size());
+	batch_.reserve(controls_.size());
+	priority_.reserve(1);
+
 	reset();
 }
 
+DelayedControls::ControlState *DelayedControls::findControl(unsigned int id)
+{
+	auto it = std::lower_bound(controls_.begin(), controls_.end(), id,
+				   [](const ControlState &state, unsigned int value) {
+					   return state.id->id() < value;
+				   });
+	if (it == controls_.end() || it->id->id() != id)
+		return nullptr;
+
+	return &*it;
+}
+
 /**
  * \brief Reset state machine
  *
@@ -120,66 +147,77 @@ void DelayedControls::reset()
 
 	/* Retrieve control as reported by the device. */
 	std::vector<uint32_t> ids;
-	for (const auto &param : controlParams_)
-		ids.push_back(param.first->id());
+	for (const ControlState &state : controls_)
+		ids.push_back(state.id->id());
 
 	ControlList controls = device_->getControls(ids);
 
 	/* Seed the control queue with the controls reported by the device. */
-	values_.clear();
-	for (const auto &ctrl : controls) {
-		const ControlId *id = device_->controls().idmap().at(ctrl.first);
+	for (ControlState &state : controls_) {
+		state.values = {};
+
 		/*
 		 * Do not mark this control value as updated, it does not need
 		 * to be written to to device on startup.
 		 */
-		values_[id][0] = Info(ctrl.second, false);
+		if (controls.contains(state.id->id()))
+			state.values[0] = Info(controls.get(state.id->id()), false);
 	}
 }
 
 /**
  * \brief Push a set of controls on the queue
  * \param[in] controls List of controls to add to the device queue
+ * \param[out] sequence The sequence number of the first frame affected by
+ * \a controls (optional)
  *
  * Push a set of controls to the control queue. This increases the control queue
  * depth by one.
  *
+ * If \a sequence is not null, it is set to the sequence number of the first
+ * frame captured with \a controls applied, taking the delay of all controls
+ * into account. This is the sequence for which get() will first return the
+ * values of \a controls. The \a sequence is only set if the function returns
+ * true.
+ *
  * \returns true if \a controls are accepted, or false otherwise
  */
-bool DelayedControls::push(const ControlList &controls)
+bool DelayedControls::push(const ControlList &controls, uint32_t *sequence)
 {
 	/* Copy state from previous frame. */
-	for (auto &ctrl : values_) {
-		Info &info = ctrl.second[queueCount_];
-		info = values_[ctrl.first][queueCount_ - 1];
+	for (ControlState &state : controls_) {
+		Info &info = state.values[queueCount_];
+		info = state.values[queueCount_ - 1];
 		info.updated = false;
 	}
 
 	/* Update with new controls. */
-	const ControlIdMap &idmap = device_->controls().idmap();
 	for (const auto &control : controls) {
-		const auto &it = idmap.find(control.first);
-		if (it == idmap.end()) {
-			LOG(DelayedControls, Warning)
-				<< "Unknown control " << control.first;
+		ControlState *state = findControl(control.first);
+		if (!state) {
+			if (!device_->controls().idmap().count(control.first))
+				LOG(DelayedControls, Warning)
+					<< "Unknown control " << control.first;
 			return false;
 		}
 
-		const ControlId *id = it->second;
-
-		if (controlParams_.find(id) == controlParams_.end())
-			return false;
-
-		Info &info = values_[id][queueCount_];
+		Info &info = state->values[queueCount_];
 
 		info = Info(control.second);
 
 		LOG(DelayedControls, Debug)
-			<< "Queuing " << id->name()
+			<< "Queuing " << state->id->name()
 			<< " to " << info.toString()
 			<< " at index " << queueCount_;
 	}
 
+	/*
+	 * Controls queued at index i are read back by get() for sequence
+	 * i + maxDelay_, which is the first frame they affect.
+	 */
+	if (sequence)
+		*sequence = queueCount_ + maxDelay_;
+
 	queueCount_++;
 
 	return true;
@@ -198,26 +236,31 @@ bool DelayedControls::push(const ControlList &controls)
  * push(). The max history from the current sequence number that yields valid
  * values are thus 16 minus number of controls pushed.
  *
+ * The returned list is stored in the DelayedControls instance and reused for
+ * every call, to avoid memory allocations on every frame. It is only valid
+ * until the next call to this function, callers that need to keep the controls
+ * shall copy them.
+ *
  * \return The controls at \a sequence number
  */
-ControlList DelayedControls::get(uint32_t sequence)
+const ControlList &DelayedControls::get(uint32_t sequence)
 {
 	unsigned int index = std::max<int>(0, sequence - maxDelay_);
 
-	ControlList out(device_->controls());
-	for (const auto &ctrl : values_) {
-		const ControlId *id = ctrl.first;
-		const Info &info = ctrl.second[index];
+	current_.clear();
 
-		out.set(id->id(), info);
+	for (const ControlState &state : controls_) {
+		const Info &info = state.values[index];
+
+		current_.set(state.id->id(), info);
 
 		LOG(DelayedControls, Debug)
-			<< "Reading " << id->name()
+			<< "Reading " << state.id->name()
 			<< " to " << info.toString()
 			<< " at index " << index;
 	}
 
-	return out;
+	return current_;
 }
 
 /**
@@ -235,34 +278,35 @@ void DelayedControls::applyControls(uint32_t sequence)
 
 	/*
 	 * Create control list peeking ahead in the value queue to ensure
-	 * values are set in time to satisfy the sensor delay.
+	 * values are set in time to satisfy the sensor delay. The lists are
+	 * preallocated and reused to avoid allocations on every frame.
 	 */
-	ControlList out(device_->controls());
-	for (auto &ctrl : values_) {
-		const ControlId *id = ctrl.first;
-		unsigned int delayDiff = maxDelay_ - controlParams_[id].delay;
+	batch_.clear();
+
+	for (ControlState &state : controls_) {
+		unsigned int delayDiff = maxDelay_ - state.params.delay;
 		unsigned int index = std::max<int>(0, writeCount_ - delayDiff);
-		Info &info = ctrl.second[index];
+		Info &info = state.values[index];
 
 		if (info.updated) {
-			if (controlParams_[id].priorityWrite) {
+			if (state.params.priorityWrite) {
 				/*
 				 * This control must be written now, it could
 				 * affect validity of the other controls.
 				 */
-				ControlList priority(device_->controls());
-				priority.set(id->id(), info);
-				device_->setControls(&priority);
+				priority_.clear();
+				priority_.set(state.id->id(), info);
+				device_->setControls(&priority_);
 			} else {
 				/*
 				 * Batch up the list of controls and write them
 				 * at the end of the function.
 				 */
-				out.set(id->id(), info);
+				batch_.set(state.id->id(), info);
 			}
 
 			LOG(DelayedControls, Debug)
-				<< "Setting " << id->name()
+				<< "Setting " << state.id->name()
 				<< " to " << info.toString()
 				<< " at index " << index;
 
@@ -279,7 +323,7 @@ void DelayedControls::applyControls(uint32_t sequence)
 		push({});
 	}
 
-	device_->setControls(&out);
+	device_->setControls(&batch_);
 }
 
 } /* namespace libcamera */
@@ -7,6 +7,7 @@
 
 #include "libcamera/internal/device_enumerator.h"
 
+#include <algorithm>
 #include <string.h>
 
 #include <libcamera/base/log.h>
@@ -14,6 +15,7 @@
 #include "libcamera/internal/device_enumerator_sysfs.h"
 #include "libcamera/internal/device_enumerator_udev.h"
 #include "libcamera/internal/media_device.h"
+#include "libcamera/internal/worker_thread.h"
 
 /**
  * \file device_enumerator.h
@@ -107,23 +109,16 @@ bool DeviceMatch::match(const MediaDevice *device) const
 		return false;
 
 	for (const std::string &name : entities_) {
-		bool found = false;
-
-		for (const MediaEntity *entity : device->entities()) {
-			if (name == entity->name()) {
-				if (!entity->deviceNode().empty()) {
-					found = true;
-					break;
-				} else {
-					LOG(DeviceEnumerator, Debug)
-						<< "Skip " << entity->name()
-						<< ": no device node";
-				}
-			}
-		}
+		const MediaEntity *entity = device->getEntityByName(name);
+		if (!entity)
+			return false;
 
-		if (!found)
+		if (entity->deviceNode().empty()) {
+			LOG(DeviceEnumerator, Debug)
+				<< "Skip " << entity->name()
+				<< ": no device node";
 			return false;
+		}
 	}
 
 	for (const std::regex &nameRegex : entityRegexs_) {
@@ -271,6 +266,91 @@ std::unique_ptr<MediaDevice> DeviceEnumerator::createDevice(const std::string &d
 	return media;
 }
 
+class DeviceEnumerator::Worker : public WorkerThread
+{
+public:
+	Worker(DeviceEnumerator *enumerator, unsigned int index)
+		: WorkerThread("DeviceEnum", index), enumerator_(enumerator)
+	{
+	}
+
+	void createDevice(const std::string *deviceNode,
+			  std::unique_ptr<MediaDevice> *media)
+	{
+		*media = enumerator_->createDevice(*deviceNode);
+	}
+
+private:
+	DeviceEnumerator *enumerator_;
+};
+
+/**
+ * \brief Create media device instances for multiple device nodes in parallel
+ * \param[in] deviceNodes paths to the media devices to create
+ *
+ * Create media devices for all entries in \a deviceNodes as done by
+ * createDevice(). Populating a media device requires multiple ioctl calls to
+ * retrieve its topology, and this function spreads the work over multiple
+ * worker threads to speed up enumeration on systems with many media devices.
+ * The workers are libcamera threads, as creating media devices logs messages.
+ *
+ * The media devices are returned in the same order as \a deviceNodes. Entries
+ * for media devices that failed to be created are set to nullptr.
+ *
+ * \return Created media device instances
+ */
+std::vector<std::unique_ptr<MediaDevice>>
+DeviceEnumerator::createDevices(const std::vector<std::string> &deviceNodes)
+{
+	static constexpr unsigned int kMaxThreads = 8;
+
+	return createDevices(deviceNodes, WorkerThread::idealCount(kMaxThreads));
+}
+
+/**
+ * \brief Create media device instances on a given number of threads
+ * \param[in] deviceNodes paths to the media devices to create
+ * \param[in] maxThreads maximum number of worker threads
+ *
+ * This function behaves as createDevices(const std::vector<std::string> &),
+ * with an explicit limit on the number of worker threads. A limit of 1 creates
+ * the media devices in the calling thread.
+ *
+ * \return Created media device instances
+ */
+std::vector<std::unique_ptr<MediaDevice>>
+DeviceEnumerator::createDevices(const std::vector<std::string> &deviceNodes,
+				unsigned int maxThreads)
+{
+	std::vector<std::unique_ptr<MediaDevice>> devices(deviceNodes.size());
+
+	unsigned int numThreads = std::min<size_t>(deviceNodes.size(), maxThreads);
+	if (numThreads <= 1) {
+		for (unsigned int i = 0; i < deviceNodes.size(); ++i)
+			devices[i] = createDevice(deviceNodes[i]);
+
+		return devices;
+	}
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	for (unsigned int i = 0; i < numThreads; ++i) {
+		workers.push_back(std::make_unique<Worker>(this, i));
+		workers.back()->start();
+	}
+
+	for (unsigned int i = 0; i < deviceNodes.size(); ++i)
+		workers[i % numThreads]->queue(&Worker::createDevice,
+					       &deviceNodes[i], &devices[i]);
+
+	for (std::unique_ptr<Worker> &worker : workers) {
+		worker->waitIdle();
+		worker->exit();
+		worker->wait();
+	}
+
+	return devices;
+}
+
 /**
 * \var DeviceEnumerator::devicesAdded
 * \brief Notify of new media devices being found
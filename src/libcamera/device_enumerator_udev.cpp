@@ -17,6 +17,7 @@
 #include <sys/ioctl.h>
 #include <sys/sysmacros.h>
 #include <unistd.h>
+#include <vector>
 
 #include <libcamera/base/event_notifier.h>
 #include <libcamera/base/log.h>
@@ -68,7 +69,8 @@ int DeviceEnumeratorUdev::init()
 	return 0;
 }
 
-int DeviceEnumeratorUdev::addUdevDevice(struct udev_device *dev)
+int DeviceEnumeratorUdev::addUdevDevice(struct udev_device *dev,
+					std::unique_ptr<MediaDevice> media)
 {
 	const char *subsystem = udev_device_get_subsystem(dev);
 	if (!subsystem)
@@ -90,8 +92,8 @@ int DeviceEnumeratorUdev::addUdevDevice(struct udev_device *dev)
 		return -EEXIST;
 
 	if (!strcmp(subsystem, "media")) {
-		std::unique_ptr<MediaDevice> media =
-			createDevice(udev_device_get_devnode(dev));
+		if (!media)
+			media = createDevice(udev_device_get_devnode(dev));
 		if (!media)
 			return -ENODEV;
 
@@ -144,6 +146,10 @@ int DeviceEnumeratorUdev::enumerate()
 {
 	struct udev_enumerate *udev_enum = nullptr;
 	struct udev_list_entry *ents, *ent;
+	std::vector<struct udev_device *> udevDevices;
+	std::vector<std::string> mediaNodes;
+	std::vector<std::unique_ptr<MediaDevice>> mediaDevices;
+	unsigned int mediaIndex = 0;
 	int ret;
 
 	udev_enum = udev_enumerate_new(udev_);
@@ -192,10 +198,31 @@ int DeviceEnumeratorUdev::enumerate()
 			continue;
 		}
 
-		if (addUdevDevice(dev) < 0)
+		const char *subsystem = udev_device_get_subsystem(dev);
+		if (subsystem && !strcmp(subsystem, "media"))
+			mediaNodes.push_back(devnode);
+
+		udevDevices.push_back(dev);
+	}
+
+	/*
+	 * Populate all media devices in parallel before adding them, as
+	 * retrieving the media graph topology is the most time-consuming part
+	 * of enumeration.
+	 */
+	mediaDevices = createDevices(mediaNodes);
+
+	for (struct udev_device *dev : udevDevices) {
+		std::unique_ptr<MediaDevice> media;
+		const char *subsystem = udev_device_get_subsystem(dev);
+
+		if (subsystem && !strcmp(subsystem, "media"))
+			media = std::move(mediaDevices[mediaIndex++]);
+
+		if (addUdevDevice(dev, std::move(media)) < 0)
 			LOG(DeviceEnumerator, Warning)
 				<< "Failed to add device for '"
-				<< syspath << "', skipping";
+				<< udev_device_get_syspath(dev) << "', skipping";
 
 		udev_device_unref(dev);
 	}
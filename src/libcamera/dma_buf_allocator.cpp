@@ -8,7 +8,10 @@
 
 #include "libcamera/internal/dma_buf_allocator.h"
 
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <errno.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
@@ -26,6 +29,8 @@
 
 #include <libcamera/framebuffer.h>
 
+#include "libcamera/internal/framebuffer.h"
+
 /**
  * \file dma_buf_allocator.cpp
  * \brief dma-buf allocator
@@ -53,6 +58,71 @@ static constexpr std::array<DmaBufAllocatorInfo, 4> providerInfos = { {
 
 LOG_DEFINE_CATEGORY(DmaBufAllocator)
 
+#ifndef __DOXYGEN__
+namespace {
+
+#ifndef MFD_HUGE_2MB
+#define MFD_HUGE_SHIFT		26
+#define MFD_HUGE_2MB		(21U << MFD_HUGE_SHIFT)
+#endif
+
+constexpr std::size_t kHugePageSize = 2 * 1024 * 1024;
+
+/*
+ * Create a memfd backed by 2MB huge pages. Huge pages are only available when
+ * the system administrator has reserved them, failures are thus expected and
+ * not reported as errors.
+ */
+UniqueFD createHugePageMemFd([[maybe_unused]] const char *name,
+			     [[maybe_unused]] std::size_t size)
+{
+#if HAVE_MEMFD_CREATE && HAVE_FILE_SEALS
+	int ret = memfd_create(name, MFD_ALLOW_SEALING | MFD_CLOEXEC |
+				     MFD_HUGETLB | MFD_HUGE_2MB);
+	if (ret < 0)
+		return {};
+
+	UniqueFD memfd(ret);
+
+	if (ftruncate(memfd.get(), size) < 0)
+		return {};
+
+	if (fcntl(memfd.get(), F_ADD_SEALS, F_SEAL_SHRINK) < 0)
+		return {};
+
+	return memfd;
+#else
+	return {};
+#endif
+}
+
+class PooledFrameBufferPrivate : public FrameBuffer::Private
+{
+public:
+	PooledFrameBufferPrivate(Span<const FrameBuffer::Plane> planes,
+				 std::shared_ptr<DmaBufPool> pool,
+				 DmaBufAllocator::DmaBufAllocatorFlag type,
+				 std::size_t size, SharedFD fd)
+		: FrameBuffer::Private(planes), pool_(std::move(pool)),
+		  type_(type), size_(size), fd_(std::move(fd))
+	{
+	}
+
+	~PooledFrameBufferPrivate()
+	{
+		pool_->release(type_, size_, std::move(fd_));
+	}
+
+private:
+	std::shared_ptr<DmaBufPool> pool_;
+	DmaBufAllocator::DmaBufAllocatorFlag type_;
+	std::size_t size_;
+	SharedFD fd_;
+};
+
+} /* namespace */
+#endif /* __DOXYGEN__ */
+
 /**
  * \class DmaBufAllocator
  * \brief Helper class for dma-buf allocations
@@ -135,17 +205,37 @@ UniqueFD DmaBufAllocator::allocFromUDmaBuf(const char *name, std::size_t size)
 	std::size_t pageMask = sysconf(_SC_PAGESIZE) - 1;
 	size = (size + pageMask) & ~pageMask;
 
+	struct udmabuf_create create;
+
+	create.flags = UDMABUF_FLAGS_CLOEXEC;
+	create.offset = 0;
+	create.size = size;
+
+	/*
+	 * Back sizes that are a multiple of 2MB with huge pages when available,
+	 * to lower the TLB pressure of CPU access to large frame buffers.
+	 */
+	if (!(size % kHugePageSize)) {
+		UniqueFD memfd = createHugePageMemFd(name, size);
+		if (memfd.isValid()) {
+			create.memfd = memfd.get();
+
+			int ret = ::ioctl(providerHandle_.get(), UDMABUF_CREATE, &create);
+			if (ret >= 0)
+				return UniqueFD(ret);
+
+			LOG(DmaBufAllocator, Debug)
+				<< "Huge pages unavailable for " << name
+				<< ", falling back to regular pages";
+		}
+	}
+
 	/* udmabuf dma-buffers *must* have the F_SEAL_SHRINK seal. */
 	UniqueFD memfd = MemFd::create(name, size, MemFd::Seal::Shrink);
 	if (!memfd.isValid())
 		return {};
 
-	struct udmabuf_create create;
-
 	create.memfd = memfd.get();
-	create.flags = UDMABUF_FLAGS_CLOEXEC;
-	create.offset = 0;
-	create.size = size;
 
 	int ret = ::ioctl(providerHandle_.get(), UDMABUF_CREATE, &create);
 	if (ret < 0) {
@@ -214,7 +304,9 @@ UniqueFD DmaBufAllocator::alloc(const char *name, std::size_t size)
  * \param[in] planeSizes The sizes of planes in each FrameBuffer
  * \param[out] buffers Array of buffers successfully allocated
  *
- * Planes in a FrameBuffer are allocated with a single dma buf.
+ * Planes in a FrameBuffer are allocated with a single dma buf. When the
+ * process-wide DmaBufPool is enabled, the dma bufs are taken from the pool and
+ * returned to it when the FrameBuffer is destroyed.
  * \todo Add the option to allocate each plane with a dma buf respectively.
  *
  * \return The number of allocated buffers on success or a negative error code
@@ -250,7 +342,20 @@ DmaBufAllocator::createBuffer(std::string name,
 	for (auto planeSize : planeSizes)
 		frameSize += planeSize;
 
-	SharedFD fd(alloc(name.c_str(), frameSize));
+	std::shared_ptr<DmaBufPool> pool = DmaBufPool::instance();
+	bool pooled = pool->isEnabled();
+	std::size_t size = frameSize;
+	SharedFD fd;
+
+	if (pooled) {
+		size = DmaBufPool::sizeClass(frameSize);
+		fd = pool->acquire(type_, size, [&](std::size_t allocSize) {
+			return alloc(name.c_str(), allocSize);
+		});
+	} else {
+		fd = SharedFD(alloc(name.c_str(), frameSize));
+	}
+
 	if (!fd.isValid())
 		return nullptr;
 
@@ -259,7 +364,256 @@ DmaBufAllocator::createBuffer(std::string name,
 		offset += planeSize;
 	}
 
-	return std::make_unique<FrameBuffer>(planes);
+	if (!pooled)
+		return std::make_unique<FrameBuffer>(planes);
+
+	return std::make_unique<FrameBuffer>(
+		std::make_unique<PooledFrameBufferPrivate>(planes, std::move(pool),
+							   type_, size, std::move(fd)));
+}
+
+/**
+ * \class DmaBufPool
+ * \brief Process-wide pool of dma-buf allocations
+ *
+ * Allocating dma-bufs is expensive, and repeatedly allocating and freeing
+ * large buffers, as happens when a camera is reconfigured, fragments the CMA
+ * area. The DmaBufPool keeps dma-bufs released by their users, and hands them
+ * out again to later allocations of the same provider type and size class.
+ *
+ * Requested sizes are rounded up to a size class with sizeClass(), which
+ * bounds the memory wasted by the rounding while allowing buffers to be reused
+ * across similar but not identical formats.
+ *
+ * The total size of the idle buffers kept in the pool is capped by maxSize().
+ * When releasing a buffer would exceed the cap, the least recently released
+ * buffers are freed first. The pool is disabled when the maximum size is 0,
+ * which is the default. The process-wide instance is configured by the camera
+ * manager from the `dma_buf_pool.max_size` configuration option.
+ *
+ * Usage of the pool can be inspected with statistics().
+ */
+
+/**
+ * \struct DmaBufPool::Statistics
+ * \brief Usage statistics of a DmaBufPool
+ *
+ * \var DmaBufPool::Statistics::hits
+ * \brief Number of acquisitions served from idle pooled buffers
+ *
+ * \var DmaBufPool::Statistics::misses
+ * \brief Number of acquisitions that required a new allocation
+ *
+ * \var DmaBufPool::Statistics::evictions
+ * \brief Number of released buffers freed to honour the size cap
+ *
+ * \var DmaBufPool::Statistics::usedSize
+ * \brief Total size in bytes of the buffers currently acquired
+ *
+ * \var DmaBufPool::Statistics::pooledSize
+ * \brief Total size in bytes of the idle buffers kept in the pool
+ *
+ * \var DmaBufPool::Statistics::peakSize
+ * \brief Highest total size in bytes of acquired and idle buffers
+ */
+
+/**
+ * \typedef DmaBufPool::Allocator
+ * \brief Function called to allocate a dma-buf of the given size on a pool
+ * miss
+ */
+
+/**
+ * \brief Retrieve the process-wide DmaBufPool instance
+ * \return The process-wide DmaBufPool
+ */
+std::shared_ptr<DmaBufPool> DmaBufPool::instance()
+{
+	static std::shared_ptr<DmaBufPool> pool = std::make_shared<DmaBufPool>();
+	return pool;
+}
+
+/**
+ * \brief Construct an empty and disabled DmaBufPool
+ */
+DmaBufPool::DmaBufPool()
+	: maxSize_(0), stats_({})
+{
+}
+
+/**
+ * \brief Destroy the DmaBufPool, freeing all idle buffers
+ */
+DmaBufPool::~DmaBufPool() = default;
+
+/**
+ * \brief Set the maximum total size of idle buffers kept in the pool
+ * \param[in] size The maximum size in bytes, 0 disables the pool
+ *
+ * Idle buffers exceeding the new maximum size are freed immediately. Disabling
+ * the pool doesn't affect buffers currently in use, but they will be freed
+ * instead of being pooled when released.
+ */
+void DmaBufPool::setMaxSize(std::size_t size)
+{
+	MutexLocker locker(mutex_);
+
+	maxSize_ = size;
+	evict(0);
+}
+
+/**
+ * \brief Retrieve the maximum total size of idle buffers kept in the pool
+ * \return The maximum size in bytes
+ */
+std::size_t DmaBufPool::maxSize() const
+{
+	MutexLocker locker(mutex_);
+
+	return maxSize_;
+}
+
+/**
+ * \fn DmaBufPool::isEnabled()
+ * \brief Check if the pool is enabled
+ * \return True if the maximum size of the pool is not 0, false otherwise
+ */
+
+/**
+ * \brief Compute the size class of an allocation size
+ * \param[in] size The requested allocation size
+ *
+ * Sizes are rounded up to the page size, and then to a multiple of 1/8th of
+ * their largest power of two. This limits the memory overhead to 12.5%, and
+ * results in multiples of 2MB for sizes of 16MB and more, which allows backing
+ * large buffers with huge pages.
+ *
+ * \return The size class of \a size in bytes
+ */
+std::size_t DmaBufPool::sizeClass(std::size_t size)
+{
+	const std::size_t pageSize = sysconf(_SC_PAGESIZE);
+
+	size = (size + pageSize - 1) / pageSize * pageSize;
+	if (!size)
+		return pageSize;
+
+	std::size_t step = std::max(pageSize, std::bit_floor(size) / 8);
+	return (size + step - 1) / step * step;
+}
+
+/**
+ * \brief Acquire a dma-buf from the pool
+ * \param[in] type The dma-buf provider type
+ * \param[in] size The buffer size, as returned by sizeClass()
+ * \param[in] allocate Function to allocate a new buffer on a pool miss
+ *
+ * Return the most recently released idle buffer matching \a type and \a size
+ * if any, or allocate a new buffer with \a allocate otherwise. The buffer must
+ * be returned to the pool with release() when not used anymore.
+ *
+ * \return The dma-buf file descriptor, or an invalid SharedFD if allocation
+ * failed
+ */
+SharedFD DmaBufPool::acquire(DmaBufAllocator::DmaBufAllocatorFlag type,
+			     std::size_t size, const Allocator &allocate)
+{
+	{
+		MutexLocker locker(mutex_);
+
+		auto it = std::find_if(entries_.rbegin(), entries_.rend(),
+				       [&](const Entry &entry) {
+					       return entry.type == type &&
+						      entry.size == size;
+				       });
+		if (it != entries_.rend()) {
+			SharedFD fd = std::move(it->fd);
+			entries_.erase(std::next(it).base());
+
+			stats_.hits++;
+			stats_.pooledSize -= size;
+			stats_.usedSize += size;
+			return fd;
+		}
+	}
+
+	/* Allocate without holding the lock, as allocation can be slow. */
+	SharedFD fd(allocate(size));
+	if (!fd.isValid())
+		return fd;
+
+	MutexLocker locker(mutex_);
+
+	stats_.misses++;
+	stats_.usedSize += size;
+	stats_.peakSize = std::max(stats_.peakSize,
+				   stats_.usedSize + stats_.pooledSize);
+
+	LOG(DmaBufAllocator, Debug)
+		<< "Pool miss for " << size << " bytes, "
+		<< stats_.usedSize << " bytes in use";
+
+	return fd;
+}
+
+/**
+ * \brief Release a dma-buf to the pool
+ * \param[in] type The dma-buf provider type
+ * \param[in] size The buffer size passed to acquire()
+ * \param[in] fd The dma-buf file descriptor returned by acquire()
+ *
+ * The buffer is kept in the pool for reuse by later acquisitions, unless it is
+ * larger than the pool maximum size. Older idle buffers are freed as needed to
+ * honour the maximum size.
+ */
+void DmaBufPool::release(DmaBufAllocator::DmaBufAllocatorFlag type,
+			 std::size_t size, SharedFD fd)
+{
+	MutexLocker locker(mutex_);
+
+	stats_.usedSize -= size;
+
+	if (size > maxSize_) {
+		stats_.evictions++;
+		return;
+	}
+
+	evict(size);
+
+	entries_.push_back({ type, size, std::move(fd) });
+	stats_.pooledSize += size;
+}
+
+/**
+ * \brief Free all idle buffers kept in the pool
+ */
+void DmaBufPool::trim()
+{
+	MutexLocker locker(mutex_);
+
+	entries_.clear();
+	stats_.pooledSize = 0;
+}
+
+/**
+ * \brief Retrieve the pool usage statistics
+ * \return The pool usage statistics
+ */
+DmaBufPool::Statistics DmaBufPool::statistics() const
+{
+	MutexLocker locker(mutex_);
+
+	return stats_;
+}
+
+/* Free the oldest idle buffers to make room for \a size bytes. */
+void DmaBufPool::evict(std::size_t size)
+{
+	while (!entries_.empty() && stats_.pooledSize + size > maxSize_) {
+		stats_.pooledSize -= entries_.front().size;
+		stats_.evictions++;
+		entries_.pop_front();
+	}
 }
 
 /**
@@ -272,6 +626,16 @@ DmaBufAllocator::createBuffer(std::string name,
  * It's used when the user needs to access a dma-buf with CPU, mostly mapped
  * with MappedFrameBuffer, so that the buffer is synchronized between CPU and
  * ISP.
+ *
+ * As the kernel only supports synchronizing complete dma-bufs, each instance
+ * causes a full cache maintenance of the buffer. Users that split the
+ * processing of a buffer in multiple parts, for instance in stripes handled by
+ * worker threads, should keep a single DmaSyncer for the duration of the whole
+ * processing instead of one per part.
+ *
+ * File descriptors that don't support synchronization, such as memfds, are
+ * detected when starting the CPU access, and the end of the access is then
+ * skipped.
  */
 
 /**
@@ -308,7 +672,7 @@ DmaSyncer::DmaSyncer(SharedFD fd, SyncType type)
 		break;
 	}
 
-	sync(DMA_BUF_SYNC_START);
+	active_ = sync(DMA_BUF_SYNC_START);
 }
 
 /**
@@ -329,11 +693,11 @@ DmaSyncer::~DmaSyncer()
 	 * DmaSyncer might be moved and left with an empty SharedFD.
 	 * Avoid syncing with an invalid file descriptor in this case.
 	 */
-	if (fd_.isValid())
+	if (fd_.isValid() && active_)
 		sync(DMA_BUF_SYNC_END);
 }
 
-void DmaSyncer::sync(uint64_t step)
+bool DmaSyncer::sync(uint64_t step)
 {
 	struct dma_buf_sync sync = {
 		.flags = flags_ | step
@@ -346,11 +710,22 @@ void DmaSyncer::sync(uint64_t step)
 
 	if (ret) {
 		ret = errno;
+
+		/* The file descriptor isn't a dma-buf, no sync is needed. */
+		if (ret == ENOTTY) {
+			LOG(DmaBufAllocator, Debug)
+				<< "fd " << fd_.get() << " doesn't support sync";
+			return false;
+		}
+
 		LOG(DmaBufAllocator, Error)
 			<< "Unable to sync dma fd: " << fd_.get()
 			<< ", err: " << strerror(ret)
 			<< ", flags: " << sync.flags;
+		return false;
 	}
+
+	return true;
 }
 
 } /* namespace libcamera */
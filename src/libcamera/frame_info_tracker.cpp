@@ -0,0 +1,314 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Indexed tracking of in-flight frame information
+ */
+
+#include "libcamera/internal/frame_info_tracker.h"
+
+#include <algorithm>
+
+/**
+ * \file frame_info_tracker.h
+ * \brief Indexed tracking of in-flight frame information
+ */
+
+namespace libcamera {
+
+/**
+ * \class FrameInfoIndex
+ * \brief Open-addressing hash index mapping 64-bit keys to slot numbers
+ *
+ * The FrameInfoIndex class is a minimal hash table used by FrameInfoTracker
+ * to look up slots by frame sequence number, request or buffer in constant
+ * time. It stores entries in a flat array with linear probing, and only
+ * allocates memory when it needs to grow, which doesn't happen in steady state
+ * once the index has been reserved to the expected number of entries.
+ *
+ * The key value 0 is reserved to denote empty entries and can't be stored in
+ * the index.
+ */
+
+/**
+ * \var FrameInfoIndex::kInvalid
+ * \brief Value returned by find() when the key isn't present in the index
+ */
+
+FrameInfoIndex::FrameInfoIndex()
+	: size_(0)
+{
+}
+
+/**
+ * \brief Reserve storage for at least \a size entries
+ * \param[in] size The number of entries
+ */
+void FrameInfoIndex::reserve(unsigned int size)
+{
+	/* Keep the load factor below 50% to keep probe sequences short. */
+	unsigned int capacity = 8;
+	while (capacity < size * 2)
+		capacity *= 2;
+
+	if (capacity > entries_.size())
+		rehash(capacity);
+}
+
+/**
+ * \brief Remove all entries from the index
+ *
+ * The index storage is retained.
+ */
+void FrameInfoIndex::clear()
+{
+	std::fill(entries_.begin(), entries_.end(), Entry{ 0, 0 });
+	size_ = 0;
+}
+
+/**
+ * \brief Insert or replace an entry in the index
+ * \param[in] key The entry key, shall not be 0
+ * \param[in] value The entry value
+ */
+void FrameInfoIndex::insert(uint64_t key, unsigned int value)
+{
+	if ((size_ + 1) * 2 > entries_.size())
+		rehash(std::max<size_t>(entries_.size() * 2, 8));
+
+	unsigned int mask = entries_.size() - 1;
+	unsigned int i = home(key);
+
+	while (entries_[i].key && entries_[i].key != key)
+		i = (i + 1) & mask;
+
+	if (!entries_[i].key)
+		size_++;
+
+	entries_[i] = { key, value };
+}
+
+/**
+ * \brief Remove the entry for \a key from the index
+ * \param[in] key The entry key
+ */
+void FrameInfoIndex::erase(uint64_t key)
+{
+	if (entries_.empty())
+		return;
+
+	unsigned int mask = entries_.size() - 1;
+	unsigned int i = home(key);
+
+	while (entries_[i].key != key) {
+		if (!entries_[i].key)
+			return;
+		i = (i + 1) & mask;
+	}
+
+	/*
+	 * Shift the following entries of the probe sequence back to fill the
+	 * hole, to avoid the need for tombstones.
+	 */
+	unsigned int j = i;
+	while (true) {
+		j = (j + 1) & mask;
+		if (!entries_[j].key)
+			break;
+
+		unsigned int k = home(entries_[j].key);
+		if (((j - k) & mask) < ((j - i) & mask))
+			continue;
+
+		entries_[i] = entries_[j];
+		i = j;
+	}
+
+	entries_[i] = { 0, 0 };
+	size_--;
+}
+
+/**
+ * \brief Find the value associated with \a key
+ * \param[in] key The entry key
+ * \return The value associated with \a key, or kInvalid if not found
+ */
+unsigned int FrameInfoIndex::find(uint64_t key) const
+{
+	if (entries_.empty())
+		return kInvalid;
+
+	unsigned int mask = entries_.size() - 1;
+	unsigned int i = home(key);
+
+	while (entries_[i].key) {
+		if (entries_[i].key == key)
+			return entries_[i].value;
+		i = (i + 1) & mask;
+	}
+
+	return kInvalid;
+}
+
+/**
+ * \fn FrameInfoIndex::size()
+ * \brief Retrieve the number of entries in the index
+ * \return The number of entries
+ */
+
+unsigned int FrameInfoIndex::home(uint64_t key) const
+{
+	/* Fibonacci hashing spreads sequential and aligned keys well. */
+	return (key * 0x9e3779b97f4a7c15ULL) >> 32 & (entries_.size() - 1);
+}
+
+void FrameInfoIndex::rehash(unsigned int capacity)
+{
+	std::vector<Entry> entries(capacity, Entry{ 0, 0 });
+	entries_.swap(entries);
+	size_ = 0;
+
+	for (const Entry &entry : entries) {
+		if (entry.key)
+			insert(entry.key, entry.value);
+	}
+}
+
+/**
+ * \class FrameInfoTracker
+ * \brief Track per-frame information for requests in flight in a pipeline
+ * \tparam Info The pipeline-specific frame information type
+ *
+ * Pipeline handlers need to associate their own information with every frame
+ * being processed by the hardware, and to locate that information when a
+ * buffer completes, when the IPA reports results for a frame, or when a
+ * request needs to be cancelled. The FrameInfoTracker class stores
+ * instances of the \a Info type in preallocated slots, and indexes them by
+ * frame sequence number, by request and by buffer to provide constant-time
+ * lookups.
+ *
+ * Slots are allocated by reserve() and reused as frames complete, so that
+ * no memory allocation occurs in steady state as long as the number of frames
+ * in flight doesn't exceed the reserved size. The tracker grows automatically
+ * if more frames are created, pointers to \a Info instances remain valid until
+ * the corresponding frame is removed.
+ *
+ * The buffers of the request are indexed automatically when a frame is
+ * created. Internal buffers, such as parameters, statistics or intermediate
+ * raw buffers, shall be registered with addBuffer() to be found by
+ * find(const FrameBuffer *).
+ *
+ * The \a Info type must be default-constructible and copy-assignable, it is
+ * reset to its default value when a frame is created.
+ */
+
+/**
+ * \typedef FrameInfoTracker::CompletionCheck
+ * \brief Function to check if a frame is complete from its information
+ */
+
+/**
+ * \fn FrameInfoTracker::FrameInfoTracker()
+ * \brief Construct a FrameInfoTracker
+ * \param[in] check Function called by tryComplete() to check if a frame is
+ * complete
+ */
+
+/**
+ * \fn FrameInfoTracker::reserve()
+ * \brief Preallocate storage for \a size frames in flight
+ * \param[in] size The number of frames
+ *
+ * This function should be called when starting the camera with the maximum
+ * expected number of frames in flight, typically the pipeline queue depth.
+ */
+
+/**
+ * \fn FrameInfoTracker::clear()
+ * \brief Remove all frames from the tracker
+ *
+ * The tracker storage is retained for reuse.
+ */
+
+/**
+ * \fn FrameInfoTracker::create()
+ * \brief Create tracking information for a frame
+ * \param[in] sequence The frame sequence number
+ * \param[in] request The request associated with the frame
+ *
+ * The frame is indexed by \a sequence, by \a request and by all buffers of the
+ * \a request. It is a fatal error to create a frame with the sequence number
+ * of a frame already being tracked.
+ *
+ * \return A pointer to the frame information, reset to its default value
+ */
+
+/**
+ * \fn FrameInfoTracker::addBuffer()
+ * \brief Associate a buffer with a frame
+ * \param[in] sequence The frame sequence number
+ * \param[in] buffer The buffer
+ *
+ * If \a buffer is already associated with another frame, the association is
+ * replaced. Null buffers are ignored.
+ */
+
+/**
+ * \fn FrameInfoTracker::remove()
+ * \brief Stop tracking a frame
+ * \param[in] sequence The frame sequence number
+ * \return True if the frame was removed, false if it wasn't being tracked
+ */
+
+/**
+ * \fn FrameInfoTracker::tryComplete()
+ * \brief Remove a frame if it has completed
+ * \param[in] sequence The frame sequence number
+ *
+ * A frame is considered complete when its request has no pending buffers and
+ * the completion check function passed to the constructor, if any, returns
+ * true.
+ *
+ * \return True if the frame was complete and has been removed, false otherwise
+ */
+
+/**
+ * \fn FrameInfoTracker::find(unsigned int sequence)
+ * \brief Find a frame by sequence number
+ * \param[in] sequence The frame sequence number
+ * \return A pointer to the frame information, or nullptr if not found
+ */
+
+/**
+ * \fn FrameInfoTracker::find(const FrameBuffer *buffer)
+ * \brief Find the frame a buffer is associated with
+ * \param[in] buffer The buffer
+ * \return A pointer to the frame information, or nullptr if not found
+ */
+
+/**
+ * \fn FrameInfoTracker::find(const Request *request)
+ * \brief Find the frame a request is associated with
+ * \param[in] request The request
+ * \return A pointer to the frame information, or nullptr if not found
+ */
+
+/**
+ * \fn FrameInfoTracker::forEach()
+ * \brief Call \a func for the information of every tracked frame
+ * \param[in] func The function
+ */
+
+/**
+ * \fn FrameInfoTracker::size()
+ * \brief Retrieve the number of tracked frames
+ * \return The number of tracked frames
+ */
+
+/**
+ * \fn FrameInfoTracker::empty()
+ * \brief Check if no frame is being tracked
+ * \return True if no frame is being tracked, false otherwise
+ */
+
+} /* namespace libcamera */
@@ -96,8 +96,12 @@ struct EnvironmentOverride {
 	std::unique_ptr<EnvironmentProcessor> processor;
 };
 
-const std::array<EnvironmentOverride, 6> environmentOverrides{ {
+const std::array<EnvironmentOverride, 9> environmentOverrides{ {
 	{
+		"LIBCAMERA_DMA_BUF_POOL_SIZE",
+		{ "dma_buf_pool", "max_size" },
+		std::make_unique<EnvironmentValueProcessor>(),
+	}, {
 		"LIBCAMERA_IPA_CONFIG_PATH",
 		{ "ipa", "config_paths" },
 		std::make_unique<EnvironmentListProcessor>(":"),
@@ -105,6 +109,10 @@ const std::array<EnvironmentOverride, 6> environmentOverrides{ {
 		"LIBCAMERA_IPA_FORCE_ISOLATION",
 		{ "ipa", "force_isolation" },
 		std::make_unique<EnvironmentFixedProcessor<bool>>(true),
+	}, {
+		"LIBCAMERA_IPA_MODULE_CACHE",
+		{ "ipa", "module_cache" },
+		std::make_unique<EnvironmentFixedProcessor<bool>>(true),
 	}, {
 		"LIBCAMERA_IPA_MODULE_PATH",
 		{ "ipa", "module_paths" },
@@ -117,6 +125,10 @@ const std::array<EnvironmentOverride, 6> environmentOverrides{ {
 		"LIBCAMERA_PIPELINES_MATCH_LIST",
 		{ "pipelines_match_list" },
 		std::make_unique<EnvironmentListProcessor>(","),
+	}, {
+		"LIBCAMERA_REQUEST_QUEUE_AUTO_DEPTH",
+		{ "request_queue", "auto_depth" },
+		std::make_unique<EnvironmentFixedProcessor<bool>>(true),
 	}, {
 		"LIBCAMERA_SOFTISP_MODE",
 		{ "software_isp", "mode" },
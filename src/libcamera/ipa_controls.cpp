@@ -137,6 +137,19 @@
  * As with the ControlList packet, empty spaces may be present between the end of
  * the entries array and the data section, and after the data section. They
  * shall be ignored when parsing the packet.
+ *
+ * ControlList packets may additionally be part of a delta session, identified
+ * by a non-zero ipa_controls_header::session value. Within a session, the
+ * receiver keeps the state of the control list conveyed by the last packet,
+ * and packets with the IPA_CONTROLS_FLAG_DELTA flag set only carry the
+ * differences with that state. Controls that have been added or whose value
+ * has changed are stored as regular entries, while controls that have been
+ * removed are stored as entries of type ControlTypeNone with no associated
+ * data. Packets without the IPA_CONTROLS_FLAG_DELTA flag are full
+ * synchronization packets that replace the session state entirely. The
+ * ipa_controls_header::generation field is incremented by one for every packet
+ * in the session, and a delta packet shall only be applied to the state
+ * resulting from the packet of the previous generation.
  */
 
 namespace libcamera {
@@ -146,6 +159,12 @@ namespace libcamera {
  * \brief The current control serialization format version
  */
 
+/**
+ * \def IPA_CONTROLS_FLAG_DELTA
+ * \brief The ControlList packet only contains differences with the previous
+ * packet of the same session
+ */
+
 /**
  * \var ipa_controls_id_map_type
  * \brief Enumerates the different control id map types
@@ -190,8 +209,15 @@ namespace libcamera {
  * Offset in bytes from the beginning of the packet of the data section start
  * \var ipa_controls_header::id_map_type
  * The id map type as defined by the ipa_controls_id_map_type enumeration
- * \var ipa_controls_header::reserved
- * Reserved for future extensions
+ * \var ipa_controls_header::session
+ * For ControlList packets, the identifier of the delta session the packet
+ * belongs to, or 0 if the packet is self-contained. Shall be 0 for
+ * ControlInfoMap packets.
+ * \var ipa_controls_header::flags
+ * Packet flags (IPA_CONTROLS_FLAG_*)
+ * \var ipa_controls_header::generation
+ * For ControlList packets that belong to a delta session, the packet sequence
+ * number within the session. Shall be 0 otherwise.
  */
 
 static_assert(sizeof(ipa_controls_header) == 32,
@@ -296,6 +296,8 @@ IPADataSerializer<std::string>::deserialize(std::vector<uint8_t>::const_iterator
 	return { dataBegin, dataEnd };
 }
 
+namespace {
+
 /*
  * ControlList is serialized as:
  *
@@ -307,9 +309,9 @@ IPADataSerializer<std::string>::deserialize(std::vector<uint8_t>::const_iterator
  * If data.infoMap() is nullptr, then the default controls::controls will
  * be used. The serialized ControlInfoMap will have zero length.
  */
-template<>
 std::tuple<std::vector<uint8_t>, std::vector<SharedFD>>
-IPADataSerializer<ControlList>::serialize(const ControlList &data, ControlSerializer *cs)
+serializeControlList(const ControlList &data, unsigned int session,
+		     ControlSerializer *cs)
 {
 	if (!cs)
 		LOG(IPADataSerializer, Fatal)
@@ -335,16 +337,25 @@ IPADataSerializer<ControlList>::serialize(const ControlList &data, ControlSerial
 		}
 	}
 
+	/*
+	 * The size of the full list is an upper bound for delta sessions,
+	 * shrink the data to the actual size after serialization.
+	 */
 	size = cs->binarySize(data);
 	std::vector<uint8_t> listData(size);
 	ByteStreamBuffer buffer(listData.data(), listData.size());
-	ret = cs->serialize(data, buffer);
+	if (session)
+		ret = cs->serialize(data, session, buffer);
+	else
+		ret = cs->serialize(data, buffer);
 
 	if (ret < 0 || buffer.overflow()) {
 		LOG(IPADataSerializer, Error) << "Failed to serialize ControlList";
 		return { {}, {} };
 	}
 
+	listData.resize(buffer.offset());
+
 	std::vector<uint8_t> dataVec;
 	dataVec.reserve(8 + infoData.size() + listData.size());
 	appendPOD<uint32_t>(dataVec, infoData.size());
@@ -355,6 +366,15 @@ IPADataSerializer<ControlList>::serialize(const ControlList &data, ControlSerial
 	return { dataVec, {} };
 }
 
+} /* namespace */
+
+template<>
+std::tuple<std::vector<uint8_t>, std::vector<SharedFD>>
+IPADataSerializer<ControlList>::serialize(const ControlList &data, ControlSerializer *cs)
+{
+	return serializeControlList(data, 0, cs);
+}
+
 template<>
 ControlList
 IPADataSerializer<ControlList>::deserialize(std::vector<uint8_t>::const_iterator dataBegin,
@@ -622,4 +642,33 @@ IPADataSerializer<FrameBuffer::Plane>::deserialize(const std::vector<uint8_t> &d
 
 #endif /* __DOXYGEN__ */
 
+/**
+ * \brief Serialize a ControlList as part of a delta session
+ * \param[in] data The ControlList to serialize
+ * \param[in] session The delta session number
+ * \param[in] cs ControlSerializer
+ *
+ * Serialize \a data in the same format as
+ * IPADataSerializer<ControlList>::serialize(), but only store the controls that
+ * have changed since the previous list serialized by \a cs in the same
+ * \a session. The result is deserialized with
+ * IPADataSerializer<ControlList>::deserialize(), which reconstructs the full
+ * list.
+ *
+ * This is used by the IPA proxies for ControlList parameters marked with the
+ * [delta] mojom attribute, for which each parameter is assigned a unique
+ * session number.
+ *
+ * \sa ControlSerializer::serialize(const ControlList &list, unsigned int session, ByteStreamBuffer &buffer)
+ *
+ * \return Tuple of byte vector and fd vector, that is the serialized form
+ * of \a data
+ */
+std::tuple<std::vector<uint8_t>, std::vector<SharedFD>>
+serializeControlListDelta(const ControlList &data, unsigned int session,
+			  ControlSerializer *cs)
+{
+	return serializeControlList(data, session, cs);
+}
+
 } /* namespace libcamera */
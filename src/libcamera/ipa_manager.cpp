@@ -9,8 +9,11 @@
 
 #include <algorithm>
 #include <dirent.h>
+#include <map>
+#include <set>
 #include <string.h>
 #include <string>
+#include <string_view>
 #include <sys/types.h>
 #include <vector>
 
@@ -20,7 +23,9 @@
 
 #include "libcamera/internal/global_configuration.h"
 #include "libcamera/internal/ipa_module.h"
+#include "libcamera/internal/ipa_module_cache.h"
 #include "libcamera/internal/ipa_proxy.h"
+#include "libcamera/internal/ipc_pipe_unixsocket.h"
 #include "libcamera/internal/pipeline_handler.h"
 
 /**
@@ -32,6 +37,15 @@ namespace libcamera {
 
 LOG_DEFINE_CATEGORY(IPAManager)
 
+namespace {
+
+/* Proxy worker executable names, indexed by pipeline handler name. */
+const std::map<std::string_view, std::string_view> proxyWorkerNames = {
+	IPA_PROXY_WORKERS
+};
+
+} /* namespace */
+
 /**
  * \class IPAManager
  * \brief Manager for IPA modules
@@ -96,6 +110,22 @@ LOG_DEFINE_CATEGORY(IPAManager)
  * serialized to Plain Old Data, either for the purpose of passing it to the IPA
  * context plain C API, or to transmit the data to the isolated process through
  * IPC.
+ *
+ * Starting an isolated IPA module requires forking and executing a proxy worker
+ * process that then loads the IPA module, which adds significant latency to
+ * camera acquisition. To reduce that latency, the manager can maintain a pool
+ * of pre-spawned proxy workers for each isolated IPA module, whose size is
+ * set by the `ipa.proxy_pool_size` configuration option. The pool is disabled
+ * by default. When enabled, workers are pre-spawned for every IPA module that
+ * runs in isolation when the manager is created, and the pool is refilled every
+ * time a pooled worker is handed out. Workers are never reused once handed out,
+ * they are terminated when the IPA proxy that owns them is destroyed.
+ *
+ * When the `ipa.module_cache` configuration option is enabled, the information
+ * of IPA modules and the result of their signature verification are stored in
+ * an IPAModuleCache, and reused by other processes as long as the IPA modules
+ * are not modified. This avoids parsing all IPA modules and hashing the
+ * signed ones every time a CameraManager is started.
  */
 
 /**
@@ -110,6 +140,9 @@ IPAManager::IPAManager(const CameraManager &cm)
 {
 	const GlobalConfiguration &configuration = cm._d()->configuration();
 
+	proxyPoolSize_ = configuration.option<unsigned int>({ "ipa", "proxy_pool_size" })
+				 .value_or(0);
+
 #if HAVE_IPA_PUBKEY
 	if (!pubKey_.isValid())
 		LOG(IPAManager, Warning) << "Public key not valid";
@@ -118,6 +151,19 @@ IPAManager::IPAManager(const CameraManager &cm)
 				       .value_or(false);
 #endif
 
+	if (configuration.option<bool>({ "ipa", "module_cache" }).value_or(false)) {
+		std::string cachePath = IPAModuleCache::defaultPath();
+		if (!cachePath.empty()) {
+#if HAVE_IPA_PUBKEY
+			Span<const uint8_t> publicKey = publicKeyData();
+#else
+			Span<const uint8_t> publicKey;
+#endif
+			moduleCache_ = std::make_unique<IPAModuleCache>(cachePath,
+									publicKey);
+		}
+	}
+
 	unsigned int ipaCount = 0;
 
 	/* User-specified paths take precedence. */
@@ -158,6 +204,12 @@ IPAManager::IPAManager(const CameraManager &cm)
 	if (!ipaCount)
 		LOG(IPAManager, Warning)
 			<< "No IPA found in '" IPA_MODULE_DIR "'";
+
+	if (moduleCache_)
+		moduleCache_->save();
+
+	if (proxyPoolSize_)
+		spawnProxyWorkers(configuration);
 }
 
 IPAManager::~IPAManager() = default;
@@ -233,7 +285,25 @@ unsigned int IPAManager::addDir(const char *libDir, unsigned int maxDepth)
 
 	unsigned int count = 0;
 	for (const std::string &file : files) {
-		auto ipaModule = std::make_unique<IPAModule>(file);
+		std::unique_ptr<IPAModule> ipaModule;
+
+		if (moduleCache_) {
+			IPAModuleCache::Stamp stamp = IPAModuleCache::stamp(file);
+			const IPAModuleCache::Entry *entry =
+				moduleCache_->find(file, stamp);
+
+			if (entry) {
+				ipaModule = std::make_unique<IPAModule>(file, entry->info);
+			} else {
+				ipaModule = std::make_unique<IPAModule>(file);
+				if (ipaModule->isValid())
+					moduleCache_->update(file, stamp,
+							     ipaModule->info());
+			}
+		} else {
+			ipaModule = std::make_unique<IPAModule>(file);
+		}
+
 		if (!ipaModule->isValid())
 			continue;
 
@@ -254,9 +324,21 @@ unsigned int IPAManager::addDir(const char *libDir, unsigned int maxDepth)
  */
 IPAModule *IPAManager::module(PipelineHandler *pipe, uint32_t minVersion,
 			      uint32_t maxVersion)
+{
+	return module(pipe->name(), minVersion, maxVersion);
+}
+
+/**
+ * \brief Retrieve an IPA module that matches a given pipeline handler name
+ * \param[in] pipelineName The pipeline handler name
+ * \param[in] minVersion Minimum acceptable version of IPA module
+ * \param[in] maxVersion Maximum acceptable version of IPA module
+ */
+IPAModule *IPAManager::module(const char *pipelineName, uint32_t minVersion,
+			      uint32_t maxVersion)
 {
 	for (const auto &module : modules_) {
-		if (module->match(pipe, minVersion, maxVersion))
+		if (module->match(pipelineName, minVersion, maxVersion))
 			return module.get();
 	}
 
@@ -264,7 +346,113 @@ IPAModule *IPAManager::module(PipelineHandler *pipe, uint32_t minVersion,
 }
 
 /**
- * \fn IPAManager::createIPA()
+ * \brief Retrieve an IPC pipe to a running proxy worker for an IPA module
+ * \param[in] ipam The IPA module
+ * \param[in] workerPath The path to the proxy worker executable
+ *
+ * This function is called by isolated IPA proxies to obtain the IPC pipe to
+ * the proxy worker process that runs the IPA module \a ipam. If the proxy
+ * worker pool is enabled and holds a live worker for the module, that worker
+ * is handed out and the pool is refilled. Otherwise a new proxy worker is
+ * started.
+ *
+ * \return The IPC pipe to the proxy worker, which may not be connected if the
+ * worker failed to start
+ */
+std::unique_ptr<IPCPipeUnixSocket>
+IPAManager::acquireProxyWorker(const IPAModule *ipam, const std::string &workerPath)
+{
+	std::unique_ptr<IPCPipeUnixSocket> ipc;
+
+	if (!proxyPoolSize_)
+		return std::make_unique<IPCPipeUnixSocket>(ipam->path().c_str(),
+							   workerPath.c_str());
+
+	ProxyWorkerPool &pool = proxyPools_[ipam];
+	if (pool.workerPath != workerPath) {
+		pool.workerPath = workerPath;
+		pool.workers.clear();
+	}
+
+	/* Discard workers that have terminated since they were spawned. */
+	std::erase_if(pool.workers, [](const auto &worker) {
+		return !worker->isConnected();
+	});
+
+	if (!pool.workers.empty()) {
+		ipc = std::move(pool.workers.front());
+		pool.workers.erase(pool.workers.begin());
+
+		LOG(IPAManager, Debug)
+			<< "Using pooled proxy worker for " << ipam->path();
+	} else {
+		ipc = std::make_unique<IPCPipeUnixSocket>(ipam->path().c_str(),
+							  workerPath.c_str());
+	}
+
+	fillProxyWorkerPool(ipam, pool);
+
+	return ipc;
+}
+
+/**
+ * \brief Pre-spawn proxy workers for the IPA modules that run in isolation
+ * \param[in] configuration The global configuration
+ *
+ * Workers are only spawned for the first IPA module of each pipeline handler,
+ * which is the one that module() selects.
+ */
+void IPAManager::spawnProxyWorkers(const GlobalConfiguration &configuration)
+{
+	const std::vector<std::string> execPaths =
+		configuration.listOption({ "ipa", "proxy_paths" })
+			.value_or(utils::defopt);
+	std::set<std::string_view> pipelines;
+
+	for (const auto &module : modules_) {
+		std::string_view pipelineName = module->info().pipelineName;
+		if (!pipelines.insert(pipelineName).second)
+			continue;
+
+		const auto it = proxyWorkerNames.find(pipelineName);
+		if (it == proxyWorkerNames.end())
+			continue;
+
+		if (isSignatureValid(module.get()))
+			continue;
+
+		std::string workerPath =
+			IPAProxy::resolvePath(std::string(it->second), execPaths);
+		if (workerPath.empty())
+			continue;
+
+		LOG(IPAManager, Debug)
+			<< "Pre-spawning proxy workers for " << module->path();
+
+		ProxyWorkerPool &pool = proxyPools_[module.get()];
+		pool.workerPath = std::move(workerPath);
+		fillProxyWorkerPool(module.get(), pool);
+	}
+}
+
+void IPAManager::fillProxyWorkerPool(const IPAModule *ipam, ProxyWorkerPool &pool)
+{
+	while (pool.workers.size() < proxyPoolSize_) {
+		auto worker = std::make_unique<IPCPipeUnixSocket>(ipam->path().c_str(),
+								  pool.workerPath.c_str());
+		if (!worker->isConnected()) {
+			LOG(IPAManager, Warning)
+				<< "Failed to pre-spawn proxy worker for "
+				<< ipam->path();
+			return;
+		}
+
+		pool.workers.push_back(std::move(worker));
+	}
+}
+
+/**
+ * \fn IPAManager::createIPA(PipelineHandler *pipe, uint32_t minVersion, uint32_t maxVersion)
  * \brief Create an IPA proxy that matches a given pipeline handler
  * \param[in] pipe The pipeline handler that wants a matching IPA proxy
  * \param[in] minVersion Minimum acceptable version of IPA module
@@ -274,6 +462,30 @@ IPAModule *IPAManager::module(PipelineHandler *pipe, uint32_t minVersion,
  * found or if the IPA proxy fails to initialize
  */
 
+/**
+ * \fn IPAManager::createIPA(const char *pipelineName, uint32_t minVersion, uint32_t maxVersion)
+ * \brief Create an IPA proxy that matches a given pipeline handler name
+ * \param[in] pipelineName The name of the pipeline handler the IPA module is
+ * designed for
+ * \param[in] minVersion Minimum acceptable version of IPA module
+ * \param[in] maxVersion Maximum acceptable version of IPA module
+ *
+ * This function is meant for IPA modules that are used by multiple pipeline
+ * handlers, such as the soft ISP IPA module.
+ *
+ * \return A newly created IPA proxy, or nullptr if no matching IPA module is
+ * found or if the IPA proxy fails to initialize
+ */
+
+/**
+ * \fn IPAManager::createProxy()
+ * \brief Create an IPA proxy for an IPA module
+ * \param[in] m The IPA module, may be null
+ *
+ * \return A newly created IPA proxy, or nullptr if \a m is null or if the IPA
+ * proxy fails to initialize
+ */
+
 #if HAVE_IPA_PUBKEY
 /**
  * \fn IPAManager::pubKey()
@@ -297,6 +509,21 @@ bool IPAManager::isSignatureValid([[maybe_unused]] IPAModule *ipa) const
 		return false;
 	}
 
+	IPAModuleCache::Stamp stamp{};
+	if (moduleCache_) {
+		stamp = IPAModuleCache::stamp(ipa->path());
+		const IPAModuleCache::Entry *entry =
+			moduleCache_->find(ipa->path(), stamp);
+
+		if (entry && entry->signatureValid) {
+			LOG(IPAManager, Debug)
+				<< "IPA module " << ipa->path()
+				<< " cached signature status is "
+				<< (*entry->signatureValid ? "valid" : "not valid");
+			return *entry->signatureValid;
+		}
+	}
+
 	File file{ ipa->path() };
 	if (!file.open(File::OpenModeFlag::ReadOnly))
 		return false;
@@ -311,6 +538,11 @@ bool IPAManager::isSignatureValid([[maybe_unused]] IPAModule *ipa) const
 		<< "IPA module " << ipa->path() << " signature is "
 		<< (valid ? "valid" : "not valid");
 
+	if (moduleCache_) {
+		moduleCache_->setSignatureValid(ipa->path(), stamp, valid);
+		moduleCache_->save();
+	}
+
 	return valid;
 #else
 	return false;
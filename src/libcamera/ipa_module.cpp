@@ -261,6 +261,37 @@ IPAModule::IPAModule(const std::string &libPath)
 	if (loadIPAModuleInfo() < 0)
 		return;
 
+	if (validateIPAModuleInfo() < 0)
+		return;
+
+	loadSignature();
+
+	valid_ = true;
+}
+
+/**
+ * \brief Construct an IPAModule instance from known IPA module information
+ * \param[in] libPath path to IPA module shared object
+ * \param[in] info The IPA module information
+ *
+ * Construct an IPAModule without parsing the IPA module shared object at
+ * libPath, using instead the IPA module information previously retrieved from
+ * the same shared object. This is used to avoid parsing IPA modules when their
+ * information is available from the IPAModuleCache.
+ *
+ * The information is validated as for the IPAModule(const std::string &)
+ * constructor, and the caller shall call the isValid() function after
+ * constructing an IPAModule instance to verify the validity of the IPAModule.
+ */
+IPAModule::IPAModule(const std::string &libPath, const struct IPAModuleInfo &info)
+	: info_(info), libPath_(libPath), valid_(false), loaded_(false),
+	  dlHandle_(nullptr), ipaCreate_(nullptr)
+{
+	if (validateIPAModuleInfo() < 0)
+		return;
+
+	loadSignature();
+
 	valid_ = true;
 }
 
@@ -294,6 +325,11 @@ int IPAModule::loadIPAModuleInfo()
 
 	memcpy(&info_, info.data(), sizeof(info_));
 
+	return 0;
+}
+
+int IPAModule::validateIPAModuleInfo() const
+{
 	if (info_.moduleAPIVersion != IPA_MODULE_API_VERSION) {
 		LOG(IPAModule, Error) << "IPA module API version mismatch";
 		return -EINVAL;
@@ -318,21 +354,24 @@ int IPAModule::loadIPAModuleInfo()
 		return -EINVAL;
 	}
 
+	return 0;
+}
+
+void IPAModule::loadSignature()
+{
 	/* Load the signature. Failures are not fatal. */
 	File sign{ libPath_ + ".sign" };
 	if (!sign.open(File::OpenModeFlag::ReadOnly)) {
 		LOG(IPAModule, Debug)
 			<< "IPA module " << libPath_ << " is not signed";
-		return 0;
+		return;
 	}
 
-	data = sign.map(0, -1, File::MapFlag::Private);
+	Span<const uint8_t> data = sign.map(0, -1, File::MapFlag::Private);
 	signature_.resize(data.size());
 	memcpy(signature_.data(), data.data(), data.size());
 
 	LOG(IPAModule, Debug) << "IPA module " << libPath_ << " is signed";
-
-	return 0;
 }
 
 /**
@@ -474,10 +513,25 @@ IPAInterface *IPAModule::createInterface()
  */
 bool IPAModule::match(PipelineHandler *pipe,
 		      uint32_t minVersion, uint32_t maxVersion) const
+{
+	return match(pipe->name(), minVersion, maxVersion);
+}
+
+/**
+ * \brief Verify if the IPA module matches a given pipeline handler name
+ * \param[in] pipelineName Name of the pipeline handler to match with
+ * \param[in] minVersion Minimum acceptable version of IPA module
+ * \param[in] maxVersion Maximum acceptable version of IPA module
+ *
+ * \return True if the pipeline handler name matches the IPA module, or false
+ * otherwise
+ */
+bool IPAModule::match(const char *pipelineName,
+		      uint32_t minVersion, uint32_t maxVersion) const
 {
 	return info_.pipelineVersion >= minVersion &&
 	       info_.pipelineVersion <= maxVersion &&
-	       !strcmp(info_.pipelineName, pipe->name());
+	       !strcmp(info_.pipelineName, pipelineName);
 }
 
 std::string IPAModule::logPrefix() const
@@ -0,0 +1,442 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Persistent cache of IPA module information
+ */
+
+#include "libcamera/internal/ipa_module_cache.h"
+
+#include <charconv>
+#include <errno.h>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include <libcamera/base/log.h>
+#include <libcamera/base/unique_fd.h>
+#include <libcamera/base/utils.h>
+
+/**
+ * \file ipa_module_cache.h
+ * \brief Persistent cache of IPA module information
+ */
+
+namespace libcamera {
+
+LOG_DECLARE_CATEGORY(IPAManager)
+
+namespace {
+
+constexpr unsigned int kCacheVersion = 1;
+
+template<typename T>
+bool parseNumber(const std::string &str, T *value)
+{
+	const char *end = str.data() + str.size();
+	auto [ptr, ec] = std::from_chars(str.data(), end, *value);
+	return ec == std::errc() && ptr == end;
+}
+
+bool isStorable(const std::string &str)
+{
+	return str.find_first_of("\t\n") == std::string::npos;
+}
+
+IPAModuleCache::FileStamp fileStamp(const std::string &path)
+{
+	struct stat st;
+
+	if (stat(path.c_str(), &st) < 0)
+		return {};
+
+	return {
+		static_cast<uint64_t>(st.st_dev),
+		static_cast<uint64_t>(st.st_ino),
+		static_cast<int64_t>(st.st_size),
+		st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec,
+		st.st_ctim.tv_sec * 1000000000LL + st.st_ctim.tv_nsec,
+	};
+}
+
+void writeFileStamp(std::ostream &stream, const IPAModuleCache::FileStamp &stamp)
+{
+	stream << stamp.dev << '\t' << stamp.ino << '\t' << stamp.size << '\t'
+	       << stamp.mtime << '\t' << stamp.ctime;
+}
+
+bool parseFileStamp(const std::vector<std::string> &fields, unsigned int index,
+		    IPAModuleCache::FileStamp *stamp)
+{
+	return parseNumber(fields[index], &stamp->dev) &&
+	       parseNumber(fields[index + 1], &stamp->ino) &&
+	       parseNumber(fields[index + 2], &stamp->size) &&
+	       parseNumber(fields[index + 3], &stamp->mtime) &&
+	       parseNumber(fields[index + 4], &stamp->ctime);
+}
+
+} /* namespace */
+
+/**
+ * \class IPAModuleCache
+ * \brief Persistent cache of IPA module information and signature status
+ *
+ * Discovering IPA modules requires parsing the ELF headers of every shared
+ * object found in the IPA module directories, and deciding whether to isolate
+ * an IPA module requires hashing the whole shared object to verify its
+ * signature. Both operations are repeated by every process that creates a
+ * CameraManager. The IPAModuleCache stores the result of those operations in a
+ * file, and allows the IPAManager to skip them when the IPA modules haven't
+ * changed.
+ *
+ * Cache entries are indexed by the IPA module path, and are only considered
+ * valid if the IPA module file and its signature file still match the Stamp
+ * recorded when the entry was created. The stamp includes the device, inode,
+ * size, modification and status change times of both files. As the status
+ * change time can't be set from userspace, any modification of the files
+ * invalidates the corresponding entry.
+ *
+ * The whole cache is discarded if it has been created for a different cache
+ * format, IPA module API version or IPA module signing public key. It is also
+ * ignored if it isn't owned by the current user or is writable by other users,
+ * as a tampered cache could otherwise be used to run untrusted IPA modules
+ * without isolation.
+ */
+
+/**
+ * \struct IPAModuleCache::FileStamp
+ * \brief Identification of the state of a file
+ *
+ * A zeroed file stamp identifies a file that doesn't exist.
+ *
+ * \var IPAModuleCache::FileStamp::dev
+ * \brief The device containing the file
+ * \var IPAModuleCache::FileStamp::ino
+ * \brief The file inode number
+ * \var IPAModuleCache::FileStamp::size
+ * \brief The file size in bytes
+ * \var IPAModuleCache::FileStamp::mtime
+ * \brief The file last modification time in nanoseconds
+ * \var IPAModuleCache::FileStamp::ctime
+ * \brief The file last status change time in nanoseconds
+ */
+
+/**
+ * \struct IPAModuleCache::Stamp
+ * \brief Identification of the state of an IPA module
+ *
+ * \var IPAModuleCache::Stamp::module
+ * \brief The stamp of the IPA module shared object
+ * \var IPAModuleCache::Stamp::signature
+ * \brief The stamp of the IPA module signature file
+ */
+
+/**
+ * \struct IPAModuleCache::Entry
+ * \brief Cached data for an IPA module
+ *
+ * \var IPAModuleCache::Entry::info
+ * \brief The IPA module information
+ * \var IPAModuleCache::Entry::signatureValid
+ * \brief The IPA module signature verification result, if known
+ */
+
+/**
+ * \brief Construct an IPAModuleCache and load its content from \a path
+ * \param[in] path The path to the cache file
+ * \param[in] publicKey The IPA module signing public key data
+ *
+ * If the cache file doesn't exist or can't be used, the cache is constructed
+ * empty.
+ */
+IPAModuleCache::IPAModuleCache(const std::string &path,
+			       Span<const uint8_t> publicKey)
+	: path_(path), dirty_(false)
+{
+	std::ostringstream header;
+
+	header << "libcamera-ipa-module-cache " << kCacheVersion << " "
+	       << IPA_MODULE_API_VERSION << " ";
+
+	if (publicKey.empty()) {
+		header << "-";
+	} else {
+		header << std::hex << std::setfill('0');
+		for (uint8_t byte : publicKey)
+			header << std::setw(2) << static_cast<unsigned int>(byte);
+	}
+
+	header_ = header.str();
+
+	load();
+}
+
+/**
+ * \brief Retrieve the default location of the IPA module cache file
+ *
+ * The cache file is stored in the libcamera directory of the user cache
+ * directory, as specified by the XDG base directory specification.
+ *
+ * \return The default cache file path, or an empty string if the user cache
+ * directory can't be determined
+ */
+std::string IPAModuleCache::defaultPath()
+{
+	std::filesystem::path cacheDirectory;
+
+	const char *xdgCacheHome = utils::secure_getenv("XDG_CACHE_HOME");
+	if (xdgCacheHome && xdgCacheHome[0]) {
+		cacheDirectory = xdgCacheHome;
+	} else {
+		const char *home = utils::secure_getenv("HOME");
+		if (!home || !home[0])
+			return {};
+
+		cacheDirectory = std::filesystem::path(home) / ".cache";
+	}
+
+	return cacheDirectory / "libcamera" / "ipa_module_cache";
+}
+
+/**
+ * \brief Compute the stamp of an IPA module
+ * \param[in] modulePath The IPA module path
+ *
+ * The stamp should be computed before reading the IPA module, to ensure that
+ * modifications to the module performed concurrently with the read invalidate
+ * the cache entry.
+ *
+ * \return The current stamp of the IPA module
+ */
+IPAModuleCache::Stamp IPAModuleCache::stamp(const std::string &modulePath)
+{
+	return { fileStamp(modulePath), fileStamp(modulePath + ".sign") };
+}
+
+/**
+ * \brief Find the cache entry for an IPA module
+ * \param[in] modulePath The IPA module path
+ * \param[in] stamp The current stamp of the IPA module
+ *
+ * \return The cache entry for the IPA module if it exists and matches \a stamp,
+ * or nullptr otherwise
+ */
+const IPAModuleCache::Entry *IPAModuleCache::find(const std::string &modulePath,
+						  const Stamp &stamp) const
+{
+	auto iter = records_.find(modulePath);
+	if (iter == records_.end() || iter->second.stamp != stamp)
+		return nullptr;
+
+	return &iter->second.entry;
+}
+
+/**
+ * \brief Store the information of an IPA module in the cache
+ * \param[in] modulePath The IPA module path
+ * \param[in] stamp The stamp of the IPA module computed before reading it
+ * \param[in] info The IPA module information
+ *
+ * Any previous cache entry for the IPA module is replaced, including its
+ * signature verification result.
+ */
+void IPAModuleCache::update(const std::string &modulePath, const Stamp &stamp,
+			    const struct IPAModuleInfo &info)
+{
+	if (!isStorable(modulePath))
+		return;
+
+	Record &record = records_[modulePath];
+	record.stamp = stamp;
+	record.entry.info = info;
+	record.entry.signatureValid.reset();
+
+	dirty_ = true;
+}
+
+/**
+ * \brief Store the signature verification result of an IPA module in the cache
+ * \param[in] modulePath The IPA module path
+ * \param[in] stamp The stamp of the IPA module computed before verifying it
+ * \param[in] valid The signature verification result
+ *
+ * The result is ignored if the cache doesn't contain an entry for the IPA
+ * module that matches \a stamp.
+ */
+void IPAModuleCache::setSignatureValid(const std::string &modulePath,
+				       const Stamp &stamp, bool valid)
+{
+	auto iter = records_.find(modulePath);
+	if (iter == records_.end() || iter->second.stamp != stamp)
+		return;
+
+	iter->second.entry.signatureValid = valid;
+	dirty_ = true;
+}
+
+/**
+ * \brief Write the cache to disk
+ *
+ * The cache is only written if it has been modified since it was loaded. It is
+ * written to a temporary file that then atomically replaces the cache file,
+ * ensuring that concurrent readers never see a partially written cache.
+ *
+ * \return 0 on success or a negative error code otherwise
+ */
+int IPAModuleCache::save()
+{
+	if (!dirty_ || path_.empty())
+		return 0;
+
+	std::error_code ec;
+	std::filesystem::path path{ path_ };
+	std::filesystem::create_directories(path.parent_path(), ec);
+	if (ec) {
+		LOG(IPAManager, Debug)
+			<< "Failed to create IPA module cache directory: "
+			<< ec.message();
+		return -ec.value();
+	}
+
+	std::ostringstream data;
+	data << header_ << "\n";
+
+	for (const auto &[modulePath, record] : records_) {
+		const IPAModuleInfo &info = record.entry.info;
+		const std::string pipelineName(info.pipelineName,
+					       strnlen(info.pipelineName, sizeof(info.pipelineName)));
+		const std::string name(info.name, strnlen(info.name, sizeof(info.name)));
+
+		if (!isStorable(pipelineName) || !isStorable(name))
+			continue;
+
+		data << modulePath << '\t';
+		writeFileStamp(data, record.stamp.module);
+		data << '\t';
+		writeFileStamp(data, record.stamp.signature);
+		data << '\t' << info.pipelineVersion
+		     << '\t' << pipelineName
+		     << '\t' << name
+		     << '\t' << (!record.entry.signatureValid ? -1
+				 : *record.entry.signatureValid ? 1 : 0)
+		     << "\n";
+	}
+
+	const std::string tmpPath = path_ + "." + std::to_string(getpid());
+	const std::string content = data.str();
+
+	mode_t mask = umask(077);
+	std::ofstream file(tmpPath, std::ios::trunc);
+	umask(mask);
+
+	file << content;
+	file.close();
+
+	if (!file) {
+		std::filesystem::remove(tmpPath, ec);
+		LOG(IPAManager, Debug) << "Failed to write IPA module cache";
+		return -EIO;
+	}
+
+	if (rename(tmpPath.c_str(), path_.c_str()) < 0) {
+		int ret = -errno;
+		std::filesystem::remove(tmpPath, ec);
+		LOG(IPAManager, Debug)
+			<< "Failed to write IPA module cache: " << strerror(-ret);
+		return ret;
+	}
+
+	dirty_ = false;
+
+	return 0;
+}
+
+void IPAModuleCache::load()
+{
+	if (path_.empty())
+		return;
+
+	UniqueFD fd(open(path_.c_str(), O_RDONLY | O_CLOEXEC));
+	if (!fd.isValid())
+		return;
+
+	struct stat st;
+	if (fstat(fd.get(), &st) < 0 || !S_ISREG(st.st_mode) ||
+	    st.st_uid != geteuid() || st.st_mode & (S_IWGRP | S_IWOTH)) {
+		LOG(IPAManager, Warning)
+			<< "Ignoring IPA module cache " << path_
+			<< " with unsafe ownership or permissions";
+		return;
+	}
+
+	std::string content(st.st_size, '\0');
+	ssize_t ret = read(fd.get(), content.data(), content.size());
+	if (ret != st.st_size)
+		return;
+
+	std::istringstream stream(content);
+	std::string line;
+	if (!std::getline(stream, line) || line != header_) {
+		LOG(IPAManager, Debug) << "Discarding stale IPA module cache";
+		return;
+	}
+
+	while (std::getline(stream, line)) {
+		if (!parseRecord(line)) {
+			LOG(IPAManager, Warning)
+				<< "Discarding corrupted IPA module cache";
+			records_.clear();
+			return;
+		}
+	}
+
+	LOG(IPAManager, Debug)
+		<< "Loaded " << records_.size() << " entries from IPA module cache";
+}
+
+bool IPAModuleCache::parseRecord(const std::string &line)
+{
+	std::vector<std::string> fields;
+	for (const std::string &field : utils::split(line, "\t"))
+		fields.push_back(field);
+
+	if (fields.size() != 15)
+		return false;
+
+	Record record{};
+	uint32_t pipelineVersion;
+	int signatureValid;
+
+	if (!parseFileStamp(fields, 1, &record.stamp.module) ||
+	    !parseFileStamp(fields, 6, &record.stamp.signature) ||
+	    !parseNumber(fields[11], &pipelineVersion) ||
+	    !parseNumber(fields[14], &signatureValid))
+		return false;
+
+	const std::string &pipelineName = fields[12];
+	const std::string &name = fields[13];
+	if (pipelineName.size() >= sizeof(record.entry.info.pipelineName) ||
+	    name.size() >= sizeof(record.entry.info.name))
+		return false;
+
+	record.entry.info.moduleAPIVersion = IPA_MODULE_API_VERSION;
+	record.entry.info.pipelineVersion = pipelineVersion;
+	memcpy(record.entry.info.pipelineName, pipelineName.c_str(),
+	       pipelineName.size() + 1);
+	memcpy(record.entry.info.name, name.c_str(), name.size() + 1);
+
+	if (signatureValid >= 0)
+		record.entry.signatureValid = signatureValid == 1;
+
+	records_[fields[0]] = record;
+
+	return true;
+}
+
+} /* namespace libcamera */
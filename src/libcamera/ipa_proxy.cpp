@@ -201,6 +201,7 @@ std::string IPAProxy::configurationFile(const std::string &name,
 }
 
 /**
+ * \fn IPAProxy::resolvePath(const std::string &file) const
  * \brief Find a valid full path for a proxy worker for a given executable name
  * \param[in] file File name of proxy worker executable
  *
@@ -214,12 +215,26 @@ std::string IPAProxy::configurationFile(const std::string &name,
  * \return The full path to the proxy worker executable, or an empty string if
  * no valid executable path
  */
-std::string IPAProxy::resolvePath(const std::string &file) const
+
+/**
+ * \brief Find a valid full path for a proxy worker in a set of directories
+ * \param[in] file File name of proxy worker executable
+ * \param[in] execPaths The directories set by the ipa.proxy_paths option
+ *
+ * This function is used by the IPAManager to locate proxy workers before any
+ * IPA proxy is created. It otherwise behaves as resolvePath(const std::string &)
+ * does, looking up \a execPaths first.
+ *
+ * \return The full path to the proxy worker executable, or an empty string if
+ * no valid executable path
+ */
+std::string IPAProxy::resolvePath(const std::string &file,
+				  const std::vector<std::string> &execPaths)
 {
 	std::string proxyFile = "/" + file;
 
 	/* Try paths from the configuration first. */
-	for (const auto &dir : execPaths_) {
+	for (const auto &dir : execPaths) {
 		if (dir.empty())
 			continue;
 
@@ -40,6 +40,7 @@ IPCPipeUnixSocket::IPCPipeUnixSocket(const char *ipaModulePath,
 	std::array fds{ fd.get() };
 
 	proc_ = std::make_unique<Process>();
+	proc_->finished.connect(this, &IPCPipeUnixSocket::processFinished);
 	int ret = proc_->start(ipaProxyWorkerPath, args, fds);
 	if (ret) {
 		LOG(IPCPipe, Error)
@@ -109,6 +110,16 @@ void IPCPipeUnixSocket::readyRead()
 	recv.emit(ipcMessage);
 }
 
+void IPCPipeUnixSocket::processFinished(enum Process::ExitStatus exitStatus,
+					int exitCode)
+{
+	LOG(IPCPipe, Debug)
+		<< "Proxy worker process terminated, status " << exitStatus
+		<< ", code " << exitCode;
+
+	connected_ = false;
+}
+
 int IPCPipeUnixSocket::call(const IPCUnixSocket::Payload &message,
 			    IPCUnixSocket::Payload *response, uint32_t cookie)
 {
@@ -335,11 +335,11 @@ done:
  */
 MediaEntity *MediaDevice::getEntityByName(const std::string &name) const
 {
-	for (MediaEntity *e : entities_)
-		if (e->name() == name)
-			return e;
+	auto it = entitiesByName_.find(name);
+	if (it == entitiesByName_.end())
+		return nullptr;
 
-	return nullptr;
+	return it->second;
 }
 
 /**
@@ -594,6 +594,7 @@ void MediaDevice::clear()
 
 	objects_.clear();
 	entities_.clear();
+	entitiesByName_.clear();
 	valid_ = false;
 }
 
@@ -602,6 +603,14 @@ void MediaDevice::clear()
  * \brief Global list of media entities in the media graph
  */
 
+/**
+ * \var MediaDevice::entitiesByName_
+ * \brief Index of the media entities in the media graph by name
+ *
+ * Entity names are unique within a media device. Should the kernel report
+ * duplicated names, the index points to the first entity with the name.
+ */
+
 /**
  * \brief Find the interface associated with an entity
  * \param[in] topology The media topology as returned by MEDIA_IOC_G_TOPOLOGY
@@ -674,6 +683,7 @@ bool MediaDevice::populateEntities(const struct media_v2_topology &topology)
 		}
 
 		entities_.push_back(entity);
+		entitiesByName_.emplace(entity->name(), entity);
 	}
 
 	return true;
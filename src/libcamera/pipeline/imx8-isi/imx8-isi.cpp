@@ -1126,10 +1126,12 @@ void PipelineHandlerISI::bufferReady(FrameBuffer *buffer)
 	Request *request = buffer->request();
 
 	/* Record the sensor's timestamp in the request metadata. */
-	ControlList &metadata = request->_d()->metadata();
-	if (!metadata.contains(controls::SensorTimestamp.id()))
-		metadata.set(controls::SensorTimestamp,
-			     buffer->metadata().timestamp);
+	if (!request->metadata().contains(controls::SensorTimestamp.id())) {
+		ControlList sensorMetadata(controls::controls);
+		sensorMetadata.set(controls::SensorTimestamp,
+				   buffer->metadata().timestamp);
+		metadataAvailable(request, sensorMetadata);
+	}
 
 	if (completeBuffer(request, buffer))
 		completeRequest(request);
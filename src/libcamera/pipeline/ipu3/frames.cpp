@@ -20,6 +20,9 @@ namespace libcamera {
 LOG_DECLARE_CATEGORY(IPU3)
 
 IPU3Frames::IPU3Frames()
+	: frameInfo_([](const Info &info) {
+		  return info.metadataProcessed && info.paramDequeued;
+	  })
 {
 }
 
@@ -33,6 +36,7 @@ void IPU3Frames::init(const std::vector<std::unique_ptr<FrameBuffer>> &paramBuff
 		availableStatBuffers_.push(buffer.get());
 
 	frameInfo_.clear();
+	frameInfo_.reserve(paramBuffers.size());
 }
 
 void IPU3Frames::clear()
@@ -61,20 +65,26 @@ IPU3Frames::Info *IPU3Frames::create(Request *request)
 	availableParamBuffers_.pop();
 	availableStatBuffers_.pop();
 
-	auto [it, inserted] = frameInfo_.try_emplace(id);
-	ASSERT(inserted);
+	Info *info = frameInfo_.create(id, request);
 
-	auto &info = it->second;
+	info->id = id;
+	info->request = request;
+	info->rawBuffer = nullptr;
+	info->paramBuffer = paramBuffer;
+	info->statBuffer = statBuffer;
+	info->paramDequeued = false;
+	info->metadataProcessed = false;
 
-	info.id = id;
-	info.request = request;
-	info.rawBuffer = nullptr;
-	info.paramBuffer = paramBuffer;
-	info.statBuffer = statBuffer;
-	info.paramDequeued = false;
-	info.metadataProcessed = false;
+	frameInfo_.addBuffer(id, paramBuffer);
+	frameInfo_.addBuffer(id, statBuffer);
 
-	return &info;
+	return info;
+}
+
+void IPU3Frames::setRawBuffer(IPU3Frames::Info *info, FrameBuffer *buffer)
+{
+	info->rawBuffer = buffer;
+	frameInfo_.addBuffer(info->id, buffer);
 }
 
 void IPU3Frames::remove(IPU3Frames::Info *info)
@@ -84,23 +94,20 @@ void IPU3Frames::remove(IPU3Frames::Info *info)
 	availableStatBuffers_.push(info->statBuffer);
 
 	/* Delete the extended frame information. */
-	frameInfo_.erase(info->id);
+	frameInfo_.remove(info->id);
 }
 
 bool IPU3Frames::tryComplete(IPU3Frames::Info *info)
 {
-	Request *request = info->request;
-
-	if (request->hasPendingBuffers())
-		return false;
+	FrameBuffer *paramBuffer = info->paramBuffer;
+	FrameBuffer *statBuffer = info->statBuffer;
 
-	if (!info->metadataProcessed)
+	if (!frameInfo_.tryComplete(info->id))
 		return false;
 
-	if (!info->paramDequeued)
-		return false;
-
-	remove(info);
+	/* Return params and stat buffer for reuse. */
+	availableParamBuffers_.push(paramBuffer);
+	availableStatBuffers_.push(statBuffer);
 
 	bufferAvailable.emit();
 
@@ -109,10 +116,9 @@ bool IPU3Frames::tryComplete(IPU3Frames::Info *info)
 
 IPU3Frames::Info *IPU3Frames::find(unsigned int id)
 {
-	const auto &itInfo = frameInfo_.find(id);
-
-	if (itInfo != frameInfo_.end())
-		return &itInfo->second;
+	Info *info = frameInfo_.find(id);
+	if (info)
+		return info;
 
 	LOG(IPU3, Fatal) << "Can't find tracking information for frame " << id;
 
@@ -121,15 +127,9 @@ IPU3Frames::Info *IPU3Frames::find(unsigned int id)
 
 IPU3Frames::Info *IPU3Frames::find(FrameBuffer *buffer)
 {
-	for (auto &[id, info] : frameInfo_) {
-		for (const auto &[stream, buf] : info.request->buffers())
-			if (buf == buffer)
-				return &info;
-
-		if (info.rawBuffer == buffer || info.paramBuffer == buffer ||
-		    info.statBuffer == buffer)
-			return &info;
-	}
+	Info *info = frameInfo_.find(buffer);
+	if (info)
+		return info;
 
 	LOG(IPU3, Fatal) << "Can't find tracking information from buffer";
 
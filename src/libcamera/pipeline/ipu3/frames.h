@@ -7,7 +7,6 @@
 
 #pragma once
 
-#include <map>
 #include <memory>
 #include <queue>
 #include <vector>
@@ -16,6 +15,8 @@
 
 #include <libcamera/controls.h>
 
+#include "libcamera/internal/frame_info_tracker.h"
+
 namespace libcamera {
 
 class FrameBuffer;
@@ -45,6 +46,7 @@ public:
 	void clear();
 
 	Info *create(Request *request);
+	void setRawBuffer(Info *info, FrameBuffer *buffer);
 	void remove(Info *info);
 	bool tryComplete(Info *info);
 
@@ -57,7 +59,7 @@ private:
 	std::queue<FrameBuffer *> availableParamBuffers_;
 	std::queue<FrameBuffer *> availableStatBuffers_;
 
-	std::map<unsigned int, Info> frameInfo_;
+	FrameInfoTracker<Info> frameInfo_;
 };
 
 } /* namespace libcamera */
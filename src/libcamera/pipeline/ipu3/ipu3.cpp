@@ -86,6 +86,9 @@ public:
 
 	ControlInfoMap ipaControls_;
 
+	/* Sequence of the next frame to start, lens controls take effect there. */
+	uint32_t nextSequence_;
+
 private:
 	void metadataReady(unsigned int id, const ControlList &metadata);
 	void paramsComputed(unsigned int id);
@@ -741,6 +744,7 @@ int PipelineHandlerIPU3::start(Camera *camera, [[maybe_unused]] const ControlLis
 		goto error;
 
 	data->delayedCtrls_->reset();
+	data->nextSequence_ = 0;
 
 	/*
 	 * Start the ImgU video devices, buffers will be queued to the
@@ -826,7 +830,7 @@ void IPU3CameraData::queuePendingRequests()
 			break;
 		}
 
-		info->rawBuffer = rawBuffer;
+		frameInfos_.setRawBuffer(info, rawBuffer);
 
 		ipa_->queueRequest(info->id, request->controls());
 
@@ -1198,22 +1202,29 @@ int IPU3CameraData::loadIPA()
 	return 0;
 }
 
-void IPU3CameraData::setSensorControls([[maybe_unused]] unsigned int id,
+void IPU3CameraData::setSensorControls(unsigned int id,
 				       const ControlList &sensorControls,
 				       const ControlList &lensControls)
 {
-	delayedCtrls_->push(sensorControls);
+	ControlList metadata(controls::controls);
+
+	uint32_t sequence;
+	if (delayedCtrls_->push(sensorControls, &sequence))
+		metadata.set(controls::SensorControlsSequence, sequence);
 
 	CameraLens *focusLens = cio2_.sensor()->focusLens();
-	if (!focusLens)
-		return;
+	if (focusLens && lensControls.contains(V4L2_CID_FOCUS_ABSOLUTE)) {
+		const ControlValue &focusValue = lensControls.get(V4L2_CID_FOCUS_ABSOLUTE);
 
-	if (!lensControls.contains(V4L2_CID_FOCUS_ABSOLUTE))
-		return;
+		if (!focusLens->setFocusPosition(focusValue.get<int32_t>()))
+			metadata.set(controls::LensControlsSequence, nextSequence_);
+	}
 
-	const ControlValue &focusValue = lensControls.get(V4L2_CID_FOCUS_ABSOLUTE);
+	IPU3Frames::Info *info = frameInfos_.find(id);
+	if (!info || metadata.empty())
+		return;
 
-	focusLens->setFocusPosition(focusValue.get<int32_t>());
+	pipe()->metadataAvailable(info->request, metadata);
 }
 
 void IPU3CameraData::paramsComputed(unsigned int id)
@@ -1244,7 +1255,7 @@ void IPU3CameraData::metadataReady(unsigned int id, const ControlList &metadata)
 		return;
 
 	Request *request = info->request;
-	request->_d()->metadata().merge(metadata);
+	pipe()->metadataAvailable(request, metadata);
 
 	info->metadataProcessed = true;
 	if (frameInfos_.tryComplete(info))
@@ -1310,13 +1321,15 @@ void IPU3CameraData::cio2BufferReady(FrameBuffer *buffer)
 	}
 
 	/*
-	 * Record the sensor's timestamp in the request metadata.
+	 * Report the sensor's timestamp as early metadata.
 	 *
 	 * \todo The sensor timestamp should be better estimated by connecting
 	 * to the V4L2Device::frameStart signal.
 	 */
-	request->_d()->metadata().set(controls::SensorTimestamp,
-				      buffer->metadata().timestamp);
+	ControlList sensorMetadata(controls::controls);
+	sensorMetadata.set(controls::SensorTimestamp,
+			   buffer->metadata().timestamp);
+	pipe()->metadataAvailable(request, sensorMetadata);
 
 	info->effectiveSensorControls = delayedCtrls_->get(buffer->metadata().sequence);
 
@@ -1385,6 +1398,7 @@ void IPU3CameraData::statBufferReady(FrameBuffer *buffer)
 void IPU3CameraData::frameStart(uint32_t sequence)
 {
 	delayedCtrls_->applyControls(sequence);
+	nextSequence_ = sequence + 1;
 
 	if (processingRequests_.empty())
 		return;
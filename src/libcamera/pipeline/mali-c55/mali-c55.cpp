@@ -1678,7 +1678,8 @@ void PipelineHandlerMaliC55::statsBufferReady(FrameBuffer *buffer)
 	Request *request = info->request;
 	MaliC55CameraData *data = cameraData(request->_d()->camera());
 
-	ControlList sensorControls = data->delayedCtrls_->get(buffer->metadata().sequence);
+	const ControlList &sensorControls =
+		data->delayedCtrls_->get(buffer->metadata().sequence);
 
 	data->ipa_->processStats(request->sequence(), buffer->cookie(),
 				 sensorControls);
@@ -1702,8 +1703,11 @@ void PipelineHandlerMaliC55::cruBufferReady(FrameBuffer *buffer)
 	ASSERT(info);
 
 	Request *request = info->request;
-	request->_d()->metadata().set(controls::SensorTimestamp,
-				      buffer->metadata().timestamp);
+
+	ControlList sensorMetadata(controls::controls);
+	sensorMetadata.set(controls::SensorTimestamp,
+			   buffer->metadata().timestamp);
+	metadataAvailable(request, sensorMetadata);
 
 	MaliC55CameraData *data = cameraData(request->_d()->camera());
 	data->ipa_->fillParams(request->sequence(), info->paramBuffer->cookie());
@@ -1759,7 +1763,7 @@ void PipelineHandlerMaliC55::statsProcessed(unsigned int requestId,
 		return;
 
 	frameInfo.statsDone = true;
-	frameInfo.request->_d()->metadata().merge(metadata);
+	metadataAvailable(frameInfo.request, metadata);
 
 	tryComplete(&frameInfo);
 }
@@ -39,6 +39,7 @@
 #include "libcamera/internal/converter/converter_dw100.h"
 #include "libcamera/internal/delayed_controls.h"
 #include "libcamera/internal/device_enumerator.h"
+#include "libcamera/internal/frame_info_tracker.h"
 #include "libcamera/internal/framebuffer.h"
 #include "libcamera/internal/media_device.h"
 #include "libcamera/internal/media_pipeline.h"
@@ -88,7 +89,7 @@ private:
 	void recycleBuffers(const RkISP1FrameInfo &info);
 
 	PipelineHandlerRkISP1 *pipe_;
-	std::map<unsigned int, RkISP1FrameInfo> frameInfo_;
+	FrameInfoTracker<RkISP1FrameInfo> frameInfo_;
 };
 
 class RkISP1CameraData : public Camera::Private
@@ -255,6 +256,7 @@ private:
 RkISP1Frames::RkISP1Frames(PipelineHandler *pipe)
 	: pipe_(static_cast<PipelineHandlerRkISP1 *>(pipe))
 {
+	frameInfo_.reserve(kRkISP1MinBufferCount);
 }
 
 RkISP1FrameInfo *RkISP1Frames::create(const RkISP1CameraData *data, Request *request,
@@ -294,39 +296,41 @@ RkISP1FrameInfo *RkISP1Frames::create(const RkISP1CameraData *data, Request *req
 		mainPathBuffer = request->findBuffer(&data->mainPathStream_);
 	selfPathBuffer = request->findBuffer(&data->selfPathStream_);
 
-	auto [it, inserted] = frameInfo_.try_emplace(frame);
-	ASSERT(inserted);
+	RkISP1FrameInfo *info = frameInfo_.create(frame, request);
 
-	auto &info = it->second;
+	info->frame = frame;
+	info->request = request;
+	info->paramBuffer = paramBuffer;
+	info->mainPathBuffer = mainPathBuffer;
+	info->selfPathBuffer = selfPathBuffer;
+	info->statBuffer = statBuffer;
+	info->paramDequeued = false;
+	info->metadataProcessed = false;
 
-	info.frame = frame;
-	info.request = request;
-	info.paramBuffer = paramBuffer;
-	info.mainPathBuffer = mainPathBuffer;
-	info.selfPathBuffer = selfPathBuffer;
-	info.statBuffer = statBuffer;
-	info.paramDequeued = false;
-	info.metadataProcessed = false;
+	frameInfo_.addBuffer(frame, paramBuffer);
+	frameInfo_.addBuffer(frame, statBuffer);
+	frameInfo_.addBuffer(frame, mainPathBuffer);
 
-	return &info;
+	return info;
 }
 
 int RkISP1Frames::destroy(unsigned int frame)
 {
-	auto it = frameInfo_.find(frame);
-	if (it == frameInfo_.end())
+	RkISP1FrameInfo *info = frameInfo_.find(frame);
+	if (!info)
 		return -ENOENT;
 
-	recycleBuffers(it->second);
-	frameInfo_.erase(it);
+	recycleBuffers(*info);
+	frameInfo_.remove(frame);
 
 	return 0;
 }
 
 void RkISP1Frames::clear()
 {
-	for (const auto &[frame, info] : frameInfo_)
+	frameInfo_.forEach([this](const RkISP1FrameInfo &info) {
 		recycleBuffers(info);
+	});
 
 	frameInfo_.clear();
 }
@@ -345,10 +349,9 @@ void RkISP1Frames::recycleBuffers(const RkISP1FrameInfo &info)
 
 RkISP1FrameInfo *RkISP1Frames::find(unsigned int frame)
 {
-	auto itInfo = frameInfo_.find(frame);
-
-	if (itInfo != frameInfo_.end())
-		return &itInfo->second;
+	RkISP1FrameInfo *info = frameInfo_.find(frame);
+	if (info)
+		return info;
 
 	LOG(RkISP1, Fatal) << "Can't locate info from frame";
 
@@ -357,13 +360,9 @@ RkISP1FrameInfo *RkISP1Frames::find(unsigned int frame)
 
 RkISP1FrameInfo *RkISP1Frames::find(FrameBuffer *buffer)
 {
-	for (auto &[frame, info] : frameInfo_) {
-		if (info.paramBuffer == buffer ||
-		    info.statBuffer == buffer ||
-		    info.mainPathBuffer == buffer ||
-		    info.selfPathBuffer == buffer)
-			return &info;
-	}
+	RkISP1FrameInfo *info = frameInfo_.find(buffer);
+	if (info)
+		return info;
 
 	LOG(RkISP1, Fatal) << "Can't locate info from buffer";
 
@@ -372,10 +371,9 @@ RkISP1FrameInfo *RkISP1Frames::find(FrameBuffer *buffer)
 
 RkISP1FrameInfo *RkISP1Frames::find(Request *request)
 {
-	for (auto &[frame, info] : frameInfo_) {
-		if (info.request == request)
-			return &info;
-	}
+	RkISP1FrameInfo *info = frameInfo_.find(request);
+	if (info)
+		return info;
 
 	LOG(RkISP1, Fatal) << "Can't locate info from request";
 
@@ -500,10 +498,20 @@ void RkISP1CameraData::paramsComputed(unsigned int frame, unsigned int bytesused
 		selfPath_->queueBuffer(info->selfPathBuffer);
 }
 
-void RkISP1CameraData::setSensorControls([[maybe_unused]] unsigned int frame,
+void RkISP1CameraData::setSensorControls(unsigned int frame,
 					 const ControlList &sensorControls)
 {
-	delayedCtrls_->push(sensorControls);
+	uint32_t sequence;
+	if (!delayedCtrls_->push(sensorControls, &sequence))
+		return;
+
+	RkISP1FrameInfo *info = frameInfo_.find(frame);
+	if (!info)
+		return;
+
+	ControlList metadata(controls::controls);
+	metadata.set(controls::SensorControlsSequence, sequence);
+	pipe()->metadataAvailable(info->request, metadata);
 }
 
 void RkISP1CameraData::metadataReady(unsigned int frame, const ControlList &metadata)
@@ -512,7 +520,7 @@ void RkISP1CameraData::metadataReady(unsigned int frame, const ControlList &meta
 	if (!info)
 		return;
 
-	info->request->_d()->metadata().merge(metadata);
+	pipe()->metadataAvailable(info->request, metadata);
 	info->metadataProcessed = true;
 
 	pipe()->tryCompleteRequest(info);
@@ -1640,13 +1648,18 @@ void PipelineHandlerRkISP1::imageBufferReady(FrameBuffer *buffer)
 
 	if (metadata.status != FrameMetadata::FrameCancelled) {
 		/*
-		 * Record the sensor's timestamp in the request metadata.
+		 * Report the sensor's timestamp as early metadata, once for
+		 * all the streams of the request.
 		 *
 		 * \todo The sensor timestamp should be better estimated by connecting
 		 * to the V4L2Device::frameStart signal.
 		 */
-		request->_d()->metadata().set(controls::SensorTimestamp,
-					      metadata.timestamp);
+		if (!request->metadata().contains(controls::SensorTimestamp.id())) {
+			ControlList sensorMetadata(controls::controls);
+			sensorMetadata.set(controls::SensorTimestamp,
+					   metadata.timestamp);
+			metadataAvailable(request, sensorMetadata);
+		}
 
 		if (isRaw_) {
 			const ControlList &ctrls =
@@ -40,6 +40,7 @@
 #include "libcamera/internal/delayed_controls.h"
 #include "libcamera/internal/device_enumerator.h"
 #include "libcamera/internal/formats.h"
+#include "libcamera/internal/framebuffer.h"
 #include "libcamera/internal/global_configuration.h"
 #include "libcamera/internal/media_device.h"
 #include "libcamera/internal/pipeline_handler.h"
@@ -163,6 +164,18 @@ LOG_DEFINE_CATEGORY(SimplePipeline)
  * the capture video node, and stores the information in the outputFormats and
  * outputSizes of the SimpleCameraData::Configuration structure.
  *
+ * Platforms without a hardware converter can enable the software converter
+ * through the configuration file. It performs the same operations on the CPU,
+ * for YUV capture formats only.
+ *
+ * Raw Bayer capture formats are processed by the software ISP when it is
+ * enabled. If a hardware converter is also present, the two are chained: the
+ * software ISP debayers the captured frames to internal buffers, in the first
+ * of its output formats that the converter accepts, and the converter then
+ * scales and converts those buffers to all the output streams. The internal
+ * buffers are handed from one stage to the next without any copy, and the two
+ * stages run concurrently on consecutive frames.
+ *
  * Concurrent Access to Cameras
  * ----------------------------
  *
@@ -248,7 +261,8 @@ struct SimplePipelineInfo {
 	/*
 	 * Using Software ISP is to be enabled per driver.
 	 *
-	 * The Software ISP can't be used together with the converters.
+	 * When a converter is also present, the Software ISP output is fed to
+	 * the converter.
 	 */
 	bool swIspEnabled;
 };
@@ -330,6 +344,12 @@ public:
 		Size captureSize;
 		std::vector<PixelFormat> outputFormats;
 		SizeRange outputSizes;
+		/* Processing stages used to produce the output formats */
+		bool swIsp;
+		bool converter;
+		/* Intermediate format and size when both stages are chained */
+		PixelFormat ispFormat;
+		Size ispSize;
 	};
 
 	std::vector<Stream> streams_;
@@ -356,6 +376,18 @@ public:
 	};
 	std::queue<RequestOutputs> conversionQueue_;
 	bool useConversion_;
+	bool useSwIsp_;
+	bool useConverter_;
+
+	/*
+	 * Internal buffers passed from the Software ISP to the converter when
+	 * the two are chained, and the outputs of the requests being processed
+	 * by the Software ISP.
+	 */
+	Stream ispStream_;
+	std::vector<std::unique_ptr<FrameBuffer>> ispBuffers_;
+	std::queue<FrameBuffer *> availableIspBuffers_;
+	std::queue<RequestOutputs> ispQueue_;
 
 	std::unique_ptr<Converter> converter_;
 	std::unique_ptr<SoftwareIsp> swIsp_;
@@ -366,8 +398,11 @@ private:
 	static std::vector<const MediaPad *> routedSourcePads(MediaPad *sink);
 
 	void tryCompleteRequest(Request *request);
+	void cancelOutputs(const RequestOutputs &outputs);
 	void conversionInputDone(FrameBuffer *buffer);
 	void conversionOutputDone(FrameBuffer *buffer);
+	void converterInputDone(FrameBuffer *buffer);
+	void ispOutputDone(FrameBuffer *buffer);
 
 	void ispStatsReady(uint32_t frame, uint32_t bufferId);
 	void metadataReady(uint32_t frame, const ControlList &metadata);
@@ -426,6 +461,7 @@ public:
 	V4L2VideoDevice *video(const MediaEntity *entity);
 	V4L2Subdevice *subdev(const MediaEntity *entity);
 	std::shared_ptr<MediaDevice> converter() { return converter_; }
+	bool swConverterEnabled() const { return swConverterEnabled_; }
 	bool swIspEnabled() const { return swIspEnabled_; }
 
 protected:
@@ -434,6 +470,7 @@ protected:
 private:
 	static constexpr unsigned int kMaxQueuedRequestsDevice = 4;
 	static constexpr unsigned int kNumInternalBuffers = 4;
+	static constexpr unsigned int kSoftwareConverterStreams = 3;
 
 	struct EntityData {
 		std::unique_ptr<V4L2VideoDevice> video;
@@ -459,6 +496,7 @@ private:
 	std::map<const MediaEntity *, EntityData> entities_;
 
 	std::shared_ptr<MediaDevice> converter_;
+	bool swConverterEnabled_;
 	bool swIspEnabled_;
 };
 
@@ -601,20 +639,23 @@ int SimpleCameraData::init()
 	std::shared_ptr<MediaDevice> converter = pipe->converter();
 	if (converter) {
 		converter_ = ConverterFactoryBase::create(converter);
-		if (!converter_) {
+		if (!converter_)
 			LOG(SimplePipeline, Warning)
 				<< "Failed to create converter, disabling format conversion";
-			converter_.reset();
-		} else {
-			converter_->inputBufferReady.connect(this, &SimpleCameraData::conversionInputDone);
-			converter_->outputBufferReady.connect(this, &SimpleCameraData::conversionOutputDone);
-		}
+	} else if (pipe->swConverterEnabled()) {
+		converter_ = ConverterFactoryBase::create("software");
+		if (!converter_)
+			LOG(SimplePipeline, Warning)
+				<< "Failed to create software converter, disabling format conversion";
 	}
 
-	/*
-	 * Instantiate Soft ISP if this is enabled for the given driver and no converter is used.
-	 */
-	if (!converter_ && pipe->swIspEnabled()) {
+	if (converter_) {
+		converter_->inputBufferReady.connect(this, &SimpleCameraData::converterInputDone);
+		converter_->outputBufferReady.connect(this, &SimpleCameraData::conversionOutputDone);
+	}
+
+	/* Instantiate Soft ISP if this is enabled for the given driver. */
+	if (pipe->swIspEnabled()) {
 		swIsp_ = std::make_unique<SoftwareIsp>(pipe, sensor_.get(), &controlInfo_);
 		if (!swIsp_->isValid()) {
 			LOG(SimplePipeline, Warning)
@@ -622,7 +663,7 @@ int SimpleCameraData::init()
 			swIsp_.reset();
 		} else {
 			swIsp_->inputBufferReady.connect(this, &SimpleCameraData::conversionInputDone);
-			swIsp_->outputBufferReady.connect(this, &SimpleCameraData::conversionOutputDone);
+			swIsp_->outputBufferReady.connect(this, &SimpleCameraData::ispOutputDone);
 			swIsp_->ispStatsReady.connect(this, &SimpleCameraData::ispStatsReady);
 			swIsp_->metadataReady.connect(this, &SimpleCameraData::metadataReady);
 			swIsp_->setSensorControls.connect(this, &SimpleCameraData::setSensorControls);
@@ -737,19 +778,62 @@ void SimpleCameraData::tryPipeline(unsigned int code, const Size &size)
 		config.sensorSize = size;
 		config.captureFormat = pixelFormat;
 		config.captureSize = format.size;
+		config.swIsp = false;
+		config.converter = false;
 
-		if (converter_) {
+		std::vector<PixelFormat> ispFormats;
+		if (swIsp_)
+			ispFormats = swIsp_->formats(pixelFormat);
+
+		/*
+		 * Chain the Software ISP and the converter if the converter
+		 * accepts one of the Software ISP output formats. The
+		 * intermediate buffers use the largest size that both stages
+		 * support.
+		 */
+		if (!ispFormats.empty() && converter_) {
+			SizeRange ispSizes = swIsp_->sizes(pixelFormat, format.size);
+
+			for (const PixelFormat &ispFormat : ispFormats) {
+				std::vector<PixelFormat> outputFormats =
+					converter_->formats(ispFormat);
+				if (outputFormats.empty())
+					continue;
+
+				Size ispSize = converter_->adjustInputSize(ispFormat, ispSizes.max)
+						       .alignedDownTo(ispSizes.hStep, ispSizes.vStep);
+				if (!ispSizes.contains(ispSize) ||
+				    converter_->adjustInputSize(ispFormat, ispSize) != ispSize)
+					continue;
+
+				config.outputFormats = std::move(outputFormats);
+				config.outputSizes = converter_->sizes(ispSize);
+				config.swIsp = true;
+				config.converter = true;
+				config.ispFormat = ispFormat;
+				config.ispSize = ispSize;
+				break;
+			}
+		}
+
+		if (config.outputFormats.empty() && converter_) {
 			config.outputFormats = converter_->formats(pixelFormat);
 			config.outputSizes = converter_->sizes(format.size);
-		} else if (swIsp_) {
-			config.outputFormats = swIsp_->formats(pixelFormat);
+			config.converter = !config.outputFormats.empty();
+		}
+
+		if (config.outputFormats.empty() && !ispFormats.empty()) {
+			config.outputFormats = std::move(ispFormats);
 			config.outputSizes = swIsp_->sizes(pixelFormat, format.size);
-			if (config.outputFormats.empty()) {
-				/* Do not use swIsp for unsupported pixelFormat's. */
-				config.outputFormats = { pixelFormat };
-				config.outputSizes = config.captureSize;
-			}
-		} else {
+			config.swIsp = true;
+		}
+
+		if (config.outputFormats.empty()) {
+			/*
+			 * Without conversion, or when the converter or swIsp
+			 * doesn't support the pixelFormat, output the capture
+			 * format.
+			 */
 			config.outputFormats = { pixelFormat };
 			config.outputSizes = config.captureSize;
 		}
@@ -907,13 +991,7 @@ void SimpleCameraData::imageBufferReady(FrameBuffer *buffer)
 		if (conversionQueue_.empty())
 			return;
 
-		const RequestOutputs &outputs = conversionQueue_.front();
-		for (auto &[stream, buf] : outputs.outputs)
-			pipe->completeBuffer(outputs.request, buf);
-		SimpleFrameInfo *info = frameInfo_.find(outputs.request->sequence());
-		if (info)
-			info->metadataRequired = false;
-		tryCompleteRequest(outputs.request);
+		cancelOutputs(conversionQueue_.front());
 		conversionQueue_.pop();
 
 		return;
@@ -939,9 +1017,12 @@ void SimpleCameraData::imageBufferReady(FrameBuffer *buffer)
 		}
 	}
 
-	if (request)
-		request->_d()->metadata().set(controls::SensorTimestamp,
-					      buffer->metadata().timestamp);
+	if (request) {
+		ControlList sensorMetadata(controls::controls);
+		sensorMetadata.set(controls::SensorTimestamp,
+				   buffer->metadata().timestamp);
+		pipe->metadataAvailable(request, sensorMetadata);
+	}
 
 	/*
 	 * Queue the captured and the request buffer to the converter or Software
@@ -955,17 +1036,50 @@ void SimpleCameraData::imageBufferReady(FrameBuffer *buffer)
 			return;
 		}
 
-		if (converter_)
+		if (!useSwIsp_) {
 			converter_->queueBuffers(buffer, conversionQueue_.front().outputs);
-		else
-			/*
-			 * request->sequence() cannot be retrieved from `buffer' inside
-			 * queueBuffers because unique_ptr's make buffer->request() invalid
-			 * already here.
-			 */
-			swIsp_->queueBuffers(request->sequence(), buffer,
-					     conversionQueue_.front().outputs);
+			conversionQueue_.pop();
+			return;
+		}
 
+		/*
+		 * When the Software ISP is chained with the converter, debayer
+		 * to an internal buffer, and keep the request outputs until the
+		 * buffer is handed to the converter. Drop the frame if all
+		 * internal buffers are in use.
+		 */
+		std::map<const Stream *, FrameBuffer *> ispOutputs;
+		if (useConverter_) {
+			if (availableIspBuffers_.empty()) {
+				LOG(SimplePipeline, Warning)
+					<< "No internal buffer available, dropping frame "
+					<< request->sequence();
+
+				if (rawStream_)
+					pipe->completeBuffer(buffer->request(), buffer);
+				else
+					video_->queueBuffer(buffer);
+
+				cancelOutputs(conversionQueue_.front());
+				conversionQueue_.pop();
+				return;
+			}
+
+			ispOutputs[&ispStream_] = availableIspBuffers_.front();
+			availableIspBuffers_.pop();
+		}
+
+		/*
+		 * request->sequence() cannot be retrieved from `buffer' inside
+		 * queueBuffers because unique_ptr's make buffer->request() invalid
+		 * already here.
+		 */
+		swIsp_->queueBuffers(request->sequence(), buffer,
+				     useConverter_ ? ispOutputs
+						   : conversionQueue_.front().outputs);
+
+		if (useConverter_)
+			ispQueue_.push(std::move(conversionQueue_.front()));
 		conversionQueue_.pop();
 		return;
 	}
@@ -977,6 +1091,11 @@ void SimpleCameraData::imageBufferReady(FrameBuffer *buffer)
 
 void SimpleCameraData::clearIncompleteRequests()
 {
+	while (!ispQueue_.empty()) {
+		pipe()->cancelRequest(ispQueue_.front().request);
+		ispQueue_.pop();
+	}
+
 	while (!conversionQueue_.empty()) {
 		pipe()->cancelRequest(conversionQueue_.front().request);
 		conversionQueue_.pop();
@@ -1001,6 +1120,24 @@ void SimpleCameraData::tryCompleteRequest(Request *request)
 	pipe()->completeRequest(request);
 }
 
+void SimpleCameraData::cancelOutputs(const RequestOutputs &outputs)
+{
+	SimplePipelineHandler *pipe = SimpleCameraData::pipe();
+
+	/*
+	 * Cancel and complete all the user-facing buffers of the request, as
+	 * no frame will be produced for them.
+	 */
+	for (auto &[stream, buf] : outputs.outputs) {
+		buf->_d()->cancel();
+		pipe->completeBuffer(outputs.request, buf);
+	}
+	SimpleFrameInfo *info = frameInfo_.find(outputs.request->sequence());
+	if (info)
+		info->metadataRequired = false;
+	tryCompleteRequest(outputs.request);
+}
+
 void SimpleCameraData::conversionInputDone(FrameBuffer *buffer)
 {
 	if (rawStream_) {
@@ -1024,6 +1161,43 @@ void SimpleCameraData::conversionOutputDone(FrameBuffer *buffer)
 		tryCompleteRequest(request);
 }
 
+void SimpleCameraData::converterInputDone(FrameBuffer *buffer)
+{
+	/*
+	 * When chained with the Software ISP, the converter input is an
+	 * internal buffer that can be reused for the next frame.
+	 */
+	if (useSwIsp_) {
+		availableIspBuffers_.push(buffer);
+		return;
+	}
+
+	conversionInputDone(buffer);
+}
+
+void SimpleCameraData::ispOutputDone(FrameBuffer *buffer)
+{
+	if (!useConverter_) {
+		conversionOutputDone(buffer);
+		return;
+	}
+
+	/*
+	 * Hand the internal buffer over to the converter along with the
+	 * outputs of the corresponding request, in capture order.
+	 */
+	ASSERT(!ispQueue_.empty());
+	RequestOutputs outputs = std::move(ispQueue_.front());
+	ispQueue_.pop();
+
+	if (buffer->metadata().status == FrameMetadata::FrameSuccess &&
+	    !converter_->queueBuffers(buffer, outputs.outputs))
+		return;
+
+	availableIspBuffers_.push(buffer);
+	cancelOutputs(outputs);
+}
+
 void SimpleCameraData::ispStatsReady(uint32_t frame, uint32_t bufferId)
 {
 	swIsp_->processStats(frame, bufferId,
@@ -1036,7 +1210,7 @@ void SimpleCameraData::metadataReady(uint32_t frame, const ControlList &metadata
 	if (!info)
 		return;
 
-	info->request->_d()->metadata().merge(metadata);
+	pipe()->metadataAvailable(info->request, metadata);
 	info->metadataProcessed = true;
 	tryCompleteRequest(info->request);
 }
@@ -1359,7 +1533,7 @@ CameraConfiguration::Status SimpleCameraConfiguration::validate()
 		/* Set the stride and frameSize. */
 		if (needConversion_ && !raw) {
 			std::tie(cfg.stride, cfg.frameSize) =
-				data_->converter_
+				pipeConfig_->converter
 					? data_->converter_->strideAndFrameSize(cfg.pixelFormat,
 										cfg.size)
 					: data_->swIsp_->strideAndFrameSize(cfg.pixelFormat,
@@ -1543,7 +1717,7 @@ int SimplePipelineHandler::configure(Camera *camera, CameraConfiguration *c)
 	captureFormat.size = pipeConfig->captureSize;
 
 	uint32_t requested_bpl = 0;
-	if (data->swIsp_)
+	if (pipeConfig->swIsp)
 		requested_bpl = data->swIsp_->preferredInputStride(videoFormat.toPixelFormat(), pipeConfig->captureSize);
 	captureFormat.planes[0].bpl = requested_bpl;
 
@@ -1576,6 +1750,8 @@ int SimplePipelineHandler::configure(Camera *camera, CameraConfiguration *c)
 	/* Configure the converter if needed. */
 	std::vector<std::reference_wrapper<const StreamConfiguration>> outputCfgs;
 	data->useConversion_ = config->needConversion();
+	data->useSwIsp_ = data->useConversion_ && pipeConfig->swIsp;
+	data->useConverter_ = data->useConversion_ && pipeConfig->converter;
 
 	data->rawStream_ = nullptr;
 	for (unsigned int i = 0; i < config->size(); ++i) {
@@ -1600,13 +1776,32 @@ int SimplePipelineHandler::configure(Camera *camera, CameraConfiguration *c)
 	inputCfg.stride = captureFormat.planes[0].bpl;
 	inputCfg.bufferCount = kNumInternalBuffers;
 
-	if (data->converter_) {
+	if (!data->useSwIsp_)
 		return data->converter_->configure(inputCfg, outputCfgs);
-	} else {
-		ipa::soft::IPAConfigInfo configInfo;
-		configInfo.sensorControls = data->sensor_->controls();
+
+	ipa::soft::IPAConfigInfo configInfo;
+	configInfo.sensorControls = data->sensor_->controls();
+
+	if (!data->useConverter_)
 		return data->swIsp_->configure(inputCfg, outputCfgs, configInfo);
-	}
+
+	/*
+	 * Chain the Software ISP and the converter through internal buffers,
+	 * produced by the Software ISP on the internal stream.
+	 */
+	StreamConfiguration ispCfg;
+	ispCfg.pixelFormat = pipeConfig->ispFormat;
+	ispCfg.size = pipeConfig->ispSize;
+	std::tie(ispCfg.stride, ispCfg.frameSize) =
+		data->swIsp_->strideAndFrameSize(ispCfg.pixelFormat, ispCfg.size);
+	ispCfg.bufferCount = kNumInternalBuffers;
+	ispCfg.setStream(&data->ispStream_);
+
+	ret = data->swIsp_->configure(inputCfg, { ispCfg }, configInfo);
+	if (ret < 0)
+		return ret;
+
+	return data->converter_->configure(ispCfg, outputCfgs);
 }
 
 int SimplePipelineHandler::exportFrameBuffers(Camera *camera, Stream *stream,
@@ -1620,7 +1815,7 @@ int SimplePipelineHandler::exportFrameBuffers(Camera *camera, Stream *stream,
 	 * whether the converter is used or not.
 	 */
 	if (data->useConversion_ && stream != data->rawStream_)
-		return data->converter_
+		return data->useConverter_
 			       ? data->converter_->exportBuffers(stream, count, buffers)
 			       : data->swIsp_->exportBuffers(stream, count, buffers);
 	else
@@ -1662,6 +1857,20 @@ int SimplePipelineHandler::start(Camera *camera, [[maybe_unused]] const ControlL
 		return ret;
 	}
 
+	if (data->useSwIsp_ && data->useConverter_) {
+		ret = data->swIsp_->exportBuffers(&data->ispStream_, kNumInternalBuffers,
+						  &data->ispBuffers_);
+		if (ret < 0) {
+			video->releaseBuffers();
+			data->conversionBuffers_.clear();
+			releasePipeline(data);
+			return ret;
+		}
+
+		for (std::unique_ptr<FrameBuffer> &buffer : data->ispBuffers_)
+			data->availableIspBuffers_.push(buffer.get());
+	}
+
 	video->bufferReady.connect(data, &SimpleCameraData::imageBufferReady);
 
 	data->delayedCtrls_->reset();
@@ -1682,12 +1891,9 @@ int SimplePipelineHandler::start(Camera *camera, [[maybe_unused]] const ControlL
 	}
 
 	if (data->useConversion_) {
-		if (data->converter_)
+		ret = data->useSwIsp_ ? data->swIsp_->start() : 0;
+		if (!ret && data->useConverter_)
 			ret = data->converter_->start();
-		else if (data->swIsp_)
-			ret = data->swIsp_->start();
-		else
-			ret = 0;
 
 		if (ret < 0) {
 			stop(camera);
@@ -1715,12 +1921,15 @@ void SimplePipelineHandler::stopDevice(Camera *camera)
 							 &DelayedControls::applyControls);
 	}
 
-	if (data->useConversion_) {
-		if (data->converter_)
-			data->converter_->stop();
-		else if (data->swIsp_)
-			data->swIsp_->stop();
-	}
+	/*
+	 * Stop the processing stages from the first one. The Software ISP
+	 * returns its pending buffers as cancelled, and the outputs of the
+	 * corresponding requests are cancelled without reaching the converter.
+	 */
+	if (data->useSwIsp_)
+		data->swIsp_->stop();
+	if (data->useConverter_)
+		data->converter_->stop();
 
 	video->streamOff();
 	video->releaseBuffers();
@@ -1730,6 +1939,8 @@ void SimplePipelineHandler::stopDevice(Camera *camera)
 	data->frameInfo_.clear();
 	data->clearIncompleteRequests();
 	data->conversionBuffers_.clear();
+	data->availableIspBuffers_ = {};
+	data->ispBuffers_.clear();
 
 	releasePipeline(data);
 }
@@ -1750,7 +1961,7 @@ int SimplePipelineHandler::queueRequestDevice(Camera *camera, Request *request)
 		 */
 		if (data->useConversion_ && stream != data->rawStream_) {
 			buffers.emplace(stream, buffer);
-			metadataRequired = !!data->swIsp_;
+			metadataRequired = data->useSwIsp_;
 		} else {
 			ret = data->video_->queueBuffer(buffer);
 			if (ret < 0)
@@ -1761,7 +1972,7 @@ int SimplePipelineHandler::queueRequestDevice(Camera *camera, Request *request)
 	data->frameInfo_.create(request, metadataRequired);
 	if (data->useConversion_) {
 		data->conversionQueue_.push({ request, std::move(buffers) });
-		if (data->swIsp_)
+		if (data->useSwIsp_)
 			data->swIsp_->queueRequest(request->sequence(), request->controls());
 	}
 
@@ -1880,16 +2091,7 @@ bool SimplePipelineHandler::matchDevice(std::shared_ptr<MediaDevice> media,
 		}
 	}
 
-	if (info.swIspEnabled) {
-		/*
-		 * When the software ISP is enabled, the simple pipeline handler
-		 * exposes the raw stream, giving a total of two streams. This
-		 * is mutually exclusive with the presence of a converter.
-		 */
-		ASSERT(!converter_);
-		numStreams = 2;
-	}
-
+	swConverterEnabled_ = false;
 	swIspEnabled_ = info.swIspEnabled;
 	const GlobalConfiguration &configuration = cameraManager()->_d()->configuration();
 	for (const ValueNode &entry :
@@ -1898,13 +2100,36 @@ bool SimplePipelineHandler::matchDevice(std::shared_ptr<MediaDevice> media,
 		auto name = entry["driver"].get<std::string>();
 		if (name == info.driver) {
 			swIspEnabled_ = entry["software_isp"].get<bool>().value_or(swIspEnabled_);
+			swConverterEnabled_ = entry["software_converter"].get<bool>().value_or(false);
 			LOG(SimplePipeline, Debug)
 				<< "Configuration file overrides software ISP for "
-				<< info.driver << " to " << swIspEnabled_;
+				<< info.driver << " to " << swIspEnabled_
+				<< ", software converter to " << swConverterEnabled_;
 			break;
 		}
 	}
 
+	/*
+	 * The software converter is a fallback for platforms without a
+	 * hardware converter, and is mutually exclusive with the software ISP.
+	 */
+	if (swConverterEnabled_ && (converter_ || swIspEnabled_)) {
+		LOG(SimplePipeline, Warning)
+			<< "Software converter can't be used with a hardware converter or the software ISP";
+		swConverterEnabled_ = false;
+	}
+
+	if (swConverterEnabled_)
+		numStreams = kSoftwareConverterStreams;
+
+	/*
+	 * When the software ISP is enabled, the simple pipeline handler exposes
+	 * the raw stream in addition to the processed streams, which are
+	 * produced by the converter when the software ISP is chained with it.
+	 */
+	if (swIspEnabled_)
+		numStreams = (converter_ ? numStreams : 1) + 1;
+
 	/* Locate the sensors. */
 	std::vector<MediaEntity *> sensors = locateSensors(media.get());
 	if (sensors.empty()) {
@@ -0,0 +1,487 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Multithreaded MJPEG decoder for UVC cameras
+ */
+
+#include "mjpeg_decoder.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <string.h>
+
+#include <libcamera/base/log.h>
+#include <libcamera/base/span.h>
+#include <libcamera/base/thread.h>
+
+#include <libcamera/formats.h>
+#include <libcamera/framebuffer.h>
+
+#include "libcamera/internal/formats.h"
+#include "libcamera/internal/framebuffer.h"
+#include "libcamera/internal/mapped_framebuffer.h"
+#include "libcamera/internal/worker_thread.h"
+
+#if HAVE_MJPEG_DECODER
+#include <setjmp.h>
+#include <stdio.h>
+
+#include <jpeglib.h>
+#endif
+
+namespace libcamera {
+
+LOG_DECLARE_CATEGORY(UVC)
+
+/*
+ * The MjpegDecoder decodes the MJPEG frames captured by UVC cameras to NV12 or
+ * YUV420. JPEG frames can't easily be split, so frames are decoded in parallel
+ * by a pool of worker threads, each of them decoding a whole frame. Frames are
+ * handed to the first idle worker, and completed in the order the workers
+ * finish.
+ *
+ * The decoder uses the libjpeg raw data output to skip the colour conversion
+ * and chroma upsampling, and subsamples the chroma planes to 4:2:0 when the
+ * frames use a different chroma subsampling.
+ */
+
+namespace {
+
+const std::vector<PixelFormat> kFormats = {
+	formats::NV12,
+	formats::YUV420,
+};
+
+#if HAVE_MJPEG_DECODER
+
+class JpegDecompressor
+{
+public:
+	JpegDecompressor()
+	{
+		decompress_.err = jpeg_std_error(&error_.manager);
+		error_.manager.error_exit = errorExit;
+		error_.manager.output_message = outputMessage;
+
+		jpeg_create_decompress(&decompress_);
+	}
+
+	~JpegDecompressor()
+	{
+		jpeg_destroy_decompress(&decompress_);
+	}
+
+	int decode(Span<const uint8_t> jpeg, const std::vector<Span<uint8_t>> &planes,
+		   const PixelFormat &format, const Size &size);
+
+private:
+	struct ErrorManager {
+		struct jpeg_error_mgr manager;
+		jmp_buf jump;
+	};
+
+	static void errorExit(j_common_ptr cinfo);
+	static void outputMessage(j_common_ptr cinfo);
+
+	int decompress(Span<const uint8_t> jpeg, const std::vector<Span<uint8_t>> &planes,
+		       const PixelFormat &format, const Size &size);
+
+	void copyLines(unsigned int line, unsigned int count,
+		       const std::vector<Span<uint8_t>> &planes,
+		       const PixelFormat &format, const Size &size);
+
+	struct jpeg_decompress_struct decompress_;
+	ErrorManager error_;
+
+	/* Output of jpeg_read_raw_data() for one iMCU row of each component */
+	std::vector<uint8_t> lines_[3];
+	std::vector<JSAMPROW> rows_[3];
+};
+
+void JpegDecompressor::errorExit(j_common_ptr cinfo)
+{
+	ErrorManager *error = reinterpret_cast<ErrorManager *>(cinfo->err);
+
+	outputMessage(cinfo);
+	longjmp(error->jump, 1);
+}
+
+void JpegDecompressor::outputMessage(j_common_ptr cinfo)
+{
+	char message[JMSG_LENGTH_MAX];
+
+	(*cinfo->err->format_message)(cinfo, message);
+	LOG(UVC, Debug) << "JPEG: " << message;
+}
+
+int JpegDecompressor::decode(Span<const uint8_t> jpeg,
+			     const std::vector<Span<uint8_t>> &planes,
+			     const PixelFormat &format, const Size &size)
+{
+	/*
+	 * libjpeg reports fatal errors through errorExit(), which jumps back
+	 * here. Decompress in a separate function, to avoid local variables
+	 * being clobbered by the jump.
+	 */
+	if (setjmp(error_.jump)) {
+		jpeg_abort_decompress(&decompress_);
+		return -EINVAL;
+	}
+
+	return decompress(jpeg, planes, format, size);
+}
+
+int JpegDecompressor::decompress(Span<const uint8_t> jpeg,
+				 const std::vector<Span<uint8_t>> &planes,
+				 const PixelFormat &format, const Size &size)
+{
+	jpeg_mem_src(&decompress_, const_cast<unsigned char *>(jpeg.data()),
+		     jpeg.size());
+	jpeg_read_header(&decompress_, TRUE);
+
+	/*
+	 * Only YCbCr frames with a full resolution luma component can be
+	 * output as raw data to the output planes.
+	 */
+	const jpeg_component_info *luma = &decompress_.comp_info[0];
+	if (decompress_.image_width != size.width ||
+	    decompress_.image_height != size.height ||
+	    decompress_.jpeg_color_space != JCS_YCbCr ||
+	    decompress_.num_components != 3 ||
+	    luma->h_samp_factor != decompress_.max_h_samp_factor ||
+	    luma->v_samp_factor != decompress_.max_v_samp_factor) {
+		LOG(UVC, Debug)
+			<< "Unsupported JPEG frame "
+			<< decompress_.image_width << "x"
+			<< decompress_.image_height;
+		jpeg_abort_decompress(&decompress_);
+		return -EINVAL;
+	}
+
+	decompress_.raw_data_out = TRUE;
+	decompress_.dct_method = JDCT_IFAST;
+
+	jpeg_start_decompress(&decompress_);
+
+	/* Allocate the buffers for one iMCU row, padded to a whole MCU. */
+	JSAMPARRAY image[3];
+	for (unsigned int i = 0; i < 3; i++) {
+		const jpeg_component_info *comp = &decompress_.comp_info[i];
+		unsigned int width = (comp->width_in_blocks + comp->h_samp_factor) *
+				     DCTSIZE;
+		unsigned int height = comp->v_samp_factor * DCTSIZE;
+
+		lines_[i].resize(width * height);
+		rows_[i].resize(height);
+		for (unsigned int y = 0; y < height; y++)
+			rows_[i][y] = &lines_[i][y * width];
+
+		image[i] = rows_[i].data();
+	}
+
+	unsigned int lines = decompress_.max_v_samp_factor * DCTSIZE;
+
+	while (decompress_.output_scanline < decompress_.output_height) {
+		unsigned int line = decompress_.output_scanline;
+		unsigned int count = jpeg_read_raw_data(&decompress_, image, lines);
+		if (!count)
+			break;
+
+		copyLines(line, std::min(count, size.height - line), planes,
+			  format, size);
+	}
+
+	jpeg_finish_decompress(&decompress_);
+
+	return 0;
+}
+
+void JpegDecompressor::copyLines(unsigned int line, unsigned int count,
+				 const std::vector<Span<uint8_t>> &planes,
+				 const PixelFormat &format, const Size &size)
+{
+	const PixelFormatInfo &info = PixelFormatInfo::info(format);
+	unsigned int strideY = info.stride(size.width, 0, 1);
+	unsigned int strideC = info.stride(size.width, 1, 1);
+
+	for (unsigned int y = 0; y < count; y++)
+		memcpy(&planes[0][(line + y) * strideY], rows_[0][y], size.width);
+
+	/*
+	 * Sample the chroma components at the 4:2:0 positions. The iMCU rows
+	 * cover an even number of luma lines, the chroma lines of the output
+	 * are thus fully contained in a single iMCU row.
+	 */
+	unsigned int maxH = decompress_.max_h_samp_factor;
+	unsigned int maxV = decompress_.max_v_samp_factor;
+	unsigned int width = (size.width + 1) / 2;
+	unsigned int first = line / 2;
+	unsigned int last = (line + count + 1) / 2;
+
+	for (unsigned int c = 1; c < 3; c++) {
+		const jpeg_component_info *comp = &decompress_.comp_info[c];
+		bool subsampled = static_cast<unsigned int>(comp->h_samp_factor) * 2 == maxH;
+
+		for (unsigned int cy = first; cy < last; cy++) {
+			unsigned int sy = (cy * 2 - line) * comp->v_samp_factor / maxV;
+			const uint8_t *src = rows_[c][sy];
+
+			if (format == formats::YUV420) {
+				uint8_t *dst = &planes[c][cy * strideC];
+
+				if (subsampled) {
+					memcpy(dst, src, width);
+					continue;
+				}
+
+				for (unsigned int cx = 0; cx < width; cx++)
+					dst[cx] = src[cx * 2 * comp->h_samp_factor / maxH];
+			} else {
+				uint8_t *dst = &planes[1][cy * strideC + c - 1];
+
+				for (unsigned int cx = 0; cx < width; cx++)
+					dst[cx * 2] = src[cx * 2 * comp->h_samp_factor / maxH];
+			}
+		}
+	}
+}
+
+#else
+
+class JpegDecompressor
+{
+public:
+	int decode([[maybe_unused]] Span<const uint8_t> jpeg,
+		   [[maybe_unused]] const std::vector<Span<uint8_t>> &planes,
+		   [[maybe_unused]] const PixelFormat &format,
+		   [[maybe_unused]] const Size &size)
+	{
+		return -ENOTSUP;
+	}
+};
+
+#endif /* HAVE_MJPEG_DECODER */
+
+} /* namespace */
+
+class MjpegDecoder::Worker : public WorkerThread
+{
+public:
+	Worker(MjpegDecoder *decoder, unsigned int index)
+		: WorkerThread("MjpegDecoder", index), decoder_(decoder)
+	{
+	}
+
+	void decode(Job job)
+	{
+		FrameMetadata &metadata = job.output->_d()->metadata();
+		const FrameMetadata &inputMetadata = job.input->metadata();
+
+		metadata.sequence = inputMetadata.sequence;
+		metadata.timestamp = inputMetadata.timestamp;
+
+		if (decoder_->stopping_.load(std::memory_order_relaxed)) {
+			metadata.status = FrameMetadata::FrameCancelled;
+		} else {
+			int ret = decodeFrame(job.input, job.output);
+			metadata.status = ret ? FrameMetadata::FrameError
+					      : FrameMetadata::FrameSuccess;
+		}
+
+		decoder_->invokeMethod(&MjpegDecoder::jobDone,
+				       ConnectionTypeQueued, this, job);
+	}
+
+private:
+	int decodeFrame(FrameBuffer *input, FrameBuffer *output)
+	{
+		MappedFrameBuffer in(input, MappedFrameBuffer::MapFlag::Read);
+		MappedFrameBuffer out(output, MappedFrameBuffer::MapFlag::Write);
+		if (!in.isValid() || !out.isValid())
+			return -EINVAL;
+
+		/* Keep CPU access to the buffers open until the frame is decoded. */
+		std::vector<DmaSyncer> syncers;
+		for (const FrameBuffer::Plane &plane : input->planes())
+			syncers.emplace_back(plane.fd, DmaSyncer::SyncType::Read);
+
+		for (const FrameBuffer::Plane &plane : output->planes())
+			syncers.emplace_back(plane.fd, DmaSyncer::SyncType::Write);
+
+		Span<const uint8_t> jpeg = in.planes()[0];
+		jpeg = jpeg.first(std::min<size_t>(input->metadata().planes()[0].bytesused,
+						   jpeg.size()));
+
+		/*
+		 * The planes of the output may be stored in a single frame
+		 * buffer plane, in which case split it according to the format.
+		 */
+		const PixelFormatInfo &info = PixelFormatInfo::info(decoder_->format_);
+		const std::vector<Span<uint8_t>> &maps = out.planes();
+		std::vector<Span<uint8_t>> planes;
+		size_t offset = 0;
+
+		if (maps.size() != info.numPlanes() && maps.size() != 1)
+			return -EINVAL;
+
+		for (unsigned int i = 0; i < info.numPlanes(); i++) {
+			size_t planeSize = info.planeSize(decoder_->size_, i, 1);
+			Span<uint8_t> plane = maps.size() == 1 ? maps[0].subspan(offset)
+							       : maps[i];
+
+			if (plane.size() < planeSize)
+				return -EINVAL;
+
+			planes.push_back(plane.first(planeSize));
+			offset += planeSize;
+		}
+
+		int ret = decompressor_.decode(jpeg, planes, decoder_->format_,
+					       decoder_->size_);
+		if (ret)
+			return ret;
+
+		FrameMetadata &metadata = output->_d()->metadata();
+		Span<const FrameBuffer::Plane> outputPlanes = output->planes();
+		for (unsigned int i = 0; i < outputPlanes.size(); i++)
+			metadata.planes()[i].bytesused = outputPlanes[i].length;
+
+		return 0;
+	}
+
+	MjpegDecoder *decoder_;
+	JpegDecompressor decompressor_;
+};
+
+MjpegDecoder::MjpegDecoder()
+	: stopping_(false),
+	  dmaHeap_(DmaBufAllocator::DmaBufAllocatorFlag::CmaHeap |
+		   DmaBufAllocator::DmaBufAllocatorFlag::SystemHeap |
+		   DmaBufAllocator::DmaBufAllocatorFlag::UDmaBuf)
+{
+	unsigned int threadCount = WorkerThread::idealCount(kMaxThreads);
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		workers_.push_back(std::make_unique<Worker>(this, i));
+
+	LOG(UVC, Debug) << "MJPEG decoder using " << threadCount << " threads";
+}
+
+MjpegDecoder::~MjpegDecoder() = default;
+
+bool MjpegDecoder::isAvailable()
+{
+#if HAVE_MJPEG_DECODER
+	return true;
+#else
+	return false;
+#endif
+}
+
+const std::vector<PixelFormat> &MjpegDecoder::formats()
+{
+	return kFormats;
+}
+
+int MjpegDecoder::configure(const PixelFormat &format, const Size &size)
+{
+	if (std::find(kFormats.begin(), kFormats.end(), format) == kFormats.end()) {
+		LOG(UVC, Error) << "MJPEG frames can't be decoded to " << format;
+		return -EINVAL;
+	}
+
+	format_ = format;
+	size_ = size;
+
+	return 0;
+}
+
+int MjpegDecoder::exportBuffers(unsigned int count,
+				std::vector<std::unique_ptr<FrameBuffer>> *buffers)
+{
+	const PixelFormatInfo &info = PixelFormatInfo::info(format_);
+
+	std::vector<unsigned int> planeSizes;
+	for (unsigned int i = 0; i < info.numPlanes(); i++)
+		planeSizes.push_back(info.planeSize(size_, i, 1));
+
+	return dmaHeap_.exportBuffers(count, planeSizes, buffers);
+}
+
+int MjpegDecoder::start()
+{
+	stopping_.store(false, std::memory_order_relaxed);
+
+	idleWorkers_.clear();
+	for (std::unique_ptr<Worker> &worker : workers_) {
+		worker->start();
+		idleWorkers_.push_back(worker.get());
+	}
+
+	return 0;
+}
+
+/*
+ * Frames that haven't been decoded yet are completed with their output buffer
+ * marked as cancelled.
+ */
+void MjpegDecoder::stop()
+{
+	stopping_.store(true, std::memory_order_relaxed);
+
+	while (!pendingJobs_.empty()) {
+		Job job = pendingJobs_.front();
+		pendingJobs_.pop();
+
+		job.output->_d()->cancel();
+		inputBufferReady.emit(job.input);
+		outputBufferReady.emit(job.output);
+	}
+
+	/*
+	 * Wait for the workers to complete the frames they're decoding before
+	 * stopping them, and complete those frames.
+	 */
+	for (std::unique_ptr<Worker> &worker : workers_) {
+		if (worker->isRunning())
+			worker->waitIdle();
+	}
+
+	for (std::unique_ptr<Worker> &worker : workers_) {
+		worker->exit();
+		worker->wait();
+	}
+
+	Thread::current()->dispatchMessages(Message::Type::InvokeMessage, this);
+}
+
+void MjpegDecoder::queueBuffers(FrameBuffer *input, FrameBuffer *output)
+{
+	pendingJobs_.push({ input, output });
+	schedule();
+}
+
+void MjpegDecoder::schedule()
+{
+	while (!idleWorkers_.empty() && !pendingJobs_.empty()) {
+		Worker *worker = idleWorkers_.back();
+		idleWorkers_.pop_back();
+
+		worker->queue(&Worker::decode, pendingJobs_.front());
+		pendingJobs_.pop();
+	}
+}
+
+void MjpegDecoder::jobDone(Worker *worker, Job job)
+{
+	idleWorkers_.push_back(worker);
+
+	inputBufferReady.emit(job.input);
+	outputBufferReady.emit(job.output);
+
+	if (!stopping_.load(std::memory_order_relaxed))
+		schedule();
+}
+
+} /* namespace libcamera */
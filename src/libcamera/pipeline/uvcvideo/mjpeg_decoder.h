@@ -0,0 +1,72 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Multithreaded MJPEG decoder for UVC cameras
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <queue>
+#include <vector>
+
+#include <libcamera/base/object.h>
+#include <libcamera/base/signal.h>
+
+#include <libcamera/geometry.h>
+#include <libcamera/pixel_format.h>
+
+#include "libcamera/internal/dma_buf_allocator.h"
+
+namespace libcamera {
+
+class FrameBuffer;
+
+class MjpegDecoder : public Object
+{
+public:
+	MjpegDecoder();
+	~MjpegDecoder();
+
+	static bool isAvailable();
+	static const std::vector<PixelFormat> &formats();
+
+	int configure(const PixelFormat &format, const Size &size);
+	int exportBuffers(unsigned int count,
+			  std::vector<std::unique_ptr<FrameBuffer>> *buffers);
+
+	int start();
+	void stop();
+
+	void queueBuffers(FrameBuffer *input, FrameBuffer *output);
+
+	Signal<FrameBuffer *> inputBufferReady;
+	Signal<FrameBuffer *> outputBufferReady;
+
+private:
+	class Worker;
+
+	struct Job {
+		FrameBuffer *input;
+		FrameBuffer *output;
+	};
+
+	void schedule();
+	void jobDone(Worker *worker, Job job);
+
+	static constexpr unsigned int kMaxThreads = 4;
+
+	PixelFormat format_;
+	Size size_;
+
+	std::vector<std::unique_ptr<Worker>> workers_;
+	std::vector<Worker *> idleWorkers_;
+	std::queue<Job> pendingJobs_;
+	std::atomic<bool> stopping_;
+
+	DmaBufAllocator dmaHeap_;
+};
+
+} /* namespace libcamera */
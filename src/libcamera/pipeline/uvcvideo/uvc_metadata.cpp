@@ -0,0 +1,186 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * UVC payload header metadata parser
+ */
+
+#include "uvc_metadata.h"
+
+#include <fstream>
+#include <iterator>
+#include <string.h>
+#include <vector>
+
+namespace libcamera {
+
+/*
+ * The UVCMetadataParser parses the UVC payload headers captured by the UVC
+ * metadata node in the V4L2_META_FMT_UVC format. Their SCR and PTS fields are
+ * used to recover the device clock and timestamp frames with the time they
+ * have been sampled by the device.
+ */
+
+namespace {
+
+/*
+ * Layout of the blocks stored in V4L2_META_FMT_UVC buffers, matching struct
+ * uvc_meta_buf. The host timestamp and USB frame number are followed by the
+ * UVC payload header, starting with its bLength and bmHeaderInfo fields.
+ */
+struct UVCMetadataBlock {
+	uint64_t ns;
+	uint16_t sof;
+	uint8_t length;
+	uint8_t flags;
+} __attribute__((packed));
+
+constexpr uint8_t kUVCHeaderPts = 1 << 2;
+constexpr uint8_t kUVCHeaderScr = 1 << 3;
+
+} /* namespace */
+
+UVCMetadataParser::UVCMetadataParser(uint32_t clockFrequency)
+	: clockFrequency_(clockFrequency)
+{
+	/*
+	 * Allow for the jitter of the USB transfers, as the transfer delay is
+	 * only known with a 1ms precision.
+	 */
+	clockRecovery_.configure(100, 1000000, 10, 10000000);
+	reset();
+}
+
+/*
+ * Retrieve the device clock frequency from the dwClockFrequency field of the
+ * VideoControl interface header, found in the raw USB descriptors of the
+ * device. The path is the sysfs path of the VideoControl interface.
+ */
+std::optional<uint32_t> UVCMetadataParser::clockFrequency(const std::string &path)
+{
+	std::ifstream file(path + "/../descriptors", std::ios::binary);
+	if (!file.is_open())
+		return {};
+
+	std::vector<uint8_t> data{ std::istreambuf_iterator<char>(file),
+				   std::istreambuf_iterator<char>() };
+	bool videoControl = false;
+
+	for (size_t offset = 0; offset + 2 <= data.size();) {
+		const uint8_t *desc = &data[offset];
+		uint8_t length = desc[0];
+		uint8_t type = desc[1];
+
+		if (length < 2 || offset + length > data.size())
+			break;
+
+		/* Interface descriptor, VideoControl is class 0x0e subclass 1. */
+		if (type == 0x04 && length >= 7)
+			videoControl = desc[5] == 0x0e && desc[6] == 0x01;
+
+		/* Class-specific VC_HEADER descriptor. */
+		if (videoControl && type == 0x24 && length >= 11 && desc[2] == 0x01)
+			return desc[7] | desc[8] << 8 | desc[9] << 16 |
+			       static_cast<uint32_t>(desc[10]) << 24;
+
+		offset += length;
+	}
+
+	return {};
+}
+
+/* The device clock may have been reset, recover it from scratch. */
+void UVCMetadataParser::reset()
+{
+	clockRecovery_.reset();
+	lastStc_.reset();
+}
+
+uint64_t UVCMetadataParser::deviceClockToNs(uint64_t ticks) const
+{
+	return ticks / clockFrequency_ * 1000000000ULL +
+	       ticks % clockFrequency_ * 1000000000ULL / clockFrequency_;
+}
+
+/*
+ * Parse the UVC payload headers captured for a frame. The SCR of the last
+ * header pairs a device clock (STC) sample with the host time, and feeds the
+ * clock recovery model. The frame PTS, in device clock units, is then
+ * converted to the host CLOCK_BOOTTIME.
+ */
+std::optional<uint64_t> UVCMetadataParser::process(Span<const uint8_t> data,
+						   int64_t boottimeOffset)
+{
+	std::optional<uint32_t> pts;
+	std::optional<uint32_t> stc;
+	uint64_t stcTime = 0;
+
+	for (size_t offset = 0; offset + sizeof(UVCMetadataBlock) <= data.size();) {
+		UVCMetadataBlock block;
+		memcpy(&block, &data[offset], sizeof(block));
+
+		/* The block length covers the bLength and bmHeaderInfo fields. */
+		size_t size = sizeof(block) - 2 + block.length;
+		if (block.length < 2 || offset + size > data.size())
+			break;
+
+		const uint8_t *header = &data[offset + sizeof(block)];
+		size_t headerSize = 2;
+
+		if (block.flags & kUVCHeaderPts) {
+			headerSize += 4;
+			if (headerSize > block.length)
+				break;
+
+			uint32_t value;
+			memcpy(&value, header, sizeof(value));
+			pts = value;
+			header += 4;
+		}
+
+		if (block.flags & kUVCHeaderScr) {
+			headerSize += 6;
+			if (headerSize > block.length)
+				break;
+
+			uint32_t value;
+			uint16_t deviceSof;
+			memcpy(&value, header, sizeof(value));
+			memcpy(&deviceSof, header + 4, sizeof(deviceSof));
+
+			/*
+			 * The STC has been sampled by the device at the start
+			 * of the USB frame reported in the SCR, while the host
+			 * time has been sampled when receiving the header.
+			 * Compensate for the transfer delay using the frame
+			 * numbers, compared modulo 1024 as some host
+			 * controllers implement a 10-bit frame counter.
+			 */
+			unsigned int delay = (block.sof - deviceSof) & 0x3ff;
+			stcTime = block.ns - delay * 1000000ULL;
+			stc = value;
+		}
+
+		offset += size;
+	}
+
+	if (stc) {
+		/* Extend the 32-bit STC to 64 bits. */
+		lastStc_ = lastStc_ ? *lastStc_ + static_cast<uint32_t>(*stc - *lastStc_)
+				    : *stc;
+
+		/* Host times use CLOCK_MONOTONIC, convert them to CLOCK_BOOTTIME. */
+		stcTime += boottimeOffset;
+
+		clockRecovery_.addSample(deviceClockToNs(*lastStc_), stcTime);
+	}
+
+	if (!pts || !lastStc_)
+		return {};
+
+	/* The PTS is close to the last STC sample, extend it the same way. */
+	int32_t delta = *pts - static_cast<uint32_t>(*lastStc_);
+	return clockRecovery_.getOutput(deviceClockToNs(*lastStc_ + delta));
+}
+
+} /* namespace libcamera */
@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * UVC payload header metadata parser
+ */
+
+#pragma once
+
+#include <optional>
+#include <stdint.h>
+#include <string>
+
+#include <libcamera/base/span.h>
+
+#include "libcamera/internal/clock_recovery.h"
+
+namespace libcamera {
+
+class UVCMetadataParser
+{
+public:
+	UVCMetadataParser(uint32_t clockFrequency);
+
+	static std::optional<uint32_t> clockFrequency(const std::string &path);
+
+	void reset();
+	std::optional<uint64_t> process(Span<const uint8_t> data,
+					int64_t boottimeOffset);
+
+private:
+	uint64_t deviceClockToNs(uint64_t ticks) const;
+
+	uint32_t clockFrequency_;
+	std::optional<uint64_t> lastStc_;
+	ClockRecovery clockRecovery_;
+};
+
+} /* namespace libcamera */
@@ -12,28 +12,41 @@
 #include <map>
 #include <memory>
 #include <optional>
+#include <queue>
 #include <set>
 #include <string>
+#include <time.h>
+#include <utility>
 #include <vector>
 
 #include <libcamera/base/log.h>
 #include <libcamera/base/mutex.h>
+#include <libcamera/base/span.h>
 #include <libcamera/base/utils.h>
 
 #include <libcamera/camera.h>
 #include <libcamera/control_ids.h>
 #include <libcamera/controls.h>
+#include <libcamera/formats.h>
 #include <libcamera/property_ids.h>
 #include <libcamera/stream.h>
 
 #include "libcamera/internal/camera.h"
+#include "libcamera/internal/camera_manager.h"
 #include "libcamera/internal/device_enumerator.h"
+#include "libcamera/internal/formats.h"
+#include "libcamera/internal/framebuffer.h"
+#include "libcamera/internal/global_configuration.h"
+#include "libcamera/internal/mapped_framebuffer.h"
 #include "libcamera/internal/media_device.h"
 #include "libcamera/internal/pipeline_handler.h"
 #include "libcamera/internal/request.h"
 #include "libcamera/internal/sysfs.h"
 #include "libcamera/internal/v4l2_videodevice.h"
 
+#include "mjpeg_decoder.h"
+#include "uvc_metadata.h"
+
 namespace libcamera {
 
 LOG_DEFINE_CATEGORY(UVC)
@@ -42,7 +55,7 @@ class UVCCameraData : public Camera::Private
 {
 public:
 	UVCCameraData(PipelineHandler *pipe)
-		: Camera::Private(pipe)
+		: Camera::Private(pipe), useDecoder_(false), useMetadata_(false)
 	{
 	}
 
@@ -50,21 +63,59 @@ public:
 	void addControl(uint32_t cid, const ControlInfo &v4l2info,
 			ControlInfoMap::Map *ctrls);
 	void imageBufferReady(FrameBuffer *buffer);
+	void metadataBufferReady(FrameBuffer *buffer);
+
+	int startMetadata();
+	void stopMetadata();
 
 	const std::string &id() const { return id_; }
 
 	Mutex openLock_;
 	std::unique_ptr<V4L2VideoDevice> video_;
+	std::unique_ptr<V4L2VideoDevice> metadata_;
 	Stream stream_;
 	std::map<PixelFormat, std::vector<SizeRange>> formats_;
 
+	/*
+	 * The MJPEG decoder produces the decoded formats from MJPEG frames
+	 * captured to internal buffers, and decodes them to the buffers of the
+	 * queued requests.
+	 */
+	std::unique_ptr<MjpegDecoder> decoder_;
+	std::set<PixelFormat> decodedFormats_;
+	bool useDecoder_;
+	std::vector<std::unique_ptr<FrameBuffer>> mjpegBuffers_;
+	std::queue<FrameBuffer *> decodeQueue_;
+
 	std::optional<v4l2_exposure_auto_type> autoExposureMode_;
 	std::optional<v4l2_exposure_auto_type> manualExposureMode_;
 
 private:
+	static constexpr unsigned int kNumMetadataBuffers = 4;
+	static constexpr unsigned int kMaxPendingBuffers = 2;
+
 	bool generateId();
+	void initDecoder();
+	void initMetadata(std::shared_ptr<MediaDevice> media);
+	void completePendingBuffers();
+	void processBuffer(FrameBuffer *buffer, uint64_t timestamp);
+	void completeRequest(FrameBuffer *buffer);
+	void decoderInputDone(FrameBuffer *buffer);
+	void decoderOutputDone(FrameBuffer *buffer);
 
 	std::string id_;
+
+	/*
+	 * The UVC metadata node captures the payload headers of the frames,
+	 * parsed to timestamp frames with the time they have been sampled by
+	 * the device.
+	 */
+	std::unique_ptr<UVCMetadataParser> metadataParser_;
+	bool useMetadata_;
+	std::vector<std::unique_ptr<FrameBuffer>> metadataBuffers_;
+	std::map<const FrameBuffer *, MappedFrameBuffer> mappedMetadataBuffers_;
+	std::queue<std::pair<FrameBuffer *, int64_t>> pendingBuffers_;
+	std::queue<std::pair<uint64_t, std::optional<uint64_t>>> pendingTimestamps_;
 };
 
 class UVCCameraConfiguration : public CameraConfiguration
@@ -98,6 +149,8 @@ public:
 	bool match(DeviceEnumerator *enumerator) override;
 
 private:
+	static constexpr unsigned int kNumDecodeBuffers = 4;
+
 	int processControl(const UVCCameraData *data, ControlList *controls,
 			   unsigned int id, const ControlValue &value);
 	int processControls(UVCCameraData *data, const ControlList &reqControls);
@@ -129,6 +182,28 @@ std::optional<controls::ExposureTimeModeEnum> v4l2ToExposureMode(int32_t x)
 	}
 }
 
+uint64_t timespecToNs(const struct timespec &ts)
+{
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Return the offset to add to a CLOCK_MONOTONIC time to convert it to
+ * CLOCK_BOOTTIME. The offset changes when the system resumes from suspend, it
+ * is thus sampled when dequeuing buffers, as close as possible to the times it
+ * applies to.
+ */
+int64_t boottimeOffset()
+{
+	struct timespec boottime;
+	struct timespec monotonic;
+
+	clock_gettime(CLOCK_BOOTTIME, &boottime);
+	clock_gettime(CLOCK_MONOTONIC, &monotonic);
+
+	return timespecToNs(boottime) - timespecToNs(monotonic);
+}
+
 } /* namespace */
 
 UVCCameraConfiguration::UVCCameraConfiguration(UVCCameraData *data)
@@ -189,8 +264,12 @@ CameraConfiguration::Status UVCCameraConfiguration::validate()
 
 	cfg.bufferCount = 4;
 
+	/* Decoded formats are captured in MJPEG. */
+	bool decode = data_->decodedFormats_.count(cfg.pixelFormat);
+
 	V4L2DeviceFormat format;
-	format.fourcc = data_->video_->toV4L2PixelFormat(cfg.pixelFormat);
+	format.fourcc = data_->video_->toV4L2PixelFormat(decode ? formats::MJPEG
+								: cfg.pixelFormat);
 	format.size = cfg.size;
 
 	/*
@@ -217,8 +296,14 @@ CameraConfiguration::Status UVCCameraConfiguration::validate()
 			return Invalid;
 	}
 
-	cfg.stride = format.planes[0].bpl;
-	cfg.frameSize = format.planes[0].size;
+	if (decode) {
+		const PixelFormatInfo &info = PixelFormatInfo::info(cfg.pixelFormat);
+		cfg.stride = info.stride(cfg.size.width, 0, 1);
+		cfg.frameSize = info.frameSize(cfg.size, 1);
+	} else {
+		cfg.stride = format.planes[0].bpl;
+		cfg.frameSize = format.planes[0].size;
+	}
 
 	if (cfg.colorSpace != format.colorSpace) {
 		cfg.colorSpace = format.colorSpace;
@@ -247,7 +332,14 @@ PipelineHandlerUVC::generateConfiguration(Camera *camera,
 	StreamFormats formats(data->formats_);
 	StreamConfiguration cfg(formats);
 
-	cfg.pixelFormat = formats.pixelformats().front();
+	/* Default to the first format supported natively by the camera. */
+	std::vector<PixelFormat> pixelFormats = formats.pixelformats();
+	auto native = std::find_if(pixelFormats.begin(), pixelFormats.end(),
+				   [&](const PixelFormat &format) {
+					   return !data->decodedFormats_.count(format);
+				   });
+	cfg.pixelFormat = native != pixelFormats.end() ? *native
+						       : pixelFormats.front();
 	cfg.size = formats.sizes(cfg.pixelFormat).back();
 	cfg.bufferCount = 4;
 
@@ -264,18 +356,29 @@ int PipelineHandlerUVC::configure(Camera *camera, CameraConfiguration *config)
 	StreamConfiguration &cfg = config->at(0);
 	int ret;
 
+	bool decode = data->decodedFormats_.count(cfg.pixelFormat);
+	V4L2PixelFormat fourcc =
+		data->video_->toV4L2PixelFormat(decode ? formats::MJPEG : cfg.pixelFormat);
+
 	V4L2DeviceFormat format;
-	format.fourcc = data->video_->toV4L2PixelFormat(cfg.pixelFormat);
+	format.fourcc = fourcc;
 	format.size = cfg.size;
 
 	ret = data->video_->setFormat(&format);
 	if (ret)
 		return ret;
 
-	if (format.size != cfg.size ||
-	    format.fourcc != data->video_->toV4L2PixelFormat(cfg.pixelFormat))
+	if (format.size != cfg.size || format.fourcc != fourcc)
 		return -EINVAL;
 
+	if (decode) {
+		ret = data->decoder_->configure(cfg.pixelFormat, cfg.size);
+		if (ret)
+			return ret;
+	}
+
+	data->useDecoder_ = decode;
+
 	cfg.setStream(&data->stream_);
 
 	return 0;
@@ -287,6 +390,9 @@ int PipelineHandlerUVC::exportFrameBuffers(Camera *camera, Stream *stream,
 	UVCCameraData *data = cameraData(camera);
 	unsigned int count = stream->configuration().bufferCount;
 
+	if (data->useDecoder_)
+		return data->decoder_->exportBuffers(count, buffers);
+
 	return data->video_->exportBuffers(count, buffers);
 }
 
@@ -294,8 +400,17 @@ int PipelineHandlerUVC::start(Camera *camera, const ControlList *controls)
 {
 	UVCCameraData *data = cameraData(camera);
 	unsigned int count = data->stream_.configuration().bufferCount;
+	int ret;
 
-	int ret = data->video_->importBuffers(count);
+	/*
+	 * When decoding MJPEG, capture to internal buffers. Allocate enough
+	 * of them to keep capturing while frames are being decoded.
+	 */
+	if (data->useDecoder_)
+		ret = data->video_->allocateBuffers(count + kNumDecodeBuffers,
+						    &data->mjpegBuffers_);
+	else
+		ret = data->video_->importBuffers(count);
 	if (ret < 0)
 		return ret;
 
@@ -305,14 +420,32 @@ int PipelineHandlerUVC::start(Camera *camera, const ControlList *controls)
 			goto err_release_buffers;
 	}
 
+	/*
+	 * Timestamps fall back to the buffer timestamps if the metadata can't
+	 * be captured, don't fail in that case.
+	 */
+	if (data->startMetadata() < 0)
+		LOG(UVC, Warning)
+			<< "Failed to start metadata capture, using buffer timestamps";
+
 	ret = data->video_->streamOn();
 	if (ret < 0)
-		goto err_release_buffers;
+		goto err_stop_metadata;
+
+	if (data->useDecoder_) {
+		data->decoder_->start();
+
+		for (std::unique_ptr<FrameBuffer> &buffer : data->mjpegBuffers_)
+			data->video_->queueBuffer(buffer.get());
+	}
 
 	return 0;
 
+err_stop_metadata:
+	data->stopMetadata();
 err_release_buffers:
 	data->video_->releaseBuffers();
+	data->mjpegBuffers_.clear();
 
 	return ret;
 }
@@ -320,8 +453,29 @@ err_release_buffers:
 void PipelineHandlerUVC::stopDevice(Camera *camera)
 {
 	UVCCameraData *data = cameraData(camera);
+
+	/*
+	 * Stop the metadata first to complete the pending image buffers, and
+	 * the decoder before the capture, as it requeues the decoded buffers.
+	 */
+	data->stopMetadata();
+	if (data->useDecoder_)
+		data->decoder_->stop();
+
 	data->video_->streamOff();
 	data->video_->releaseBuffers();
+
+	/* Cancel the requests that haven't been given a captured frame. */
+	while (!data->decodeQueue_.empty()) {
+		FrameBuffer *buffer = data->decodeQueue_.front();
+		data->decodeQueue_.pop();
+
+		buffer->_d()->cancel();
+		completeBuffer(buffer->request(), buffer);
+		completeRequest(buffer->request());
+	}
+
+	data->mjpegBuffers_.clear();
 }
 
 int PipelineHandlerUVC::processControl(const UVCCameraData *data, ControlList *controls,
@@ -460,6 +614,12 @@ int PipelineHandlerUVC::queueRequestDevice(Camera *camera, Request *request)
 	if (ret < 0)
 		return ret;
 
+	/* The buffer will be decoded to when a frame is captured. */
+	if (data->useDecoder_) {
+		data->decodeQueue_.push(buffer);
+		return 0;
+	}
+
 	ret = data->video_->queueBuffer(buffer);
 	if (ret < 0)
 		return ret;
@@ -500,7 +660,13 @@ bool PipelineHandlerUVC::acquireDevice(Camera *camera)
 
 	MutexLocker locker(data->openLock_);
 
-	return data->video_->open() == 0;
+	if (data->video_->open())
+		return false;
+
+	if (data->metadata_ && data->metadata_->open())
+		LOG(UVC, Warning) << "Failed to open the metadata device";
+
+	return true;
 }
 
 void PipelineHandlerUVC::releaseDevice(Camera *camera)
@@ -509,6 +675,8 @@ void PipelineHandlerUVC::releaseDevice(Camera *camera)
 
 	MutexLocker locker(data->openLock_);
 	data->video_->close();
+	if (data->metadata_)
+		data->metadata_->close();
 }
 
 int UVCCameraData::init(std::shared_ptr<MediaDevice> media)
@@ -540,6 +708,8 @@ int UVCCameraData::init(std::shared_ptr<MediaDevice> media)
 		return -EINVAL;
 	}
 
+	initMetadata(media);
+
 	/*
 	 * Populate the map of supported formats, and infer the camera sensor
 	 * resolution from the largest size it advertises.
@@ -566,6 +736,8 @@ int UVCCameraData::init(std::shared_ptr<MediaDevice> media)
 		return -EINVAL;
 	}
 
+	initDecoder();
+
 	/* Populate the camera properties. */
 	properties_.set(properties::Model, utils::toAscii(media->model()));
 
@@ -890,18 +1062,280 @@ void UVCCameraData::addControl(uint32_t cid, const ControlInfo &v4l2Info,
 	ctrls->emplace(id, info);
 }
 
+void UVCCameraData::initDecoder()
+{
+	const GlobalConfiguration &configuration =
+		pipe()->cameraManager()->_d()->configuration();
+	bool enabled = configuration.option<bool>({ "pipelines", "uvcvideo", "mjpeg_decoder" })
+			       .value_or(true);
+
+	auto mjpeg = formats_.find(formats::MJPEG);
+	if (!enabled || !MjpegDecoder::isAvailable() || mjpeg == formats_.end())
+		return;
+
+	/*
+	 * Expose the decoded formats with the MJPEG sizes, unless the camera
+	 * supports them natively.
+	 */
+	for (const PixelFormat &format : MjpegDecoder::formats()) {
+		if (formats_.count(format))
+			continue;
+
+		formats_[format] = mjpeg->second;
+		decodedFormats_.insert(format);
+	}
+
+	if (decodedFormats_.empty())
+		return;
+
+	decoder_ = std::make_unique<MjpegDecoder>();
+	decoder_->inputBufferReady.connect(this, &UVCCameraData::decoderInputDone);
+	decoder_->outputBufferReady.connect(this, &UVCCameraData::decoderOutputDone);
+}
+
+void UVCCameraData::initMetadata(std::shared_ptr<MediaDevice> media)
+{
+	std::optional<uint32_t> frequency =
+		UVCMetadataParser::clockFrequency(video_->devicePath());
+	if (!frequency || !*frequency) {
+		LOG(UVC, Debug) << "Device clock frequency unknown, ignoring metadata";
+		return;
+	}
+
+	/*
+	 * The metadata node is the video node, other than the default one,
+	 * that supports the UVC payload header metadata format.
+	 */
+	for (MediaEntity *entity : media->entities()) {
+		if (entity->type() != MediaEntity::Type::V4L2VideoDevice ||
+		    entity->flags() & MEDIA_ENT_FL_DEFAULT)
+			continue;
+
+		auto metadata = std::make_unique<V4L2VideoDevice>(entity);
+		if (metadata->open())
+			continue;
+
+		V4L2DeviceFormat format;
+		format.fourcc = V4L2PixelFormat(V4L2_META_FMT_UVC);
+
+		bool supported = metadata->caps().isMetaCapture() &&
+				 !metadata->tryFormat(&format) &&
+				 format.fourcc == V4L2PixelFormat(V4L2_META_FMT_UVC);
+		metadata->close();
+
+		if (!supported)
+			continue;
+
+		metadata->bufferReady.connect(this, &UVCCameraData::metadataBufferReady);
+		metadata_ = std::move(metadata);
+		metadataParser_ = std::make_unique<UVCMetadataParser>(*frequency);
+
+		LOG(UVC, Debug)
+			<< "Using metadata node " << metadata_->deviceNode()
+			<< ", device clock " << *frequency << " Hz";
+		return;
+	}
+}
+
+int UVCCameraData::startMetadata()
+{
+	if (!metadata_ || !metadata_->isOpen())
+		return 0;
+
+	V4L2DeviceFormat format;
+	format.fourcc = V4L2PixelFormat(V4L2_META_FMT_UVC);
+
+	int ret = metadata_->setFormat(&format);
+	if (ret)
+		return ret;
+
+	ret = metadata_->allocateBuffers(kNumMetadataBuffers, &metadataBuffers_);
+	if (ret < 0)
+		return ret;
+
+	for (const std::unique_ptr<FrameBuffer> &buffer : metadataBuffers_) {
+		MappedFrameBuffer mapped(buffer.get(), MappedFrameBuffer::MapFlag::Read);
+		if (!mapped.isValid()) {
+			ret = -ENOMEM;
+			goto error;
+		}
+
+		mappedMetadataBuffers_.emplace(buffer.get(), std::move(mapped));
+	}
+
+	ret = metadata_->streamOn();
+	if (ret < 0)
+		goto error;
+
+	for (const std::unique_ptr<FrameBuffer> &buffer : metadataBuffers_)
+		metadata_->queueBuffer(buffer.get());
+
+	metadataParser_->reset();
+	useMetadata_ = true;
+
+	return 0;
+
+error:
+	mappedMetadataBuffers_.clear();
+	metadataBuffers_.clear();
+	metadata_->releaseBuffers();
+	return ret;
+}
+
+void UVCCameraData::stopMetadata()
+{
+	if (useMetadata_) {
+		useMetadata_ = false;
+
+		metadata_->streamOff();
+		mappedMetadataBuffers_.clear();
+		metadataBuffers_.clear();
+		metadata_->releaseBuffers();
+	}
+
+	pendingTimestamps_ = {};
+	completePendingBuffers();
+}
+
+void UVCCameraData::metadataBufferReady(FrameBuffer *buffer)
+{
+	const int64_t offset = boottimeOffset();
+	const FrameMetadata &metadata = buffer->metadata();
+
+	if (metadata.status == FrameMetadata::FrameCancelled)
+		return;
+
+	/*
+	 * The metadata buffer carries the timestamp of the corresponding image
+	 * buffer. Record the timestamp computed from the payload headers, to
+	 * be reported when completing the image buffer.
+	 */
+	std::optional<uint64_t> timestamp;
+	if (metadata.status == FrameMetadata::FrameSuccess) {
+		Span<const uint8_t> data = mappedMetadataBuffers_.at(buffer).planes()[0];
+		size_t bytesused = std::min<size_t>(metadata.planes()[0].bytesused,
+						    data.size());
+		timestamp = metadataParser_->process(data.first(bytesused), offset);
+	}
+
+	pendingTimestamps_.emplace(metadata.timestamp, timestamp);
+	metadata_->queueBuffer(buffer);
+
+	completePendingBuffers();
+}
+
 void UVCCameraData::imageBufferReady(FrameBuffer *buffer)
 {
-	Request *request = buffer->request();
+	pendingBuffers_.emplace(buffer, boottimeOffset());
+	completePendingBuffers();
+}
+
+void UVCCameraData::completePendingBuffers()
+{
+	while (!pendingBuffers_.empty()) {
+		auto [buffer, offset] = pendingBuffers_.front();
+		uint64_t timestamp = buffer->metadata().timestamp;
+		std::optional<uint64_t> sensorTimestamp;
+
+		if (useMetadata_ &&
+		    buffer->metadata().status == FrameMetadata::FrameSuccess) {
+			/* Drop the metadata of frames that have been lost. */
+			while (!pendingTimestamps_.empty() &&
+			       pendingTimestamps_.front().first < timestamp)
+				pendingTimestamps_.pop();
+
+			/*
+			 * Wait for the metadata of the frame, unless it appears
+			 * to have been lost.
+			 */
+			if (pendingTimestamps_.empty() &&
+			    pendingBuffers_.size() <= kMaxPendingBuffers)
+				return;
+
+			if (!pendingTimestamps_.empty() &&
+			    pendingTimestamps_.front().first == timestamp) {
+				sensorTimestamp = pendingTimestamps_.front().second;
+				pendingTimestamps_.pop();
+			}
+		}
+
+		/*
+		 * Sensor timestamps use CLOCK_BOOTTIME. Convert the
+		 * CLOCK_MONOTONIC buffer timestamp when no timestamp has been
+		 * computed from the metadata.
+		 */
+		if (!sensorTimestamp)
+			sensorTimestamp = timestamp + offset;
+
+		pendingBuffers_.pop();
+		processBuffer(buffer, *sensorTimestamp);
+	}
+}
+
+void UVCCameraData::processBuffer(FrameBuffer *buffer, uint64_t timestamp)
+{
+	const FrameMetadata::Status status = buffer->metadata().status;
+	FrameBuffer *output = buffer;
+
+	/*
+	 * When decoding MJPEG, the captured frame is decoded to the buffer of
+	 * the oldest request. If there's no request, requeue the internal
+	 * buffer for capture right away.
+	 */
+	if (useDecoder_) {
+		if (decodeQueue_.empty()) {
+			if (status != FrameMetadata::FrameCancelled)
+				video_->queueBuffer(buffer);
+			return;
+		}
 
-	/* \todo Use the UVC metadata to calculate a more precise timestamp */
-	request->_d()->metadata().set(controls::SensorTimestamp,
-				      buffer->metadata().timestamp);
+		output = decodeQueue_.front();
+		decodeQueue_.pop();
+	}
+
+	Request *request = output->request();
+
+	ControlList sensorMetadata(controls::controls);
+	sensorMetadata.set(controls::SensorTimestamp, timestamp);
+	pipe()->metadataAvailable(request, sensorMetadata);
+
+	if (!useDecoder_) {
+		completeRequest(buffer);
+		return;
+	}
+
+	if (status == FrameMetadata::FrameSuccess) {
+		decoder_->queueBuffers(buffer, output);
+		return;
+	}
+
+	/* Don't decode erroneous frames, complete the request right away. */
+	if (status != FrameMetadata::FrameCancelled)
+		video_->queueBuffer(buffer);
+
+	output->_d()->metadata().status = status;
+	completeRequest(output);
+}
+
+void UVCCameraData::completeRequest(FrameBuffer *buffer)
+{
+	Request *request = buffer->request();
 
 	pipe()->completeBuffer(request, buffer);
 	pipe()->completeRequest(request);
 }
 
+void UVCCameraData::decoderInputDone(FrameBuffer *buffer)
+{
+	/* Queue the MJPEG buffer back for capture. */
+	video_->queueBuffer(buffer);
+}
+
+void UVCCameraData::decoderOutputDone(FrameBuffer *buffer)
+{
+	completeRequest(buffer);
+}
+
 REGISTER_PIPELINE_HANDLER(PipelineHandlerUVC, "uvcvideo")
 
 } /* namespace libcamera */
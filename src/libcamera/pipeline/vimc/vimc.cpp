@@ -614,9 +614,11 @@ void VimcCameraData::imageBufferReady(FrameBuffer *buffer)
 		return;
 	}
 
-	/* Record the sensor's timestamp in the request metadata. */
-	request->_d()->metadata().set(controls::SensorTimestamp,
-				      buffer->metadata().timestamp);
+	/* Report the sensor's timestamp as early metadata. */
+	ControlList sensorMetadata(controls::controls);
+	sensorMetadata.set(controls::SensorTimestamp,
+			   buffer->metadata().timestamp);
+	pipe->metadataAvailable(request, sensorMetadata);
 
 	pipe->completeBuffer(request, buffer);
 	pipe->completeRequest(request);
@@ -7,14 +7,26 @@
 
 #include "config_parser.h"
 
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <optional>
 #include <string.h>
+#include <string>
+#include <type_traits>
 #include <utility>
 
 #include <libcamera/base/log.h>
+#include <libcamera/base/span.h>
 
 #include <libcamera/control_ids.h>
+#include <libcamera/formats.h>
+#include <libcamera/pixel_format.h>
 #include <libcamera/property_ids.h>
 
+#include "libcamera/internal/bayer_format.h"
+#include "libcamera/internal/formats.h"
 #include "libcamera/internal/pipeline_handler.h"
 #include "libcamera/internal/yaml_parser.h"
 
@@ -22,8 +34,142 @@
 
 namespace libcamera {
 
+using namespace std::literals::chrono_literals;
+
 LOG_DECLARE_CATEGORY(Virtual)
 
+namespace {
+
+/* 64-bit integers are parsed from their string representation */
+template<typename T>
+std::optional<T> parseScalar(const ValueNode &node)
+{
+	if constexpr (std::is_same_v<T, int64_t> || std::is_same_v<T, uint64_t>) {
+		std::optional<std::string> str = node.get<std::string>();
+		if (!str)
+			return std::nullopt;
+
+		T value;
+		auto [ptr, ec] = std::from_chars(str->data(), str->data() + str->size(), value);
+		if (ec != std::errc() || ptr != str->data() + str->size())
+			return std::nullopt;
+
+		return value;
+	} else {
+		return node.get<T>();
+	}
+}
+
+template<typename T>
+std::optional<ControlValue> parseControlArray(const ControlId *id, const ValueNode &node)
+{
+	if (!node.isList())
+		return std::nullopt;
+
+	std::vector<T> values;
+	for (const ValueNode &entry : node.asList()) {
+		std::optional<T> value = parseScalar<T>(entry);
+		if (!value)
+			return std::nullopt;
+
+		values.push_back(*value);
+	}
+
+	if (id->size() != std::numeric_limits<std::size_t>::max() &&
+	    values.size() != id->size())
+		return std::nullopt;
+
+	return ControlValue(Span<const T>(values));
+}
+
+template<typename T>
+std::optional<ControlValue> parseControlValue(const ControlId *id, const ValueNode &node)
+{
+	if (!id->isArray()) {
+		std::optional<T> value = parseScalar<T>(node);
+		if (!value)
+			return std::nullopt;
+
+		return ControlValue(*value);
+	}
+
+	/* Boolean arrays can't be stored in a std::vector. */
+	if constexpr (std::is_same_v<T, bool>)
+		return std::nullopt;
+	else
+		return parseControlArray<T>(id, node);
+}
+
+/*
+ * Parse a dictionary of control names and values to \a controls. Controls of
+ * unknown names or unsupported types are ignored.
+ */
+int parseControls(const ValueNode &node, ControlList *controls)
+{
+	static const std::map<std::string, const ControlId *, std::less<>> controlIds = []() {
+		std::map<std::string, const ControlId *, std::less<>> ids;
+		for (const auto &[id, ctrl] : controls::controls)
+			ids[ctrl->name()] = ctrl;
+		return ids;
+	}();
+
+	if (!node)
+		return 0;
+
+	if (!node.isDictionary())
+		return -EINVAL;
+
+	for (const auto &[name, value] : node.asDict()) {
+		auto it = controlIds.find(name);
+		if (it == controlIds.end()) {
+			LOG(Virtual, Debug) << "Ignoring unknown control " << name;
+			continue;
+		}
+
+		const ControlId *id = it->second;
+		std::optional<ControlValue> controlValue;
+
+		switch (id->type()) {
+		case ControlTypeBool:
+			controlValue = parseControlValue<bool>(id, value);
+			break;
+		case ControlTypeByte:
+			controlValue = parseControlValue<uint8_t>(id, value);
+			break;
+		case ControlTypeUnsigned16:
+			controlValue = parseControlValue<uint16_t>(id, value);
+			break;
+		case ControlTypeUnsigned32:
+			controlValue = parseControlValue<uint32_t>(id, value);
+			break;
+		case ControlTypeInteger32:
+			controlValue = parseControlValue<int32_t>(id, value);
+			break;
+		case ControlTypeInteger64:
+			controlValue = parseControlValue<int64_t>(id, value);
+			break;
+		case ControlTypeFloat:
+			controlValue = parseControlValue<float>(id, value);
+			break;
+		default:
+			LOG(Virtual, Debug)
+				<< "Ignoring control " << name << " of unsupported type";
+			continue;
+		}
+
+		if (!controlValue) {
+			LOG(Virtual, Error) << "Invalid value for control " << name;
+			return -EINVAL;
+		}
+
+		controls->set(id->id(), *controlValue);
+	}
+
+	return 0;
+}
+
+} /* namespace */
+
 std::vector<std::unique_ptr<VirtualCameraData>>
 ConfigParser::parseConfigFile(File &file, PipelineHandler *pipe)
 {
@@ -76,14 +222,37 @@ ConfigParser::parseCameraConfigData(const ValueNode &cameraConfigData,
 				    PipelineHandler *pipe)
 {
 	std::vector<VirtualCameraData::Resolution> resolutions;
-	if (parseSupportedFormats(cameraConfigData, &resolutions))
+	std::optional<RecordingFrames> recording;
+
+	/* Recordings define the resolution and frame rate of the camera. */
+	if (cameraConfigData.contains("recording")) {
+		recording.emplace();
+		if (parseRecording(cameraConfigData, &*recording, &resolutions))
+			return nullptr;
+	} else if (parseSupportedFormats(cameraConfigData, &resolutions)) {
 		return nullptr;
+	}
 
 	std::unique_ptr<VirtualCameraData> data =
 		std::make_unique<VirtualCameraData>(pipe, resolutions);
 
-	if (parseFrameGenerator(cameraConfigData, data.get()))
+	if (recording) {
+		/* Recorded frames are replayed as the raw frames of the camera. */
+		data->config_.raw = VirtualCameraData::RawConfiguration{
+			recording->format, recording->isp
+		};
+
+		/* Frames are paced at the recorded timing by the frame pacer. */
+		if (recording->realtime) {
+			data->pacer_ = FramePacer::create({});
+			if (!data->pacer_)
+				return nullptr;
+		}
+
+		data->config_.frame = std::move(*recording);
+	} else if (parseFrameGenerator(cameraConfigData, data.get())) {
 		return nullptr;
+	}
 
 	if (parseLocation(cameraConfigData, data.get()))
 		return nullptr;
@@ -91,6 +260,12 @@ ConfigParser::parseCameraConfigData(const ValueNode &cameraConfigData,
 	if (parseModel(cameraConfigData, data.get()))
 		return nullptr;
 
+	if (parsePacing(cameraConfigData, data.get()))
+		return nullptr;
+
+	if (parseRaw(cameraConfigData, data.get()))
+		return nullptr;
+
 	return data;
 }
 
@@ -226,7 +401,41 @@ int ConfigParser::parseFrameGenerator(const ValueNode &cameraConfigData, Virtual
 		return -EINVAL;
 	}
 
-	data->config_.frame = ImageFrames{ std::move(files) };
+	ImageFrames imageFrames;
+	imageFrames.files = std::move(files);
+
+	imageFrames.repeat = frames["repeat"].get<uint32_t>(4);
+	if (!imageFrames.repeat) {
+		LOG(Virtual, Error) << "Invalid repeat: it needs to be at least 1";
+		return -EINVAL;
+	}
+
+	imageFrames.prefetch = frames["prefetch"].get<uint32_t>(0);
+
+	/* Raw sequence files contain frames of a fixed format and size. */
+	if (frames.contains("format")) {
+		std::string name = frames["format"].get<std::string>("");
+		PixelFormat format = PixelFormat::fromString(name);
+		if (format != formats::NV12 && format != formats::YUV420) {
+			LOG(Virtual, Error) << "Frames format: " << name
+					    << " is not supported";
+			return -EINVAL;
+		}
+
+		unsigned int width = frames["width"].get<uint32_t>(0);
+		unsigned int height = frames["height"].get<uint32_t>(0);
+		if (!width || !height || width % 2 || height % 2) {
+			LOG(Virtual, Error)
+				<< "Invalid frames size: " << width << "x" << height
+				<< ", it needs to be even and not null";
+			return -EINVAL;
+		}
+
+		imageFrames.format = format;
+		imageFrames.size = Size(width, height);
+	}
+
+	data->config_.frame = std::move(imageFrames);
 
 	return 0;
 }
@@ -261,4 +470,249 @@ int ConfigParser::parseModel(const ValueNode &cameraConfigData, VirtualCameraDat
 	return 0;
 }
 
+int ConfigParser::parsePacing(const ValueNode &cameraConfigData, VirtualCameraData *data)
+{
+	const ValueNode &pacing = cameraConfigData["pacing"];
+
+	/* Without a pacing entry, requests are completed as fast as possible */
+	if (!pacing)
+		return 0;
+
+	if (!pacing.isDictionary()) {
+		LOG(Virtual, Error) << "'pacing' is not a dictionary.";
+		return -EINVAL;
+	}
+
+	FramePacer::Config config;
+
+	double jitter = pacing["jitter"].get<double>(0.0);
+	if (jitter < 0.0) {
+		LOG(Virtual, Error) << "Invalid jitter: " << jitter;
+		return -EINVAL;
+	}
+	config.jitter = utils::Duration(jitter * 1000.0);
+
+	config.dropRate = pacing["drop_rate"].get<double>(0.0);
+	if (config.dropRate < 0.0 || config.dropRate >= 1.0) {
+		LOG(Virtual, Error)
+			<< "Invalid drop_rate: " << config.dropRate
+			<< ", it needs to be in the [0, 1) range";
+		return -EINVAL;
+	}
+
+	config.controlDelay = pacing["control_delay"].get<uint32_t>(0);
+	config.seed = pacing["seed"].get<uint32_t>(0);
+
+	data->pacer_ = FramePacer::create(config);
+	if (!data->pacer_)
+		return -EIO;
+
+	return 0;
+}
+
+int ConfigParser::parseRaw(const ValueNode &cameraConfigData, VirtualCameraData *data)
+{
+	const ValueNode &raw = cameraConfigData["raw"];
+
+	/* Without a raw entry, only processed frames are produced */
+	if (!raw)
+		return 0;
+
+	if (!raw.isDictionary()) {
+		LOG(Virtual, Error) << "'raw' is not a dictionary.";
+		return -EINVAL;
+	}
+
+	if (!std::holds_alternative<TestPattern>(data->config_.frame)) {
+		LOG(Virtual, Error) << "Raw frames require a test pattern";
+		return -EINVAL;
+	}
+
+	std::string name = raw["format"].get<std::string>("SRGGB10_CSI2P");
+	PixelFormat format = PixelFormat::fromString(name);
+	if (!format.isValid() || format == formats::NV12 ||
+	    !TestPatternGenerator::isSupported(format)) {
+		LOG(Virtual, Error) << "Raw format: " << name << " is not supported";
+		return -EINVAL;
+	}
+
+	VirtualCameraData::RawConfiguration config;
+	config.format = format;
+	config.isp = raw["isp"].get<bool>(false);
+
+	data->config_.raw = config;
+
+	return 0;
+}
+
+int ConfigParser::parseRecording(const ValueNode &cameraConfigData,
+				 RecordingFrames *recording,
+				 std::vector<VirtualCameraData::Resolution> *resolutions)
+{
+	const ValueNode &config = cameraConfigData["recording"];
+
+	if (!config.isDictionary()) {
+		LOG(Virtual, Error) << "'recording' is not a dictionary.";
+		return -EINVAL;
+	}
+
+	/* The recording defines the frames, their format and their timing. */
+	for (const char *key : { "supported_formats", "test_pattern", "frames",
+				 "pacing", "raw" }) {
+		if (cameraConfigData.contains(key)) {
+			LOG(Virtual, Error)
+				<< "A camera can't use both recording and " << key;
+			return -EINVAL;
+		}
+	}
+
+	auto path = config["path"].get<std::string>();
+	if (!path) {
+		LOG(Virtual, Error) << "Recording path should be specified.";
+		return -EINVAL;
+	}
+
+	std::string timing = config["timing"].get<std::string>("original");
+	if (timing == "original") {
+		recording->realtime = true;
+	} else if (timing == "fast") {
+		recording->realtime = false;
+	} else {
+		LOG(Virtual, Error) << "Recording timing: " << timing
+				    << " is not supported";
+		return -EINVAL;
+	}
+
+	recording->isp = config["isp"].get<bool>(false);
+
+	int ret = parseRecordingIndex(*path, recording);
+	if (ret)
+		return ret;
+
+	/* Report the average frame rate of the recording. */
+	int64_t frameRate = std::max<int64_t>(1, std::lround(1.0s / recording->frameDuration));
+	resolutions->emplace_back(
+		VirtualCameraData::Resolution{ recording->size, { frameRate, frameRate } });
+
+	return 0;
+}
+
+/*
+ * Parse the recording index at \a path, which describes the format of the
+ * recorded frames, and lists the frames in capture order along with the file
+ * they are stored in, their timestamp, metadata and request controls.
+ */
+int ConfigParser::parseRecordingIndex(const std::filesystem::path &path,
+				      RecordingFrames *recording)
+{
+	File file(path);
+	if (!file.open(File::OpenModeFlag::ReadOnly)) {
+		LOG(Virtual, Error) << "Failed to open recording " << file.fileName()
+				    << ": " << strerror(-file.error());
+		return -ENOENT;
+	}
+
+	std::unique_ptr<ValueNode> index = YamlParser::parse(file);
+	if (!index || !index->isDictionary()) {
+		LOG(Virtual, Error) << "Failed to parse recording " << path;
+		return -EINVAL;
+	}
+
+	std::string name = (*index)["format"].get<std::string>("");
+	recording->format = PixelFormat::fromString(name);
+	if (!BayerFormat::fromPixelFormat(recording->format).isValid()) {
+		LOG(Virtual, Error) << "Recording format: " << name
+				    << " is not supported, it needs to be a raw format";
+		return -EINVAL;
+	}
+
+	unsigned int width = (*index)["width"].get<uint32_t>(0);
+	unsigned int height = (*index)["height"].get<uint32_t>(0);
+	if (!width || !height || width % 2 || height % 2) {
+		LOG(Virtual, Error)
+			<< "Invalid recording size: " << width << "x" << height
+			<< ", it needs to be even and not null";
+		return -EINVAL;
+	}
+
+	recording->size = Size(width, height);
+
+	unsigned int minStride = PixelFormatInfo::info(recording->format).stride(width, 0, 1);
+	recording->stride = (*index)["stride"].get<uint32_t>(minStride);
+	if (recording->stride < minStride) {
+		LOG(Virtual, Error) << "Invalid recording stride: " << recording->stride;
+		return -EINVAL;
+	}
+
+	const ValueNode &frames = (*index)["frames"];
+	if (!frames.isList() || !frames.size()) {
+		LOG(Virtual, Error) << "Recording has no frames";
+		return -EINVAL;
+	}
+
+	/* Frame files are relative to the directory of the index. */
+	std::filesystem::path directory = path.parent_path();
+
+	for (const ValueNode &entry : frames.asList()) {
+		RecordedFrame frame;
+
+		auto fileName = entry["file"].get<std::string>();
+		auto sequence = entry["sequence"].get<uint32_t>();
+		auto timestamp = parseScalar<uint64_t>(entry["timestamp"]);
+		auto offset = parseScalar<uint64_t>(entry["offset"]);
+		if (!fileName || !sequence || !timestamp ||
+		    (entry.contains("offset") && !offset)) {
+			LOG(Virtual, Error)
+				<< "Recorded frame " << recording->frames.size()
+				<< " needs a file, a sequence and a timestamp";
+			return -EINVAL;
+		}
+
+		if (!recording->frames.empty() &&
+		    *sequence <= recording->frames.back().sequence) {
+			LOG(Virtual, Error)
+				<< "Recorded frame sequences need to be increasing";
+			return -EINVAL;
+		}
+
+		frame.file = directory / *fileName;
+		frame.offset = offset.value_or(0);
+		frame.sequence = *sequence;
+		frame.timestamp = *timestamp;
+		frame.controls = ControlList(controls::controls);
+		frame.metadata = ControlList(controls::controls);
+
+		ControlList metadata(controls::controls);
+		if (parseControls(entry["controls"], &frame.controls) ||
+		    parseControls(entry["metadata"], &metadata)) {
+			LOG(Virtual, Error)
+				<< "Invalid controls or metadata for frame " << *sequence;
+			return -EINVAL;
+		}
+
+		/* The timestamp is reported by the replay. */
+		for (const auto &[id, value] : metadata) {
+			if (id != controls::SensorTimestamp.id())
+				frame.metadata.set(id, value);
+		}
+
+		recording->frames.push_back(std::move(frame));
+	}
+
+	/* Default to 30 fps for recordings without a valid timeline. */
+	const RecordedFrame &first = recording->frames.front();
+	const RecordedFrame &last = recording->frames.back();
+	if (last.timestamp > first.timestamp)
+		recording->frameDuration = utils::Duration(last.timestamp - first.timestamp) /
+					   (recording->frames.size() - 1);
+	else
+		recording->frameDuration = utils::Duration(1.0s / 30);
+
+	LOG(Virtual, Debug)
+		<< "Recording " << path << ": " << recording->frames.size()
+		<< " frames of " << recording->format << "/" << recording->size;
+
+	return 0;
+}
+
 } /* namespace libcamera */
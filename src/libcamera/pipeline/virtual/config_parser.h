@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <filesystem>
 #include <memory>
 #include <vector>
 
@@ -34,6 +35,12 @@ private:
 	int parseFrameGenerator(const ValueNode &cameraConfigData, VirtualCameraData *data);
 	int parseLocation(const ValueNode &cameraConfigData, VirtualCameraData *data);
 	int parseModel(const ValueNode &cameraConfigData, VirtualCameraData *data);
+	int parsePacing(const ValueNode &cameraConfigData, VirtualCameraData *data);
+	int parseRaw(const ValueNode &cameraConfigData, VirtualCameraData *data);
+	int parseRecording(const ValueNode &cameraConfigData, RecordingFrames *recording,
+			   std::vector<VirtualCameraData::Resolution> *resolutions);
+	int parseRecordingIndex(const std::filesystem::path &path,
+				RecordingFrames *recording);
 };
 
 } /* namespace libcamera */
@@ -9,6 +9,7 @@
 
 #include <libcamera/framebuffer.h>
 #include <libcamera/geometry.h>
+#include <libcamera/pixel_format.h>
 
 namespace libcamera {
 
@@ -17,11 +18,14 @@ class FrameGenerator
 public:
 	virtual ~FrameGenerator() = default;
 
-	virtual void configure(const Size &size) = 0;
+	virtual int configure(const PixelFormat &format, const Size &size) = 0;
 
 	virtual int generateFrame(const Size &size,
 				  const FrameBuffer *buffer) = 0;
 
+	/* Scale the pixel values to emulate the sensor exposure, if supported */
+	virtual void setExposureScale([[maybe_unused]] double scale) {}
+
 protected:
 	FrameGenerator() {}
 };
@@ -0,0 +1,185 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Virtual cameras helper to pace frames like a sensor
+ */
+
+#include "frame_pacer.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <libcamera/base/log.h>
+
+namespace libcamera {
+
+LOG_DECLARE_CATEGORY(Virtual)
+
+namespace {
+
+int64_t monotonicTime()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+} /* namespace */
+
+/*
+ * The FramePacer emulates the timing of a sensor running at a given frame
+ * duration. Frames are produced back to back from a CLOCK_MONOTONIC timerfd
+ * armed with absolute expiry times, so that processing delays don't
+ * accumulate. The end of each frame is offset from its nominal time by a
+ * normally distributed jitter, frames can be randomly dropped, and frame
+ * duration changes take effect after a configurable number of frames. The
+ * random generator is seeded from the configuration to make runs
+ * reproducible.
+ *
+ * The control delay only models the frame duration, which is the only control
+ * the pacer handles. The exposure time and analogue gain of virtual sensors are
+ * applied without delay.
+ */
+
+std::unique_ptr<FramePacer> FramePacer::create(const Config &config)
+{
+	UniqueFD timerfd(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC));
+	if (!timerfd.isValid()) {
+		LOG(Virtual, Error)
+			<< "Failed to create timerfd: " << strerror(errno);
+		return nullptr;
+	}
+
+	return std::make_unique<FramePacer>(config, std::move(timerfd));
+}
+
+FramePacer::FramePacer(const Config &config, UniqueFD timerfd)
+	: config_(config), timerfd_(std::move(timerfd)), random_(config.seed),
+	  jitter_(0.0, std::max(config.jitter.get<std::nano>(), 1.0)),
+	  drop_(config.dropRate),
+	  sequence_(0), nominalStart_(0), frameStart_(0), frameEnd_(0)
+{
+}
+
+FramePacer::~FramePacer() = default;
+
+/*
+ * Start producing frames. This shall be called from the thread that handles
+ * the frameCompleted signal, the timer is serviced by its event dispatcher.
+ */
+void FramePacer::start(utils::Duration frameDuration)
+{
+	random_.seed(config_.seed);
+	jitter_.reset();
+	drop_.reset();
+
+	pendingDurations_.clear();
+	sequence_ = 0;
+	frameDuration_ = frameDuration;
+	nominalStart_ = monotonicTime();
+	frameStart_ = nominalStart_;
+
+	notifier_ = std::make_unique<EventNotifier>(timerfd_.get(), EventNotifier::Read);
+	notifier_->activated.connect(this, &FramePacer::timeout);
+
+	arm();
+}
+
+void FramePacer::stop()
+{
+	struct itimerspec spec = {};
+	timerfd_settime(timerfd_.get(), 0, &spec, nullptr);
+
+	notifier_.reset();
+}
+
+/*
+ * Change the frame duration, honouring the control delay. Return the sequence
+ * of the first frame captured with the new duration. When called from the
+ * frameCompleted signal handler, a change without delay applies to the next
+ * frame.
+ */
+uint32_t FramePacer::setFrameDuration(utils::Duration frameDuration)
+{
+	uint32_t sequence = sequence_ + config_.controlDelay;
+
+	pendingDurations_.emplace_back(sequence, frameDuration);
+
+	return sequence;
+}
+
+void FramePacer::arm()
+{
+	int64_t duration = frameDuration_.get<std::nano>();
+
+	/*
+	 * Offset the end of the frame from its nominal time by up to a quarter
+	 * of the frame duration, and never make a frame shorter than half of
+	 * its nominal duration.
+	 */
+	double jitter = config_.jitter.get<std::nano>() > 0 ? jitter_(random_) : 0.0;
+	jitter = std::clamp(jitter, -duration / 4.0, duration / 4.0);
+
+	frameEnd_ = nominalStart_ + duration + static_cast<int64_t>(jitter);
+	frameEnd_ = std::max(frameEnd_, frameStart_ + duration / 2);
+
+	struct itimerspec spec = {};
+	spec.it_value.tv_sec = frameEnd_ / 1000000000;
+	spec.it_value.tv_nsec = frameEnd_ % 1000000000;
+
+	int ret = timerfd_settime(timerfd_.get(), TFD_TIMER_ABSTIME, &spec, nullptr);
+	if (ret < 0)
+		LOG(Virtual, Error)
+			<< "Failed to arm frame timer: " << strerror(errno);
+}
+
+void FramePacer::timeout()
+{
+	uint64_t expirations;
+	if (read(timerfd_.get(), &expirations, sizeof(expirations)) < 0)
+		return;
+
+	Frame frame;
+	frame.sequence = sequence_;
+	frame.timestamp = frameStart_;
+	frame.duration = utils::Duration(frameEnd_ - frameStart_);
+	frame.dropped = config_.dropRate > 0.0 && drop_(random_);
+
+	/*
+	 * Move to the next frame before notifying, so that duration changes
+	 * requested by the signal handler can apply to the next frame.
+	 */
+	nominalStart_ += frameDuration_.get<std::nano>();
+	frameStart_ = frameEnd_;
+	sequence_++;
+
+	frameCompleted.emit(frame);
+
+	while (!pendingDurations_.empty() &&
+	       pendingDurations_.front().first <= sequence_) {
+		frameDuration_ = pendingDurations_.front().second;
+		pendingDurations_.pop_front();
+	}
+
+	/*
+	 * If processing has fallen behind by more than a frame, restart the
+	 * timeline from the current time instead of bursting to catch up, as
+	 * a sensor would after a stall.
+	 */
+	int64_t now = monotonicTime();
+	if (nominalStart_ + frameDuration_.get<std::nano>() < now) {
+		nominalStart_ = now;
+		frameStart_ = now;
+	}
+
+	if (notifier_)
+		arm();
+}
+
+} /* namespace libcamera */
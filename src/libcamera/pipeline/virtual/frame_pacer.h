@@ -0,0 +1,77 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Virtual cameras helper to pace frames like a sensor
+ */
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <random>
+#include <stdint.h>
+#include <utility>
+
+#include <libcamera/base/event_notifier.h>
+#include <libcamera/base/signal.h>
+#include <libcamera/base/unique_fd.h>
+#include <libcamera/base/utils.h>
+
+namespace libcamera {
+
+class FramePacer
+{
+public:
+	/* The pacing parameters, parsed from the `pacing` config file entry */
+	struct Config {
+		utils::Duration jitter{ 0 };
+		double dropRate = 0.0;
+		unsigned int controlDelay = 0;
+		uint32_t seed = 0;
+	};
+
+	struct Frame {
+		uint32_t sequence;
+		uint64_t timestamp;
+		utils::Duration duration;
+		bool dropped;
+	};
+
+	static std::unique_ptr<FramePacer> create(const Config &config);
+
+	FramePacer(const Config &config, UniqueFD timerfd);
+	~FramePacer();
+
+	void start(utils::Duration frameDuration);
+	void stop();
+
+	uint32_t setFrameDuration(utils::Duration frameDuration);
+
+	Signal<const Frame &> frameCompleted;
+
+private:
+	void arm();
+	void timeout();
+
+	Config config_;
+
+	UniqueFD timerfd_;
+	std::unique_ptr<EventNotifier> notifier_;
+
+	std::mt19937 random_;
+	std::normal_distribution<double> jitter_;
+	std::bernoulli_distribution drop_;
+
+	/* Frame duration changes waiting for their frame, by sequence */
+	std::deque<std::pair<uint32_t, utils::Duration>> pendingDurations_;
+
+	uint32_t sequence_;
+	utils::Duration frameDuration_;
+	/* Nominal and actual start time of the current frame, in nanoseconds */
+	int64_t nominalStart_;
+	int64_t frameStart_;
+	int64_t frameEnd_;
+};
+
+} /* namespace libcamera */
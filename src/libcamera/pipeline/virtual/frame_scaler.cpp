@@ -0,0 +1,152 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Virtual cameras helper to scale and convert frames
+ */
+
+#include "frame_scaler.h"
+
+#include <algorithm>
+#include <errno.h>
+
+#include <libcamera/base/log.h>
+
+#include <libcamera/formats.h>
+
+#include "libcamera/internal/formats.h"
+
+#include "libyuv/convert.h"
+#include "libyuv/convert_argb.h"
+#include "libyuv/scale.h"
+
+namespace libcamera {
+
+LOG_DECLARE_CATEGORY(Virtual)
+
+/*
+ * The FrameScaler produces the frames of a stream from the NV12 source frame
+ * shared by all the streams of a virtual camera. The source frame is scaled to
+ * the stream size, and converted to the stream pixel format. When both are
+ * needed, the frame is scaled in NV12 to an intermediate buffer first.
+ */
+
+namespace {
+
+const std::vector<PixelFormat> kFormats = {
+	formats::NV12,
+	formats::YUV420,
+	formats::YVU420,
+	formats::XRGB8888,
+};
+
+} /* namespace */
+
+const std::vector<PixelFormat> &FrameScaler::formats()
+{
+	return kFormats;
+}
+
+int FrameScaler::configure(const Size &sourceSize, const PixelFormat &format,
+			   const Size &size)
+{
+	if (std::find(kFormats.begin(), kFormats.end(), format) == kFormats.end()) {
+		LOG(Virtual, Error) << "Frames can't be converted to " << format;
+		return -EINVAL;
+	}
+
+	sourceSize_ = sourceSize;
+	format_ = format;
+	size_ = size;
+
+	const PixelFormatInfo &info = PixelFormatInfo::info(format);
+	for (unsigned int i = 0; i < strides_.size(); i++)
+		strides_[i] = info.stride(size.width, i, 1);
+
+	scaled_.clear();
+	if (size_ != sourceSize_ && format_ != formats::NV12)
+		scaled_.resize(PixelFormatInfo::info(formats::NV12).frameSize(size_, 1));
+
+	return 0;
+}
+
+int FrameScaler::process(const MappedFrameBuffer &source, const FrameBuffer *buffer)
+{
+	MappedFrameBuffer mappedFrameBuffer(buffer, MappedFrameBuffer::MapFlag::Write);
+	if (!mappedFrameBuffer.isValid())
+		return -EINVAL;
+
+	const auto &planes = mappedFrameBuffer.planes();
+
+	const uint8_t *srcY = source.planes()[0].data();
+	const uint8_t *srcUV = source.planes()[1].data();
+	unsigned int srcStride = sourceSize_.width;
+	int ret;
+
+	if (size_ != sourceSize_) {
+		uint8_t *dstY;
+		uint8_t *dstUV;
+		unsigned int dstStrideY;
+		unsigned int dstStrideUV;
+
+		/* Scale directly to the stream buffer, with its stride, for NV12. */
+		if (format_ == formats::NV12) {
+			dstY = planes[0].data();
+			dstUV = planes[1].data();
+			dstStrideY = strides_[0];
+			dstStrideUV = strides_[1];
+		} else {
+			dstY = scaled_.data();
+			dstUV = dstY + size_.width * size_.height;
+			dstStrideY = size_.width;
+			dstStrideUV = size_.width;
+		}
+
+		ret = libyuv::NV12Scale(srcY, srcStride, srcUV, srcStride,
+					sourceSize_.width, sourceSize_.height,
+					dstY, dstStrideY, dstUV, dstStrideUV,
+					size_.width, size_.height,
+					libyuv::FilterMode::kFilterBilinear);
+		if (ret) {
+			LOG(Virtual, Error) << "NV12Scale() failed with " << ret;
+			return ret;
+		}
+
+		if (format_ == formats::NV12)
+			return 0;
+
+		srcY = dstY;
+		srcUV = dstUV;
+		srcStride = size_.width;
+	}
+
+	if (format_ == formats::NV12) {
+		ret = libyuv::NV12Copy(srcY, srcStride, srcUV, srcStride,
+				       planes[0].data(), strides_[0],
+				       planes[1].data(), strides_[1],
+				       size_.width, size_.height);
+	} else if (format_ == formats::YUV420 || format_ == formats::YVU420) {
+		/* The two formats only differ by the order of the chroma planes. */
+		unsigned int u = format_ == formats::YUV420 ? 1 : 2;
+		unsigned int v = 3 - u;
+
+		ret = libyuv::NV12ToI420(srcY, srcStride, srcUV, srcStride,
+					 planes[0].data(), strides_[0],
+					 planes[u].data(), strides_[u],
+					 planes[v].data(), strides_[v],
+					 size_.width, size_.height);
+	} else {
+		/* libyuv's ARGB is stored as B, G, R, A, matching XRGB8888. */
+		ret = libyuv::NV12ToARGB(srcY, srcStride, srcUV, srcStride,
+					 planes[0].data(), strides_[0],
+					 size_.width, size_.height);
+	}
+
+	if (ret)
+		LOG(Virtual, Error)
+			<< "Failed to convert frame to " << format_ << ": " << ret;
+
+	return ret;
+}
+
+} /* namespace libcamera */
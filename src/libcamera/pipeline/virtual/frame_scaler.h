@@ -0,0 +1,41 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Virtual cameras helper to scale and convert frames
+ */
+
+#pragma once
+
+#include <array>
+#include <stdint.h>
+#include <vector>
+
+#include <libcamera/framebuffer.h>
+#include <libcamera/geometry.h>
+#include <libcamera/pixel_format.h>
+
+#include "libcamera/internal/mapped_framebuffer.h"
+
+namespace libcamera {
+
+class FrameScaler
+{
+public:
+	static const std::vector<PixelFormat> &formats();
+
+	int configure(const Size &sourceSize, const PixelFormat &format,
+		      const Size &size);
+	int process(const MappedFrameBuffer &source, const FrameBuffer *buffer);
+
+private:
+	Size sourceSize_;
+	PixelFormat format_;
+	Size size_;
+	std::array<unsigned int, 3> strides_;
+
+	/* Intermediate NV12 frame, when the frame is scaled and converted */
+	std::vector<uint8_t> scaled_;
+};
+
+} /* namespace libcamera */
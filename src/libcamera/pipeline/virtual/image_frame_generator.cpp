@@ -7,26 +7,200 @@
 
 #include "image_frame_generator.h"
 
+#include <errno.h>
+#include <queue>
 #include <string>
+#include <string.h>
 
 #include <libcamera/base/file.h>
 #include <libcamera/base/log.h>
+#include <libcamera/base/mutex.h>
+#include <libcamera/base/thread.h>
+#include <libcamera/base/utils.h>
 
+#include <libcamera/formats.h>
 #include <libcamera/framebuffer.h>
 
+#include "libcamera/internal/formats.h"
 #include "libcamera/internal/mapped_framebuffer.h"
 
 #include "libyuv/convert.h"
+#include "libyuv/planar_functions.h"
 #include "libyuv/scale.h"
 
 namespace libcamera {
 
 LOG_DECLARE_CATEGORY(Virtual)
 
+namespace {
+
+int scaleFrame(const uint8_t *srcY, const uint8_t *srcUV, const Size &srcSize,
+	       uint8_t *dstY, uint8_t *dstUV, const Size &dstSize)
+{
+	if (srcSize == dstSize)
+		return libyuv::NV12Copy(srcY, srcSize.width, srcUV, srcSize.width,
+					dstY, dstSize.width, dstUV, dstSize.width,
+					dstSize.width, dstSize.height);
+
+	return libyuv::NV12Scale(srcY, srcSize.width, srcUV, srcSize.width,
+				 srcSize.width, srcSize.height,
+				 dstY, dstSize.width, dstUV, dstSize.width,
+				 dstSize.width, dstSize.height,
+				 libyuv::FilterMode::kFilterBilinear);
+}
+
+} /* namespace */
+
+/*
+ * The Prefetcher loads frames ahead of time in a background thread, in a
+ * bounded window of slots scaled to the configured size. Frame positions are
+ * assigned to the slots in a round-robin fashion, and a slot is reloaded with
+ * the frame one window ahead once the generator releases it. The generator
+ * waits for the frame it needs when the prefetcher falls behind, so frames are
+ * never skipped or repeated, including when looping over the images.
+ */
+class ImageFrameGenerator::Prefetcher : public Thread
+{
+public:
+	Prefetcher(const ImageFrameGenerator *generator, unsigned int count);
+	~Prefetcher();
+
+	const ImageFrameData *acquire(unsigned int position);
+	void release(unsigned int position);
+
+protected:
+	void run() override;
+
+private:
+	struct Slot {
+		ImageFrameData frame;
+		unsigned int position;
+		bool ready;
+		int status;
+	};
+
+	const ImageFrameGenerator *generator_;
+	std::vector<Slot> slots_;
+
+	Mutex mutex_;
+	ConditionVariable cv_;
+	std::queue<Slot *> pending_ LIBCAMERA_TSA_GUARDED_BY(mutex_);
+	bool stopping_ LIBCAMERA_TSA_GUARDED_BY(mutex_);
+};
+
+ImageFrameGenerator::Prefetcher::Prefetcher(const ImageFrameGenerator *generator,
+					    unsigned int count)
+	: Thread("VirtualPrefetch"), generator_(generator), slots_(count),
+	  stopping_(false)
+{
+	const Size &size = generator_->size_;
+
+	{
+		MutexLocker locker(mutex_);
+
+		for (auto [i, slot] : utils::enumerate(slots_)) {
+			slot.frame.Y = std::make_unique<uint8_t[]>(size.width * size.height);
+			slot.frame.UV = std::make_unique<uint8_t[]>(size.width * size.height / 2);
+			slot.frame.size = size;
+			slot.position = i;
+			slot.ready = false;
+			slot.status = 0;
+
+			pending_.push(&slot);
+		}
+	}
+
+	start();
+}
+
+ImageFrameGenerator::Prefetcher::~Prefetcher()
+{
+	{
+		MutexLocker locker(mutex_);
+		stopping_ = true;
+	}
+
+	cv_.notify_all();
+	wait();
+}
+
+/*
+ * Wait for the frame at \a position to be loaded. The frame stays valid until
+ * it is released.
+ */
+const ImageFrameGenerator::ImageFrameData *
+ImageFrameGenerator::Prefetcher::acquire(unsigned int position)
+{
+	Slot &slot = slots_[position % slots_.size()];
+
+	MutexLocker locker(mutex_);
+	cv_.wait(locker, [&]() LIBCAMERA_TSA_REQUIRES(mutex_) {
+		return slot.ready && slot.position == position;
+	});
+
+	if (slot.status)
+		return nullptr;
+
+	return &slot.frame;
+}
+
+/* Release the frame at \a position, and load the frame one window ahead. */
+void ImageFrameGenerator::Prefetcher::release(unsigned int position)
+{
+	Slot &slot = slots_[position % slots_.size()];
+
+	{
+		MutexLocker locker(mutex_);
+
+		slot.ready = false;
+		slot.position = position + slots_.size();
+		pending_.push(&slot);
+	}
+
+	cv_.notify_all();
+}
+
+void ImageFrameGenerator::Prefetcher::run()
+{
+	MutexLocker locker(mutex_);
+
+	while (true) {
+		cv_.wait(locker, [&]() LIBCAMERA_TSA_REQUIRES(mutex_) {
+			return stopping_ || !pending_.empty();
+		});
+
+		if (stopping_)
+			break;
+
+		Slot *slot = pending_.front();
+		pending_.pop();
+
+		unsigned int index = slot->position % generator_->frameCount();
+
+		locker.unlock();
+		int ret = generator_->loadFrame(index, slot->frame.Y.get(),
+						slot->frame.UV.get());
+		locker.lock();
+
+		slot->status = ret;
+		slot->ready = true;
+		cv_.notify_all();
+	}
+}
+
+ImageFrameGenerator::ImageFrameGenerator()
+	: imageFrames_(nullptr), parameter_(0)
+{
+}
+
+ImageFrameGenerator::~ImageFrameGenerator() = default;
+
 /*
  * Factory function to create an ImageFrameGenerator object.
- * Read the images and convert them to buffers in NV12 format.
- * Store the pointers to the buffers to a list (imageFrameDatas)
+ *
+ * Raw sequence files are mapped in memory and split in frames. Images are
+ * decoded to NV12 and stored in a list (imageFrameDatas), unless they are
+ * prefetched, in which case they are decoded when generating frames.
  */
 std::unique_ptr<ImageFrameGenerator>
 ImageFrameGenerator::create(ImageFrames &imageFrames)
@@ -35,48 +209,56 @@ ImageFrameGenerator::create(ImageFrames &imageFrames)
 		std::make_unique<ImageFrameGenerator>();
 	imageFrameGenerator->imageFrames_ = &imageFrames;
 
-	/*
-	 * For each file in the directory, load the image,
-	 * convert it to NV12, and store the pointer.
-	 */
-	for (const auto &path : imageFrames.files) {
-		File file(path);
-		if (!file.open(File::OpenModeFlag::ReadOnly)) {
-			LOG(Virtual, Error) << "Failed to open image file " << file.fileName()
-					    << ": " << strerror(file.error());
-			return nullptr;
+	if (imageFrames.format.isValid()) {
+		const PixelFormatInfo &info = PixelFormatInfo::info(imageFrames.format);
+		size_t frameSize = info.frameSize(imageFrames.size, 1);
+
+		for (const auto &path : imageFrames.files) {
+			auto file = std::make_unique<File>(path);
+			if (!file->open(File::OpenModeFlag::ReadOnly)) {
+				LOG(Virtual, Error) << "Failed to open file " << file->fileName()
+						    << ": " << strerror(file->error());
+				return nullptr;
+			}
+
+			Span<uint8_t> data = file->map();
+			if (data.empty()) {
+				LOG(Virtual, Error) << "Failed to map file " << file->fileName()
+						    << ": " << strerror(file->error());
+				return nullptr;
+			}
+
+			/* Ignore trailing data that doesn't form a complete frame. */
+			for (size_t offset = 0; offset + frameSize <= data.size(); offset += frameSize)
+				imageFrameGenerator->rawFrames_.emplace_back(data.data() + offset,
+									     frameSize);
+
+			imageFrameGenerator->files_.push_back(std::move(file));
 		}
 
-		/* Read the image file to data */
-		auto fileSize = file.size();
-		auto buffer = std::make_unique<uint8_t[]>(fileSize);
-		if (file.read({ buffer.get(), static_cast<size_t>(fileSize) }) != fileSize) {
-			LOG(Virtual, Error) << "Failed to read file " << file.fileName()
-					    << ": " << strerror(file.error());
+		if (imageFrameGenerator->rawFrames_.empty()) {
+			LOG(Virtual, Error) << "No complete " << imageFrames.format
+					    << " frame of size " << imageFrames.size
+					    << " in the sequence files";
 			return nullptr;
 		}
 
-		/* Get the width and height of the image */
-		int width, height;
-		if (libyuv::MJPGSize(buffer.get(), fileSize, &width, &height)) {
-			LOG(Virtual, Error) << "Failed to get the size of the image file: "
-					    << file.fileName();
+		return imageFrameGenerator;
+	}
+
+	if (imageFrames.prefetch)
+		return imageFrameGenerator;
+
+	/*
+	 * For each file in the directory, load the image,
+	 * convert it to NV12, and store the pointer.
+	 */
+	for (const auto &path : imageFrames.files) {
+		ImageFrameData data;
+		if (decodeImage(path, &data))
 			return nullptr;
-		}
 
-		std::unique_ptr<uint8_t[]> dstY =
-			std::make_unique<uint8_t[]>(width * height);
-		std::unique_ptr<uint8_t[]> dstUV =
-			std::make_unique<uint8_t[]>(width * height / 2);
-		int ret = libyuv::MJPGToNV12(buffer.get(), fileSize,
-					     dstY.get(), width, dstUV.get(),
-					     width, width, height, width, height);
-		if (ret != 0)
-			LOG(Virtual, Error) << "MJPGToNV12() failed with " << ret;
-
-		imageFrameGenerator->imageFrameDatas_.emplace_back(
-			ImageFrameData{ std::move(dstY), std::move(dstUV),
-					Size(width, height) });
+		imageFrameGenerator->imageFrameDatas_.push_back(std::move(data));
 	}
 
 	ASSERT(!imageFrameGenerator->imageFrameDatas_.empty());
@@ -84,18 +266,25 @@ ImageFrameGenerator::create(ImageFrames &imageFrames)
 	return imageFrameGenerator;
 }
 
-/*
- * \var ImageFrameGenerator::frameRepeat
- * \brief Number of frames to repeat before proceeding to the next frame
- */
-
 /* Scale the buffers for image frames. */
-void ImageFrameGenerator::configure(const Size &size)
+int ImageFrameGenerator::configure(const PixelFormat &format, const Size &size)
 {
+	if (format != formats::NV12) {
+		LOG(Virtual, Error)
+			<< "Image frames can't be generated in " << format;
+		return -EINVAL;
+	}
+
 	/* Reset the source images to prevent multiple configuration calls */
+	prefetcher_.reset();
 	scaledFrameDatas_.clear();
-	frameIndex_ = 0;
 	parameter_ = 0;
+	size_ = size;
+
+	if (imageFrames_->prefetch) {
+		prefetcher_ = std::make_unique<Prefetcher>(this, imageFrames_->prefetch);
+		return 0;
+	}
 
 	for (unsigned int i = 0; i < imageFrameDatas_.size(); i++) {
 		/* Scale the imageFrameDatas_ to scaledY and scaledUV */
@@ -121,35 +310,147 @@ void ImageFrameGenerator::configure(const Size &size)
 		scaledFrameDatas_.emplace_back(
 			ImageFrameData{ std::move(scaledY), std::move(scaledUV), size });
 	}
+
+	return 0;
 }
 
 int ImageFrameGenerator::generateFrame(const Size &size, const FrameBuffer *buffer)
 {
-	ASSERT(!scaledFrameDatas_.empty());
-
 	MappedFrameBuffer mappedFrameBuffer(buffer, MappedFrameBuffer::MapFlag::Write);
 
 	const auto &planes = mappedFrameBuffer.planes();
 
-	/* Loop only around the number of images available */
-	frameIndex_ %= imageFrameDatas_.size();
+	/*
+	 * Proceed to the next image every imageFrames_->repeat frames, and
+	 * loop around the images available.
+	 */
+	unsigned int position = parameter_ / imageFrames_->repeat;
+	parameter_++;
+	bool lastRepeat = parameter_ % imageFrames_->repeat == 0;
+
+	if (prefetcher_) {
+		const ImageFrameData *frame = prefetcher_->acquire(position);
+		int ret = frame ? libyuv::NV12Copy(frame->Y.get(), size.width,
+						   frame->UV.get(), size.width,
+						   planes[0].data(), size.width,
+						   planes[1].data(), size.width,
+						   size.width, size.height)
+				: -EIO;
+
+		if (lastRepeat)
+			prefetcher_->release(position);
+
+		return ret;
+	}
+
+	/* Frames of raw sequence files are scaled from the mapped files. */
+	if (scaledFrameDatas_.empty())
+		return loadFrame(position % frameCount(), planes[0].data(),
+				 planes[1].data());
+
+	const ImageFrameData &frame = scaledFrameDatas_[position % scaledFrameDatas_.size()];
 
 	/* Write the scaledY and scaledUV to the mapped frame buffer */
-	libyuv::NV12Copy(scaledFrameDatas_[frameIndex_].Y.get(), size.width,
-			 scaledFrameDatas_[frameIndex_].UV.get(), size.width,
+	libyuv::NV12Copy(frame.Y.get(), size.width,
+			 frame.UV.get(), size.width,
 			 planes[0].data(), size.width,
 			 planes[1].data(), size.width,
 			 size.width, size.height);
 
-	/* Proceed to the next image every 4 frames */
-	/* \todo Consider setting the frameRepeat in the config file  */
-	parameter_++;
-	if (parameter_ % frameRepeat == 0)
-		frameIndex_++;
+	return 0;
+}
+
+unsigned int ImageFrameGenerator::frameCount() const
+{
+	return rawFrames_.empty() ? imageFrames_->files.size() : rawFrames_.size();
+}
+
+/* Decode the JPEG image at \a path to NV12. */
+int ImageFrameGenerator::decodeImage(const std::filesystem::path &path,
+				     ImageFrameData *data)
+{
+	File file(path);
+	if (!file.open(File::OpenModeFlag::ReadOnly)) {
+		LOG(Virtual, Error) << "Failed to open image file " << file.fileName()
+				    << ": " << strerror(file.error());
+		return -ENOENT;
+	}
+
+	/* Read the image file to data */
+	auto fileSize = file.size();
+	auto buffer = std::make_unique<uint8_t[]>(fileSize);
+	if (file.read({ buffer.get(), static_cast<size_t>(fileSize) }) != fileSize) {
+		LOG(Virtual, Error) << "Failed to read file " << file.fileName()
+				    << ": " << strerror(file.error());
+		return -EIO;
+	}
+
+	/* Get the width and height of the image */
+	int width, height;
+	if (libyuv::MJPGSize(buffer.get(), fileSize, &width, &height)) {
+		LOG(Virtual, Error) << "Failed to get the size of the image file: "
+				    << file.fileName();
+		return -EINVAL;
+	}
+
+	data->Y = std::make_unique<uint8_t[]>(width * height);
+	data->UV = std::make_unique<uint8_t[]>(width * height / 2);
+	data->size = Size(width, height);
+
+	int ret = libyuv::MJPGToNV12(buffer.get(), fileSize,
+				     data->Y.get(), width, data->UV.get(),
+				     width, width, height, width, height);
+	if (ret != 0) {
+		LOG(Virtual, Error) << "MJPGToNV12() failed with " << ret;
+		return -EINVAL;
+	}
 
 	return 0;
 }
 
+/*
+ * Load the frame at \a index, scaled to the configured size, in the \a dstY
+ * and \a dstUV NV12 planes. This is called from the prefetcher thread.
+ */
+int ImageFrameGenerator::loadFrame(unsigned int index, uint8_t *dstY,
+				   uint8_t *dstUV) const
+{
+	int ret;
+
+	if (!rawFrames_.empty()) {
+		const Size &srcSize = imageFrames_->size;
+		const uint8_t *srcY = rawFrames_[index].data();
+		const uint8_t *srcUV = srcY + srcSize.width * srcSize.height;
+		std::unique_ptr<uint8_t[]> uv;
+
+		/* Interleave the chroma planes of YUV420 frames. */
+		if (imageFrames_->format == formats::YUV420) {
+			unsigned int width = (srcSize.width + 1) / 2;
+			unsigned int height = (srcSize.height + 1) / 2;
+
+			uv = std::make_unique<uint8_t[]>(width * height * 2);
+			libyuv::MergeUVPlane(srcUV, width, srcUV + width * height, width,
+					     uv.get(), width * 2, width, height);
+			srcUV = uv.get();
+		}
+
+		ret = scaleFrame(srcY, srcUV, srcSize, dstY, dstUV, size_);
+	} else {
+		ImageFrameData image;
+		ret = decodeImage(imageFrames_->files[index], &image);
+		if (ret)
+			return ret;
+
+		ret = scaleFrame(image.Y.get(), image.UV.get(), image.size,
+				 dstY, dstUV, size_);
+	}
+
+	if (ret)
+		LOG(Virtual, Error) << "Failed to load frame " << index << ": " << ret;
+
+	return ret;
+}
+
 /*
  * \var ImageFrameGenerator::imageFrameDatas_
  * \brief List of pointers to the not scaled image buffers
@@ -167,7 +468,17 @@ int ImageFrameGenerator::generateFrame(const Size &size, const FrameBuffer *buff
 
 /*
  * \var ImageFrameGenerator::parameter_
- * \brief Speed parameter. Change to the next image every parameter_ frames
+ * \brief Number of frames generated since the generator was configured
+ */
+
+/*
+ * \var ImageFrameGenerator::rawFrames_
+ * \brief List of the frames of the raw sequence files, mapped in memory
+ */
+
+/*
+ * \var ImageFrameGenerator::prefetcher_
+ * \brief Prefetcher of the frames, when loading them ahead of time
  */
 
 } /* namespace libcamera */
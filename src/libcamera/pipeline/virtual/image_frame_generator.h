@@ -13,6 +13,12 @@
 #include <sys/types.h>
 #include <vector>
 
+#include <libcamera/base/file.h>
+#include <libcamera/base/span.h>
+
+#include <libcamera/geometry.h>
+#include <libcamera/pixel_format.h>
+
 #include "frame_generator.h"
 
 namespace libcamera {
@@ -20,6 +26,13 @@ namespace libcamera {
 /* Frame configuration provided by the config file */
 struct ImageFrames {
 	std::vector<std::filesystem::path> files;
+	/* Format and size of raw sequence files, invalid for JPEG images */
+	PixelFormat format;
+	Size size;
+	/* Number of frames generated from each image */
+	unsigned int repeat = 4;
+	/* Number of frames loaded ahead of time, or 0 to load them all up front */
+	unsigned int prefetch = 0;
 };
 
 class ImageFrameGenerator : public FrameGenerator
@@ -27,8 +40,11 @@ class ImageFrameGenerator : public FrameGenerator
 public:
 	static std::unique_ptr<ImageFrameGenerator> create(ImageFrames &imageFrames);
 
+	ImageFrameGenerator();
+	~ImageFrameGenerator();
+
 private:
-	static constexpr unsigned int frameRepeat = 4;
+	class Prefetcher;
 
 	struct ImageFrameData {
 		std::unique_ptr<uint8_t[]> Y;
@@ -36,14 +52,23 @@ private:
 		Size size;
 	};
 
-	void configure(const Size &size) override;
+	int configure(const PixelFormat &format, const Size &size) override;
 	int generateFrame(const Size &size, const FrameBuffer *buffer) override;
 
+	unsigned int frameCount() const;
+	static int decodeImage(const std::filesystem::path &path, ImageFrameData *data);
+	int loadFrame(unsigned int index, uint8_t *dstY, uint8_t *dstUV) const;
+
 	std::vector<ImageFrameData> imageFrameDatas_;
 	std::vector<ImageFrameData> scaledFrameDatas_;
 	ImageFrames *imageFrames_;
-	unsigned int frameIndex_;
 	unsigned int parameter_;
+	Size size_;
+
+	std::vector<std::unique_ptr<File>> files_;
+	std::vector<Span<const uint8_t>> rawFrames_;
+
+	std::unique_ptr<Prefetcher> prefetcher_;
 };
 
 } /* namespace libcamera */
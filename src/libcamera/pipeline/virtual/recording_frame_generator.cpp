@@ -0,0 +1,172 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Derived class of FrameGenerator for replaying recorded frames
+ */
+
+#include "recording_frame_generator.h"
+
+#include <algorithm>
+#include <array>
+#include <errno.h>
+#include <map>
+#include <string.h>
+
+#include <libcamera/base/log.h>
+
+#include <libcamera/framebuffer.h>
+
+#include "libcamera/internal/formats.h"
+#include "libcamera/internal/mapped_framebuffer.h"
+
+namespace libcamera {
+
+LOG_DECLARE_CATEGORY(Virtual)
+
+/*
+ * The RecordingFrameGenerator replays the frames of a recording, captured
+ * from a real camera along with their metadata and request controls. The
+ * files containing the frames are mapped in memory when the generator is
+ * created, and frames are copied from the mappings to the buffers without any
+ * conversion.
+ *
+ * Frames are addressed by their replay position, counted from the start of
+ * the replay. The recording is looped over, the sequence numbers and the
+ * intervals between frames are identical on every loop.
+ */
+
+std::unique_ptr<RecordingFrameGenerator>
+RecordingFrameGenerator::create(const RecordingFrames &recording)
+{
+	std::unique_ptr<RecordingFrameGenerator> generator =
+		std::make_unique<RecordingFrameGenerator>(&recording);
+
+	const PixelFormatInfo &info = PixelFormatInfo::info(recording.format);
+	size_t frameSize = info.frameSize(recording.size,
+					  std::array<unsigned int, 3>{ recording.stride });
+
+	/* Map each file once, frames may be stored in a single file. */
+	std::map<std::filesystem::path, Span<const uint8_t>> mappings;
+
+	for (const RecordedFrame &frame : recording.frames) {
+		auto it = mappings.find(frame.file);
+		if (it == mappings.end()) {
+			auto file = std::make_unique<File>(frame.file);
+			if (!file->open(File::OpenModeFlag::ReadOnly)) {
+				LOG(Virtual, Error) << "Failed to open file " << file->fileName()
+						    << ": " << strerror(-file->error());
+				return nullptr;
+			}
+
+			Span<uint8_t> data = file->map();
+			if (data.empty()) {
+				LOG(Virtual, Error) << "Failed to map file " << file->fileName()
+						    << ": " << strerror(-file->error());
+				return nullptr;
+			}
+
+			/* The mapping outlives the file descriptor. */
+			file->close();
+
+			it = mappings.emplace(frame.file, data).first;
+			generator->files_.push_back(std::move(file));
+		}
+
+		Span<const uint8_t> data = it->second;
+		if (frame.offset + frameSize > data.size()) {
+			LOG(Virtual, Error)
+				<< "Frame " << frame.sequence << " exceeds the size of "
+				<< frame.file;
+			return nullptr;
+		}
+
+		generator->frames_.push_back(data.subspan(frame.offset, frameSize));
+	}
+
+	return generator;
+}
+
+RecordingFrameGenerator::RecordingFrameGenerator(const RecordingFrames *recording)
+	: recording_(recording), position_(0), stride_(0)
+{
+}
+
+int RecordingFrameGenerator::configure(const PixelFormat &format, const Size &size)
+{
+	if (format != recording_->format || size != recording_->size) {
+		LOG(Virtual, Error)
+			<< "Recorded frames can't be replayed in " << format
+			<< "/" << size;
+		return -EINVAL;
+	}
+
+	stride_ = PixelFormatInfo::info(format).stride(size.width, 0, 1);
+	position_ = 0;
+
+	return 0;
+}
+
+/* Copy the frame at the current position, line by line to handle strides. */
+int RecordingFrameGenerator::generateFrame(const Size &size, const FrameBuffer *buffer)
+{
+	MappedFrameBuffer mappedFrameBuffer(buffer, MappedFrameBuffer::MapFlag::Write);
+	if (!mappedFrameBuffer.isValid())
+		return -EINVAL;
+
+	Span<uint8_t> dst = mappedFrameBuffer.planes()[0];
+	Span<const uint8_t> src = frames_[position_ % frames_.size()];
+	unsigned int length = std::min(stride_, recording_->stride);
+
+	if (dst.size() < static_cast<size_t>(stride_) * size.height)
+		return -EINVAL;
+
+	for (unsigned int y = 0; y < size.height; y++)
+		memcpy(&dst[y * stride_], &src[y * recording_->stride], length);
+
+	return 0;
+}
+
+/* Select the frame produced by the next generateFrame() call. */
+void RecordingFrameGenerator::seek(unsigned int position)
+{
+	position_ = position;
+}
+
+const RecordedFrame &RecordingFrameGenerator::frame(unsigned int position) const
+{
+	return recording_->frames[position % recording_->frames.size()];
+}
+
+/*
+ * Compute the sequence number of the frame at \a position, relative to the
+ * first recorded frame. Gaps in the recorded sequence, caused by frames
+ * dropped during the capture, are preserved.
+ */
+uint32_t RecordingFrameGenerator::sequence(unsigned int position) const
+{
+	const std::vector<RecordedFrame> &frames = recording_->frames;
+	unsigned int loop = position / frames.size();
+	uint32_t first = frames.front().sequence;
+	uint32_t length = frames.back().sequence - first + 1;
+
+	return loop * length + frame(position).sequence - first;
+}
+
+/*
+ * Compute the interval between the frame at \a position and the previous one.
+ * The first frame of each loop follows the previous one by the average frame
+ * duration.
+ */
+utils::Duration RecordingFrameGenerator::interval(unsigned int position) const
+{
+	const std::vector<RecordedFrame> &frames = recording_->frames;
+	unsigned int index = position % frames.size();
+
+	if (!index || frames[index].timestamp <= frames[index - 1].timestamp)
+		return recording_->frameDuration;
+
+	return utils::Duration(frames[index].timestamp - frames[index - 1].timestamp);
+}
+
+} /* namespace libcamera */
@@ -0,0 +1,80 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Derived class of FrameGenerator for replaying recorded frames
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include <libcamera/base/file.h>
+#include <libcamera/base/span.h>
+#include <libcamera/base/utils.h>
+
+#include <libcamera/controls.h>
+#include <libcamera/geometry.h>
+#include <libcamera/pixel_format.h>
+
+#include "frame_generator.h"
+
+namespace libcamera {
+
+/* A frame of a recording, as described by the recording index */
+struct RecordedFrame {
+	std::filesystem::path file;
+	size_t offset = 0;
+	uint32_t sequence = 0;
+	uint64_t timestamp = 0;
+	/* Controls of the request that captured the frame */
+	ControlList controls;
+	/* Metadata reported for the frame, except for the SensorTimestamp */
+	ControlList metadata;
+};
+
+/* Recording configuration provided by the config file and recording index */
+struct RecordingFrames {
+	PixelFormat format;
+	Size size;
+	unsigned int stride = 0;
+	std::vector<RecordedFrame> frames;
+	/* Average interval between frames */
+	utils::Duration frameDuration;
+	/* Replay at the recorded timing, or as fast as requests are queued */
+	bool realtime = true;
+	/* Process the recorded frames with the software ISP */
+	bool isp = false;
+};
+
+class RecordingFrameGenerator : public FrameGenerator
+{
+public:
+	static std::unique_ptr<RecordingFrameGenerator> create(const RecordingFrames &recording);
+
+	RecordingFrameGenerator(const RecordingFrames *recording);
+
+	int configure(const PixelFormat &format, const Size &size) override;
+	int generateFrame(const Size &size, const FrameBuffer *buffer) override;
+
+	void seek(unsigned int position);
+
+	const RecordedFrame &frame(unsigned int position) const;
+	uint32_t sequence(unsigned int position) const;
+	utils::Duration interval(unsigned int position) const;
+
+private:
+	const RecordingFrames *recording_;
+
+	std::vector<std::unique_ptr<File>> files_;
+	std::vector<Span<const uint8_t>> frames_;
+
+	unsigned int position_;
+	unsigned int stride_;
+};
+
+} /* namespace libcamera */
@@ -7,29 +7,49 @@
 
 #include "test_pattern_generator.h"
 
+#include <algorithm>
+#include <errno.h>
 #include <string.h>
 
 #include <libcamera/base/log.h>
 
+#include <libcamera/formats.h>
+
+#include "libcamera/internal/formats.h"
 #include "libcamera/internal/mapped_framebuffer.h"
 
 #include <libyuv/convert_from_argb.h>
+#include <libyuv/planar_functions.h>
 
 namespace {
 
-template<size_t SampleSize>
-void rotateLeft1Column(const libcamera::Size &size, uint8_t *image)
+/* Pack a line of 10-bit pixels in the MIPI CSI-2 format, 4 pixels in 5 bytes */
+void packCSI2P10(const uint16_t *src, uint8_t *dst, unsigned int width)
 {
-	if (size.width < 2)
-		return;
+	for (unsigned int x = 0; x < width; x += 4, dst += 5) {
+		uint8_t lsbs = 0;
+
+		for (unsigned int i = 0; i < 4; i++) {
+			uint16_t value = x + i < width ? src[x + i] : 0;
+
+			dst[i] = value >> 2;
+			lsbs |= (value & 0x3) << (i * 2);
+		}
 
-	const size_t stride = size.width * SampleSize;
-	uint8_t first[SampleSize];
+		dst[4] = lsbs;
+	}
+}
+
+/* Pack a line of 12-bit pixels in the MIPI CSI-2 format, 2 pixels in 3 bytes */
+void packCSI2P12(const uint16_t *src, uint8_t *dst, unsigned int width)
+{
+	for (unsigned int x = 0; x < width; x += 2, dst += 3) {
+		uint16_t value0 = src[x];
+		uint16_t value1 = x + 1 < width ? src[x + 1] : 0;
 
-	for (size_t i = 0; i < size.height; i++, image += stride) {
-		memcpy(first, &image[0], SampleSize);
-		memmove(&image[0], &image[SampleSize], stride - SampleSize);
-		memcpy(&image[stride - SampleSize], first, SampleSize);
+		dst[0] = value0 >> 4;
+		dst[1] = value1 >> 4;
+		dst[2] = (value0 & 0xf) | ((value1 & 0xf) << 4);
 	}
 }
 
@@ -41,6 +61,61 @@ LOG_DECLARE_CATEGORY(Virtual)
 
 static const unsigned int kARGBSize = 4;
 
+int TestPatternGenerator::configure(const PixelFormat &format, const Size &size)
+{
+	if (!isSupported(format)) {
+		LOG(Virtual, Error)
+			<< "Test patterns can't be generated in " << format;
+		return -EINVAL;
+	}
+
+	if (format == formats::NV12) {
+		bayer_ = {};
+	} else {
+		bayer_ = BayerFormat::fromPixelFormat(format);
+		stride_ = PixelFormatInfo::info(format).stride(size.width, 0, 1);
+		line_.resize(size.width);
+	}
+
+	offset_ = 0;
+	generateTemplate(size);
+
+	if (!bayer_.isValid()) {
+		int ret = generateNV12(size);
+		if (ret)
+			return ret;
+
+		/* The NV12 frames are copied from the renderings only. */
+		template_.reset();
+	}
+
+	return 0;
+}
+
+bool TestPatternGenerator::isSupported(const PixelFormat &format)
+{
+	if (format == formats::NV12)
+		return true;
+
+	const BayerFormat bayer = BayerFormat::fromPixelFormat(format);
+	if (!bayer.isValid())
+		return false;
+
+	switch (bayer.packing) {
+	case BayerFormat::Packing::None:
+		return bayer.bitDepth >= 8 && bayer.bitDepth <= 16;
+	case BayerFormat::Packing::CSI2:
+		return bayer.bitDepth == 10 || bayer.bitDepth == 12;
+	default:
+		return false;
+	}
+}
+
+void TestPatternGenerator::setExposureScale(double scale)
+{
+	exposureScale_ = std::clamp(scale, 0.0, 255.0) * 256;
+}
+
 int TestPatternGenerator::generateFrame(const Size &size,
 					const FrameBuffer *buffer)
 {
@@ -49,20 +124,138 @@ int TestPatternGenerator::generateFrame(const Size &size,
 
 	const auto &planes = mappedFrameBuffer.planes();
 
-	rotateLeft1Column<kARGBSize>(size, template_.get());
+	offset_ = (offset_ + 1) % size.width;
+
+	if (bayer_.isValid()) {
+		generateBayer(size, planes[0].data());
+		return 0;
+	}
+
+	/*
+	 * Copy the window of the NV12 rendering that starts at the current
+	 * offset. Chroma samples are shared by pairs of columns, so odd offsets
+	 * copy from the rendering shifted by one column.
+	 */
+	const unsigned int phase = offset_ & 1;
+	const unsigned int start = offset_ - phase;
+	const unsigned int stride = size.width * 2;
+	const uint8_t *y = nv12_[phase].data();
+	const uint8_t *uv = y + stride * size.height;
 
-	/* Convert the template_ to the frame buffer */
-	int ret = libyuv::ARGBToNV12(template_.get(), size.width * kARGBSize,
-				     planes[0].data(), size.width,
-				     planes[1].data(), size.width,
-				     size.width, size.height);
+	int ret = libyuv::NV12Copy(y + start, stride, uv + start, stride,
+				   planes[0].data(), size.width,
+				   planes[1].data(), size.width,
+				   size.width, size.height);
 	if (ret != 0)
-		LOG(Virtual, Error) << "ARGBToNV12() failed with " << ret;
+		LOG(Virtual, Error) << "NV12Copy() failed with " << ret;
 
 	return ret;
 }
 
-void ColorBarsGenerator::configure(const Size &size)
+/*
+ * Render the template_ in NV12 once at configuration time, so that frames
+ * only need to be copied. The pattern scrolls horizontally, render it twice
+ * side by side to make every window of one frame width contiguous.
+ */
+int TestPatternGenerator::generateNV12(const Size &size)
+{
+	const unsigned int width = size.width * 2;
+	const size_t rowSize = size.width * kARGBSize;
+	std::vector<uint8_t> argb(rowSize * 2 * size.height);
+
+	for (unsigned int phase = 0; phase < nv12_.size(); phase++) {
+		const size_t shift = std::min(phase, size.width) * kARGBSize;
+
+		for (unsigned int y = 0; y < size.height; y++) {
+			const uint8_t *src = template_.get() + y * rowSize;
+			uint8_t *dst = argb.data() + y * rowSize * 2;
+
+			memcpy(dst, src + shift, rowSize - shift);
+			memcpy(dst + rowSize - shift, src, rowSize);
+			memcpy(dst + rowSize * 2 - shift, src, shift);
+		}
+
+		std::vector<uint8_t> &nv12 = nv12_[phase];
+		nv12.resize(width * size.height + width * ((size.height + 1) / 2));
+
+		int ret = libyuv::ARGBToNV12(argb.data(), width * kARGBSize,
+					     nv12.data(), width,
+					     nv12.data() + width * size.height, width,
+					     width, size.height);
+		if (ret != 0) {
+			LOG(Virtual, Error) << "ARGBToNV12() failed with " << ret;
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Sample the template_ through the color filter array, scale the samples to
+ * the bit depth and exposure, and pack them in the output buffer.
+ */
+void TestPatternGenerator::generateBayer(const Size &size, uint8_t *data)
+{
+	/*
+	 * Offsets of the CFA components in the BGRA template pixels, indexed
+	 * by BayerFormat::Order.
+	 */
+	constexpr unsigned int kBlue = 0;
+	constexpr unsigned int kGreen = 1;
+	constexpr unsigned int kRed = 2;
+	constexpr unsigned int kComponents[][4] = {
+		{ kBlue, kGreen, kGreen, kRed }, /* BGGR */
+		{ kGreen, kBlue, kRed, kGreen }, /* GBRG */
+		{ kGreen, kRed, kBlue, kGreen }, /* GRBG */
+		{ kRed, kGreen, kGreen, kBlue }, /* RGGB */
+		{ kGreen, kGreen, kGreen, kGreen }, /* MONO */
+	};
+
+	const unsigned int *components = kComponents[bayer_.order];
+	const uint32_t shift = bayer_.bitDepth - 8;
+	const uint32_t maxValue = (1 << bayer_.bitDepth) - 1;
+
+	for (unsigned int y = 0; y < size.height; y++) {
+		const uint8_t *src = template_.get() + y * size.width * kARGBSize;
+		const unsigned int *cfa = &components[(y & 1) * 2];
+		uint8_t *dst = data + y * stride_;
+
+		for (unsigned int x = 0; x < size.width; x++) {
+			/* Scroll the pattern by sampling from the current offset. */
+			unsigned int column = x + offset_;
+			if (column >= size.width)
+				column -= size.width;
+
+			uint32_t value = src[column * kARGBSize + cfa[x & 1]] << shift;
+			line_[x] = std::min((value * exposureScale_) >> 8, maxValue);
+		}
+
+		switch (bayer_.packing) {
+		case BayerFormat::Packing::CSI2:
+			if (bayer_.bitDepth == 10)
+				packCSI2P10(line_.data(), dst, size.width);
+			else
+				packCSI2P12(line_.data(), dst, size.width);
+			break;
+
+		default:
+			if (bayer_.bitDepth == 8) {
+				for (unsigned int x = 0; x < size.width; x++)
+					dst[x] = line_[x];
+			} else {
+				/* Unpacked samples are stored as little-endian 16-bit values. */
+				for (unsigned int x = 0; x < size.width; x++) {
+					dst[x * 2] = line_[x] & 0xff;
+					dst[x * 2 + 1] = line_[x] >> 8;
+				}
+			}
+			break;
+		}
+	}
+}
+
+void ColorBarsGenerator::generateTemplate(const Size &size)
 {
 	constexpr uint8_t kColorBar[8][3] = {
 		/*  R,    G,    B */
@@ -95,7 +288,7 @@ void ColorBarsGenerator::configure(const Size &size)
 	}
 }
 
-void DiagonalLinesGenerator::configure(const Size &size)
+void DiagonalLinesGenerator::generateTemplate(const Size &size)
 {
 	constexpr uint8_t kColorBar[2][3] = {
 		/*  R,    G,    B */
@@ -7,10 +7,16 @@
 
 #pragma once
 
+#include <array>
 #include <memory>
+#include <stdint.h>
+#include <vector>
 
 #include <libcamera/framebuffer.h>
 #include <libcamera/geometry.h>
+#include <libcamera/pixel_format.h>
+
+#include "libcamera/internal/bayer_format.h"
 
 #include "frame_generator.h"
 
@@ -24,25 +30,52 @@ enum class TestPattern : char {
 class TestPatternGenerator : public FrameGenerator
 {
 public:
+	int configure(const PixelFormat &format, const Size &size) override;
 	int generateFrame(const Size &size, const FrameBuffer *buffer) override;
 
+	static bool isSupported(const PixelFormat &format);
+
+	/* Scale the Bayer pixel values to emulate the sensor exposure and gain */
+	void setExposureScale(double scale) override;
+
 protected:
+	/* Generate a template buffer of the test pattern. */
+	virtual void generateTemplate(const Size &size) = 0;
+
 	/* Buffer of test pattern template */
 	std::unique_ptr<uint8_t[]> template_;
+
+private:
+	int generateNV12(const Size &size);
+	void generateBayer(const Size &size, uint8_t *data);
+
+	/* The Bayer format when generating raw frames, invalid otherwise */
+	BayerFormat bayer_;
+	unsigned int stride_ = 0;
+	/* The exposure scale in Q8.8 fixed point format */
+	uint32_t exposureScale_ = 1 << 8;
+
+	std::vector<uint16_t> line_;
+
+	/* Horizontal offset of the pattern, scrolled by one column per frame */
+	unsigned int offset_ = 0;
+	/*
+	 * NV12 renderings of the template repeated twice horizontally, for
+	 * even and odd offsets.
+	 */
+	std::array<std::vector<uint8_t>, 2> nv12_;
 };
 
 class ColorBarsGenerator : public TestPatternGenerator
 {
-public:
-	/* Generate a template buffer of the color bar test pattern. */
-	void configure(const Size &size) override;
+protected:
+	void generateTemplate(const Size &size) override;
 };
 
 class DiagonalLinesGenerator : public TestPatternGenerator
 {
-public:
-	/* Generate a template buffer of the diagonal lines test pattern. */
-	void configure(const Size &size) override;
+protected:
+	void generateTemplate(const Size &size) override;
 };
 
 } /* namespace libcamera */
@@ -13,6 +13,7 @@
 #include <errno.h>
 #include <map>
 #include <memory>
+#include <optional>
 #include <ostream>
 #include <set>
 #include <stdint.h>
@@ -21,6 +22,8 @@
 #include <utility>
 #include <vector>
 
+#include <linux/v4l2-controls.h>
+
 #include <libcamera/base/flags.h>
 #include <libcamera/base/log.h>
 #include <libcamera/base/utils.h>
@@ -31,10 +34,12 @@
 #include <libcamera/pixel_format.h>
 #include <libcamera/property_ids.h>
 
+#include "libcamera/internal/bayer_format.h"
 #include "libcamera/internal/camera.h"
 #include "libcamera/internal/dma_buf_allocator.h"
 #include "libcamera/internal/formats.h"
 #include "libcamera/internal/framebuffer.h"
+#include "libcamera/internal/mapped_framebuffer.h"
 #include "libcamera/internal/pipeline_handler.h"
 #include "libcamera/internal/request.h"
 #include "libcamera/internal/value_node.h"
@@ -43,6 +48,8 @@
 
 namespace libcamera {
 
+using namespace std::literals::chrono_literals;
+
 LOG_DEFINE_CATEGORY(Virtual)
 
 namespace {
@@ -56,6 +63,20 @@ uint64_t currentTimestamp()
 	return nsecs.count();
 }
 
+/* Sensor controls used to emulate the exposure of frames processed by the ISP */
+constexpr std::array<uint32_t, 2> kSensorControls = {
+	V4L2_CID_EXPOSURE,
+	V4L2_CID_ANALOGUE_GAIN,
+};
+
+std::unique_ptr<TestPatternGenerator> createTestPatternGenerator(TestPattern testPattern)
+{
+	if (testPattern == TestPattern::DiagonalLines)
+		return std::make_unique<DiagonalLinesGenerator>();
+	else
+		return std::make_unique<ColorBarsGenerator>();
+}
+
 } /* namespace */
 
 class VirtualCameraConfiguration : public CameraConfiguration
@@ -67,8 +88,15 @@ public:
 
 	Status validate() override;
 
+	/* The size of the raw frames processed by the software ISP */
+	const Size &rawSize() const { return rawSize_; }
+
 private:
+	Status validateRaw(StreamConfiguration &cfg);
+	Status validateProcessed(StreamConfiguration &cfg, const Size *rawSize);
+
 	const VirtualCameraData *data_;
+	Size rawSize_;
 };
 
 class PipelineHandlerVirtual : public PipelineHandler
@@ -100,7 +128,21 @@ private:
 	}
 
 	bool initFrameGenerator(Camera *camera);
+	void metadataReady(Request *request, const ControlList &metadata);
 	void bufferCompleted(FrameBuffer *buffer);
+	void tryCompleteRequest(VirtualCameraData *data, Request *request);
+
+#if HAVE_SOFTISP
+	bool initSoftwareIsp(VirtualCameraData *data);
+	void processIspRequests(VirtualCameraData *data);
+	void ispInputReady(Request *request, FrameBuffer *input);
+	void ispInputDone(VirtualCameraData *data, FrameBuffer *buffer);
+	void ispOutputDone(FrameBuffer *buffer);
+	void ispStatsReady(VirtualCameraData *data, uint32_t frame, uint32_t bufferId);
+	void ispMetadataReady(VirtualCameraData *data, uint32_t frame,
+			      const ControlList &metadata);
+	void setSensorControls(VirtualCameraData *data, const ControlList &sensorControls);
+#endif
 
 	DmaBufAllocator dmaBufAllocator_;
 
@@ -109,7 +151,8 @@ private:
 
 VirtualCameraData::VirtualCameraData(PipelineHandler *pipe,
 				     const std::vector<Resolution> &supportedResolutions)
-	: Camera::Private(pipe), Thread("VirtualCamera")
+	: Camera::Private(pipe), Thread("VirtualCamera"),
+	  ispFrames_([](const IspFrameInfo &info) { return info.metadataProcessed; })
 {
 	config_.resolutions = supportedResolutions;
 	for (const auto &resolution : config_.resolutions) {
@@ -122,41 +165,228 @@ VirtualCameraData::VirtualCameraData(PipelineHandler *pipe,
 	properties_.set(properties::PixelArrayActiveAreas,
 			{ Rectangle(config_.maxResolutionSize) });
 
-	/* \todo Support multiple streams and pass multi_stream_test */
 	streamConfigs_.resize(kMaxStream);
 
 	moveToThread(this);
 }
 
-void VirtualCameraData::processRequest(Request *request)
+/*
+ * Produce the frame for \a request. The \a input buffer, if any, receives the
+ * raw frame processed by the software ISP, with its pixel values scaled by
+ * \a exposureScale.
+ */
+void VirtualCameraData::processRequest(Request *request, FrameBuffer *input,
+				       double exposureScale)
+{
+	PendingRequest pending{ request, input, exposureScale };
+
+	/* Paced requests wait for the next frame produced by the pacer. */
+	if (pacer_) {
+		pendingRequests_.push(pending);
+		return;
+	}
+
+	/* Without pacing, the recorded frames are replayed back to back. */
+	if (recording_) {
+		replayFrame(pending, replayPosition_++, currentTimestamp(),
+			    ControlList(controls::controls));
+		return;
+	}
+
+	fillRequest(pending, std::nullopt, currentTimestamp());
+}
+
+/*
+ * Compute the frame duration for the given FrameDurationLimits. Like a sensor,
+ * the virtual camera runs as fast as the limits allow.
+ */
+utils::Duration VirtualCameraData::frameDuration(Span<const int64_t, 2> limits) const
+{
+	const ControlInfo &info = controlInfo_.at(controls::FrameDurationLimits.id());
+	int64_t duration = std::clamp(limits[0], info.min().get<int64_t>(),
+				      info.max().get<int64_t>());
+
+	return duration * 1us;
+}
+
+bool VirtualCameraData::isRaw(const PixelFormat &format) const
+{
+	return config_.raw && format == config_.raw->format;
+}
+
+bool VirtualCameraData::hasIsp() const
+{
+#if HAVE_SOFTISP
+	return !!swIsp_;
+#else
+	return false;
+#endif
+}
+
+void VirtualCameraData::run()
+{
+	if (pacer_) {
+		pacer_->frameCompleted.connect(this, &VirtualCameraData::frameCompleted);
+		pacer_->start(startFrameDuration_);
+	}
+
+	exec();
+
+	if (pacer_) {
+		pacer_->stop();
+		pacer_->frameCompleted.disconnect(this);
+	}
+
+	/* The pipeline handler cancels the requests left behind. */
+	pendingRequests_ = {};
+}
+
+void VirtualCameraData::frameCompleted(const FramePacer::Frame &frame)
 {
+	/*
+	 * Follow the recorded frame intervals, frames produced without a
+	 * request are skipped in the recording.
+	 */
+	if (recording_)
+		pacer_->setFrameDuration(recording_->interval(frame.sequence + 1));
+
+	if (frame.dropped) {
+		LOG(Virtual, Debug) << "Frame " << frame.sequence << " dropped";
+		return;
+	}
+
+	/* Frames produced without a request are lost, as with a real sensor. */
+	if (pendingRequests_.empty())
+		return;
+
+	PendingRequest pending = pendingRequests_.front();
+	pendingRequests_.pop();
+
+	Request *request = pending.request;
+
+	ControlList metadata(controls::controls);
+	metadata.set(controls::SensorTimestamp, static_cast<int64_t>(frame.timestamp));
+	metadata.set(controls::FrameDuration,
+		     static_cast<int64_t>(frame.duration.get<std::micro>()));
+
+	if (recording_) {
+		replayFrame(pending, frame.sequence, frame.timestamp, std::move(metadata));
+		return;
+	}
+
+	const auto &limits = request->controls().get(controls::FrameDurationLimits);
+	if (limits) {
+		uint32_t sequence = pacer_->setFrameDuration(frameDuration(*limits));
+		metadata.set(controls::SensorControlsSequence, sequence);
+	}
+
+	metadataReady.emit(request, metadata);
+
+	fillRequest(pending, frame.sequence, frame.timestamp);
+}
+
+/*
+ * Produce the recorded frame at \a position, and report its recorded metadata
+ * along with the replay \a metadata.
+ */
+void VirtualCameraData::replayFrame(const PendingRequest &pending, unsigned int position,
+				    uint64_t timestamp, ControlList metadata)
+{
+	metadata.merge(recording_->frame(position).metadata,
+		       ControlList::MergePolicy::KeepExisting);
+	metadataReady.emit(pending.request, metadata);
+
+	recording_->seek(position);
+	fillRequest(pending, recording_->sequence(position), timestamp);
+}
+
+void VirtualCameraData::fillRequest(const PendingRequest &pending,
+				    std::optional<uint32_t> sequence,
+				    uint64_t timestamp)
+{
+	Request *request = pending.request;
+	FrameBuffer *input = pending.input;
+
+	auto fillMetadata = [&](StreamConfig &streamConfig, FrameBuffer *buffer) {
+		FrameMetadata &fmd = buffer->_d()->metadata();
+
+		fmd.status = FrameMetadata::Status::FrameSuccess;
+		fmd.sequence = sequence ? *sequence : streamConfig.seq++;
+		fmd.timestamp = timestamp;
+
+		Span<const FrameBuffer::Plane> planes = buffer->planes();
+		for (const auto [i, p] : utils::enumerate(planes))
+			fmd.planes()[i].bytesused = p.length;
+	};
+
+	/*
+	 * Generate the source frame when the request needs it, directly in the
+	 * buffer of the source stream when possible.
+	 */
+	FrameBuffer *source = sourceStream_ ? request->findBuffer(sourceStream_) : nullptr;
+	bool scaled = false;
 	for (const auto &[stream, buffer] : request->buffers()) {
-		bool found = false;
-		/* map buffer and fill test patterns */
-		for (auto &streamConfig : streamConfigs_) {
-			if (stream == &streamConfig.stream) {
-				FrameMetadata &fmd = buffer->_d()->metadata();
+		if (stream != sourceStream_ && stream != rawStream_ && stream != ispStream_)
+			scaled = true;
+	}
 
-				fmd.status = FrameMetadata::Status::FrameSuccess;
-				fmd.sequence = streamConfig.seq++;
-				fmd.timestamp = currentTimestamp();
+	if (!source && scaled)
+		source = sourceBuffer_.get();
 
-				Span<const FrameBuffer::Plane> planes = buffer->planes();
-				for (const auto [i, p] : utils::enumerate(planes))
-					fmd.planes()[i].bytesused = p.length;
+	int sourceStatus = source ? frameGenerator_->generateFrame(sourceSize_, source) : 0;
 
-				found = true;
+	std::optional<MappedFrameBuffer> mappedSource;
+	if (scaled && !sourceStatus) {
+		mappedSource.emplace(source, MappedFrameBuffer::MapFlag::Read);
+		if (!mappedSource->isValid())
+			sourceStatus = -EINVAL;
+	}
 
-				if (streamConfig.frameGenerator->generateFrame(
-					    stream->configuration().size, buffer))
-					fmd.status = FrameMetadata::Status::FrameError;
+	if (rawGenerator_)
+		rawGenerator_->setExposureScale(pending.exposureScale);
 
-				bufferCompleted.emit(buffer);
-				break;
-			}
+	for (const auto &[stream, buffer] : request->buffers()) {
+		auto it = std::find_if(streamConfigs_.begin(), streamConfigs_.end(),
+				       [&](const StreamConfig &streamConfig) {
+					       return &streamConfig.stream == stream;
+				       });
+		ASSERT(it != streamConfigs_.end());
+		StreamConfig &streamConfig = *it;
+
+		/* The ISP stream is produced from the input below. */
+		if (stream == ispStream_) {
+			if (!input->request())
+				fillMetadata(streamConfig, input);
+			continue;
 		}
-		ASSERT(found);
+
+		fillMetadata(streamConfig, buffer);
+
+		/* The raw buffer used as input is completed by the ISP. */
+		if (buffer == input)
+			continue;
+
+		int ret;
+		if (stream == rawStream_)
+			ret = rawGenerator_->generateFrame(rawSize_, buffer);
+		else if (stream == sourceStream_ || sourceStatus)
+			ret = sourceStatus;
+		else
+			ret = streamConfig.scaler.process(*mappedSource, buffer);
+
+		if (ret)
+			buffer->_d()->metadata().status = FrameMetadata::Status::FrameError;
+
+		bufferCompleted.emit(buffer);
 	}
+
+	if (!input)
+		return;
+
+	if (rawGenerator_->generateFrame(rawSize_, input))
+		input->_d()->metadata().status = FrameMetadata::Status::FrameError;
+
+	inputReady.emit(request, input);
 }
 
 VirtualCameraConfiguration::VirtualCameraConfiguration(VirtualCameraData *data)
@@ -173,63 +403,209 @@ CameraConfiguration::Status VirtualCameraConfiguration::validate()
 		return Invalid;
 	}
 
-	/* Only one stream is supported */
 	if (config_.size() > VirtualCameraData::kMaxStream) {
 		config_.resize(VirtualCameraData::kMaxStream);
 		status = Adjusted;
 	}
 
-	for (StreamConfiguration &cfg : config_) {
-		bool adjusted = false;
-		bool found = false;
-		for (const auto &resolution : data_->config_.resolutions) {
-			if (resolution.size.width == cfg.size.width &&
-			    resolution.size.height == cfg.size.height) {
-				found = true;
-				break;
+	/*
+	 * The software ISP produces a single processed stream, optionally
+	 * along with the raw stream it processes.
+	 */
+	if (data_->hasIsp()) {
+		bool raw = false;
+		bool processed = false;
+
+		for (auto it = config_.begin(); it != config_.end();) {
+			bool &found = data_->isRaw(it->pixelFormat) ? raw : processed;
+			if (found) {
+				it = config_.erase(it);
+				status = Adjusted;
+				continue;
 			}
+
+			found = true;
+			it++;
 		}
+	}
+
+	/* Validate the raw streams first, the ISP input size depends on them. */
+	const Size *rawSize = nullptr;
+	for (StreamConfiguration &cfg : config_) {
+		if (!data_->isRaw(cfg.pixelFormat))
+			continue;
 
-		if (!found) {
-			/*
-			 * \todo It's a pipeline's decision to choose a
-			 * resolution when the exact one is not supported.
-			 * Defining the default logic in PipelineHandler to
-			 * find the closest resolution would be nice.
-			 */
-			cfg.size = data_->config_.maxResolutionSize;
+		if (validateRaw(cfg) == Adjusted)
 			status = Adjusted;
-			adjusted = true;
-		}
 
-		if (cfg.pixelFormat != formats::NV12) {
-			cfg.pixelFormat = formats::NV12;
+		rawSize = &cfg.size;
+	}
+
+	for (StreamConfiguration &cfg : config_) {
+		if (data_->isRaw(cfg.pixelFormat))
+			continue;
+
+		Status ret = validateProcessed(cfg, rawSize);
+		if (ret == Invalid)
+			return Invalid;
+		if (ret == Adjusted)
 			status = Adjusted;
+	}
+
+	return status;
+}
+
+CameraConfiguration::Status VirtualCameraConfiguration::validateRaw(StreamConfiguration &cfg)
+{
+	Status status = Valid;
+
+	bool found = false;
+	for (const auto &resolution : data_->config_.resolutions) {
+		if (resolution.size == cfg.size) {
+			found = true;
+			break;
+		}
+	}
+
+	if (!found) {
+		cfg.size = data_->config_.maxResolutionSize;
+		status = Adjusted;
+	}
+
+	if (cfg.colorSpace != ColorSpace::Raw) {
+		cfg.colorSpace = ColorSpace::Raw;
+		status = Adjusted;
+	}
+
+	if (status == Adjusted)
+		LOG(Virtual, Info)
+			<< "Stream configuration adjusted to " << cfg.toString();
+
+	const PixelFormatInfo &info = PixelFormatInfo::info(cfg.pixelFormat);
+	cfg.stride = info.stride(cfg.size.width, 0, 1);
+	cfg.frameSize = info.frameSize(cfg.size, 1);
+
+	cfg.bufferCount = VirtualCameraConfiguration::kBufferCount;
+
+	return status;
+}
+
+CameraConfiguration::Status
+VirtualCameraConfiguration::validateProcessed(StreamConfiguration &cfg,
+					      [[maybe_unused]] const Size *rawSize)
+{
+	Status status = Valid;
+	bool adjusted = false;
+
+#if HAVE_SOFTISP
+	if (data_->hasIsp()) {
+		SoftwareIsp *swIsp = data_->swIsp_.get();
+		const PixelFormat &rawFormat = data_->config_.raw->format;
+
+		std::vector<PixelFormat> formats = swIsp->formats(rawFormat);
+		if (formats.empty())
+			return Invalid;
+
+		if (std::find(formats.begin(), formats.end(), cfg.pixelFormat) == formats.end()) {
+			cfg.pixelFormat = formats[0];
 			adjusted = true;
 		}
 
-		if (cfg.colorSpace != ColorSpace::Smpte170m) {
-			cfg.colorSpace = ColorSpace::Smpte170m;
-			status = Adjusted;
+		/*
+		 * Without a raw stream, pick the smallest raw frame size the
+		 * requested size can be produced from.
+		 */
+		if (rawSize) {
+			rawSize_ = *rawSize;
+		} else {
+			rawSize_ = data_->config_.maxResolutionSize;
+			for (const auto &resolution : data_->config_.resolutions) {
+				if (resolution.size < rawSize_ &&
+				    swIsp->sizes(rawFormat, resolution.size).contains(cfg.size))
+					rawSize_ = resolution.size;
+			}
+		}
+
+		SizeRange sizes = swIsp->sizes(rawFormat, rawSize_);
+		if (!sizes.contains(cfg.size)) {
+			cfg.size = sizes.max;
 			adjusted = true;
 		}
 
-		if (validateColorSpaces() == Adjusted) {
-			status = Adjusted;
+		const PixelFormatInfo &info = PixelFormatInfo::info(cfg.pixelFormat);
+		ColorSpace colorSpace = info.colourEncoding == PixelFormatInfo::ColourEncodingYUV
+						? ColorSpace::Sycc
+						: ColorSpace::Srgb;
+		if (cfg.colorSpace != colorSpace) {
+			cfg.colorSpace = colorSpace;
 			adjusted = true;
 		}
 
-		if (adjusted)
+		std::tie(cfg.stride, cfg.frameSize) =
+			swIsp->strideAndFrameSize(cfg.pixelFormat, cfg.size);
+		if (!cfg.stride)
+			return Invalid;
+
+		cfg.bufferCount = VirtualCameraConfiguration::kBufferCount;
+
+		if (adjusted) {
 			LOG(Virtual, Info)
 				<< "Stream configuration adjusted to " << cfg.toString();
+			status = Adjusted;
+		}
 
-		const PixelFormatInfo &info = PixelFormatInfo::info(cfg.pixelFormat);
-		cfg.stride = info.stride(cfg.size.width, 0, 1);
-		cfg.frameSize = info.frameSize(cfg.size, 1);
+		return status;
+	}
+#endif
 
-		cfg.bufferCount = VirtualCameraConfiguration::kBufferCount;
+	/* Recordings only produce processed streams through the ISP. */
+	if (!data_->frameGenerator_)
+		return Invalid;
+
+	/*
+	 * The processed streams are scaled from the source frame, any size in
+	 * the range of the supported resolutions can be produced.
+	 */
+	Size size = cfg.size.expandedTo(data_->config_.minResolutionSize)
+			    .boundedTo(data_->config_.maxResolutionSize)
+			    .alignedDownTo(2, 2);
+	if (cfg.size != size) {
+		cfg.size = size;
+		status = Adjusted;
+		adjusted = true;
+	}
+
+	const std::vector<PixelFormat> &scalerFormats = FrameScaler::formats();
+	if (std::find(scalerFormats.begin(), scalerFormats.end(), cfg.pixelFormat) ==
+	    scalerFormats.end()) {
+		cfg.pixelFormat = formats::NV12;
+		status = Adjusted;
+		adjusted = true;
+	}
+
+	ColorSpace colorSpace = ColorSpace::Smpte170m;
+	colorSpace.adjust(cfg.pixelFormat);
+	if (cfg.colorSpace != colorSpace) {
+		cfg.colorSpace = colorSpace;
+		status = Adjusted;
+		adjusted = true;
 	}
 
+	if (validateColorSpaces() == Adjusted) {
+		status = Adjusted;
+		adjusted = true;
+	}
+
+	if (adjusted)
+		LOG(Virtual, Info)
+			<< "Stream configuration adjusted to " << cfg.toString();
+
+	const PixelFormatInfo &info = PixelFormatInfo::info(cfg.pixelFormat);
+	cfg.stride = info.stride(cfg.size.width, 0, 1);
+	cfg.frameSize = info.frameSize(cfg.size, 1);
+
+	cfg.bufferCount = VirtualCameraConfiguration::kBufferCount;
+
 	return status;
 }
 
@@ -261,29 +637,67 @@ PipelineHandlerVirtual::generateConfiguration(Camera *camera,
 		return config;
 
 	for (const StreamRole role : roles) {
+		std::map<PixelFormat, std::vector<SizeRange>> streamFormats;
+		PixelFormat pixelFormat;
+		Size size = data->config_.maxResolutionSize;
+		ColorSpace colorSpace = ColorSpace::Smpte170m;
+
 		switch (role) {
 		case StreamRole::StillCapture:
 		case StreamRole::VideoRecording:
 		case StreamRole::Viewfinder:
+#if HAVE_SOFTISP
+			if (data->hasIsp()) {
+				const PixelFormat &rawFormat = data->config_.raw->format;
+				SizeRange sizes = data->swIsp_->sizes(rawFormat, size);
+
+				for (const PixelFormat &format : data->swIsp_->formats(rawFormat))
+					streamFormats[format] = { sizes };
+
+				pixelFormat = streamFormats.begin()->first;
+				size = sizes.max;
+				colorSpace = ColorSpace::Srgb;
+				break;
+			}
+#endif
+			if (!data->frameGenerator_) {
+				LOG(Virtual, Error)
+					<< "Processed streams require the software ISP"
+					<< " with recordings";
+				return {};
+			}
+
+			for (const PixelFormat &format : FrameScaler::formats())
+				streamFormats[format] = { { data->config_.minResolutionSize,
+							    data->config_.maxResolutionSize } };
+
+			pixelFormat = formats::NV12;
 			break;
 
 		case StreamRole::Raw:
+			if (data->config_.raw) {
+				pixelFormat = data->config_.raw->format;
+				colorSpace = ColorSpace::Raw;
+				break;
+			}
+
+			[[fallthrough]];
 		default:
 			LOG(Virtual, Error)
 				<< "Requested stream role not supported: " << role;
 			return {};
 		}
 
-		std::map<PixelFormat, std::vector<SizeRange>> streamFormats;
-		PixelFormat pixelFormat = formats::NV12;
-		streamFormats[pixelFormat] = { { data->config_.minResolutionSize,
-						 data->config_.maxResolutionSize } };
+		if (streamFormats.empty())
+			streamFormats[pixelFormat] = { { data->config_.minResolutionSize,
+							 data->config_.maxResolutionSize } };
+
 		StreamFormats formats(streamFormats);
 		StreamConfiguration cfg(formats);
 		cfg.pixelFormat = pixelFormat;
-		cfg.size = data->config_.maxResolutionSize;
+		cfg.size = size;
 		cfg.bufferCount = VirtualCameraConfiguration::kBufferCount;
-		cfg.colorSpace = ColorSpace::Smpte170m;
+		cfg.colorSpace = colorSpace;
 
 		config->addConfiguration(cfg);
 	}
@@ -297,23 +711,137 @@ int PipelineHandlerVirtual::configure(Camera *camera,
 				      CameraConfiguration *config)
 {
 	VirtualCameraData *data = cameraData(camera);
+	const StreamConfiguration *ispCfg = nullptr;
+
+	data->sourceStream_ = nullptr;
+	data->sourceBuffer_.reset();
+	data->sourceSize_ = {};
+	data->rawStream_ = nullptr;
+	data->ispStream_ = nullptr;
+
 	for (auto [i, c] : utils::enumerate(*config)) {
-		c.setStream(&data->streamConfigs_[i].stream);
-		/* Start reading the images/generating test patterns */
-		data->streamConfigs_[i].frameGenerator->configure(c.size);
+		Stream *stream = &data->streamConfigs_[i].stream;
+		c.setStream(stream);
+
+		if (data->isRaw(c.pixelFormat)) {
+			data->rawStream_ = stream;
+			data->rawSize_ = c.size;
+		} else if (data->hasIsp()) {
+			data->ispStream_ = stream;
+			ispCfg = &c;
+		} else {
+			data->sourceSize_ = data->sourceSize_.expandedTo(c.size);
+		}
 	}
 
-	return 0;
+	/*
+	 * Generate the source frame at the largest size of the processed
+	 * streams, in the first NV12 stream of that size if any, and scale it
+	 * to the other processed streams.
+	 */
+	bool scaled = false;
+	for (auto [i, c] : utils::enumerate(*config)) {
+		Stream *stream = c.stream();
+		if (stream == data->rawStream_ || stream == data->ispStream_)
+			continue;
+
+		if (!data->sourceStream_ && c.pixelFormat == formats::NV12 &&
+		    c.size == data->sourceSize_) {
+			data->sourceStream_ = stream;
+			continue;
+		}
+
+		int ret = data->streamConfigs_[i].scaler.configure(data->sourceSize_,
+								   c.pixelFormat, c.size);
+		if (ret)
+			return ret;
+
+		scaled = true;
+	}
+
+	if (!data->sourceSize_.isNull()) {
+		int ret = data->frameGenerator_->configure(formats::NV12, data->sourceSize_);
+		if (ret)
+			return ret;
+	}
+
+	/* The source frame is needed for requests without a source stream buffer. */
+	if (scaled) {
+		if (!dmaBufAllocator_.isValid())
+			return -ENOBUFS;
+
+		const PixelFormatInfo &info = PixelFormatInfo::info(formats::NV12);
+		std::vector<std::unique_ptr<FrameBuffer>> buffers;
+
+		int ret = dmaBufAllocator_.exportBuffers(1, { info.planeSize(data->sourceSize_, 0),
+							      info.planeSize(data->sourceSize_, 1) },
+							 &buffers);
+		if (ret < 0)
+			return ret;
+
+		data->sourceBuffer_ = std::move(buffers[0]);
+	}
+
+	/* The ISP input size has been selected when validating the configuration. */
+	if (ispCfg)
+		data->rawSize_ = static_cast<VirtualCameraConfiguration *>(config)->rawSize();
+
+	if (data->rawStream_ || ispCfg) {
+		int ret = data->rawGenerator_->configure(data->config_.raw->format,
+							 data->rawSize_);
+		if (ret)
+			return ret;
+	}
+
+	data->rawBuffers_.clear();
+
+	if (!ispCfg)
+		return 0;
+
+#if HAVE_SOFTISP
+	const PixelFormat &rawFormat = data->config_.raw->format;
+	const PixelFormatInfo &info = PixelFormatInfo::info(rawFormat);
+
+	/* Allocate the internal buffers used when requests have no raw buffer. */
+	if (!dmaBufAllocator_.isValid())
+		return -ENOBUFS;
+
+	int ret = dmaBufAllocator_.exportBuffers(VirtualCameraConfiguration::kBufferCount,
+					     { info.frameSize(data->rawSize_, 1) },
+					     &data->rawBuffers_);
+	if (ret < 0)
+		return ret;
+
+	StreamConfiguration inputCfg;
+	inputCfg.pixelFormat = rawFormat;
+	inputCfg.size = data->rawSize_;
+	inputCfg.stride = info.stride(data->rawSize_.width, 0, 1);
+	inputCfg.bufferCount = VirtualCameraConfiguration::kBufferCount;
+
+	ipa::soft::IPAConfigInfo configInfo;
+	configInfo.sensorControls = data->sensor_->controls();
+
+	return data->swIsp_->configure(inputCfg, { *ispCfg }, configInfo);
+#else
+	return -ENODEV;
+#endif
 }
 
 int PipelineHandlerVirtual::exportFrameBuffers([[maybe_unused]] Camera *camera,
 					       Stream *stream,
 					       std::vector<std::unique_ptr<FrameBuffer>> *buffers)
 {
+	const StreamConfiguration &config = stream->configuration();
+
+#if HAVE_SOFTISP
+	VirtualCameraData *data = cameraData(camera);
+	if (stream == data->ispStream_)
+		return data->swIsp_->exportBuffers(stream, config.bufferCount, buffers);
+#endif
+
 	if (!dmaBufAllocator_.isValid())
 		return -ENOBUFS;
 
-	const StreamConfiguration &config = stream->configuration();
 	const PixelFormatInfo &info = PixelFormatInfo::info(config.pixelFormat);
 
 	std::vector<unsigned int> planeSizes;
@@ -323,14 +851,51 @@ int PipelineHandlerVirtual::exportFrameBuffers([[maybe_unused]] Camera *camera,
 	return dmaBufAllocator_.exportBuffers(config.bufferCount, planeSizes, buffers);
 }
 
-int PipelineHandlerVirtual::start([[maybe_unused]] Camera *camera,
-				  [[maybe_unused]] const ControlList *controls)
+int PipelineHandlerVirtual::start(Camera *camera, const ControlList *controls)
 {
 	VirtualCameraData *data = cameraData(camera);
 
 	for (auto &s : data->streamConfigs_)
 		s.seq = 0;
 
+	data->replayRequests_ = 0;
+	data->replayPosition_ = 0;
+
+	if (data->recording_) {
+		data->startFrameDuration_ = data->recording_->interval(0);
+	} else if (data->pacer_) {
+		const ControlInfo &info =
+			data->controlInfo_.at(controls::FrameDurationLimits.id());
+		std::array<int64_t, 2> limits = {
+			info.min().get<int64_t>(),
+			info.max().get<int64_t>(),
+		};
+
+		if (controls) {
+			const auto &startLimits = controls->get(controls::FrameDurationLimits);
+			if (startLimits)
+				std::copy(startLimits->begin(), startLimits->end(),
+					  limits.begin());
+		}
+
+		data->startFrameDuration_ = data->frameDuration(limits);
+	}
+
+#if HAVE_SOFTISP
+	if (data->ispStream_) {
+		data->availableRawBuffers_ = {};
+		for (std::unique_ptr<FrameBuffer> &buffer : data->rawBuffers_)
+			data->availableRawBuffers_.push(buffer.get());
+
+		int ret = data->swIsp_->start();
+		if (ret)
+			return ret;
+
+		data->inputReady.connect(this, &PipelineHandlerVirtual::ispInputReady);
+	}
+#endif
+
+	data->metadataReady.connect(this, &PipelineHandlerVirtual::metadataReady);
 	data->bufferCompleted.connect(this, &PipelineHandlerVirtual::bufferCompleted);
 	data->start();
 
@@ -346,9 +911,23 @@ void PipelineHandlerVirtual::stopDevice(Camera *camera)
 	data->wait();
 	data->removeMessages(data);
 
-	/* Process pending `bufferCompleted` signals. */
+	/*
+	 * Process pending `metadataReady`, `bufferCompleted` and `inputReady`
+	 * signals.
+	 */
+	data->ispWaitingRequests_ = {};
 	thread()->dispatchMessages(Message::Type::InvokeMessage, this);
+	data->metadataReady.disconnect(this);
 	data->bufferCompleted.disconnect(this);
+	data->inputReady.disconnect(this);
+
+	/* Stopping the ISP returns the buffers it holds as cancelled. */
+#if HAVE_SOFTISP
+	if (data->ispStream_)
+		data->swIsp_->stop();
+#endif
+
+	data->ispFrames_.clear();
 
 	while (!data->queuedRequests_.empty())
 		cancelRequest(data->queuedRequests_.front());
@@ -358,11 +937,48 @@ int PipelineHandlerVirtual::queueRequestDevice([[maybe_unused]] Camera *camera,
 					       Request *request)
 {
 	VirtualCameraData *data = cameraData(camera);
-	const auto timestamp = currentTimestamp();
 
-	request->_d()->metadata().set(controls::SensorTimestamp, timestamp);
+	/*
+	 * Replay the controls recorded with the frames in order, unless the
+	 * application sets them.
+	 */
+	if (data->recording_) {
+		const RecordedFrame &frame = data->recording_->frame(data->replayRequests_++);
+		ControlList &controls = request->controls();
+
+		for (const auto &[id, value] : frame.controls) {
+			if (!controls.contains(id) && data->controlInfo_.count(id))
+				controls.set(id, value);
+		}
+	}
+
+	/* Paced cameras report the sensor metadata when the frame completes. */
+	if (!data->pacer_) {
+		ControlList sensorMetadata(controls::controls);
+		sensorMetadata.set(controls::SensorTimestamp, currentTimestamp());
+		metadataAvailable(request, sensorMetadata);
+	}
+
+#if HAVE_SOFTISP
+	/*
+	 * Requests with a buffer for the ISP stream wait for a raw input
+	 * buffer before the frame is produced, in order.
+	 */
+	if (data->ispStream_ && request->findBuffer(data->ispStream_)) {
+		VirtualCameraData::IspFrameInfo *info =
+			data->ispFrames_.create(request->sequence(), request);
+		info->request = request;
+
+		data->swIsp_->queueRequest(request->sequence(), request->controls());
+		data->ispWaitingRequests_.push(request);
+		processIspRequests(data);
+
+		return 0;
+	}
+#endif
+
 	data->invokeMethod(&VirtualCameraData::processRequest,
-			   ConnectionTypeQueued, request);
+			   ConnectionTypeQueued, request, nullptr, 1.0);
 
 	return 0;
 }
@@ -398,6 +1014,21 @@ bool PipelineHandlerVirtual::match([[maybe_unused]] DeviceEnumerator *enumerator
 
 	/* Configure and register cameras with configData */
 	for (auto &data : configData) {
+		if (data->config_.raw && data->config_.raw->isp) {
+#if HAVE_SOFTISP
+			bool ispEnabled = initSoftwareIsp(data.get());
+#else
+			bool ispEnabled = false;
+#endif
+			if (!ispEnabled) {
+				LOG(Virtual, Warning)
+					<< "Software ISP not available, disabling "
+					<< "raw frames processing for camera: "
+					<< data->config_.id;
+				data->config_.raw->isp = false;
+			}
+		}
+
 		std::set<Stream *> streams;
 		for (auto &streamConfig : data->streamConfigs_)
 			streams.insert(&streamConfig.stream);
@@ -424,33 +1055,221 @@ bool PipelineHandlerVirtual::initFrameGenerator(Camera *camera)
 	auto &frame = data->config_.frame;
 	std::visit(utils::overloaded{
 			   [&](TestPattern &testPattern) {
-				   for (auto &streamConfig : data->streamConfigs_) {
-					   if (testPattern == TestPattern::DiagonalLines)
-						   streamConfig.frameGenerator = std::make_unique<DiagonalLinesGenerator>();
-					   else
-						   streamConfig.frameGenerator = std::make_unique<ColorBarsGenerator>();
-				   }
+				   data->frameGenerator_ = createTestPatternGenerator(testPattern);
+				   if (data->config_.raw)
+					   data->rawGenerator_ = createTestPatternGenerator(testPattern);
 			   },
 			   [&](ImageFrames &imageFrames) {
-				   for (auto &streamConfig : data->streamConfigs_)
-					   streamConfig.frameGenerator = ImageFrameGenerator::create(imageFrames);
+				   data->frameGenerator_ = ImageFrameGenerator::create(imageFrames);
+			   },
+			   [&](RecordingFrames &recording) {
+				   auto generator = RecordingFrameGenerator::create(recording);
+				   data->recording_ = generator.get();
+				   data->rawGenerator_ = std::move(generator);
 			   } },
 		   frame);
 
-	for (auto &streamConfig : data->streamConfigs_)
-		if (!streamConfig.frameGenerator)
-			return false;
+	return data->frameGenerator_ || data->recording_;
+}
 
-	return true;
+void PipelineHandlerVirtual::metadataReady(Request *request, const ControlList &metadata)
+{
+	metadataAvailable(request, metadata);
 }
 
 void PipelineHandlerVirtual::bufferCompleted(FrameBuffer *buffer)
 {
 	Request *request = buffer->request();
+	VirtualCameraData *data = cameraData(request->_d()->camera());
 
 	if (completeBuffer(request, buffer))
-		completeRequest(request);
+		tryCompleteRequest(data, request);
+}
+
+void PipelineHandlerVirtual::tryCompleteRequest(VirtualCameraData *data, Request *request)
+{
+	if (request->hasPendingBuffers())
+		return;
+
+	/* Requests processed by the ISP also wait for the IPA metadata. */
+	if (data->ispFrames_.find(request) &&
+	    !data->ispFrames_.tryComplete(request->sequence()))
+		return;
+
+	completeRequest(request);
+}
+
+#if HAVE_SOFTISP
+bool PipelineHandlerVirtual::initSoftwareIsp(VirtualCameraData *data)
+{
+	const VirtualCameraData::Configuration &config = data->config_;
+	const std::vector<int64_t> &frameRates = config.resolutions[0].frameRates;
+	std::string model{ data->properties_.get(properties::Model).value_or("virtual") };
+
+	data->sensor_ = std::make_unique<VirtualCameraSensor>(model,
+							      BayerFormat::fromPixelFormat(config.raw->format),
+							      config.maxResolutionSize,
+							      frameRates[1], frameRates[0]);
+
+	ControlInfoMap ipaControls;
+	data->swIsp_ = std::make_unique<SoftwareIsp>(this, data->sensor_.get(), &ipaControls);
+	if (!data->swIsp_->isValid() || data->swIsp_->formats(config.raw->format).empty()) {
+		data->swIsp_.reset();
+		data->sensor_.reset();
+		return false;
+	}
+
+	/* Expose the IPA controls along with the virtual camera ones. */
+	ControlInfoMap::Map controls(data->controlInfo_.begin(), data->controlInfo_.end());
+	for (const auto &[id, info] : ipaControls)
+		controls[id] = info;
+	data->controlInfo_ = ControlInfoMap(std::move(controls), controls::controls);
+
+	/* The ISP signals are processed in the pipeline handler thread. */
+	SoftwareIsp *swIsp = data->swIsp_.get();
+	swIsp->inputBufferReady.connect(this, [this, data](FrameBuffer *buffer) {
+		ispInputDone(data, buffer);
+	});
+	swIsp->outputBufferReady.connect(this, &PipelineHandlerVirtual::ispOutputDone);
+	swIsp->ispStatsReady.connect(this, [this, data](uint32_t frame, uint32_t bufferId) {
+		ispStatsReady(data, frame, bufferId);
+	});
+	swIsp->metadataReady.connect(this, [this, data](uint32_t frame, const ControlList &metadata) {
+		ispMetadataReady(data, frame, metadata);
+	});
+	swIsp->setSensorControls.connect(this, [this, data](const ControlList &sensorControls) {
+		setSensorControls(data, sensorControls);
+	});
+
+	return true;
+}
+
+/*
+ * Hand the requests waiting for the ISP to the camera thread, in order, as
+ * long as raw input buffers are available. Requests that contain a buffer for
+ * the raw stream use it as the ISP input.
+ */
+void PipelineHandlerVirtual::processIspRequests(VirtualCameraData *data)
+{
+	while (!data->ispWaitingRequests_.empty()) {
+		Request *request = data->ispWaitingRequests_.front();
+
+		FrameBuffer *input = data->rawStream_
+					     ? request->findBuffer(data->rawStream_)
+					     : nullptr;
+		if (!input) {
+			if (data->availableRawBuffers_.empty())
+				return;
+
+			input = data->availableRawBuffers_.front();
+			data->availableRawBuffers_.pop();
+		}
+
+		data->ispWaitingRequests_.pop();
+
+		/* Capture the frame with the current sensor controls. */
+		VirtualCameraData::IspFrameInfo *info = data->ispFrames_.find(request);
+		info->input = input;
+		info->sensorControls = data->sensor_->getControls(kSensorControls);
+
+		double exposureScale = data->sensor_->exposureScale(info->sensorControls);
+
+		data->invokeMethod(&VirtualCameraData::processRequest,
+				   ConnectionTypeQueued, request, input, exposureScale);
+	}
+}
+
+void PipelineHandlerVirtual::ispInputReady(Request *request, FrameBuffer *input)
+{
+	VirtualCameraData *data = cameraData(request->_d()->camera());
+
+	std::map<const Stream *, FrameBuffer *> outputs = {
+		{ data->ispStream_, request->findBuffer(data->ispStream_) },
+	};
+
+	int ret = data->swIsp_->queueBuffers(request->sequence(), input, outputs);
+	if (ret >= 0)
+		return;
+
+	LOG(Virtual, Error)
+		<< "Failed to queue buffers to the software ISP: " << ret;
+
+	/*
+	 * The ISP will neither process the frame nor report its metadata.
+	 * Return the internal raw buffer and cancel the request buffers to
+	 * complete the request, otherwise stopping the camera would wait for
+	 * it forever.
+	 */
+	VirtualCameraData::IspFrameInfo *info = data->ispFrames_.find(request);
+	info->metadataProcessed = true;
+
+	if (!input->request())
+		data->availableRawBuffers_.push(input);
+
+	for (const auto &[stream, buffer] : request->buffers()) {
+		if (!buffer->request())
+			continue;
+
+		buffer->_d()->cancel();
+		completeBuffer(request, buffer);
+	}
+
+	tryCompleteRequest(data, request);
+	processIspRequests(data);
+}
+
+void PipelineHandlerVirtual::ispInputDone(VirtualCameraData *data, FrameBuffer *buffer)
+{
+	/* The raw stream buffers are completed, internal buffers are reused. */
+	Request *request = buffer->request();
+	if (request) {
+		if (completeBuffer(request, buffer))
+			tryCompleteRequest(data, request);
+		return;
+	}
+
+	data->availableRawBuffers_.push(buffer);
+	processIspRequests(data);
+}
+
+void PipelineHandlerVirtual::ispOutputDone(FrameBuffer *buffer)
+{
+	Request *request = buffer->request();
+	VirtualCameraData *data = cameraData(request->_d()->camera());
+
+	if (completeBuffer(request, buffer))
+		tryCompleteRequest(data, request);
+}
+
+void PipelineHandlerVirtual::ispStatsReady(VirtualCameraData *data, uint32_t frame,
+					   uint32_t bufferId)
+{
+	VirtualCameraData::IspFrameInfo *info = data->ispFrames_.find(frame);
+	if (!info)
+		return;
+
+	data->swIsp_->processStats(frame, bufferId, info->sensorControls);
+}
+
+void PipelineHandlerVirtual::ispMetadataReady(VirtualCameraData *data, uint32_t frame,
+					      const ControlList &metadata)
+{
+	VirtualCameraData::IspFrameInfo *info = data->ispFrames_.find(frame);
+	if (!info)
+		return;
+
+	metadataAvailable(info->request, metadata);
+	info->metadataProcessed = true;
+	tryCompleteRequest(data, info->request);
+}
+
+void PipelineHandlerVirtual::setSensorControls(VirtualCameraData *data,
+					       const ControlList &sensorControls)
+{
+	ControlList ctrls = sensorControls;
+	data->sensor_->setControls(&ctrls);
 }
+#endif /* HAVE_SOFTISP */
 
 REGISTER_PIPELINE_HANDLER(PipelineHandlerVirtual, "virtual")
 
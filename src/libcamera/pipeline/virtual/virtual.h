@@ -7,27 +7,42 @@
 
 #pragma once
 
+#include <memory>
+#include <optional>
+#include <queue>
 #include <string>
 #include <variant>
 #include <vector>
 
 #include <libcamera/base/object.h>
 #include <libcamera/base/signal.h>
+#include <libcamera/base/span.h>
 #include <libcamera/base/thread.h>
+#include <libcamera/base/utils.h>
 
+#include <libcamera/controls.h>
 #include <libcamera/geometry.h>
+#include <libcamera/pixel_format.h>
 #include <libcamera/stream.h>
 
 #include "libcamera/internal/camera.h"
+#include "libcamera/internal/frame_info_tracker.h"
 #include "libcamera/internal/pipeline_handler.h"
+#if HAVE_SOFTISP
+#include "libcamera/internal/software_isp/software_isp.h"
+#endif
 
 #include "frame_generator.h"
+#include "frame_pacer.h"
+#include "frame_scaler.h"
 #include "image_frame_generator.h"
+#include "recording_frame_generator.h"
 #include "test_pattern_generator.h"
+#include "virtual_sensor.h"
 
 namespace libcamera {
 
-using VirtualFrame = std::variant<TestPattern, ImageFrames>;
+using VirtualFrame = std::variant<TestPattern, ImageFrames, RecordingFrames>;
 
 class VirtualCameraData : public Camera::Private,
 			  public Thread,
@@ -42,30 +57,116 @@ public:
 	};
 	struct StreamConfig {
 		Stream stream;
-		std::unique_ptr<FrameGenerator> frameGenerator;
+		FrameScaler scaler;
 		unsigned int seq = 0;
 	};
+	/* Raw Bayer output, parsed from the `raw` config file entry */
+	struct RawConfiguration {
+		PixelFormat format;
+		bool isp = false;
+	};
 	/* The config file is parsed to the Configuration struct */
 	struct Configuration {
 		std::string id;
 		std::vector<Resolution> resolutions;
 		VirtualFrame frame;
+		std::optional<RawConfiguration> raw;
 
 		Size maxResolutionSize;
 		Size minResolutionSize;
 	};
+	/* Frames processed by the software ISP, by request sequence */
+	struct IspFrameInfo {
+		Request *request;
+		FrameBuffer *input;
+		ControlList sensorControls;
+		bool metadataProcessed;
+	};
 
 	VirtualCameraData(PipelineHandler *pipe,
 			  const std::vector<Resolution> &supportedResolutions);
 
 	~VirtualCameraData() = default;
 
-	void processRequest(Request *request);
+	void processRequest(Request *request, FrameBuffer *input, double exposureScale);
+	utils::Duration frameDuration(Span<const int64_t, 2> limits) const;
+	bool isRaw(const PixelFormat &format) const;
+	bool hasIsp() const;
 
 	Configuration config_;
 
 	std::vector<StreamConfig> streamConfigs_;
+	Signal<Request *, const ControlList &> metadataReady;
 	Signal<FrameBuffer *> bufferCompleted;
+	Signal<Request *, FrameBuffer *> inputReady;
+
+	/*
+	 * The processed streams are produced from a single NV12 source frame,
+	 * generated by the frameGenerator_ in the buffer of the sourceStream_
+	 * when the request contains one, or in the internal sourceBuffer_
+	 * otherwise, and scaled to the size and format of the other streams.
+	 */
+	std::unique_ptr<FrameGenerator> frameGenerator_;
+	Stream *sourceStream_ = nullptr;
+	std::unique_ptr<FrameBuffer> sourceBuffer_;
+	Size sourceSize_;
+
+	/* Raw frames, only when configured with a `raw` or `recording` entry */
+	std::unique_ptr<FrameGenerator> rawGenerator_;
+	Stream *rawStream_ = nullptr;
+	Size rawSize_;
+
+	/*
+	 * Recorded frames replayed by the rawGenerator_, only when configured
+	 * with a `recording` entry. Requests receive the recorded controls in
+	 * order, counted by replayRequests_ in the pipeline handler thread, and
+	 * the recorded frames in order, counted by replayPosition_ in the
+	 * camera thread when not paced.
+	 */
+	RecordingFrameGenerator *recording_ = nullptr;
+	unsigned int replayRequests_ = 0;
+	unsigned int replayPosition_ = 0;
+
+	/*
+	 * Emulated raw sensor and software ISP, only when configured to process
+	 * raw frames with the software ISP. The ISP input frames are generated
+	 * by the rawGenerator_ on the camera thread, in the raw app buffer when
+	 * the request contains one, or in the internal rawBuffers_ otherwise.
+	 */
+	std::unique_ptr<VirtualCameraSensor> sensor_;
+#if HAVE_SOFTISP
+	std::unique_ptr<SoftwareIsp> swIsp_;
+#endif
+	Stream *ispStream_ = nullptr;
+
+	/* ISP state, accessed from the pipeline handler thread only */
+	std::vector<std::unique_ptr<FrameBuffer>> rawBuffers_;
+	std::queue<FrameBuffer *> availableRawBuffers_;
+	std::queue<Request *> ispWaitingRequests_;
+	FrameInfoTracker<IspFrameInfo> ispFrames_;
+
+	/* Frame pacing, only when configured with a `pacing` entry */
+	std::unique_ptr<FramePacer> pacer_;
+	utils::Duration startFrameDuration_;
+
+protected:
+	void run() override;
+
+private:
+	struct PendingRequest {
+		Request *request;
+		FrameBuffer *input;
+		double exposureScale;
+	};
+
+	void frameCompleted(const FramePacer::Frame &frame);
+	void replayFrame(const PendingRequest &pending, unsigned int position,
+			 uint64_t timestamp, ControlList metadata);
+	void fillRequest(const PendingRequest &pending,
+			 std::optional<uint32_t> sequence, uint64_t timestamp);
+
+	/* Requests waiting for a frame, accessed from the camera thread only */
+	std::queue<PendingRequest> pendingRequests_;
 };
 
 } /* namespace libcamera */
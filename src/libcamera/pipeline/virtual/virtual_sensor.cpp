@@ -0,0 +1,262 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Virtual cameras emulated raw sensor
+ */
+
+#include "virtual_sensor.h"
+
+#include <algorithm>
+#include <errno.h>
+
+#include <linux/v4l2-controls.h>
+
+#include <libcamera/base/log.h>
+
+#include <libcamera/orientation.h>
+#include <libcamera/property_ids.h>
+
+#include <libcamera/ipa/core_ipa_interface.h>
+
+namespace libcamera {
+
+LOG_DECLARE_CATEGORY(Virtual)
+
+/*
+ * The VirtualCameraSensor emulates the raw sensor feeding the software ISP
+ * when the virtual camera produces Bayer frames. It exposes the exposure and
+ * analogue gain V4L2 controls required by the soft IPA, with a timing model
+ * derived from the frame rates of the virtual camera, and reports the scale
+ * the pixel values must be multiplied with to emulate the effect of the
+ * exposure and gain set by the IPA.
+ */
+
+namespace {
+
+/* Horizontal and vertical blanking of the emulated sensor, in pixels and lines */
+constexpr unsigned int kHorizontalBlanking = 128;
+constexpr unsigned int kVerticalBlanking = 32;
+
+/* Margin between the frame length and the maximum exposure, in lines */
+constexpr unsigned int kExposureMargin = 4;
+
+constexpr int32_t kMinGain = 1;
+constexpr int32_t kMaxGain = 16;
+
+} /* namespace */
+
+VirtualCameraSensor::VirtualCameraSensor(const std::string &model,
+					 const BayerFormat &format,
+					 const Size &resolution,
+					 unsigned int maxFrameRate,
+					 unsigned int minFrameRate)
+	: model_(model), format_(format), resolution_(resolution),
+	  properties_(properties::properties)
+{
+	lineLength_ = resolution_.width + kHorizontalBlanking;
+	frameLength_ = resolution_.height + kVerticalBlanking;
+	pixelRate_ = static_cast<uint64_t>(lineLength_) * frameLength_ *
+		     std::max(maxFrameRate, 1u);
+	maxFrameLength_ = pixelRate_ / lineLength_ / std::max(minFrameRate, 1u);
+
+	ControlId::DirectionFlags flags = ControlId::Direction::In |
+					  ControlId::Direction::Out;
+	controlIds_.push_back(std::make_unique<ControlId>(V4L2_CID_EXPOSURE,
+							  "Exposure", "v4l2",
+							  ControlTypeInteger32, flags));
+	controlIds_.push_back(std::make_unique<ControlId>(V4L2_CID_ANALOGUE_GAIN,
+							  "Analogue Gain", "v4l2",
+							  ControlTypeInteger32, flags));
+
+	for (const std::unique_ptr<ControlId> &id : controlIds_)
+		controlIdMap_[id->id()] = id.get();
+
+	int32_t maxExposure = frameLength_ - kExposureMargin;
+
+	ControlInfoMap::Map ctrls;
+	ctrls[controlIds_[0].get()] = ControlInfo(1, maxExposure, maxExposure / 2);
+	ctrls[controlIds_[1].get()] = ControlInfo(kMinGain, kMaxGain, kMinGain);
+	controls_ = ControlInfoMap(std::move(ctrls), controlIdMap_);
+
+	values_ = ControlList(controls_);
+	for (const auto &[id, info] : controls_)
+		values_.set(id->id(), info.def());
+
+	int32_t cfa;
+	switch (format_.order) {
+	case BayerFormat::BGGR:
+		cfa = properties::draft::BGGR;
+		break;
+	case BayerFormat::GBRG:
+		cfa = properties::draft::GBRG;
+		break;
+	case BayerFormat::GRBG:
+		cfa = properties::draft::GRBG;
+		break;
+	case BayerFormat::RGGB:
+		cfa = properties::draft::RGGB;
+		break;
+	case BayerFormat::MONO:
+	default:
+		cfa = properties::draft::MONO;
+		break;
+	}
+
+	properties_.set(properties::Model, model_);
+	properties_.set(properties::PixelArraySize, resolution_);
+	properties_.set(properties::PixelArrayActiveAreas, { Rectangle(resolution_) });
+	properties_.set(properties::draft::ColorFilterArrangement, cfa);
+}
+
+VirtualCameraSensor::~VirtualCameraSensor() = default;
+
+std::vector<Size> VirtualCameraSensor::sizes([[maybe_unused]] unsigned int mbusCode) const
+{
+	return { resolution_ };
+}
+
+V4L2SubdeviceFormat
+VirtualCameraSensor::getFormat([[maybe_unused]] Span<const unsigned int> mbusCodes,
+			       [[maybe_unused]] const Size &size,
+			       [[maybe_unused]] const Size maxSize) const
+{
+	V4L2SubdeviceFormat format{};
+	format.size = resolution_;
+
+	return format;
+}
+
+int VirtualCameraSensor::setFormat(V4L2SubdeviceFormat *format,
+				   [[maybe_unused]] Transform transform)
+{
+	return tryFormat(format);
+}
+
+int VirtualCameraSensor::tryFormat(V4L2SubdeviceFormat *format) const
+{
+	format->size = resolution_;
+
+	return 0;
+}
+
+int VirtualCameraSensor::applyConfiguration([[maybe_unused]] const SensorConfiguration &config,
+					    [[maybe_unused]] Transform transform,
+					    [[maybe_unused]] V4L2SubdeviceFormat *sensorFormat)
+{
+	return -ENOTSUP;
+}
+
+int VirtualCameraSensor::sensorInfo(IPACameraSensorInfo *info) const
+{
+	info->model = model_;
+	info->bitsPerPixel = format_.bitDepth;
+	info->cfaPattern = properties_.get(properties::draft::ColorFilterArrangement)
+				   .value_or(properties::draft::RGB);
+
+	info->activeAreaSize = resolution_;
+	info->analogCrop = Rectangle(resolution_);
+	info->outputSize = resolution_;
+
+	info->pixelRate = pixelRate_;
+
+	info->minLineLength = lineLength_;
+	info->maxLineLength = lineLength_;
+
+	info->minFrameLength = frameLength_;
+	info->maxFrameLength = maxFrameLength_;
+
+	return 0;
+}
+
+Transform VirtualCameraSensor::computeTransform(Orientation *orientation) const
+{
+	*orientation = Orientation::Rotate0;
+
+	return Transform::Identity;
+}
+
+BayerFormat::Order VirtualCameraSensor::bayerOrder([[maybe_unused]] Transform t) const
+{
+	return format_.order;
+}
+
+Orientation VirtualCameraSensor::mountingOrientation() const
+{
+	return Orientation::Rotate0;
+}
+
+ControlList VirtualCameraSensor::getControls(Span<const uint32_t> ids)
+{
+	ControlList ctrls(controls_);
+
+	for (uint32_t id : ids) {
+		if (!values_.contains(id))
+			continue;
+
+		ctrls.set(id, values_.get(id));
+	}
+
+	return ctrls;
+}
+
+int VirtualCameraSensor::setControls(ControlList *ctrls)
+{
+	for (const auto &[id, value] : *ctrls) {
+		auto it = controls_.find(id);
+		if (it == controls_.end()) {
+			LOG(Virtual, Error) << "Control " << id << " not supported";
+			return -EINVAL;
+		}
+	}
+
+	/* Clamp the values to the control limits like a V4L2 subdevice. */
+	for (auto &[id, value] : *ctrls) {
+		const ControlInfo &info = controls_.find(id)->second;
+		value = std::clamp(value.get<int32_t>(), info.min().get<int32_t>(),
+				   info.max().get<int32_t>());
+		values_.set(id, value);
+	}
+
+	return 0;
+}
+
+int VirtualCameraSensor::setTestPatternMode(controls::draft::TestPatternModeEnum mode)
+{
+	return mode == controls::draft::TestPatternModeOff ? 0 : -EINVAL;
+}
+
+const CameraSensorProperties::SensorDelays &VirtualCameraSensor::sensorDelays()
+{
+	/* The virtual sensor applies controls to the next frame. */
+	static constexpr CameraSensorProperties::SensorDelays sensorDelays = {
+		.exposureDelay = 1,
+		.gainDelay = 1,
+		.vblankDelay = 1,
+		.hblankDelay = 1,
+	};
+
+	return sensorDelays;
+}
+
+/*
+ * Compute the factor by which the pixel values of a frame captured with the
+ * sensor controls \a ctrls shall be multiplied, relative to the default
+ * exposure and gain.
+ */
+double VirtualCameraSensor::exposureScale(const ControlList &ctrls) const
+{
+	double scale = 1.0;
+
+	for (const auto &[id, info] : controls_) {
+		int32_t value = ctrls.contains(id->id())
+					? ctrls.get(id->id()).get<int32_t>()
+					: info.def().get<int32_t>();
+
+		scale *= static_cast<double>(value) / info.def().get<int32_t>();
+	}
+
+	return scale;
+}
+
+} /* namespace libcamera */
@@ -0,0 +1,94 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Virtual cameras emulated raw sensor
+ */
+
+#pragma once
+
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <libcamera/base/span.h>
+
+#include <libcamera/controls.h>
+#include <libcamera/geometry.h>
+
+#include "libcamera/internal/bayer_format.h"
+#include "libcamera/internal/camera_sensor.h"
+
+namespace libcamera {
+
+class VirtualCameraSensor : public CameraSensor
+{
+public:
+	VirtualCameraSensor(const std::string &model, const BayerFormat &format,
+			    const Size &resolution, unsigned int maxFrameRate,
+			    unsigned int minFrameRate);
+	~VirtualCameraSensor();
+
+	const std::string &model() const override { return model_; }
+	const std::string &id() const override { return model_; }
+
+	const MediaEntity *entity() const override { return nullptr; }
+	V4L2Subdevice *device() override { return nullptr; }
+
+	CameraLens *focusLens() override { return nullptr; }
+
+	const std::vector<unsigned int> &mbusCodes() const override { return mbusCodes_; }
+	std::vector<Size> sizes(unsigned int mbusCode) const override;
+	Size resolution() const override { return resolution_; }
+
+	V4L2SubdeviceFormat getFormat(Span<const unsigned int> mbusCodes,
+				      const Size &size,
+				      const Size maxSize) const override;
+	int setFormat(V4L2SubdeviceFormat *format,
+		      Transform transform = Transform::Identity) override;
+	int tryFormat(V4L2SubdeviceFormat *format) const override;
+
+	int applyConfiguration(const SensorConfiguration &config,
+			       Transform transform = Transform::Identity,
+			       V4L2SubdeviceFormat *sensorFormat = nullptr) override;
+
+	const ControlList &properties() const override { return properties_; }
+	int sensorInfo(IPACameraSensorInfo *info) const override;
+	Transform computeTransform(Orientation *orientation) const override;
+	BayerFormat::Order bayerOrder(Transform t) const override;
+	Orientation mountingOrientation() const override;
+
+	const ControlInfoMap &controls() const override { return controls_; }
+	ControlList getControls(Span<const uint32_t> ids) override;
+	int setControls(ControlList *ctrls) override;
+
+	const std::vector<controls::draft::TestPatternModeEnum> &
+	testPatternModes() const override { return testPatternModes_; }
+	int setTestPatternMode(controls::draft::TestPatternModeEnum mode) override;
+	const CameraSensorProperties::SensorDelays &sensorDelays() override;
+
+	double exposureScale(const ControlList &ctrls) const;
+
+private:
+	std::string model_;
+	BayerFormat format_;
+	Size resolution_;
+
+	std::vector<unsigned int> mbusCodes_;
+	std::vector<controls::draft::TestPatternModeEnum> testPatternModes_;
+
+	unsigned int lineLength_;
+	unsigned int frameLength_;
+	unsigned int maxFrameLength_;
+	uint64_t pixelRate_;
+
+	ControlList properties_;
+
+	std::vector<std::unique_ptr<ControlId>> controlIds_;
+	ControlIdMap controlIdMap_;
+	ControlInfoMap controls_;
+	ControlList values_;
+};
+
+} /* namespace libcamera */
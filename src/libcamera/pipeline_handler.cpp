@@ -7,6 +7,8 @@
 
 #include "libcamera/internal/pipeline_handler.h"
 
+#include <algorithm>
+#include <bit>
 #include <chrono>
 #include <sys/stat.h>
 #include <sys/sysmacros.h>
@@ -16,12 +18,14 @@
 #include <libcamera/base/utils.h>
 
 #include <libcamera/camera.h>
+#include <libcamera/control_ids.h>
 #include <libcamera/framebuffer.h>
 #include <libcamera/property_ids.h>
 
 #include "libcamera/internal/camera.h"
 #include "libcamera/internal/camera_manager.h"
 #include "libcamera/internal/device_enumerator.h"
+#include "libcamera/internal/global_configuration.h"
 #include "libcamera/internal/media_device.h"
 #include "libcamera/internal/request.h"
 #include "libcamera/internal/tracepoints.h"
@@ -72,8 +76,15 @@ LOG_DEFINE_CATEGORY(Pipeline)
 PipelineHandler::PipelineHandler(CameraManager *manager,
 				 unsigned int maxQueuedRequestsDevice)
 	: manager_(manager), maxQueuedRequestsDevice_(maxQueuedRequestsDevice),
-	  useCount_(0)
+	  useCount_(0), batchQueueing_(false)
 {
+	const GlobalConfiguration &configuration = manager_->_d()->configuration();
+
+	autoQueueDepth_ = configuration.option<bool>({ "request_queue", "auto_depth" })
+				  .value_or(false);
+	minQueueDepth_ = configuration.option<unsigned int>({ "request_queue", "min_depth" })
+				 .value_or(kDefaultMinQueueDepth);
+	minQueueDepth_ = std::clamp(minQueueDepth_, 1U, maxQueuedRequestsDevice_);
 }
 
 PipelineHandler::~PipelineHandler()
@@ -439,7 +450,8 @@ void PipelineHandler::registerRequest(Request *request)
 	 * when a request is ready to be processed.
 	 */
 	request->_d()->prepared.connect(this, [this, request]() {
-		doQueueRequests(request->_d()->camera());
+		if (!batchQueueing_)
+			doQueueRequests(request->_d()->camera());
 	});
 }
 
@@ -474,9 +486,53 @@ void PipelineHandler::queueRequest(Request *request)
 	Camera::Private *data = camera->_d();
 	data->waitingRequests_.push(request);
 
+	request->_d()->queueTime_ = std::chrono::steady_clock::now();
 	request->_d()->prepare(300ms);
 }
 
+/**
+ * \brief Queue a batch of requests
+ * \param[in] requests The requests to queue
+ *
+ * This function queues multiple capture requests to the pipeline handler for
+ * processing, in the same order as in the \a requests vector. It behaves as
+ * calling queueRequest() for each request, except that the queue of waiting
+ * requests is only processed once all requests have been added and prepared,
+ * which allows queuing the whole batch to the device in a single pass.
+ *
+ * All requests shall belong to the same camera.
+ *
+ * \context This function is called from the CameraManager thread.
+ */
+void PipelineHandler::queueRequests(const std::vector<Request *> &requests)
+{
+	if (requests.empty())
+		return;
+
+	Camera *camera = requests.front()->_d()->camera();
+	Camera::Private *data = camera->_d();
+	auto now = std::chrono::steady_clock::now();
+
+	/*
+	 * Requests without fences are prepared synchronously. Defer the
+	 * processing of the waiting queue until the whole batch is prepared.
+	 */
+	batchQueueing_ = true;
+
+	for (Request *request : requests) {
+		LIBCAMERA_TRACEPOINT(request_queue, request);
+
+		data->waitingRequests_.push(request);
+
+		request->_d()->queueTime_ = now;
+		request->_d()->prepare(300ms);
+	}
+
+	batchQueueing_ = false;
+
+	doQueueRequests(camera);
+}
+
 /**
  * \brief Queue one requests to the device
  */
@@ -486,6 +542,10 @@ void PipelineHandler::doQueueRequest(Request *request)
 
 	Camera *camera = request->_d()->camera();
 	Camera::Private *data = camera->_d();
+
+	if (!request->_d()->cancelled_)
+		updateQueueStatistics(request);
+
 	data->queuedRequests_.push_back(request);
 
 	request->_d()->sequence_ = data->requestSequence_++;
@@ -509,8 +569,13 @@ void PipelineHandler::doQueueRequest(Request *request)
 void PipelineHandler::doQueueRequests(Camera *camera)
 {
 	Camera::Private *data = camera->_d();
+
+	/* Reset the request queue state with the first request after start(). */
+	if (data->requestSequence_ == 0 && data->queuedRequests_.empty())
+		resetQueueStatistics(camera);
+
 	while (!data->waitingRequests_.empty()) {
-		if (data->queuedRequests_.size() == maxQueuedRequestsDevice_)
+		if (data->queuedRequests_.size() >= data->queueDepth_)
 			break;
 
 		Request *request = data->waitingRequests_.front();
@@ -567,6 +632,40 @@ bool PipelineHandler::completeBuffer(Request *request, FrameBuffer *buffer)
 	return request->_d()->completeBuffer(buffer);
 }
 
+/**
+ * \brief Signal the availability of metadata for a request
+ * \param[in] request The request the metadata belongs to
+ * \param[in] metadata The available metadata
+ *
+ * This function shall be called by pipeline handlers to report metadata for
+ * the \a request as soon as it becomes available, without waiting for the
+ * request to complete. The \a metadata is merged into the request metadata,
+ * and the Camera::metadataAvailable signal is emitted with \a metadata.
+ *
+ * Pipeline handlers should report metadata in parts, typically early metadata
+ * related to the sensor frame (such as controls::SensorTimestamp) when the
+ * frame starts or the first buffer completes, and late metadata produced by
+ * the IPA algorithms when it becomes available. Each control should be
+ * reported at most once per request.
+ *
+ * Metadata stored in the request without this function being called is
+ * reported by completeRequest() right before the request completes.
+ *
+ * \context This function shall be called from the CameraManager thread.
+ */
+void PipelineHandler::metadataAvailable(Request *request,
+					const ControlList &metadata)
+{
+	Request::Private *d = request->_d();
+
+	d->metadata().merge(metadata, ControlList::MergePolicy::OverwriteExisting);
+
+	for (const auto &[id, value] : metadata)
+		d->reportedMetadata_.push_back(id);
+
+	d->camera()->metadataAvailable.emit(request, metadata);
+}
+
 /**
  * \brief Signal request completion
  * \param[in] request The request that has completed
@@ -596,6 +695,12 @@ void PipelineHandler::completeRequest(Request *request)
 
 		ASSERT(!req->hasPendingBuffers());
 		data->queuedRequests_.pop_front();
+
+		if (req->status() == Request::RequestComplete) {
+			reportRemainingMetadata(req);
+			updateCompletionStatistics(req);
+		}
+
 		camera->requestComplete(req);
 	}
 
@@ -603,6 +708,148 @@ void PipelineHandler::completeRequest(Request *request)
 	doQueueRequests(camera);
 }
 
+/* Compute the logarithmic histogram bucket of a duration. */
+static unsigned int durationBucket(std::chrono::steady_clock::duration duration)
+{
+	auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+	if (us <= 0)
+		return 0;
+
+	return std::min<unsigned int>(std::bit_width(static_cast<uint64_t>(us)),
+				      RequestQueueStatistics::kHistogramSize - 1);
+}
+
+/* Reset the request queue state and statistics of a camera. */
+void PipelineHandler::resetQueueStatistics(Camera *camera)
+{
+	Camera::Private *data = camera->_d();
+
+	data->queueDepth_ = maxQueuedRequestsDevice_;
+	data->queueStableCount_ = 0;
+	data->lastSequence_.reset();
+
+	MutexLocker locker(data->queueStatsMutex_);
+	data->queueStats_ = {};
+	data->queueStats_.queueDepth = data->queueDepth_;
+}
+
+/*
+ * Update the request queue statistics when queuing \a request to the device,
+ * and increase the queue depth when the device has run out of requests and the
+ * automatic queue depth is enabled.
+ */
+void PipelineHandler::updateQueueStatistics(Request *request)
+{
+	Camera::Private *data = request->_d()->camera()->_d();
+	const auto now = std::chrono::steady_clock::now();
+	const unsigned int depth = data->queuedRequests_.size();
+
+	bool underrun = depth == 0 && data->requestSequence_ != 0;
+	if (underrun && autoQueueDepth_ &&
+	    data->queueDepth_ < maxQueuedRequestsDevice_) {
+		data->queueDepth_++;
+		data->queueStableCount_ = 0;
+
+		LOG(Pipeline, Debug)
+			<< "Request queue underrun, increasing depth to "
+			<< data->queueDepth_;
+	}
+
+	const Request::Private *d = request->_d();
+
+	MutexLocker locker(data->queueStatsMutex_);
+	RequestQueueStatistics &stats = data->queueStats_;
+
+	stats.queuedRequests++;
+	if (underrun)
+		stats.underruns++;
+	stats.queueDepth = data->queueDepth_;
+
+	stats.depthHistogram[std::min(depth, RequestQueueStatistics::kHistogramSize - 1)]++;
+	stats.prepareTimeHistogram[durationBucket(d->prepareTime_ - d->queueTime_)]++;
+	stats.waitTimeHistogram[durationBucket(now - d->prepareTime_)]++;
+}
+
+/*
+ * Update the request queue statistics when \a request completes successfully,
+ * and decrease the queue depth when the automatic queue depth is enabled and
+ * the device has been kept fed with requests for long enough.
+ */
+void PipelineHandler::updateCompletionStatistics(Request *request)
+{
+	Camera::Private *data = request->_d()->camera()->_d();
+
+	if (!request->buffers().empty()) {
+		uint32_t sequence = request->buffers().begin()->second->metadata().sequence;
+
+		if (data->lastSequence_ && sequence > *data->lastSequence_ + 1) {
+			MutexLocker locker(data->queueStatsMutex_);
+			data->queueStats_.droppedFrames += sequence - *data->lastSequence_ - 1;
+		}
+
+		data->lastSequence_ = sequence;
+	}
+
+	if (!autoQueueDepth_)
+		return;
+
+	/*
+	 * Only lower the depth when prepared requests are waiting, as the
+	 * application then provides requests faster than the device consumes
+	 * them, and queuing them early only increases the control latency.
+	 */
+	if (data->waitingRequests_.empty() ||
+	    !data->waitingRequests_.front()->_d()->prepared_) {
+		data->queueStableCount_ = 0;
+		return;
+	}
+
+	if (++data->queueStableCount_ < kQueueDepthStablePeriod ||
+	    data->queueDepth_ <= minQueueDepth_)
+		return;
+
+	data->queueDepth_--;
+	data->queueStableCount_ = 0;
+
+	LOG(Pipeline, Debug)
+		<< "Request queue stable, decreasing depth to "
+		<< data->queueDepth_;
+
+	MutexLocker locker(data->queueStatsMutex_);
+	data->queueStats_.queueDepth = data->queueDepth_;
+}
+
+/*
+ * Report the request metadata that the pipeline handler hasn't reported
+ * through metadataAvailable(), to guarantee that applications receive all the
+ * metadata through the Camera::metadataAvailable signal.
+ */
+void PipelineHandler::reportRemainingMetadata(Request *request)
+{
+	Request::Private *d = request->_d();
+	const ControlList &metadata = d->metadata();
+	Camera *camera = d->camera();
+
+	/* Avoid copies when no metadata has been reported early. */
+	if (d->reportedMetadata_.empty()) {
+		if (!metadata.empty())
+			camera->metadataAvailable.emit(request, metadata);
+		return;
+	}
+
+	ControlList remaining(controls::controls);
+
+	for (const auto &[id, value] : metadata) {
+		if (std::find(d->reportedMetadata_.begin(),
+			      d->reportedMetadata_.end(), id) ==
+		    d->reportedMetadata_.end())
+			remaining.set(id, value);
+	}
+
+	if (!remaining.empty())
+		camera->metadataAvailable.emit(request, remaining);
+}
+
 /**
  * \brief Cancel request and signal its completion
  * \param[in] request The request to cancel
@@ -836,7 +1083,7 @@ void PipelineHandler::disconnect()
  */
 
 /**
- * \fn PipelineHandler::createIPA()
+ * \fn PipelineHandler::createIPA(uint32_t minVersion, uint32_t maxVersion)
  * \brief Create an IPA proxy that matches this pipeline handler
  * \param[in] minVersion Minimum acceptable version of IPA module
  * \param[in] maxVersion Maximum acceptable version of IPA module
@@ -845,6 +1092,22 @@ void PipelineHandler::disconnect()
  * found or if the IPA proxy fails to initialize
  */
 
+/**
+ * \fn PipelineHandler::createIPA(const char *pipelineName, uint32_t minVersion, uint32_t maxVersion)
+ * \brief Create an IPA proxy that matches another pipeline handler
+ * \param[in] pipelineName The name of the pipeline handler the IPA module is
+ * designed for
+ * \param[in] minVersion Minimum acceptable version of IPA module
+ * \param[in] maxVersion Maximum acceptable version of IPA module
+ *
+ * Some IPA modules are not tied to a pipeline handler but to a processing
+ * component shared by multiple pipeline handlers, such as the software ISP.
+ * This function creates an IPA proxy for such modules.
+ *
+ * \return A newly created IPA proxy, or nullptr if no matching IPA module is
+ * found or if the IPA proxy fails to initialize
+ */
+
 /**
  * \class PipelineHandlerFactoryBase
  * \brief Base class for pipeline handler factories
@@ -7,6 +7,7 @@
 
 #include "libcamera/internal/request.h"
 
+#include <algorithm>
 #include <map>
 #include <sstream>
 
@@ -104,8 +105,9 @@ bool Request::Private::completeBuffer(FrameBuffer *buffer)
 {
 	LIBCAMERA_TRACEPOINT(request_complete_buffer, this, buffer);
 
-	int ret = pending_.erase(buffer);
-	ASSERT(ret == 1);
+	auto it = std::find(pending_.begin(), pending_.end(), buffer);
+	ASSERT(it != pending_.end());
+	pending_.erase(it);
 
 	buffer->_d()->setRequest(nullptr);
 
@@ -149,6 +151,7 @@ void Request::Private::doCancelRequest()
 	pending_.clear();
 	notifiers_.clear();
 	timer_.reset();
+	reportedMetadata_.clear();
 }
 
 /**
@@ -183,6 +186,7 @@ void Request::Private::reset()
 	pending_.clear();
 	notifiers_.clear();
 	timer_.reset();
+	reportedMetadata_.clear();
 }
 
 /*
@@ -191,6 +195,7 @@ void Request::Private::reset()
  */
 void Request::Private::emitPrepareCompleted()
 {
+	prepareTime_ = std::chrono::steady_clock::now();
 	prepared_ = true;
 	prepared.emit();
 }
@@ -381,6 +386,10 @@ Request::~Request()
  * prior to queueing the request to the camera, in lieu of constructing a new
  * request. The application can reuse the buffers that were previously added
  * to the request via addBuffer() by setting \a flags to ReuseBuffers.
+ *
+ * The storage for the buffers, controls and metadata is retained across calls
+ * to this function, so that reusing a request in steady state, with the same
+ * number of buffers and controls, doesn't allocate memory.
  */
 void Request::reuse(ReuseFlag flags)
 {
@@ -391,10 +400,15 @@ void Request::reuse(ReuseFlag flags)
 	if (flags & ReuseBuffers) {
 		for (const auto &[stream, buffer] : bufferMap_) {
 			buffer->_d()->setRequest(this);
-			_d()->pending_.insert(buffer);
+			_d()->pending_.push_back(buffer);
 		}
 	} else {
-		bufferMap_.clear();
+		/*
+		 * Keep the map nodes for reuse by addBuffer(), to avoid memory
+		 * allocations when the request is refilled with new buffers.
+		 */
+		while (!bufferMap_.empty())
+			_d()->spareBufferNodes_.push_back(bufferMap_.extract(bufferMap_.begin()));
 	}
 
 	status_ = RequestPending;
@@ -489,14 +503,25 @@ int Request::addBuffer(const Stream *stream, FrameBuffer *buffer,
 		return -EEXIST;
 	}
 
-	auto [it, inserted] = bufferMap_.try_emplace(stream, buffer);
-	if (!inserted) {
+	if (bufferMap_.find(stream) != bufferMap_.end()) {
 		LOG(Request, Error) << "FrameBuffer already set for stream";
 		return -EEXIST;
 	}
 
+	std::vector<BufferMap::node_type> &spareNodes = _d()->spareBufferNodes_;
+	if (!spareNodes.empty()) {
+		BufferMap::node_type node = std::move(spareNodes.back());
+		spareNodes.pop_back();
+
+		node.key() = stream;
+		node.mapped() = buffer;
+		bufferMap_.insert(std::move(node));
+	} else {
+		bufferMap_.emplace(stream, buffer);
+	}
+
 	buffer->_d()->setRequest(this);
-	_d()->pending_.insert(buffer);
+	_d()->pending_.push_back(buffer);
 
 	if (fence && fence->isValid())
 		buffer->_d()->setFence(std::move(fence));
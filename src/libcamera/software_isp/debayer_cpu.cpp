@@ -1046,10 +1046,6 @@ void DebayerCpu::process(uint32_t frame, FrameBuffer *input, FrameBuffer *output
 {
 	bench_.startFrame();
 
-	std::vector<DmaSyncer> dmaSyncers;
-
-	dmaSyncBegin(dmaSyncers, input, output);
-
 	updateLookupTables(params);
 
 	/* Copy metadata from the input buffer */
@@ -1066,6 +1062,13 @@ void DebayerCpu::process(uint32_t frame, FrameBuffer *input, FrameBuffer *output
 		return;
 	}
 
+	/*
+	 * Synchronize the buffers once for all the threads. The kernel only
+	 * supports synchronizing complete buffers, per-thread synchronization
+	 * would repeat the cache maintenance for each stripe.
+	 */
+	dmaSyncBegin(dmaSyncers_, input, output);
+
 	stats_->startFrame(frame);
 
 	workPendingMutex_.lock();
@@ -1086,7 +1089,8 @@ void DebayerCpu::process(uint32_t frame, FrameBuffer *input, FrameBuffer *output
 
 	metadata.planes()[0].bytesused = out.planes()[0].size();
 
-	dmaSyncers.clear();
+	/* Clearing the vector ends the CPU access and keeps its storage. */
+	dmaSyncers_.clear();
 
 	/* Measure before emitting signals */
 	bench_.finishFrame();
@@ -164,6 +164,7 @@ private:
 	Mutex workPendingMutex_;
 	ConditionVariable workPendingCv_;
 	std::vector<std::unique_ptr<DebayerCpuThread>> threads_;
+	std::vector<DmaSyncer> dmaSyncers_;
 };
 
 } /* namespace libcamera */
@@ -7,6 +7,7 @@
 
 #include "libcamera/internal/v4l2_device.h"
 
+#include <array>
 #include <fcntl.h>
 #include <map>
 #include <stdint.h>
@@ -311,7 +312,23 @@ int V4L2Device::setControls(ControlList *ctrls, const V4L2Request *request)
 	if (ctrls->empty())
 		return 0;
 
-	std::vector<v4l2_ext_control> v4l2Ctrls(ctrls->size());
+	/*
+	 * Avoid a heap allocation for the common case of a small number of
+	 * controls, as this function is called for every frame by pipeline
+	 * handlers.
+	 */
+	static constexpr unsigned int kInlineControls = 16;
+	std::array<v4l2_ext_control, kInlineControls> inlineCtrls;
+	std::vector<v4l2_ext_control> heapCtrls;
+	Span<v4l2_ext_control> v4l2Ctrls;
+
+	if (ctrls->size() <= kInlineControls) {
+		v4l2Ctrls = Span<v4l2_ext_control>(inlineCtrls.data(), ctrls->size());
+	} else {
+		heapCtrls.resize(ctrls->size());
+		v4l2Ctrls = heapCtrls;
+	}
+
 	memset(v4l2Ctrls.data(), 0, sizeof(v4l2_ext_control) * ctrls->size());
 
 	for (auto [ctrl, i] = std::pair(ctrls->begin(), 0u); i < ctrls->size(); ctrl++, i++) {
@@ -417,7 +434,7 @@ int V4L2Device::setControls(ControlList *ctrls, const V4L2Request *request)
 		LOG(V4L2, Error) << "Unable to set control " << utils::hex(id)
 				 << ": " << strerror(-ret);
 
-		v4l2Ctrls.resize(errorIdx);
+		v4l2Ctrls = v4l2Ctrls.first(errorIdx);
 		ret = -EIO;
 	}
 
@@ -0,0 +1,98 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Worker thread for CPU based processing stages
+ */
+
+#include "libcamera/internal/worker_thread.h"
+
+#include <algorithm>
+#include <thread>
+
+/**
+ * \file worker_thread.h
+ * \brief Worker thread for CPU based processing stages
+ */
+
+namespace libcamera {
+
+/**
+ * \class WorkerThread
+ * \brief Thread running jobs queued by a CPU based processing stage
+ *
+ * The WorkerThread class is a building block for processing stages that spread
+ * their work over a pool of threads, such as the software converter or the
+ * MJPEG decoder. Each worker is an Object bound to its own thread, whose member
+ * functions are run asynchronously with queue().
+ *
+ * The worker counts the jobs that have been queued but not run yet, which
+ * allows waitIdle() to wait until all of them have completed, typically before
+ * stopping the thread.
+ */
+
+/**
+ * \brief Construct a WorkerThread
+ * \param[in] name The name of the processing stage
+ * \param[in] index The index of the worker in the pool
+ *
+ * The thread is named after the processing stage and the worker index.
+ */
+WorkerThread::WorkerThread(const std::string &name, unsigned int index)
+	: Thread(name + ":" + std::to_string(index)), index_(index), queued_(0)
+{
+	moveToThread(this);
+}
+
+/**
+ * \brief Retrieve the number of workers to create for a processing stage
+ * \param[in] max The maximum number of workers
+ *
+ * \return The number of hardware threads, bounded to [1, \a max]
+ */
+unsigned int WorkerThread::idealCount(unsigned int max)
+{
+	return std::clamp(std::thread::hardware_concurrency(), 1U, max);
+}
+
+/**
+ * \fn WorkerThread::index()
+ * \brief Retrieve the index of the worker in the pool
+ * \return The worker index
+ */
+
+/**
+ * \fn WorkerThread::queue()
+ * \brief Queue a job to run in the worker thread
+ * \param[in] func The member function of the worker to run
+ * \param[in] args The arguments to pass to \a func
+ *
+ * The job runs asynchronously in the worker thread, after all the jobs queued
+ * previously.
+ */
+
+/**
+ * \brief Wait until all the jobs queued to the worker have completed
+ *
+ * The worker thread shall be running, or this function will wait forever if
+ * jobs are pending.
+ */
+void WorkerThread::waitIdle()
+{
+	MutexLocker locker(mutex_);
+	idle_.wait(locker, [&]() LIBCAMERA_TSA_REQUIRES(mutex_) {
+		return !queued_;
+	});
+}
+
+void WorkerThread::jobDone()
+{
+	{
+		MutexLocker locker(mutex_);
+		queued_--;
+	}
+
+	idle_.notify_all();
+}
+
+} /* namespace libcamera */
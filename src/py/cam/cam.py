@@ -223,9 +223,8 @@ class CameraContext:
         self.camera.stop()
 
     def queue_requests(self):
-        for request in self.requests:
-            self.camera.queue_request(request)
-            self.reqs_queued += 1
+        self.camera.queue_requests(self.requests)
+        self.reqs_queued += len(self.requests)
 
         del self.requests
 
@@ -246,6 +246,28 @@ PYBIND11_MODULE(_libcamera, m)
 			}
 		})
 
+		.def("queue_requests", [](Camera &self, const std::vector<Request *> &reqs) {
+			std::vector<py::object> py_reqs;
+			py_reqs.reserve(reqs.size());
+
+			/*
+			 * Increase the reference counts, will be dropped in
+			 * CameraManager.get_ready_requests().
+			 */
+			for (Request *req : reqs) {
+				py_reqs.push_back(py::cast(req));
+				py_reqs.back().inc_ref();
+			}
+
+			int ret = self.queueRequests(reqs);
+			if (ret) {
+				for (py::object &py_req : py_reqs)
+					py_req.dec_ref();
+				throw std::system_error(-ret, std::generic_category(),
+							"Failed to queue requests");
+			}
+		})
+
 		.def_property_readonly("streams", [](Camera &self) {
 			py::set set;
 			for (auto &s : self.streams()) {
@@ -0,0 +1,253 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * libcamera Camera API tests
+ *
+ * Test synchronised capture from a group of cameras
+ */
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <libcamera/camera.h>
+#include <libcamera/camera_group.h>
+#include <libcamera/camera_manager.h>
+#include <libcamera/framebuffer_allocator.h>
+
+#include "test.h"
+
+using namespace libcamera;
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace {
+
+class CameraGroupTest : public Test
+{
+protected:
+	/* The request cookie stores the index of the camera in the group. */
+	void requeue(Request *request)
+	{
+		if (!capturing_)
+			return;
+
+		request->reuse(Request::ReuseBuffers);
+		cameras_[request->cookie()]->queueRequest(request);
+	}
+
+	void requestSetCompleted(Span<Request *const> requests)
+	{
+		bool complete = true;
+
+		for (Request *request : requests) {
+			if (!request) {
+				complete = false;
+				continue;
+			}
+
+			if (request->status() == Request::RequestCancelled) {
+				cancelledInSets_++;
+				complete = false;
+			}
+		}
+
+		if (!complete) {
+			partialSets_++;
+			return;
+		}
+
+		completeSets_++;
+
+		for (Request *request : requests)
+			requeue(request);
+	}
+
+	void requestDropped(Request *request)
+	{
+		droppedRequests_++;
+
+		if (request->status() == Request::RequestCancelled)
+			return;
+
+		requeue(request);
+	}
+
+	int init() override
+	{
+		cm_ = std::make_unique<CameraManager>();
+		if (cm_->start()) {
+			cout << "Failed to start camera manager" << endl;
+			return TestFail;
+		}
+
+		/*
+		 * Group two virtual cameras when available, to test matching
+		 * frames across cameras, or fall back to a single vimc camera.
+		 */
+		std::shared_ptr<Camera> first = cm_->get("Virtual0");
+		std::shared_ptr<Camera> second = cm_->get("Virtual1");
+		if (first && second) {
+			cameras_ = { first, second };
+		} else {
+			first = cm_->get("platform/vimc.0 Sensor B");
+			if (!first) {
+				cout << "No camera available to group" << endl;
+				return TestSkip;
+			}
+
+			cameras_ = { first };
+		}
+
+		return TestPass;
+	}
+
+	int capture(CameraGroup::DropPolicy policy, unsigned int minSets)
+	{
+		completeSets_ = 0;
+		partialSets_ = 0;
+		droppedRequests_ = 0;
+		cancelledInSets_ = 0;
+
+		group_->setDropPolicy(policy);
+
+		if (group_->start()) {
+			cout << "Failed to start camera group" << endl;
+			return TestFail;
+		}
+
+		capturing_ = true;
+
+		for (std::unique_ptr<Request> &request : requests_) {
+			request->reuse(Request::ReuseBuffers);
+			if (cameras_[request->cookie()]->queueRequest(request.get())) {
+				cout << "Failed to queue request" << endl;
+				return TestFail;
+			}
+		}
+
+		auto deadline = std::chrono::steady_clock::now() + 5s;
+		while (completeSets_ < minSets && std::chrono::steady_clock::now() < deadline)
+			std::this_thread::sleep_for(10ms);
+
+		capturing_ = false;
+
+		if (group_->stop()) {
+			cout << "Failed to stop camera group" << endl;
+			return TestFail;
+		}
+
+		CameraGroup::Statistics stats = group_->statistics();
+
+		if (completeSets_ < minSets || stats.completeSets != completeSets_) {
+			cout << "Failed to capture enough sets (got " << completeSets_
+			     << ")" << endl;
+			return TestFail;
+		}
+
+		if (stats.maxSkew > group_->tolerance()) {
+			cout << "Set skew " << stats.maxSkew.count()
+			     << "ns exceeds tolerance" << endl;
+			return TestFail;
+		}
+
+		if (cancelledInSets_) {
+			cout << "Cancelled requests delivered in sets" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		for (unsigned int i = 0; i < cameras_.size(); ++i) {
+			const std::shared_ptr<Camera> &camera = cameras_[i];
+
+			if (camera->acquire()) {
+				cout << "Failed to acquire camera " << camera->id() << endl;
+				return TestFail;
+			}
+
+			std::unique_ptr<CameraConfiguration> config =
+				camera->generateConfiguration({ StreamRole::Viewfinder });
+			if (!config || camera->configure(config.get())) {
+				cout << "Failed to configure camera " << camera->id() << endl;
+				return TestFail;
+			}
+
+			Stream *stream = config->at(0).stream();
+			auto allocator = std::make_unique<FrameBufferAllocator>(camera);
+			if (allocator->allocate(stream) < 0) {
+				cout << "Failed to allocate buffers" << endl;
+				return TestFail;
+			}
+
+			for (const std::unique_ptr<FrameBuffer> &buffer : allocator->buffers(stream)) {
+				std::unique_ptr<Request> request = camera->createRequest(i);
+				if (!request || request->addBuffer(stream, buffer.get())) {
+					cout << "Failed to create request" << endl;
+					return TestFail;
+				}
+
+				requests_.push_back(std::move(request));
+			}
+
+			allocators_.push_back(std::move(allocator));
+		}
+
+		group_ = std::make_unique<CameraGroup>(cameras_);
+		group_->setTolerance(10ms);
+		group_->requestSetCompleted.connect(this, &CameraGroupTest::requestSetCompleted);
+		group_->requestDropped.connect(this, &CameraGroupTest::requestDropped);
+
+		int ret = capture(CameraGroup::DropPolicy::DropUnmatched, 30);
+		if (ret != TestPass)
+			return ret;
+
+		if (partialSets_) {
+			cout << "Partial sets delivered with the drop policy" << endl;
+			return TestFail;
+		}
+
+		/*
+		 * Requests cancelled when stopping must be returned through
+		 * requestDropped, even when partial sets are delivered.
+		 */
+		return capture(CameraGroup::DropPolicy::DeliverPartial, 10);
+	}
+
+	void cleanup() override
+	{
+		group_.reset();
+		requests_.clear();
+		allocators_.clear();
+
+		for (const std::shared_ptr<Camera> &camera : cameras_)
+			camera->release();
+
+		cameras_.clear();
+		cm_.reset();
+	}
+
+private:
+	std::unique_ptr<CameraManager> cm_;
+	std::vector<std::shared_ptr<Camera>> cameras_;
+	std::vector<std::unique_ptr<FrameBufferAllocator>> allocators_;
+	std::vector<std::unique_ptr<Request>> requests_;
+	std::unique_ptr<CameraGroup> group_;
+
+	std::atomic<bool> capturing_ = false;
+	std::atomic<unsigned int> completeSets_ = 0;
+	std::atomic<unsigned int> partialSets_ = 0;
+	std::atomic<unsigned int> droppedRequests_ = 0;
+	std::atomic<unsigned int> cancelledInSets_ = 0;
+};
+
+} /* namespace */
+
+TEST_REGISTER(CameraGroupTest)
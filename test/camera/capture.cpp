@@ -6,7 +6,9 @@
  */
 
 #include <iostream>
+#include <map>
 
+#include <libcamera/control_ids.h>
 #include <libcamera/framebuffer_allocator.h>
 
 #include <libcamera/base/event_dispatcher.h>
@@ -33,6 +35,8 @@ public:
 protected:
 	unsigned int completeBuffersCount_;
 	unsigned int completeRequestsCount_;
+	unsigned int incompleteMetadataCount_;
+	std::map<Request *, unsigned int> reportedMetadata_;
 
 	void bufferComplete([[maybe_unused]] Request *request,
 			    FrameBuffer *buffer)
@@ -43,6 +47,11 @@ protected:
 		completeBuffersCount_++;
 	}
 
+	void metadataAvailable(Request *request, const ControlList &metadata)
+	{
+		reportedMetadata_[request] += metadata.size();
+	}
+
 	void requestComplete(Request *request)
 	{
 		if (request->status() != Request::RequestComplete)
@@ -50,6 +59,12 @@ protected:
 
 		completeRequestsCount_++;
 
+		/* All metadata must have been reported before completion. */
+		if (reportedMetadata_[request] != request->metadata().size() ||
+		    !request->metadata().contains(controls::SensorTimestamp.id()))
+			incompleteMetadataCount_++;
+		reportedMetadata_.erase(request);
+
 		request->reuse(Request::ReuseBuffers);
 		camera_->queueRequest(request);
 
@@ -75,6 +90,8 @@ protected:
 
 	void cleanup() override
 	{
+		/* Requests may reference the buffers, release them first. */
+		requests_.clear();
 		delete allocator_;
 	}
 
@@ -115,8 +132,10 @@ protected:
 
 		completeRequestsCount_ = 0;
 		completeBuffersCount_ = 0;
+		incompleteMetadataCount_ = 0;
 
 		camera_->bufferCompleted.connect(this, &Capture::bufferComplete);
+		camera_->metadataAvailable.connect(this, &Capture::metadataAvailable);
 		camera_->requestCompleted.connect(this, &Capture::requestComplete);
 
 		if (camera_->start()) {
@@ -153,6 +172,23 @@ protected:
 			return TestFail;
 		}
 
+		if (incompleteMetadataCount_) {
+			cout << "Metadata not fully reported for "
+			     << incompleteMetadataCount_ << " requests" << endl;
+			return TestFail;
+		}
+
+		RequestQueueStatistics stats = camera_->requestQueueStatistics();
+		uint64_t depthCount = 0;
+		for (uint64_t count : stats.depthHistogram)
+			depthCount += count;
+
+		if (stats.queuedRequests < completeRequestsCount_ ||
+		    depthCount != stats.queuedRequests) {
+			cout << "Invalid request queue statistics" << endl;
+			return TestFail;
+		}
+
 		if (camera_->stop()) {
 			cout << "Failed to stop camera" << endl;
 			return TestFail;
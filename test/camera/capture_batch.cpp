@@ -0,0 +1,197 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * libcamera Camera API tests
+ *
+ * Test capture with requests queued in batches
+ */
+
+#include <iostream>
+#include <vector>
+
+#include <libcamera/framebuffer_allocator.h>
+
+#include <libcamera/base/event_dispatcher.h>
+#include <libcamera/base/thread.h>
+#include <libcamera/base/timer.h>
+
+#include "camera_test.h"
+#include "test.h"
+
+using namespace libcamera;
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace {
+
+class CaptureBatch : public CameraTest, public Test
+{
+public:
+	CaptureBatch()
+		: CameraTest("platform/vimc.0 Sensor B")
+	{
+	}
+
+protected:
+	void requestComplete(Request *request)
+	{
+		if (request->status() != Request::RequestComplete)
+			return;
+
+		/* Requests must complete in the order they have been queued. */
+		if (request->cookie() != expectedCookie_)
+			outOfOrder_++;
+
+		expectedCookie_ = (request->cookie() + 1) % requests_.size();
+		completed_.push_back(request);
+
+		dispatcher_->interrupt();
+	}
+
+	int init() override
+	{
+		if (status_ != TestPass)
+			return status_;
+
+		config_ = camera_->generateConfiguration({ StreamRole::VideoRecording });
+		if (!config_ || config_->size() != 1) {
+			cout << "Failed to generate default configuration" << endl;
+			return TestFail;
+		}
+
+		allocator_ = std::make_unique<FrameBufferAllocator>(camera_);
+		dispatcher_ = Thread::current()->eventDispatcher();
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		if (camera_->acquire()) {
+			cout << "Failed to acquire the camera" << endl;
+			return TestFail;
+		}
+
+		if (camera_->configure(config_.get())) {
+			cout << "Failed to set default configuration" << endl;
+			return TestFail;
+		}
+
+		Stream *stream = config_->at(0).stream();
+		if (allocator_->allocate(stream) < 0) {
+			cout << "Failed to allocate buffers" << endl;
+			return TestFail;
+		}
+
+		const auto &buffers = allocator_->buffers(stream);
+		if (buffers.size() < 2) {
+			cout << "Not enough buffers for a batch" << endl;
+			return TestFail;
+		}
+
+		for (unsigned int i = 0; i < buffers.size(); ++i) {
+			std::unique_ptr<Request> request = camera_->createRequest(i);
+			if (!request) {
+				cout << "Failed to create request" << endl;
+				return TestFail;
+			}
+
+			if (request->addBuffer(stream, buffers[i].get())) {
+				cout << "Failed to associate buffer with request" << endl;
+				return TestFail;
+			}
+
+			requests_.push_back(std::move(request));
+		}
+
+		camera_->requestCompleted.connect(this, &CaptureBatch::requestComplete);
+
+		if (camera_->start()) {
+			cout << "Failed to start camera" << endl;
+			return TestFail;
+		}
+
+		std::vector<Request *> batch;
+		for (std::unique_ptr<Request> &request : requests_)
+			batch.push_back(request.get());
+
+		/* A batch containing the same request twice must be rejected. */
+		std::vector<Request *> duplicated = { batch[0], batch[1], batch[0] };
+		if (camera_->queueRequests(duplicated) != -EINVAL) {
+			cout << "Batch with a duplicated request not rejected" << endl;
+			return TestFail;
+		}
+
+		if (camera_->queueRequests(batch)) {
+			cout << "Failed to queue requests" << endl;
+			return TestFail;
+		}
+
+		/*
+		 * Requeue the completed requests in batches, for a total of
+		 * three rounds over all the requests.
+		 */
+		unsigned int nFrames = requests_.size() * 3;
+		unsigned int requeued = requests_.size();
+
+		Timer timer;
+		timer.start(500ms * nFrames);
+		while (timer.isRunning() && completedCount_ < nFrames) {
+			dispatcher_->processEvents();
+
+			batch.clear();
+			for (Request *request : completed_) {
+				if (requeued >= nFrames)
+					break;
+
+				request->reuse(Request::ReuseBuffers);
+				batch.push_back(request);
+				requeued++;
+			}
+
+			completedCount_ += completed_.size();
+			completed_.clear();
+
+			if (!batch.empty() && camera_->queueRequests(batch)) {
+				cout << "Failed to requeue requests" << endl;
+				return TestFail;
+			}
+		}
+
+		if (camera_->stop()) {
+			cout << "Failed to stop camera" << endl;
+			return TestFail;
+		}
+
+		if (completedCount_ < nFrames) {
+			cout << "Failed to capture enough frames (got " << completedCount_
+			     << " expected " << nFrames << ")" << endl;
+			return TestFail;
+		}
+
+		if (outOfOrder_) {
+			cout << outOfOrder_ << " requests completed out of order"
+			     << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+private:
+	EventDispatcher *dispatcher_;
+
+	std::unique_ptr<CameraConfiguration> config_;
+	std::unique_ptr<FrameBufferAllocator> allocator_;
+	std::vector<std::unique_ptr<Request>> requests_;
+
+	std::vector<Request *> completed_;
+	unsigned int completedCount_ = 0;
+	uint64_t expectedCookie_ = 0;
+	unsigned int outOfOrder_ = 0;
+};
+
+} /* namespace */
+
+TEST_REGISTER(CaptureBatch)
@@ -0,0 +1,196 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * libcamera Camera API tests
+ *
+ * Test the control sequence metadata
+ */
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <libcamera/camera.h>
+#include <libcamera/camera_manager.h>
+#include <libcamera/control_ids.h>
+#include <libcamera/framebuffer_allocator.h>
+
+#include <libcamera/base/event_dispatcher.h>
+#include <libcamera/base/thread.h>
+#include <libcamera/base/timer.h>
+
+#include "test.h"
+
+using namespace libcamera;
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace {
+
+class ControlSequenceTest : public Test
+{
+protected:
+	void requestComplete([[maybe_unused]] Request *request)
+	{
+		completed_++;
+		dispatcher_->interrupt();
+	}
+
+	int init() override
+	{
+		cm_ = std::make_unique<CameraManager>();
+		if (cm_->start()) {
+			cout << "Failed to start camera manager" << endl;
+			return TestFail;
+		}
+
+		/*
+		 * The paced virtual camera reports the sequence at which frame
+		 * duration changes take effect.
+		 */
+		camera_ = cm_->get("Virtual5");
+		if (!camera_) {
+			cout << "Virtual paced camera not available" << endl;
+			return TestSkip;
+		}
+
+		dispatcher_ = Thread::current()->eventDispatcher();
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		if (camera_->acquire()) {
+			cout << "Failed to acquire the camera" << endl;
+			return TestFail;
+		}
+
+		std::unique_ptr<CameraConfiguration> config =
+			camera_->generateConfiguration({ StreamRole::Viewfinder });
+		if (!config || camera_->configure(config.get())) {
+			cout << "Failed to configure the camera" << endl;
+			return TestFail;
+		}
+
+		Stream *stream = config->at(0).stream();
+		FrameBufferAllocator allocator(camera_);
+		if (allocator.allocate(stream) < 0) {
+			cout << "Failed to allocate buffers" << endl;
+			return TestFail;
+		}
+
+		std::vector<std::unique_ptr<Request>> requests;
+		for (const std::unique_ptr<FrameBuffer> &buffer : allocator.buffers(stream)) {
+			std::unique_ptr<Request> request = camera_->createRequest();
+			if (!request || request->addBuffer(stream, buffer.get())) {
+				cout << "Failed to create request" << endl;
+				return TestFail;
+			}
+
+			requests.push_back(std::move(request));
+		}
+
+		if (requests.size() < 3) {
+			cout << "Not enough buffers" << endl;
+			return TestFail;
+		}
+
+		/* Change the frame duration with the second request only. */
+		const ControlInfoMap &infoMap = camera_->controls();
+		auto it = infoMap.find(&controls::FrameDurationLimits);
+		if (it == infoMap.end()) {
+			cout << "Frame duration limits not supported" << endl;
+			return TestFail;
+		}
+
+		int64_t duration = it->second.max().get<int64_t>();
+		requests[1]->controls().set(controls::FrameDurationLimits,
+					    { duration, duration });
+
+		camera_->requestCompleted.connect(this, &ControlSequenceTest::requestComplete);
+
+		if (camera_->start()) {
+			cout << "Failed to start camera" << endl;
+			return TestFail;
+		}
+
+		for (const std::unique_ptr<Request> &request : requests) {
+			if (camera_->queueRequest(request.get())) {
+				cout << "Failed to queue request" << endl;
+				return TestFail;
+			}
+		}
+
+		Timer timer;
+		timer.start(500ms * requests.size());
+		while (timer.isRunning() && completed_ < requests.size())
+			dispatcher_->processEvents();
+
+		if (camera_->stop()) {
+			cout << "Failed to stop camera" << endl;
+			return TestFail;
+		}
+
+		if (completed_ < requests.size()) {
+			cout << "Only " << completed_ << " of " << requests.size()
+			     << " requests completed" << endl;
+			return TestFail;
+		}
+
+		/* Only the request that changes the frame duration reports it. */
+		for (unsigned int i = 0; i < requests.size(); ++i) {
+			const ControlList &metadata = requests[i]->metadata();
+			if (i != 1 && metadata.contains(controls::SensorControlsSequence.id())) {
+				cout << "Unexpected sensor controls sequence for request "
+				     << i << endl;
+				return TestFail;
+			}
+		}
+
+		Request *request = requests[1].get();
+		if (request->status() != Request::RequestComplete) {
+			cout << "Request with sensor controls not completed" << endl;
+			return TestFail;
+		}
+
+		const auto sequence = request->metadata().get(controls::SensorControlsSequence);
+		if (!sequence) {
+			cout << "Sensor controls sequence not reported" << endl;
+			return TestFail;
+		}
+
+		const FrameBuffer *buffer = request->buffers().begin()->second;
+		if (*sequence < buffer->metadata().sequence) {
+			cout << "Sensor controls sequence " << *sequence
+			     << " precedes the frame " << buffer->metadata().sequence
+			     << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	void cleanup() override
+	{
+		if (camera_) {
+			camera_->release();
+			camera_.reset();
+		}
+
+		cm_.reset();
+	}
+
+private:
+	std::unique_ptr<CameraManager> cm_;
+	std::shared_ptr<Camera> camera_;
+	EventDispatcher *dispatcher_;
+
+	std::atomic<unsigned int> completed_ = 0;
+};
+
+} /* namespace */
+
+TEST_REGISTER(ControlSequenceTest)
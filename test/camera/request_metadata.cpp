@@ -0,0 +1,175 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * libcamera Camera API tests
+ *
+ * Test that reused requests report their metadata again
+ */
+
+#include <iostream>
+#include <set>
+
+#include <libcamera/control_ids.h>
+#include <libcamera/framebuffer_allocator.h>
+
+#include <libcamera/base/event_dispatcher.h>
+#include <libcamera/base/thread.h>
+#include <libcamera/base/timer.h>
+
+#include "camera_test.h"
+#include "test.h"
+
+using namespace libcamera;
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace {
+
+class RequestMetadataTest : public CameraTest, public Test
+{
+public:
+	RequestMetadataTest()
+		: CameraTest("platform/vimc.0 Sensor B")
+	{
+	}
+
+protected:
+	void metadataAvailable([[maybe_unused]] Request *request,
+			       const ControlList &metadata)
+	{
+		signals_++;
+
+		for (const auto &[id, value] : metadata)
+			reported_.insert(id);
+	}
+
+	void requestComplete(Request *request)
+	{
+		if (request->status() != Request::RequestComplete)
+			return;
+
+		/*
+		 * Every cycle must report all the metadata of the request
+		 * through the metadataAvailable signal.
+		 */
+		std::set<unsigned int> ids;
+		for (const auto &[id, value] : request->metadata())
+			ids.insert(id);
+
+		if (!signals_ || ids != reported_ ||
+		    !ids.count(controls::SensorTimestamp.id()))
+			failures_++;
+
+		signals_ = 0;
+		reported_.clear();
+		cycles_++;
+
+		if (cycles_ < kCycles) {
+			request->reuse(Request::ReuseBuffers);
+			camera_->queueRequest(request);
+		}
+
+		dispatcher_->interrupt();
+	}
+
+	int init() override
+	{
+		if (status_ != TestPass)
+			return status_;
+
+		config_ = camera_->generateConfiguration({ StreamRole::VideoRecording });
+		if (!config_ || config_->size() != 1) {
+			cout << "Failed to generate default configuration" << endl;
+			return TestFail;
+		}
+
+		dispatcher_ = Thread::current()->eventDispatcher();
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		if (camera_->acquire()) {
+			cout << "Failed to acquire the camera" << endl;
+			return TestFail;
+		}
+
+		if (camera_->configure(config_.get())) {
+			cout << "Failed to set default configuration" << endl;
+			return TestFail;
+		}
+
+		Stream *stream = config_->at(0).stream();
+		FrameBufferAllocator allocator(camera_);
+		if (allocator.allocate(stream) < 0) {
+			cout << "Failed to allocate buffers" << endl;
+			return TestFail;
+		}
+
+		/* Use a single request, to reuse it on every cycle. */
+		std::unique_ptr<Request> request = camera_->createRequest();
+		if (!request) {
+			cout << "Failed to create request" << endl;
+			return TestFail;
+		}
+
+		if (request->addBuffer(stream, allocator.buffers(stream)[0].get())) {
+			cout << "Failed to associate buffer with request" << endl;
+			return TestFail;
+		}
+
+		camera_->metadataAvailable.connect(this, &RequestMetadataTest::metadataAvailable);
+		camera_->requestCompleted.connect(this, &RequestMetadataTest::requestComplete);
+
+		if (camera_->start()) {
+			cout << "Failed to start camera" << endl;
+			return TestFail;
+		}
+
+		if (camera_->queueRequest(request.get())) {
+			cout << "Failed to queue request" << endl;
+			return TestFail;
+		}
+
+		Timer timer;
+		timer.start(500ms * kCycles);
+		while (timer.isRunning() && cycles_ < kCycles)
+			dispatcher_->processEvents();
+
+		if (camera_->stop()) {
+			cout << "Failed to stop camera" << endl;
+			return TestFail;
+		}
+
+		if (cycles_ < kCycles) {
+			cout << "Only " << cycles_ << " of " << kCycles
+			     << " cycles completed" << endl;
+			return TestFail;
+		}
+
+		if (failures_) {
+			cout << "Metadata not reported again for " << failures_
+			     << " reused requests" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+private:
+	static constexpr unsigned int kCycles = 5;
+
+	EventDispatcher *dispatcher_;
+	std::unique_ptr<CameraConfiguration> config_;
+
+	unsigned int cycles_ = 0;
+	unsigned int failures_ = 0;
+	unsigned int signals_ = 0;
+	std::set<unsigned int> reported_;
+};
+
+} /* namespace */
+
+TEST_REGISTER(RequestMetadataTest)
@@ -0,0 +1,233 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * libcamera Camera API tests
+ *
+ * Test that reusing requests doesn't allocate memory
+ */
+
+#include <atomic>
+#include <iostream>
+#include <new>
+#include <stdlib.h>
+#include <utility>
+#include <vector>
+
+#include <libcamera/control_ids.h>
+#include <libcamera/framebuffer_allocator.h>
+
+#include <libcamera/base/event_dispatcher.h>
+#include <libcamera/base/thread.h>
+#include <libcamera/base/timer.h>
+
+#include "camera_test.h"
+#include "test.h"
+
+using namespace libcamera;
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace {
+
+/*
+ * Only count the allocations performed by the thread that refills the
+ * request, the camera manager thread allocates for its own needs.
+ */
+thread_local bool countAllocations = false;
+std::atomic<unsigned int> allocations = 0;
+
+} /* namespace */
+
+void *operator new(size_t size)
+{
+	if (countAllocations)
+		allocations++;
+
+	void *ptr = malloc(size ? size : 1);
+	if (!ptr)
+		throw std::bad_alloc();
+
+	return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void *ptr, [[maybe_unused]] size_t size) noexcept
+{
+	free(ptr);
+}
+
+namespace {
+
+class RequestReuseTest : public CameraTest, public Test
+{
+public:
+	RequestReuseTest()
+		: CameraTest("platform/vimc.0 Sensor B")
+	{
+	}
+
+protected:
+	void requestComplete(Request *request)
+	{
+		if (request->status() != Request::RequestComplete) {
+			failures_++;
+			return;
+		}
+
+		if (!request->metadata().contains(controls::SensorTimestamp.id()))
+			failures_++;
+
+		cycles_++;
+		if (cycles_ >= 2 * kCycles) {
+			dispatcher_->interrupt();
+			return;
+		}
+
+		/*
+		 * Cycle through both reuse modes, and count the allocations
+		 * performed to refill the request once it has reached its
+		 * steady state capacity. Queueing the request posts a message
+		 * to the pipeline handler, which allocates, and is thus left
+		 * out.
+		 */
+		Request::ReuseFlag flags = cycles_ < kCycles
+					 ? Request::Default
+					 : Request::ReuseBuffers;
+		countAllocations = cycles_ % kCycles >= kWarmupCycles;
+
+		request->reuse(flags);
+
+		if (!(flags & Request::ReuseBuffers) &&
+		    request->addBuffer(stream_, buffer_))
+			failures_++;
+
+		for (const auto &[id, value] : controls_)
+			request->controls().set(id, value);
+
+		countAllocations = false;
+
+		if (camera_->queueRequest(request))
+			failures_++;
+	}
+
+	int init() override
+	{
+		if (status_ != TestPass)
+			return status_;
+
+		config_ = camera_->generateConfiguration({ StreamRole::VideoRecording });
+		if (!config_ || config_->size() != 1) {
+			cout << "Failed to generate default configuration" << endl;
+			return TestFail;
+		}
+
+		dispatcher_ = Thread::current()->eventDispatcher();
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		if (camera_->acquire()) {
+			cout << "Failed to acquire the camera" << endl;
+			return TestFail;
+		}
+
+		if (camera_->configure(config_.get())) {
+			cout << "Failed to set default configuration" << endl;
+			return TestFail;
+		}
+
+		stream_ = config_->at(0).stream();
+		FrameBufferAllocator allocator(camera_);
+		if (allocator.allocate(stream_) < 0) {
+			cout << "Failed to allocate buffers" << endl;
+			return TestFail;
+		}
+
+		/* Fill requests with a few of the controls the camera supports. */
+		for (const auto &[id, info] : camera_->controls()) {
+			if (info.def().isNone() || info.def().isArray())
+				continue;
+
+			controls_.emplace_back(id->id(), info.def());
+			if (controls_.size() == 4)
+				break;
+		}
+
+		buffer_ = allocator.buffers(stream_)[0].get();
+		std::unique_ptr<Request> request = camera_->createRequest();
+		if (!request) {
+			cout << "Failed to create request" << endl;
+			return TestFail;
+		}
+
+		if (request->addBuffer(stream_, buffer_)) {
+			cout << "Failed to add buffer to request" << endl;
+			return TestFail;
+		}
+
+		camera_->requestCompleted.connect(this, &RequestReuseTest::requestComplete);
+
+		if (camera_->start()) {
+			cout << "Failed to start camera" << endl;
+			return TestFail;
+		}
+
+		if (camera_->queueRequest(request.get())) {
+			cout << "Failed to queue request" << endl;
+			return TestFail;
+		}
+
+		Timer timer;
+		timer.start(100ms * 2 * kCycles);
+		while (timer.isRunning() && cycles_ < 2 * kCycles)
+			dispatcher_->processEvents();
+
+		if (camera_->stop()) {
+			cout << "Failed to stop camera" << endl;
+			return TestFail;
+		}
+
+		if (cycles_ < 2 * kCycles) {
+			cout << "Only " << cycles_ << " of " << 2 * kCycles
+			     << " cycles completed" << endl;
+			return TestFail;
+		}
+
+		if (failures_) {
+			cout << failures_ << " cycles failed" << endl;
+			return TestFail;
+		}
+
+		if (allocations) {
+			cout << allocations << " allocations when reusing requests"
+			     << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+private:
+	static constexpr unsigned int kCycles = 30;
+	static constexpr unsigned int kWarmupCycles = 2;
+
+	EventDispatcher *dispatcher_;
+	std::unique_ptr<CameraConfiguration> config_;
+	Stream *stream_;
+	FrameBuffer *buffer_;
+	std::vector<std::pair<unsigned int, ControlValue>> controls_;
+
+	std::atomic<unsigned int> cycles_ = 0;
+	unsigned int failures_ = 0;
+};
+
+} /* namespace */
+
+TEST_REGISTER(RequestReuseTest)
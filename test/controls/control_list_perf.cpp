@@ -0,0 +1,195 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * ControlList storage tests and microbenchmark
+ */
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <libcamera/control_ids.h>
+#include <libcamera/controls.h>
+
+#include "test.h"
+
+using namespace std;
+using namespace libcamera;
+
+class ControlListPerfTest : public Test
+{
+protected:
+	int init() override
+	{
+		for (const auto &[id, control] : controls::controls) {
+			if (control->type() == ControlTypeInteger32 &&
+			    !control->isArray())
+				ids_.push_back(id);
+		}
+
+		if (ids_.size() < 16) {
+			cout << "Not enough integer controls" << endl;
+			return TestSkip;
+		}
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		int ret = testMerge();
+		if (ret != TestPass)
+			return ret;
+
+		return benchmark();
+	}
+
+private:
+	/* Fill a list and a reference map with a random subset of controls. */
+	void fill(ControlList &list, std::map<unsigned int, int32_t> &ref,
+		  std::mt19937 &gen)
+	{
+		std::uniform_int_distribution<unsigned int> coin(0, 2);
+
+		for (unsigned int id : ids_) {
+			if (coin(gen))
+				continue;
+
+			int32_t value = gen();
+			list.set(id, ControlValue(value));
+			ref[id] = value;
+		}
+	}
+
+	bool check(const ControlList &list, const std::map<unsigned int, int32_t> &ref)
+	{
+		if (list.size() != ref.size())
+			return false;
+
+		auto iter = list.begin();
+		for (const auto &[id, value] : ref) {
+			if (iter->first != id || iter->second.get<int32_t>() != value)
+				return false;
+			++iter;
+		}
+
+		return true;
+	}
+
+	int testMerge()
+	{
+		std::mt19937 gen(42);
+
+		for (unsigned int i = 0; i < 1000; ++i) {
+			ControlList list(controls::controls);
+			ControlList source(controls::controls);
+			std::map<unsigned int, int32_t> ref;
+			std::map<unsigned int, int32_t> sourceRef;
+
+			fill(list, ref, gen);
+			fill(source, sourceRef, gen);
+
+			list.merge(source, ControlList::MergePolicy::OverwriteExisting);
+
+			for (const auto &[id, value] : sourceRef)
+				ref[id] = value;
+
+			if (!check(list, ref)) {
+				cout << "Merged list doesn't match reference" << endl;
+				return TestFail;
+			}
+		}
+
+		/* Existing controls must be kept with the default policy. */
+		ControlList list(controls::controls);
+		ControlList source(controls::controls);
+
+		list.set(ids_[0], ControlValue(0));
+		list.set(ids_[2], ControlValue(2));
+		source.set(ids_[1], ControlValue(10));
+		source.set(ids_[2], ControlValue(12));
+		source.set(ids_[3], ControlValue(13));
+
+		list.merge(source);
+
+		std::map<unsigned int, int32_t> ref = {
+			{ ids_[0], 0 }, { ids_[1], 10 }, { ids_[2], 2 }, { ids_[3], 13 },
+		};
+		if (!check(list, ref)) {
+			cout << "Merged list doesn't keep existing controls" << endl;
+			return TestFail;
+		}
+
+		/* Values can be modified through iterators, control IDs can't. */
+		static_assert(std::is_same_v<decltype(*list.begin()),
+					     std::pair<const unsigned int, ControlValue> &>);
+
+		for (auto &[id, value] : list) {
+			value = ControlValue(static_cast<int32_t>(id));
+			ref[id] = id;
+		}
+
+		/* Copying over a populated list replaces all its controls. */
+		ControlList copy(controls::controls);
+		std::map<unsigned int, int32_t> copyRef;
+		fill(copy, copyRef, gen);
+
+		copy = list;
+		if (!check(copy, ref)) {
+			cout << "Copied list doesn't match reference" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int benchmark()
+	{
+		constexpr unsigned int kIterations = 10000;
+
+		ControlList metadata(controls::controls);
+		for (unsigned int id : ids_)
+			metadata.set(id, ControlValue(static_cast<int32_t>(id)));
+
+		/*
+		 * Emulate the per-frame metadata handling of pipeline handlers:
+		 * fill a list, merge it in the request metadata and copy it.
+		 */
+		ControlList requestMetadata(controls::controls);
+
+		auto start = chrono::steady_clock::now();
+
+		for (unsigned int i = 0; i < kIterations; ++i) {
+			ControlList frameMetadata(controls::controls);
+			for (unsigned int id : ids_)
+				frameMetadata.set(id, ControlValue(static_cast<int32_t>(i)));
+
+			requestMetadata.clear();
+			requestMetadata.merge(metadata);
+			requestMetadata.merge(frameMetadata,
+					      ControlList::MergePolicy::OverwriteExisting);
+
+			ControlList copy = requestMetadata;
+			if (copy.size() != ids_.size())
+				return TestFail;
+		}
+
+		auto duration = chrono::steady_clock::now() - start;
+
+		cout << "Fill, merge and copy of " << ids_.size()
+		     << " controls: "
+		     << chrono::duration_cast<chrono::nanoseconds>(duration).count() / kIterations
+		     << "ns" << endl;
+
+		return TestPass;
+	}
+
+	std::vector<unsigned int> ids_;
+};
+
+TEST_REGISTER(ControlListPerfTest)
@@ -5,7 +5,10 @@
  * libcamera delayed controls test
  */
 
+#include <atomic>
 #include <iostream>
+#include <new>
+#include <stdlib.h>
 
 #include "libcamera/internal/delayed_controls.h"
 #include "libcamera/internal/device_enumerator.h"
@@ -17,6 +20,35 @@
 using namespace std;
 using namespace libcamera;
 
+namespace {
+
+std::atomic<bool> countAllocations = false;
+std::atomic<unsigned int> allocations = 0;
+
+} /* namespace */
+
+void *operator new(size_t size)
+{
+	if (countAllocations)
+		allocations++;
+
+	void *ptr = malloc(size ? size : 1);
+	if (!ptr)
+		throw std::bad_alloc();
+
+	return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void *ptr, [[maybe_unused]] size_t size) noexcept
+{
+	free(ptr);
+}
+
 class DelayedControlsTest : public Test
 {
 public:
@@ -267,6 +299,50 @@ protected:
 		return TestPass;
 	}
 
+	int readBackWithoutAllocation()
+	{
+		std::unordered_map<uint32_t, DelayedControls::ControlParams> delays = {
+			{ V4L2_CID_BRIGHTNESS, { 1, false } },
+			{ V4L2_CID_CONTRAST, { 2, false } },
+		};
+		std::unique_ptr<DelayedControls> delayed =
+			std::make_unique<DelayedControls>(dev_.get(), delays);
+		ControlList ctrls;
+
+		ctrls.set(V4L2_CID_BRIGHTNESS, 100);
+		ctrls.set(V4L2_CID_CONTRAST, 101);
+		dev_->setControls(&ctrls);
+		delayed->reset();
+
+		for (unsigned int i = 0; i < 16; i++)
+			delayed->push(ctrls);
+
+		/* Reading back controls is performed on every frame. */
+		allocations = 0;
+		countAllocations = true;
+
+		int32_t sum = 0;
+		for (unsigned int i = 0; i < 16; i++) {
+			const ControlList &result = delayed->get(i);
+			sum += result.get(V4L2_CID_BRIGHTNESS).get<int32_t>();
+		}
+
+		countAllocations = false;
+
+		if (allocations) {
+			cerr << "Reading back controls caused " << allocations
+			     << " allocations" << endl;
+			return TestFail;
+		}
+
+		if (sum != 16 * 100) {
+			cerr << "Failed to read back controls" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
 	int run() override
 	{
 		int ret;
@@ -291,6 +367,11 @@ protected:
 		if (ret)
 			return ret;
 
+		/* Test reading back controls without memory allocation. */
+		ret = readBackWithoutAllocation();
+		if (ret)
+			return ret;
+
 		return TestPass;
 	}
 
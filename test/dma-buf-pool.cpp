@@ -0,0 +1,122 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * DmaBufPool tests
+ */
+
+#include <iostream>
+
+#include <libcamera/base/memfd.h>
+#include <libcamera/base/shared_fd.h>
+
+#include "libcamera/internal/dma_buf_allocator.h"
+
+#include "test.h"
+
+using namespace std;
+using namespace libcamera;
+
+class DmaBufPoolTest : public Test
+{
+protected:
+	int run() override
+	{
+		using Type = DmaBufAllocator::DmaBufAllocatorFlag;
+
+		/* Size classes must be large enough and bound the overhead. */
+		for (size_t size : { 1UL, 4096UL, 100000UL, 640 * 480 * 2UL,
+				     1920 * 1080 * 3 / 2UL, 4096 * 3072 * 2UL }) {
+			size_t sizeClass = DmaBufPool::sizeClass(size);
+			if (sizeClass < size || (size > 65536 && sizeClass > size * 9 / 8)) {
+				cerr << "Invalid size class " << sizeClass
+				     << " for size " << size << endl;
+				return TestFail;
+			}
+		}
+
+		if (DmaBufPool::sizeClass(4096 * 3072 * 2UL) % (2 << 20)) {
+			cerr << "Large size class isn't aligned to huge pages" << endl;
+			return TestFail;
+		}
+
+		/*
+		 * Memfds stand in for dma-bufs, as the pool doesn't access the
+		 * buffers it manages.
+		 */
+		DmaBufPool pool;
+		pool.setMaxSize(3 * kSize);
+
+		SharedFD fd = pool.acquire(Type::UDmaBuf, kSize, allocate_);
+		if (!fd.isValid() || allocations_ != 1) {
+			cerr << "Failed to acquire buffer from empty pool" << endl;
+			return TestFail;
+		}
+
+		int fdNum = fd.get();
+		pool.release(Type::UDmaBuf, kSize, std::move(fd));
+
+		/* A different provider type or size must not reuse the buffer. */
+		SharedFD other = pool.acquire(Type::CmaHeap, kSize, allocate_);
+		SharedFD larger = pool.acquire(Type::UDmaBuf, 2 * kSize, allocate_);
+		if (allocations_ != 3) {
+			cerr << "Buffer reused for incompatible allocation" << endl;
+			return TestFail;
+		}
+
+		fd = pool.acquire(Type::UDmaBuf, kSize, allocate_);
+		if (allocations_ != 3 || fd.get() != fdNum) {
+			cerr << "Released buffer not reused" << endl;
+			return TestFail;
+		}
+
+		DmaBufPool::Statistics stats = pool.statistics();
+		if (stats.hits != 1 || stats.misses != 3 ||
+		    stats.usedSize != 4 * kSize || stats.pooledSize != 0) {
+			cerr << "Invalid statistics after acquisition" << endl;
+			return TestFail;
+		}
+
+		/* Releasing more than the maximum size evicts the oldest buffers. */
+		pool.release(Type::UDmaBuf, kSize, std::move(fd));
+		pool.release(Type::CmaHeap, kSize, std::move(other));
+		pool.release(Type::UDmaBuf, 2 * kSize, std::move(larger));
+
+		stats = pool.statistics();
+		if (stats.evictions != 1 || stats.pooledSize != 3 * kSize ||
+		    stats.usedSize != 0) {
+			cerr << "Invalid statistics after release" << endl;
+			return TestFail;
+		}
+
+		fd = pool.acquire(Type::UDmaBuf, kSize, allocate_);
+		if (allocations_ != 4) {
+			cerr << "Evicted buffer reused" << endl;
+			return TestFail;
+		}
+
+		pool.release(Type::UDmaBuf, kSize, std::move(fd));
+
+		/* Disabling the pool frees all idle buffers. */
+		pool.setMaxSize(0);
+
+		stats = pool.statistics();
+		if (stats.pooledSize != 0) {
+			cerr << "Idle buffers kept in disabled pool" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+private:
+	static constexpr size_t kSize = 1 << 20;
+
+	unsigned int allocations_ = 0;
+	DmaBufPool::Allocator allocate_ = [this](size_t size) {
+		allocations_++;
+		return MemFd::create("dma-buf-pool-test", size);
+	};
+};
+
+TEST_REGISTER(DmaBufPoolTest)
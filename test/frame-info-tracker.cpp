@@ -0,0 +1,166 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * FrameInfoTracker tests
+ */
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <libcamera/framebuffer.h>
+
+#include "libcamera/internal/frame_info_tracker.h"
+
+#include "test.h"
+
+using namespace std;
+using namespace libcamera;
+
+struct TestFrameInfo {
+	unsigned int frame;
+	FrameBuffer *buffer;
+	bool done;
+};
+
+class FrameInfoTrackerTest : public Test
+{
+protected:
+	int init() override
+	{
+		for (unsigned int i = 0; i < 64; ++i)
+			buffers_.push_back(std::make_unique<FrameBuffer>(Span<const FrameBuffer::Plane>{}));
+
+		return TestPass;
+	}
+
+	int testIndex()
+	{
+		FrameInfoIndex index;
+		index.reserve(4);
+
+		/* Insert enough keys to force the index to grow. */
+		for (uint64_t key = 1; key <= 1000; ++key)
+			index.insert(key * 4096, key);
+
+		if (index.size() != 1000) {
+			cerr << "Invalid index size " << index.size() << endl;
+			return TestFail;
+		}
+
+		/* Erase every other key and check the remaining ones. */
+		for (uint64_t key = 1; key <= 1000; key += 2)
+			index.erase(key * 4096);
+
+		for (uint64_t key = 1; key <= 1000; ++key) {
+			unsigned int expected = key % 2 ? FrameInfoIndex::kInvalid : key;
+			if (index.find(key * 4096) != expected) {
+				cerr << "Invalid lookup result for key " << key << endl;
+				return TestFail;
+			}
+		}
+
+		index.insert(2 * 4096, 42);
+		if (index.find(2 * 4096) != 42 || index.size() != 500) {
+			cerr << "Failed to replace index entry" << endl;
+			return TestFail;
+		}
+
+		index.clear();
+		if (index.size() != 0 || index.find(2 * 4096) != FrameInfoIndex::kInvalid) {
+			cerr << "Failed to clear index" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int testTracker()
+	{
+		FrameInfoTracker<TestFrameInfo> tracker([](const TestFrameInfo &info) {
+			return info.done;
+		});
+		tracker.reserve(4);
+
+		/* Cycle frames through the tracker, with up to 8 in flight. */
+		for (unsigned int frame = 0; frame < 1000; ++frame) {
+			FrameBuffer *buffer = buffers_[frame % buffers_.size()].get();
+
+			TestFrameInfo *info = tracker.create(frame, nullptr);
+			if (!info || info->done) {
+				cerr << "Failed to create frame " << frame << endl;
+				return TestFail;
+			}
+
+			info->frame = frame;
+			info->buffer = buffer;
+			tracker.addBuffer(frame, buffer);
+
+			if (tracker.find(buffer) != info || tracker.find(frame) != info) {
+				cerr << "Failed to find frame " << frame << endl;
+				return TestFail;
+			}
+
+			if (frame < 8)
+				continue;
+
+			unsigned int old = frame - 8;
+			TestFrameInfo *oldInfo = tracker.find(old);
+			if (!oldInfo || oldInfo->frame != old) {
+				cerr << "Failed to find frame " << old << endl;
+				return TestFail;
+			}
+
+			if (tracker.tryComplete(old)) {
+				cerr << "Frame " << old << " completed too early" << endl;
+				return TestFail;
+			}
+
+			oldInfo->done = true;
+			if (!tracker.tryComplete(old) || tracker.find(old)) {
+				cerr << "Failed to complete frame " << old << endl;
+				return TestFail;
+			}
+		}
+
+		if (tracker.size() != 8) {
+			cerr << "Invalid tracker size " << tracker.size() << endl;
+			return TestFail;
+		}
+
+		unsigned int count = 0;
+		tracker.forEach([&count](TestFrameInfo &) { count++; });
+		if (count != 8) {
+			cerr << "Invalid number of frames iterated" << endl;
+			return TestFail;
+		}
+
+		if (!tracker.remove(999) || tracker.remove(999) || tracker.find(999)) {
+			cerr << "Failed to remove frame" << endl;
+			return TestFail;
+		}
+
+		tracker.clear();
+		if (!tracker.empty() || tracker.find(buffers_[0].get())) {
+			cerr << "Failed to clear tracker" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		int ret = testIndex();
+		if (ret != TestPass)
+			return ret;
+
+		return testTracker();
+	}
+
+private:
+	std::vector<std::unique_ptr<FrameBuffer>> buffers_;
+};
+
+TEST_REGISTER(FrameInfoTrackerTest)
@@ -0,0 +1,230 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Test the IPA module cache and measure the IPA module scan time it saves
+ */
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <libcamera/base/file.h>
+
+#include "libcamera/internal/ipa_manager.h"
+#include "libcamera/internal/ipa_module.h"
+#include "libcamera/internal/ipa_module_cache.h"
+
+#include "test.h"
+
+using namespace std;
+using namespace libcamera;
+
+class IPAModuleCacheTest : public Test
+{
+protected:
+	int init() override
+	{
+		char dir[] = "/tmp/libcamera.ipa_module_cache.XXXXXX";
+		if (!mkdtemp(dir)) {
+			cerr << "Failed to create temporary directory" << endl;
+			return TestFail;
+		}
+
+		dir_ = dir;
+		modulePath_ = dir_ / "ipa_vimc.so";
+		cachePath_ = dir_ / "ipa_module_cache";
+
+		std::error_code ec;
+		filesystem::copy_file("src/ipa/vimc/ipa_vimc.so", modulePath_, ec);
+		if (ec) {
+			cerr << "Failed to copy VIMC IPA module: " << ec.message()
+			     << endl;
+			return TestFail;
+		}
+
+		/* The signature is only generated when signing is enabled. */
+		filesystem::copy_file("src/ipa/vimc/ipa_vimc.so.sign",
+				      modulePath_ + ".sign", ec);
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		/* Populate the cache. */
+		{
+			IPAModuleCache cache(cachePath_, {});
+
+			IPAModuleCache::Stamp stamp = IPAModuleCache::stamp(modulePath_);
+			if (cache.find(modulePath_, stamp)) {
+				cerr << "Empty cache has an entry" << endl;
+				return TestFail;
+			}
+
+			IPAModule module(modulePath_);
+			if (!module.isValid()) {
+				cerr << "Test IPA module is invalid" << endl;
+				return TestFail;
+			}
+
+			cache.update(modulePath_, stamp, module.info());
+			cache.setSignatureValid(modulePath_, stamp, false);
+
+			if (cache.save()) {
+				cerr << "Failed to save cache" << endl;
+				return TestFail;
+			}
+		}
+
+		/* Reload the cache and check the entry. */
+		{
+			IPAModuleCache cache(cachePath_, {});
+
+			IPAModuleCache::Stamp stamp = IPAModuleCache::stamp(modulePath_);
+			const IPAModuleCache::Entry *entry = cache.find(modulePath_, stamp);
+			if (!entry) {
+				cerr << "Cache entry not found after reload" << endl;
+				return TestFail;
+			}
+
+			IPAModule module(modulePath_);
+			if (memcmp(&entry->info, &module.info(), sizeof(entry->info))) {
+				cerr << "Cached IPA module information mismatch" << endl;
+				return TestFail;
+			}
+
+			if (entry->signatureValid != false) {
+				cerr << "Cached signature status mismatch" << endl;
+				return TestFail;
+			}
+
+			IPAModule cachedModule(modulePath_, entry->info);
+			if (!cachedModule.isValid()) {
+				cerr << "IPA module created from cache is invalid" << endl;
+				return TestFail;
+			}
+		}
+
+		/* A cache created for a different public key must be ignored. */
+		{
+			const uint8_t key[] = { 0x01, 0x02, 0x03 };
+			IPAModuleCache cache(cachePath_, key);
+
+			IPAModuleCache::Stamp stamp = IPAModuleCache::stamp(modulePath_);
+			if (cache.find(modulePath_, stamp)) {
+				cerr << "Cache not invalidated by public key change" << endl;
+				return TestFail;
+			}
+		}
+
+		/* A cache writable by other users must be ignored. */
+		{
+			chmod(cachePath_.c_str(), 0666);
+
+			IPAModuleCache cache(cachePath_, {});
+
+			IPAModuleCache::Stamp stamp = IPAModuleCache::stamp(modulePath_);
+			if (cache.find(modulePath_, stamp)) {
+				cerr << "Cache with unsafe permissions not ignored" << endl;
+				return TestFail;
+			}
+
+			chmod(cachePath_.c_str(), 0600);
+		}
+
+		int ret = benchmark();
+		if (ret != TestPass)
+			return ret;
+
+		/* Modifying the module must invalidate the entry. */
+		{
+			IPAModuleCache cache(cachePath_, {});
+
+			filesystem::last_write_time(modulePath_,
+						    filesystem::file_time_type::clock::now() -
+							    chrono::hours(1));
+
+			IPAModuleCache::Stamp stamp = IPAModuleCache::stamp(modulePath_);
+			if (cache.find(modulePath_, stamp)) {
+				cerr << "Cache entry not invalidated by module change"
+				     << endl;
+				return TestFail;
+			}
+		}
+
+		return TestPass;
+	}
+
+	void cleanup() override
+	{
+		std::error_code ec;
+		filesystem::remove_all(dir_, ec);
+	}
+
+private:
+	bool verifySignature([[maybe_unused]] const IPAModule &module)
+	{
+#if HAVE_IPA_PUBKEY
+		File file{ module.path() };
+		if (!file.open(File::OpenModeFlag::ReadOnly))
+			return false;
+
+		return IPAManager::pubKey().verify(file.map(), module.signature());
+#else
+		return false;
+#endif
+	}
+
+	int benchmark()
+	{
+		constexpr unsigned int kIterations = 100;
+
+		auto start = chrono::steady_clock::now();
+
+		for (unsigned int i = 0; i < kIterations; ++i) {
+			IPAModule module(modulePath_);
+			if (!module.isValid())
+				return TestFail;
+
+			verifySignature(module);
+		}
+
+		auto uncached = chrono::steady_clock::now() - start;
+
+		start = chrono::steady_clock::now();
+
+		for (unsigned int i = 0; i < kIterations; ++i) {
+			IPAModuleCache cache(cachePath_, {});
+
+			IPAModuleCache::Stamp stamp = IPAModuleCache::stamp(modulePath_);
+			const IPAModuleCache::Entry *entry = cache.find(modulePath_, stamp);
+			if (!entry)
+				return TestFail;
+
+			IPAModule module(modulePath_, entry->info);
+			if (!module.isValid())
+				return TestFail;
+		}
+
+		auto cached = chrono::steady_clock::now() - start;
+
+		cout << "IPA module scan and verification time: "
+		     << chrono::duration_cast<chrono::microseconds>(uncached).count() / kIterations
+		     << "us uncached, "
+		     << chrono::duration_cast<chrono::microseconds>(cached).count() / kIterations
+		     << "us cached" << endl;
+
+		return TestPass;
+	}
+
+	filesystem::path dir_;
+	string modulePath_;
+	string cachePath_;
+};
+
+TEST_REGISTER(IPAModuleCacheTest)
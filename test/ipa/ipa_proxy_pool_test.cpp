@@ -0,0 +1,214 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Test the pool of pre-spawned IPA proxy workers
+ */
+
+#include <dirent.h>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+
+#include <libcamera/ipa/vimc_ipa_proxy.h>
+
+#include <libcamera/base/event_dispatcher.h>
+#include <libcamera/base/thread.h>
+#include <libcamera/base/timer.h>
+
+#include "libcamera/internal/camera_manager.h"
+#include "libcamera/internal/ipa_manager.h"
+#include "libcamera/internal/pipeline_handler.h"
+
+#include "test.h"
+
+using namespace libcamera;
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace {
+
+/*
+ * List the live vimc proxy worker child processes, ignoring the ones that have
+ * terminated or not executed the worker yet. Workers are also pre-spawned for
+ * the other IPA modules.
+ */
+std::set<pid_t> vimcWorkers()
+{
+	std::set<pid_t> workers;
+	DIR *dir = opendir("/proc");
+	if (!dir)
+		return workers;
+
+	while (struct dirent *ent = readdir(dir)) {
+		pid_t pid = atoi(ent->d_name);
+		if (pid <= 0)
+			continue;
+
+		std::ifstream stat("/proc/" + std::string(ent->d_name) + "/stat");
+		std::string line;
+		if (!std::getline(stat, line))
+			continue;
+
+		/* The command name may contain spaces, skip past it. */
+		size_t start = line.find('(');
+		size_t pos = line.rfind(')');
+		if (start == std::string::npos || pos == std::string::npos)
+			continue;
+
+		if (line.substr(start + 1, pos - start - 1) != "vimc_ipa_proxy")
+			continue;
+
+		char state;
+		pid_t ppid;
+		if (sscanf(line.c_str() + pos + 1, " %c %d", &state, &ppid) != 2)
+			continue;
+
+		if (ppid == getpid() && state != 'Z' && state != 'X')
+			workers.insert(pid);
+	}
+
+	closedir(dir);
+	return workers;
+}
+
+} /* namespace */
+
+class IPAProxyPoolTest : public Test
+{
+protected:
+	int init() override
+	{
+		char directory[] = "/tmp/libcamera.ipa_pool.XXXXXX";
+		if (!mkdtemp(directory)) {
+			cerr << "Failed to create temporary directory" << endl;
+			return TestFail;
+		}
+
+		directory_ = directory;
+		std::filesystem::create_directory(directory_ / "libcamera");
+		std::ofstream(directory_ / "libcamera" / "configuration.yaml")
+			<< "---" << endl
+			<< "version: 1" << endl
+			<< "configuration:" << endl
+			<< "  ipa:" << endl
+			<< "    force_isolation: true" << endl
+			<< "    proxy_pool_size: 1" << endl;
+
+		setenv("XDG_CONFIG_HOME", directory_.c_str(), 1);
+
+		cameraManager_ = make_unique<CameraManager>();
+
+		for (const PipelineHandlerFactoryBase *factory :
+		     PipelineHandlerFactoryBase::factories()) {
+			if (factory->name() == "vimc") {
+				pipe_ = factory->create(cameraManager_.get());
+				break;
+			}
+		}
+
+		if (!pipe_) {
+			cerr << "Vimc pipeline not found" << endl;
+			return TestSkip;
+		}
+
+		return TestPass;
+	}
+
+	bool waitForWorkers(const std::function<bool(const std::set<pid_t> &)> &cond)
+	{
+		EventDispatcher *dispatcher = Thread::current()->eventDispatcher();
+
+		/* Poll for up to one second. */
+		for (unsigned int i = 0; i < 100; ++i) {
+			if (cond(vimcWorkers()))
+				return true;
+
+			Timer timer;
+			timer.start(10ms);
+			while (timer.isRunning())
+				dispatcher->processEvents();
+		}
+
+		return false;
+	}
+
+	int run() override
+	{
+		/* The pool is filled when the IPA manager is created. */
+		ipaManager_ = std::make_unique<IPAManager>(*cameraManager_);
+
+		std::set<pid_t> pooled;
+		if (!waitForWorkers([&](const std::set<pid_t> &live) {
+			    pooled = live;
+			    return live.size() == 1;
+		    })) {
+			cerr << "Expected 1 pre-spawned worker, found "
+			     << pooled.size() << endl;
+			return TestFail;
+		}
+
+		/* Creating a proxy hands out the pooled worker and refills the pool. */
+		std::unique_ptr<ipa::vimc::IPAProxyVimc> ipa =
+			ipaManager_->createIPA<ipa::vimc::IPAProxyVimc>(pipe_.get(), 0, 0);
+		if (!ipa) {
+			cerr << "Failed to create VIMC IPA interface" << endl;
+			return TestFail;
+		}
+
+		pid_t handedOut = *pooled.begin();
+		if (!waitForWorkers([&](const std::set<pid_t> &live) {
+			    return live.size() == 2 && live.count(handedOut);
+		    })) {
+			cerr << "Pooled worker not handed out" << endl;
+			return TestFail;
+		}
+
+		/* Releasing the proxy terminates the worker it was handed. */
+		ipa.reset();
+
+		if (!waitForWorkers([&](const std::set<pid_t> &live) {
+			    return live.size() == 1 && !live.count(handedOut);
+		    })) {
+			cerr << "Worker not terminated on proxy release" << endl;
+			return TestFail;
+		}
+
+		/* Destroying the manager terminates the pooled workers. */
+		ipaManager_.reset();
+
+		if (!waitForWorkers([](const std::set<pid_t> &live) {
+			    return live.empty();
+		    })) {
+			cerr << "Pooled worker not terminated" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	void cleanup() override
+	{
+		ipaManager_.reset();
+		pipe_.reset();
+		cameraManager_.reset();
+
+		if (!directory_.empty())
+			std::filesystem::remove_all(directory_);
+	}
+
+private:
+	std::filesystem::path directory_;
+	std::unique_ptr<CameraManager> cameraManager_;
+	std::shared_ptr<PipelineHandler> pipe_;
+	std::unique_ptr<IPAManager> ipaManager_;
+};
+
+TEST_REGISTER(IPAProxyPoolTest)
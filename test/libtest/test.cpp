@@ -19,9 +19,10 @@ Test::~Test()
 {
 }
 
-void Test::setArgs([[maybe_unused]] int argc, char *argv[])
+void Test::setArgs(int argc, char *argv[])
 {
 	self_ = argv[0];
+	args_.assign(argv + 1, argv + argc);
 }
 
 int Test::execute()
@@ -9,6 +9,7 @@
 
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include <libcamera/base/unique_fd.h>
 
@@ -28,6 +29,7 @@ public:
 	int execute();
 
 	const std::string &self() const { return self_; }
+	const std::vector<std::string> &args() const { return args_; }
 
 protected:
 	virtual int init() { return 0; }
@@ -36,6 +38,7 @@ protected:
 
 private:
 	std::string self_;
+	std::vector<std::string> args_;
 };
 
 #define TEST_REGISTER(Klass)						\
@@ -0,0 +1,179 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Test media device creation and matching in the device enumerator
+ */
+
+#include <dirent.h>
+#include <iostream>
+#include <memory>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "libcamera/internal/device_enumerator.h"
+#include "libcamera/internal/media_device.h"
+
+#include "test.h"
+
+using namespace libcamera;
+using namespace std;
+
+namespace {
+
+class TestEnumerator : public DeviceEnumerator
+{
+public:
+	int init() override { return 0; }
+	int enumerate() override { return 0; }
+
+	using DeviceEnumerator::createDevice;
+	using DeviceEnumerator::createDevices;
+};
+
+} /* namespace */
+
+class DeviceEnumeratorTest : public Test
+{
+protected:
+	int init() override
+	{
+		DIR *dir = opendir("/dev");
+		if (!dir)
+			return TestFail;
+
+		while (struct dirent *ent = readdir(dir)) {
+			if (!strncmp(ent->d_name, "media", 5))
+				mediaNodes_.push_back(std::string("/dev/") + ent->d_name);
+		}
+
+		closedir(dir);
+
+		return TestPass;
+	}
+
+	int testCreateDevices()
+	{
+		TestEnumerator enumerator;
+
+		/*
+		 * Interleave invalid device nodes with the media devices of the
+		 * system, to exercise the worker threads even when no media
+		 * device is present.
+		 */
+		std::vector<std::string> deviceNodes;
+		for (unsigned int i = 0; i < 16; ++i) {
+			deviceNodes.push_back("/dev/libcamera-test-media" + std::to_string(i));
+			if (i < mediaNodes_.size())
+				deviceNodes.push_back(mediaNodes_[i]);
+		}
+
+		/* Force multiple threads regardless of the number of CPUs. */
+		std::vector<std::unique_ptr<MediaDevice>> devices =
+			enumerator.createDevices(deviceNodes, 4);
+		if (devices.size() != deviceNodes.size()) {
+			cerr << "Created " << devices.size() << " devices, expected "
+			     << deviceNodes.size() << endl;
+			return TestFail;
+		}
+
+		for (unsigned int i = 0; i < deviceNodes.size(); ++i) {
+			const std::string &node = deviceNodes[i];
+			const std::unique_ptr<MediaDevice> &media = devices[i];
+			std::unique_ptr<MediaDevice> expected =
+				enumerator.createDevice(node);
+
+			if (!expected) {
+				if (media) {
+					cerr << "Unexpected media device for " << node << endl;
+					return TestFail;
+				}
+
+				continue;
+			}
+
+			if (!media || media->deviceNode() != node ||
+			    media->driver() != expected->driver() ||
+			    media->entities().size() != expected->entities().size()) {
+				cerr << "Media device " << node << " not created in order"
+				     << endl;
+				return TestFail;
+			}
+		}
+
+		return TestPass;
+	}
+
+	int testDeviceMatch()
+	{
+		std::unique_ptr<DeviceEnumerator> enumerator = DeviceEnumerator::create();
+		if (!enumerator || enumerator->enumerate()) {
+			cerr << "Failed to enumerate media devices" << endl;
+			return TestFail;
+		}
+
+		DeviceMatch vimc("vimc");
+		std::shared_ptr<MediaDevice> media = enumerator->search(vimc);
+		if (!media) {
+			cerr << "No VIMC media device found: skip test" << endl;
+			return TestSkip;
+		}
+
+		const struct {
+			std::vector<std::string> entities;
+			std::vector<std::string> regexes;
+			bool matches;
+		} cases[] = {
+			/* Literal entity names are matched exactly. */
+			{ { "Sensor A", "Debayer A", "Raw Capture 0" }, {}, true },
+			{ { "Sensor A", "Unknown entity" }, {}, false },
+			{ { "Raw Capture" }, {}, false },
+			/* Regular expressions shall match a single entity. */
+			{ {}, { "^Raw Capture 0$" }, true },
+			{ {}, { "Raw Capture" }, false },
+			{ {}, { "^Unknown" }, false },
+			{ { "Scaler" }, { "Capture 1$" }, true },
+			{ { "Scaler" }, { "^Unknown" }, false },
+		};
+
+		for (const auto &c : cases) {
+			DeviceMatch dm("vimc");
+			for (const std::string &entity : c.entities)
+				dm.add(entity);
+			for (const std::string &regex : c.regexes)
+				dm.add(std::regex(regex));
+
+			if (dm.match(media.get()) != c.matches) {
+				cerr << "Device match with " << c.entities.size()
+				     << " entities and " << c.regexes.size()
+				     << " regexes " << (c.matches ? "failed" : "succeeded")
+				     << endl;
+				return TestFail;
+			}
+		}
+
+		DeviceMatch other("uvcvideo");
+		other.add("Sensor A");
+		if (other.match(media.get())) {
+			cerr << "Device matched with the wrong driver" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		int ret = testCreateDevices();
+		if (ret != TestPass)
+			return ret;
+
+		return testDeviceMatch();
+	}
+
+private:
+	std::vector<std::string> mediaNodes_;
+};
+
+TEST_REGISTER(DeviceEnumeratorTest)
@@ -0,0 +1,284 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Simple pipeline software ISP and converter chain test
+ *
+ * Capture multiple processed streams from a raw sensor on a platform with a
+ * converter, where frames are debayered by the software ISP and then scaled
+ * by the converter, and stop the camera while frames are in flight in both
+ * stages.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <libcamera/camera.h>
+#include <libcamera/camera_manager.h>
+#include <libcamera/framebuffer_allocator.h>
+
+#include <libcamera/base/event_dispatcher.h>
+#include <libcamera/base/thread.h>
+#include <libcamera/base/timer.h>
+
+#include "libcamera/internal/camera.h"
+#include "libcamera/internal/formats.h"
+#include "libcamera/internal/pipeline_handler.h"
+
+#include "test.h"
+
+using namespace libcamera;
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace {
+
+class IspConverterTest : public Test
+{
+protected:
+	void requestComplete(Request *request)
+	{
+		completed_++;
+
+		if (request->status() == Request::RequestComplete) {
+			/* The streams are all produced from the same frame. */
+			std::optional<unsigned int> sequence;
+			for (const auto &[stream, buffer] : request->buffers()) {
+				const FrameMetadata &metadata = buffer->metadata();
+				if (metadata.status != FrameMetadata::FrameSuccess ||
+				    (sequence && *sequence != metadata.sequence))
+					mismatch_ = true;
+
+				sequence = metadata.sequence;
+			}
+
+			captured_++;
+		} else if (request->status() == Request::RequestCancelled) {
+			cancelled_++;
+		}
+
+		/* Keep the two stages busy until the camera is stopped. */
+		if (requeue_) {
+			request->reuse(Request::ReuseBuffers);
+			if (camera_->queueRequest(request) == 0)
+				queued_++;
+		}
+
+		dispatcher_->interrupt();
+	}
+
+	/*
+	 * Find a camera of the simple pipeline handler with a raw sensor that
+	 * can produce multiple processed streams. When the software ISP is
+	 * used, this requires a converter to be chained after it.
+	 */
+	bool isChained(Camera *camera)
+	{
+		if (camera->_d()->pipe()->name() != std::string("simple"))
+			return false;
+
+		std::unique_ptr<CameraConfiguration> raw =
+			camera->generateConfiguration({ StreamRole::Raw });
+		if (!raw || PixelFormatInfo::info(raw->at(0).pixelFormat).colourEncoding !=
+				    PixelFormatInfo::ColourEncodingRAW)
+			return false;
+
+		config_ = camera->generateConfiguration({ StreamRole::Viewfinder,
+							  StreamRole::VideoRecording });
+		return config_ && config_->size() == 2 &&
+		       config_->validate() != CameraConfiguration::Invalid;
+	}
+
+	int init() override
+	{
+		cm_ = std::make_unique<CameraManager>();
+		if (cm_->start()) {
+			cout << "Failed to start camera manager" << endl;
+			return TestFail;
+		}
+
+		for (const std::shared_ptr<Camera> &camera : cm_->cameras()) {
+			if (isChained(camera.get())) {
+				camera_ = camera;
+				break;
+			}
+		}
+
+		if (!camera_) {
+			cout << "No camera with a software ISP and converter chain" << endl;
+			return TestSkip;
+		}
+
+		dispatcher_ = Thread::current()->eventDispatcher();
+
+		return TestPass;
+	}
+
+	int capture(unsigned int frames)
+	{
+		completed_ = 0;
+		captured_ = 0;
+		cancelled_ = 0;
+		queued_ = 0;
+		mismatch_ = false;
+		requeue_ = true;
+
+		if (camera_->start()) {
+			cout << "Failed to start camera" << endl;
+			return TestFail;
+		}
+
+		for (std::unique_ptr<Request> &request : requests_) {
+			request->reuse(Request::ReuseBuffers);
+			if (camera_->queueRequest(request.get())) {
+				cout << "Failed to queue request" << endl;
+				return TestFail;
+			}
+
+			queued_++;
+		}
+
+		Timer timer;
+		timer.start(5s);
+		while (timer.isRunning() && captured_ < frames)
+			dispatcher_->processEvents();
+
+		/*
+		 * Stop with all the requests queued, frames are then in flight
+		 * in the software ISP, the converter, or both.
+		 */
+		requeue_ = false;
+
+		if (camera_->stop()) {
+			cout << "Failed to stop camera" << endl;
+			return TestFail;
+		}
+
+		if (captured_ < frames) {
+			cout << "Only " << captured_ << " frames captured" << endl;
+			return TestFail;
+		}
+
+		/* All the requests must be completed when the camera stops. */
+		if (completed_ != queued_) {
+			cout << completed_ << " of " << queued_
+			     << " requests completed on stop" << endl;
+			return TestFail;
+		}
+
+		/* Requests in flight are cancelled, not failed. */
+		if (captured_ + cancelled_ != completed_) {
+			cout << completed_ - captured_ - cancelled_
+			     << " requests neither completed nor cancelled" << endl;
+			return TestFail;
+		}
+
+		if (mismatch_) {
+			cout << "Streams not produced from the same frame" << endl;
+			return TestFail;
+		}
+
+		for (const std::unique_ptr<Request> &request : requests_) {
+			if (request->status() == Request::RequestPending) {
+				cout << "Request pending after stop" << endl;
+				return TestFail;
+			}
+		}
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		if (camera_->acquire()) {
+			cout << "Failed to acquire the camera" << endl;
+			return TestFail;
+		}
+
+		if (camera_->configure(config_.get())) {
+			cout << "Failed to configure the camera" << endl;
+			return TestFail;
+		}
+
+		allocator_ = std::make_unique<FrameBufferAllocator>(camera_);
+		unsigned int count = ~0U;
+		for (const StreamConfiguration &cfg : *config_) {
+			int ret = allocator_->allocate(cfg.stream());
+			if (ret < 0) {
+				cout << "Failed to allocate buffers" << endl;
+				return TestFail;
+			}
+
+			count = std::min<unsigned int>(count, ret);
+		}
+
+		for (unsigned int i = 0; i < count; i++) {
+			std::unique_ptr<Request> request = camera_->createRequest(i);
+			if (!request) {
+				cout << "Failed to create request" << endl;
+				return TestFail;
+			}
+
+			for (const StreamConfiguration &cfg : *config_) {
+				Stream *stream = cfg.stream();
+				if (request->addBuffer(stream, allocator_->buffers(stream)[i].get())) {
+					cout << "Failed to add buffer to request" << endl;
+					return TestFail;
+				}
+			}
+
+			requests_.push_back(std::move(request));
+		}
+
+		camera_->requestCompleted.connect(this, &IspConverterTest::requestComplete);
+
+		/*
+		 * Restart the camera after stopping it with frames in flight, to
+		 * check that the internal buffers between the two stages have
+		 * all been returned.
+		 */
+		for (unsigned int i = 0; i < 2; i++) {
+			int ret = capture(count * 2);
+			if (ret != TestPass)
+				return ret;
+		}
+
+		return TestPass;
+	}
+
+	void cleanup() override
+	{
+		requests_.clear();
+		allocator_.reset();
+
+		if (camera_) {
+			camera_->release();
+			camera_.reset();
+		}
+
+		cm_.reset();
+	}
+
+private:
+	std::unique_ptr<CameraManager> cm_;
+	std::shared_ptr<Camera> camera_;
+	std::unique_ptr<CameraConfiguration> config_;
+	std::unique_ptr<FrameBufferAllocator> allocator_;
+	std::vector<std::unique_ptr<Request>> requests_;
+	EventDispatcher *dispatcher_;
+
+	std::atomic<unsigned int> completed_ = 0;
+	std::atomic<unsigned int> captured_ = 0;
+	std::atomic<unsigned int> cancelled_ = 0;
+	std::atomic<unsigned int> queued_ = 0;
+	std::atomic<bool> mismatch_ = false;
+	std::atomic<bool> requeue_ = false;
+};
+
+} /* namespace */
+
+TEST_REGISTER(IspConverterTest)
@@ -0,0 +1,293 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * UVC MJPEG decoder test
+ */
+
+#include <iostream>
+#include <memory>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include <libcamera/base/event_dispatcher.h>
+#include <libcamera/base/memfd.h>
+#include <libcamera/base/message.h>
+#include <libcamera/base/shared_fd.h>
+#include <libcamera/base/span.h>
+#include <libcamera/base/thread.h>
+#include <libcamera/base/timer.h>
+
+#include <libcamera/formats.h>
+#include <libcamera/framebuffer.h>
+
+#include "libcamera/internal/formats.h"
+#include "libcamera/internal/framebuffer.h"
+#include "libcamera/internal/mapped_framebuffer.h"
+
+#include "mjpeg_decoder.h"
+#include "test.h"
+
+using namespace libcamera;
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace {
+
+/*
+ * The test frames are made of four 16x16 quadrants of uniform colours, listed
+ * below as Y, Cb and Cr values in raster order. They have been encoded with
+ * libjpeg at quality 100.
+ */
+const uint8_t kColours[4][3] = {
+	{ 64, 96, 160 },
+	{ 192, 160, 96 },
+	{ 128, 64, 64 },
+	{ 32, 192, 192 },
+};
+
+const Size kSize{ 32, 32 };
+
+/* 32x32 frame with 4:2:0 chroma subsampling */
+const uint8_t kJpeg420[] = {
+	0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 0x4a, 0x46, 0x49, 0x46, 0x00, 0x01,
+	0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0xff, 0xdb, 0x00, 0x43,
+	0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0xff, 0xdb, 0x00, 0x43, 0x01, 0x01, 0x01,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+	0x01, 0x01, 0xff, 0xc0, 0x00, 0x11, 0x08, 0x00, 0x20, 0x00, 0x20, 0x03,
+	0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11, 0x01, 0xff, 0xc4, 0x00,
+	0x16, 0x00, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x0b, 0xff, 0xc4, 0x00,
+	0x14, 0x10, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xc4, 0x00, 0x16, 0x01,
+	0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x09, 0x0a, 0x0b, 0xff, 0xc4, 0x00, 0x14, 0x11,
+	0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xda, 0x00, 0x0c, 0x03, 0x01, 0x00,
+	0x02, 0x11, 0x03, 0x11, 0x00, 0x3f, 0x00, 0x9f, 0xf0, 0x07, 0xf9, 0x00,
+	0x68, 0x00, 0x02, 0x80, 0x13, 0xfe, 0x9f, 0xf0, 0x11, 0xfe, 0x3f, 0xd1,
+	0xfe, 0x03, 0x40, 0x06, 0x80, 0x0f, 0xff, 0xd9,
+};
+
+/* 32x32 frame with 4:2:2 chroma subsampling */
+const uint8_t kJpeg422[] = {
+	0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 0x4a, 0x46, 0x49, 0x46, 0x00, 0x01,
+	0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0xff, 0xdb, 0x00, 0x43,
+	0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0xff, 0xdb, 0x00, 0x43, 0x01, 0x01, 0x01,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+	0x01, 0x01, 0xff, 0xc0, 0x00, 0x11, 0x08, 0x00, 0x20, 0x00, 0x20, 0x03,
+	0x01, 0x21, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11, 0x01, 0xff, 0xc4, 0x00,
+	0x16, 0x00, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a, 0x0b, 0xff, 0xc4, 0x00,
+	0x14, 0x10, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xc4, 0x00, 0x16, 0x01,
+	0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x0a, 0x0b, 0x09, 0xff, 0xc4, 0x00, 0x14, 0x11,
+	0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xda, 0x00, 0x0c, 0x03, 0x01, 0x00,
+	0x02, 0x11, 0x03, 0x11, 0x00, 0x3f, 0x00, 0x9f, 0xf1, 0x9f, 0xed, 0x00,
+	0x68, 0x00, 0x10, 0x00, 0xff, 0x00, 0xb3, 0xff, 0x00, 0x07, 0xfc, 0x80,
+	0x1a, 0x00, 0x04, 0x00, 0x3f, 0xe9, 0xff, 0x00, 0x03, 0xfd, 0x9f, 0xe8,
+	0xff, 0x00, 0x14, 0x00, 0x50, 0x01, 0x60, 0x02, 0x7f, 0xe9, 0xff, 0x00,
+	0xa3, 0xfc, 0x50, 0x01, 0x40, 0x07, 0xff, 0xd9,
+};
+
+} /* namespace */
+
+class MjpegDecoderTest : public Test
+{
+protected:
+	int init() override
+	{
+		if (!MjpegDecoder::isAvailable()) {
+			cout << "MJPEG decoder not available" << endl;
+			return TestSkip;
+		}
+
+		decoder_ = std::make_unique<MjpegDecoder>();
+		decoder_->outputBufferReady.connect(this, &MjpegDecoderTest::outputDone);
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		const std::vector<Span<const uint8_t>> frames = {
+			kJpeg420,
+			kJpeg422,
+		};
+
+		for (Span<const uint8_t> frame : frames) {
+			for (const PixelFormat &format : MjpegDecoder::formats()) {
+				int ret = decode(frame, format);
+				if (ret != TestPass)
+					return ret;
+			}
+		}
+
+		return TestPass;
+	}
+
+private:
+	std::unique_ptr<FrameBuffer> createBuffer(size_t size,
+						  const std::vector<unsigned int> &planeSizes)
+	{
+		SharedFD fd(MemFd::create("mjpeg-decoder", size));
+		if (!fd.isValid())
+			return nullptr;
+
+		std::vector<FrameBuffer::Plane> planes;
+		unsigned int offset = 0;
+
+		for (unsigned int planeSize : planeSizes) {
+			planes.push_back({ fd, offset, planeSize });
+			offset += planeSize;
+		}
+
+		return std::make_unique<FrameBuffer>(planes);
+	}
+
+	int decode(Span<const uint8_t> jpeg, const PixelFormat &format)
+	{
+		const PixelFormatInfo &info = PixelFormatInfo::info(format);
+
+		std::unique_ptr<FrameBuffer> input =
+			createBuffer(jpeg.size(), { static_cast<unsigned int>(jpeg.size()) });
+		if (!input) {
+			cerr << "Failed to create input buffer" << endl;
+			return TestFail;
+		}
+
+		{
+			MappedFrameBuffer map(input.get(), MappedFrameBuffer::MapFlag::Write);
+			memcpy(map.planes()[0].data(), jpeg.data(), jpeg.size());
+		}
+
+		FrameMetadata &metadata = input->_d()->metadata();
+		metadata.status = FrameMetadata::FrameSuccess;
+		metadata.planes()[0].bytesused = jpeg.size();
+
+		std::vector<unsigned int> planeSizes;
+		for (unsigned int i = 0; i < info.numPlanes(); i++)
+			planeSizes.push_back(info.planeSize(kSize, i, 1));
+
+		std::unique_ptr<FrameBuffer> output =
+			createBuffer(info.frameSize(kSize, 1), planeSizes);
+		if (!output) {
+			cerr << "Failed to create output buffer" << endl;
+			return TestFail;
+		}
+
+		if (decoder_->configure(format, kSize) || decoder_->start()) {
+			cerr << "Failed to start decoder for " << format << endl;
+			return TestFail;
+		}
+
+		output_ = nullptr;
+		decoder_->queueBuffers(input.get(), output.get());
+
+		/*
+		 * Completion is reported through a message posted to this
+		 * thread, dispatch it without waiting for another event.
+		 */
+		EventDispatcher *dispatcher = Thread::current()->eventDispatcher();
+		Timer timeout;
+		timeout.start(1000ms);
+		while (timeout.isRunning() && !output_) {
+			dispatcher->processEvents();
+			Thread::current()->dispatchMessages(Message::Type::InvokeMessage);
+		}
+
+		decoder_->stop();
+
+		if (output_ != output.get() ||
+		    output->metadata().status != FrameMetadata::FrameSuccess) {
+			cerr << "Failed to decode frame to " << format << endl;
+			return TestFail;
+		}
+
+		return checkPlanes(output.get(), format);
+	}
+
+	int checkPlanes(FrameBuffer *buffer, const PixelFormat &format)
+	{
+		MappedFrameBuffer map(buffer, MappedFrameBuffer::MapFlag::Read);
+		const std::vector<Span<uint8_t>> &planes = map.planes();
+
+		/*
+		 * Uniform blocks are encoded losslessly at quality 100, up to
+		 * rounding errors of the DCT.
+		 */
+		auto check = [&](const char *name, unsigned int x, unsigned int y,
+				 unsigned int value, unsigned int expected) {
+			if (std::abs(static_cast<int>(value) - static_cast<int>(expected)) <= 2)
+				return true;
+
+			cerr << format << ": invalid " << name << " sample at "
+			     << Point(x, y) << ": " << value << " != " << expected
+			     << endl;
+			return false;
+		};
+
+		for (unsigned int y = 0; y < kSize.height; y++) {
+			for (unsigned int x = 0; x < kSize.width; x++) {
+				const uint8_t *colour = kColours[y / 16 * 2 + x / 16];
+
+				if (!check("Y", x, y, planes[0][y * kSize.width + x], colour[0]))
+					return TestFail;
+			}
+		}
+
+		for (unsigned int y = 0; y < kSize.height / 2; y++) {
+			for (unsigned int x = 0; x < kSize.width / 2; x++) {
+				const uint8_t *colour = kColours[y / 8 * 2 + x / 8];
+				unsigned int cb;
+				unsigned int cr;
+
+				if (format == formats::NV12) {
+					cb = planes[1][y * kSize.width + x * 2];
+					cr = planes[1][y * kSize.width + x * 2 + 1];
+				} else {
+					cb = planes[1][y * kSize.width / 2 + x];
+					cr = planes[2][y * kSize.width / 2 + x];
+				}
+
+				if (!check("Cb", x, y, cb, colour[1]) ||
+				    !check("Cr", x, y, cr, colour[2]))
+					return TestFail;
+			}
+		}
+
+		return TestPass;
+	}
+
+	void outputDone(FrameBuffer *buffer)
+	{
+		output_ = buffer;
+	}
+
+	std::unique_ptr<MjpegDecoder> decoder_;
+	FrameBuffer *output_;
+};
+
+TEST_REGISTER(MjpegDecoderTest)
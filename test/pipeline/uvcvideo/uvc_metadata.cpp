@@ -0,0 +1,304 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * UVC metadata parser test
+ *
+ * Parse canned USB descriptors and uvc_meta_buf payloads, and check the device
+ * clock frequency and the frame timestamps recovered from the PTS and SCR
+ * fields of the UVC payload headers.
+ */
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include <libcamera/base/span.h>
+
+#include "test.h"
+#include "uvc_metadata.h"
+
+using namespace libcamera;
+using namespace std;
+
+namespace {
+
+constexpr uint8_t kUVCHeaderPts = 1 << 2;
+constexpr uint8_t kUVCHeaderScr = 1 << 3;
+
+/* Device clock frequency in Hz, and clock ticks per frame at 30fps. */
+constexpr uint32_t kClockFrequency = 48000000;
+constexpr uint64_t kFrameTicks = kClockFrequency / 30;
+
+/* Host time in nanoseconds of device clock tick 0. */
+constexpr uint64_t kHostBase = 1000000000000ULL;
+constexpr int64_t kBoottimeOffset = 5000000000LL;
+
+template<typename T>
+void append(std::vector<uint8_t> &data, T value)
+{
+	uint8_t bytes[sizeof(value)];
+	memcpy(bytes, &value, sizeof(value));
+	data.insert(data.end(), bytes, bytes + sizeof(value));
+}
+
+/*
+ * Append a uvc_meta_buf block, with the host timestamp and USB frame number
+ * followed by a UVC payload header with the optional PTS and SCR fields.
+ */
+void appendBlock(std::vector<uint8_t> &data, uint64_t ns, uint16_t sof,
+		 std::optional<uint32_t> pts, std::optional<uint32_t> stc,
+		 uint16_t deviceSof = 0)
+{
+	uint8_t flags = (pts ? kUVCHeaderPts : 0) | (stc ? kUVCHeaderScr : 0);
+	uint8_t length = 2 + (pts ? 4 : 0) + (stc ? 6 : 0);
+
+	append<uint64_t>(data, ns);
+	append<uint16_t>(data, sof);
+	append<uint8_t>(data, length);
+	append<uint8_t>(data, flags);
+
+	if (pts)
+		append<uint32_t>(data, *pts);
+
+	if (stc) {
+		append<uint32_t>(data, *stc);
+		append<uint16_t>(data, deviceSof);
+	}
+}
+
+void appendInterface(std::vector<uint8_t> &data, uint8_t number,
+		     uint8_t subclass)
+{
+	data.insert(data.end(), { 9, 0x04, number, 0, 0, 0x0e, subclass, 0, 0 });
+}
+
+void appendHeader(std::vector<uint8_t> &data, uint32_t frequency)
+{
+	data.insert(data.end(), { 13, 0x24, 0x01, 0x10, 0x01, 0x40, 0x00 });
+	append<uint32_t>(data, frequency);
+	data.insert(data.end(), { 1, 1 });
+}
+
+uint64_t ticksToNs(uint64_t ticks)
+{
+	return ticks * 1000000000ULL / kClockFrequency;
+}
+
+} /* namespace */
+
+class UVCMetadataTest : public Test
+{
+protected:
+	int init() override
+	{
+		char directory[] = "/tmp/libcamera.uvcmeta.XXXXXX";
+		if (!mkdtemp(directory)) {
+			cerr << "Failed to create temporary directory" << endl;
+			return TestFail;
+		}
+
+		directory_ = directory;
+
+		/* The sysfs path of the interface is a child of the device. */
+		interface_ = directory_ / "intf";
+		std::filesystem::create_directory(interface_);
+
+		return TestPass;
+	}
+
+	std::optional<uint32_t> clockFrequency(const std::vector<uint8_t> &descriptors)
+	{
+		std::ofstream file(directory_ / "descriptors", std::ios::binary);
+		file.write(reinterpret_cast<const char *>(descriptors.data()),
+			   descriptors.size());
+		file.close();
+
+		return UVCMetadataParser::clockFrequency(interface_);
+	}
+
+	int testClockFrequency()
+	{
+		if (UVCMetadataParser::clockFrequency(interface_)) {
+			cerr << "Clock frequency found without descriptors" << endl;
+			return TestFail;
+		}
+
+		/* Device and configuration descriptors. */
+		std::vector<uint8_t> descriptors(18, 0);
+		descriptors[0] = 18;
+		descriptors[1] = 0x01;
+		descriptors.insert(descriptors.end(),
+				   { 9, 0x02, 0x00, 0x00, 2, 1, 0, 0x80, 250 });
+
+		/*
+		 * A VideoStreaming interface header shares the subtype of the
+		 * VC_HEADER, and must be skipped.
+		 */
+		std::vector<uint8_t> streaming = descriptors;
+		appendInterface(streaming, 1, 0x02);
+		appendHeader(streaming, 12345678);
+
+		if (clockFrequency(streaming)) {
+			cerr << "Clock frequency found outside of VideoControl interface"
+			     << endl;
+			return TestFail;
+		}
+
+		appendInterface(streaming, 0, 0x01);
+		appendHeader(streaming, 48000000);
+
+		std::optional<uint32_t> frequency = clockFrequency(streaming);
+		if (!frequency || *frequency != 48000000) {
+			cerr << "Failed to parse VideoControl clock frequency" << endl;
+			return TestFail;
+		}
+
+		/* The VC_HEADER is truncated by the end of the descriptors. */
+		std::vector<uint8_t> truncated = descriptors;
+		appendInterface(truncated, 0, 0x01);
+		appendHeader(truncated, 48000000);
+		truncated.resize(truncated.size() - 3);
+
+		if (clockFrequency(truncated)) {
+			cerr << "Clock frequency found in truncated descriptor" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int testIncomplete()
+	{
+		UVCMetadataParser parser(kClockFrequency);
+		std::vector<uint8_t> data;
+
+		/* No PTS or SCR. */
+		appendBlock(data, kHostBase, 0, {}, {});
+		if (parser.process(data, kBoottimeOffset)) {
+			cerr << "Timestamp without PTS and SCR" << endl;
+			return TestFail;
+		}
+
+		/* A PTS without any SCR to recover the device clock. */
+		data.clear();
+		appendBlock(data, kHostBase, 0, 1000, {});
+		if (parser.process(data, kBoottimeOffset)) {
+			cerr << "Timestamp without SCR" << endl;
+			return TestFail;
+		}
+
+		/* An SCR without PTS. */
+		data.clear();
+		appendBlock(data, kHostBase, 0, {}, 1000, 0);
+		if (parser.process(data, kBoottimeOffset)) {
+			cerr << "Timestamp without PTS" << endl;
+			return TestFail;
+		}
+
+		/* A block truncated in the middle of the SCR. */
+		UVCMetadataParser truncated(kClockFrequency);
+		data.clear();
+		appendBlock(data, kHostBase, 0, 1000, 1000, 0);
+		data.resize(data.size() - 3);
+		if (truncated.process(data, kBoottimeOffset)) {
+			cerr << "Timestamp from truncated block" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	/*
+	 * Feed frames sampled by the device at a constant rate, with the STC
+	 * wrapping around 32 bits and the USB frame numbers wrapping around 11
+	 * bits, and check the recovered timestamps against the host times at
+	 * which the frames have been sampled.
+	 */
+	int testTimestamps(UVCMetadataParser &parser, uint64_t start)
+	{
+		constexpr unsigned int kFrames = 30;
+
+		/* Frames are sampled 5ms before the end of the transfer. */
+		constexpr uint64_t kSampleTicks = kClockFrequency / 200;
+
+		for (unsigned int i = 0; i < kFrames; i++) {
+			uint64_t stc = start + i * kFrameTicks;
+			uint64_t pts = stc - kSampleTicks;
+
+			/*
+			 * The header is received by the host 1 to 3 USB frames
+			 * after the STC has been sampled.
+			 */
+			unsigned int delay = 1 + i % 3;
+			uint16_t deviceSof = (2040 + i * 33) & 0x7ff;
+			uint16_t sof = (deviceSof + delay) & 0x7ff;
+			uint64_t ns = kHostBase + ticksToNs(stc) + delay * 1000000;
+
+			std::vector<uint8_t> data;
+			appendBlock(data, ns - 2000000, sof - 2, {}, {});
+			appendBlock(data, ns, sof, static_cast<uint32_t>(pts),
+				    static_cast<uint32_t>(stc), deviceSof);
+
+			std::optional<uint64_t> timestamp =
+				parser.process(data, kBoottimeOffset);
+			if (!timestamp) {
+				cerr << "No timestamp for frame " << i << endl;
+				return TestFail;
+			}
+
+			uint64_t expected = kHostBase + ticksToNs(pts) + kBoottimeOffset;
+			int64_t error = *timestamp - expected;
+
+			/* Allow for rounding errors in the clock recovery. */
+			if (std::abs(error) > 1000) {
+				cerr << "Frame " << i << " timestamp " << *timestamp
+				     << " off by " << error << "ns" << endl;
+				return TestFail;
+			}
+		}
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		int ret = testClockFrequency();
+		if (ret != TestPass)
+			return ret;
+
+		ret = testIncomplete();
+		if (ret != TestPass)
+			return ret;
+
+		/*
+		 * Start a few frames before the STC wraps around, with the
+		 * fourth frame sampled before the wrap and its SCR after.
+		 */
+		UVCMetadataParser parser(kClockFrequency);
+		ret = testTimestamps(parser, (1ULL << 32) - 3 * kFrameTicks + 1000);
+		if (ret != TestPass)
+			return ret;
+
+		/* The device clock restarts from scratch after a reset. */
+		parser.reset();
+		return testTimestamps(parser, kClockFrequency);
+	}
+
+	void cleanup() override
+	{
+		if (!directory_.empty())
+			std::filesystem::remove_all(directory_);
+	}
+
+private:
+	std::filesystem::path directory_;
+	std::filesystem::path interface_;
+};
+
+TEST_REGISTER(UVCMetadataTest)
@@ -0,0 +1,237 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Virtual pipeline frame pacer test
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <libcamera/base/event_dispatcher.h>
+#include <libcamera/base/thread.h>
+#include <libcamera/base/timer.h>
+
+#include "frame_pacer.h"
+#include "test.h"
+
+using namespace libcamera;
+using namespace std;
+using namespace std::chrono_literals;
+
+class FramePacerTest : public Test
+{
+protected:
+	void frameCompleted(const FramePacer::Frame &frame)
+	{
+		frames_.push_back(frame);
+
+		if (frame.sequence == changeAt_)
+			changeSequence_ = pacer_->setFrameDuration(changeDuration_);
+	}
+
+	int capture(const FramePacer::Config &config, utils::Duration frameDuration,
+		    unsigned int count)
+	{
+		frames_.clear();
+
+		pacer_ = FramePacer::create(config);
+		if (!pacer_) {
+			cerr << "Failed to create frame pacer" << endl;
+			return TestFail;
+		}
+
+		pacer_->frameCompleted.connect(this, &FramePacerTest::frameCompleted);
+		pacer_->start(frameDuration);
+
+		EventDispatcher *dispatcher = Thread::current()->eventDispatcher();
+		Timer timeout;
+		timeout.start(2s);
+
+		while (frames_.size() < count && timeout.isRunning())
+			dispatcher->processEvents();
+
+		pacer_->stop();
+		pacer_.reset();
+
+		if (frames_.size() < count) {
+			cerr << "Only " << frames_.size() << " of " << count
+			     << " frames produced" << endl;
+			return TestFail;
+		}
+
+		frames_.resize(count);
+
+		for (unsigned int i = 0; i < count; ++i) {
+			if (frames_[i].sequence != i) {
+				cerr << "Frame " << i << " has sequence "
+				     << frames_[i].sequence << endl;
+				return TestFail;
+			}
+		}
+
+		return TestPass;
+	}
+
+	std::vector<bool> drops() const
+	{
+		std::vector<bool> dropped;
+		for (const FramePacer::Frame &frame : frames_)
+			dropped.push_back(frame.dropped);
+
+		return dropped;
+	}
+
+	int testTiming()
+	{
+		FramePacer::Config config;
+		config.controlDelay = 2;
+
+		changeAt_ = 4;
+		changeDuration_ = 10ms;
+
+		auto start = std::chrono::steady_clock::now();
+
+		int ret = capture(config, 5ms, 12);
+		if (ret != TestPass)
+			return ret;
+
+		auto elapsed = std::chrono::steady_clock::now() - start;
+
+		/* Changes requested at frame N apply at N + 1 + delay. */
+		if (changeSequence_ != changeAt_ + 1 + config.controlDelay) {
+			cerr << "Frame duration change reported for frame "
+			     << changeSequence_ << endl;
+			return TestFail;
+		}
+
+		utils::Duration total{ 0 };
+
+		for (const FramePacer::Frame &frame : frames_) {
+			utils::Duration expected = frame.sequence < changeSequence_
+						 ? 5ms : 10ms;
+
+			if (frame.duration != expected || frame.dropped) {
+				cerr << "Frame " << frame.sequence << " lasted "
+				     << frame.duration << ", expected " << expected
+				     << endl;
+				return TestFail;
+			}
+
+			total += frame.duration;
+		}
+
+		if (elapsed < total) {
+			cerr << "Frames produced faster than their duration" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int testJitter()
+	{
+		FramePacer::Config config;
+		config.jitter = 1ms;
+		config.seed = 7;
+
+		changeAt_ = ~0U;
+
+		int ret = capture(config, 4ms, 30);
+		if (ret != TestPass)
+			return ret;
+
+		/*
+		 * The end of each frame is offset by at most a quarter of the
+		 * frame duration, frames thus last between 2ms and 6ms.
+		 */
+		unsigned int nominal = 0;
+
+		for (const FramePacer::Frame &frame : frames_) {
+			if (frame.duration < 2ms || frame.duration > 6ms) {
+				cerr << "Frame " << frame.sequence << " lasted "
+				     << frame.duration << endl;
+				return TestFail;
+			}
+
+			if (frame.duration == 4ms)
+				nominal++;
+		}
+
+		if (nominal == frames_.size()) {
+			cerr << "No jitter applied" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int testDrops()
+	{
+		FramePacer::Config config;
+		config.dropRate = 0.3;
+		config.seed = 42;
+
+		changeAt_ = ~0U;
+
+		int ret = capture(config, 1ms, 50);
+		if (ret != TestPass)
+			return ret;
+
+		std::vector<bool> first = drops();
+		unsigned int dropped = std::count(first.begin(), first.end(), true);
+		if (dropped == 0 || dropped == first.size()) {
+			cerr << dropped << " frames dropped out of "
+			     << first.size() << endl;
+			return TestFail;
+		}
+
+		/* The same seed must reproduce the same drops. */
+		ret = capture(config, 1ms, 50);
+		if (ret != TestPass)
+			return ret;
+
+		if (drops() != first) {
+			cerr << "Drops not reproducible with the same seed" << endl;
+			return TestFail;
+		}
+
+		config.seed = 43;
+		ret = capture(config, 1ms, 50);
+		if (ret != TestPass)
+			return ret;
+
+		if (drops() == first) {
+			cerr << "Drops identical with a different seed" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int run()
+	{
+		int ret = testTiming();
+		if (ret != TestPass)
+			return ret;
+
+		ret = testJitter();
+		if (ret != TestPass)
+			return ret;
+
+		return testDrops();
+	}
+
+private:
+	std::unique_ptr<FramePacer> pacer_;
+	std::vector<FramePacer::Frame> frames_;
+
+	uint32_t changeAt_;
+	utils::Duration changeDuration_;
+	uint32_t changeSequence_;
+};
+
+TEST_REGISTER(FramePacerTest)
@@ -0,0 +1,256 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Virtual pipeline image frame prefetch test
+ *
+ * Generate frames from a raw NV12 sequence file through the prefetcher, and
+ * check that they are produced in order when the window of prefetched frames
+ * wraps around, and that the prefetcher stops with empty or loaded slots.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdint.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+#include <libcamera/base/memfd.h>
+#include <libcamera/base/shared_fd.h>
+
+#include <libcamera/formats.h>
+#include <libcamera/framebuffer.h>
+
+#include "libcamera/internal/formats.h"
+#include "libcamera/internal/mapped_framebuffer.h"
+
+#include "image_frame_generator.h"
+#include "test.h"
+
+using namespace libcamera;
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace {
+
+/*
+ * The luma and chroma samples of each frame of the sequence are set to
+ * values derived from the frame index.
+ */
+constexpr unsigned int kFrames = 5;
+const Size kSize{ 16, 8 };
+
+uint8_t lumaValue(unsigned int index)
+{
+	return 16 + index * 32;
+}
+
+uint8_t chromaValue(unsigned int index)
+{
+	return 240 - index * 32;
+}
+
+} /* namespace */
+
+class ImagePrefetchTest : public Test
+{
+protected:
+	int init() override
+	{
+		char directory[] = "/tmp/libcamera.prefetch.XXXXXX";
+		if (!mkdtemp(directory)) {
+			cerr << "Failed to create temporary directory" << endl;
+			return TestFail;
+		}
+
+		directory_ = directory;
+		sequence_ = directory_ / "sequence.nv12";
+
+		const size_t lumaSize = kSize.width * kSize.height;
+		std::ofstream file(sequence_, std::ios::binary);
+		for (unsigned int i = 0; i < kFrames; i++) {
+			std::vector<char> frame(lumaSize * 3 / 2, chromaValue(i));
+			std::fill(frame.begin(), frame.begin() + lumaSize, lumaValue(i));
+			file.write(frame.data(), frame.size());
+		}
+
+		if (!file.good()) {
+			cerr << "Failed to write sequence file" << endl;
+			return TestFail;
+		}
+
+		const PixelFormatInfo &info = PixelFormatInfo::info(formats::NV12);
+		SharedFD fd(MemFd::create("image-prefetch", info.frameSize(kSize, 1)));
+		if (!fd.isValid()) {
+			cerr << "Failed to allocate buffer" << endl;
+			return TestFail;
+		}
+
+		std::vector<FrameBuffer::Plane> planes;
+		unsigned int offset = 0;
+
+		for (unsigned int i = 0; i < info.numPlanes(); i++) {
+			unsigned int length = info.planeSize(kSize, i, 1);
+			planes.push_back({ fd, offset, length });
+			offset += length;
+		}
+
+		buffer_ = std::make_unique<FrameBuffer>(planes);
+
+		return TestPass;
+	}
+
+	std::unique_ptr<FrameGenerator> createGenerator(ImageFrames *frames,
+							unsigned int prefetch,
+							unsigned int repeat)
+	{
+		frames->files = { sequence_ };
+		frames->format = formats::NV12;
+		frames->size = kSize;
+		frames->repeat = repeat;
+		frames->prefetch = prefetch;
+
+		std::unique_ptr<FrameGenerator> generator =
+			ImageFrameGenerator::create(*frames);
+		if (!generator || generator->configure(formats::NV12, kSize))
+			return nullptr;
+
+		return generator;
+	}
+
+	/* Check that the generated frame is the frame at \a index in the sequence. */
+	bool checkFrame(unsigned int index)
+	{
+		MappedFrameBuffer map(buffer_.get(), MappedFrameBuffer::MapFlag::Read);
+		const auto &planes = map.planes();
+
+		for (uint8_t value : planes[0]) {
+			if (value != lumaValue(index))
+				return false;
+		}
+
+		for (uint8_t value : planes[1]) {
+			if (value != chromaValue(index))
+				return false;
+		}
+
+		return true;
+	}
+
+	int testOrder(unsigned int prefetch, unsigned int repeat)
+	{
+		ImageFrames frames;
+		std::unique_ptr<FrameGenerator> generator =
+			createGenerator(&frames, prefetch, repeat);
+		if (!generator) {
+			cerr << "Failed to create generator" << endl;
+			return TestFail;
+		}
+
+		/*
+		 * Loop over the sequence multiple times, for the positions to
+		 * wrap around both the slots and the frames of the sequence.
+		 */
+		for (unsigned int i = 0; i < kFrames * repeat * 3; i++) {
+			if (generator->generateFrame(kSize, buffer_.get())) {
+				cerr << "Failed to generate frame " << i << endl;
+				return TestFail;
+			}
+
+			unsigned int index = i / repeat % kFrames;
+			if (!checkFrame(index)) {
+				cerr << "Frame " << i << " with " << prefetch
+				     << " prefetched frames isn't frame " << index
+				     << " of the sequence" << endl;
+				return TestFail;
+			}
+
+			/* Let the prefetcher get ahead on every other frame. */
+			if (i % 2)
+				std::this_thread::sleep_for(1ms);
+		}
+
+		/* Reconfiguring the generator restarts from the first frame. */
+		if (generator->configure(formats::NV12, kSize) ||
+		    generator->generateFrame(kSize, buffer_.get()) ||
+		    !checkFrame(0)) {
+			cerr << "Reconfigured generator doesn't restart the sequence"
+			     << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int testStop()
+	{
+		ImageFrames frames;
+
+		/* Stop right after starting, with slots still being loaded. */
+		std::unique_ptr<FrameGenerator> generator = createGenerator(&frames, 4, 1);
+		if (!generator) {
+			cerr << "Failed to create generator" << endl;
+			return TestFail;
+		}
+
+		generator.reset();
+
+		/* Stop with all the slots loaded. */
+		generator = createGenerator(&frames, 4, 1);
+		if (!generator) {
+			cerr << "Failed to create generator" << endl;
+			return TestFail;
+		}
+
+		std::this_thread::sleep_for(50ms);
+		generator.reset();
+
+		/* Stop with a frame acquired and the released slot reloading. */
+		generator = createGenerator(&frames, 4, 2);
+		if (!generator ||
+		    generator->generateFrame(kSize, buffer_.get()) ||
+		    generator->generateFrame(kSize, buffer_.get()) ||
+		    generator->generateFrame(kSize, buffer_.get())) {
+			cerr << "Failed to generate frames" << endl;
+			return TestFail;
+		}
+
+		generator.reset();
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		/* Fewer, as many and more slots than frames in the sequence. */
+		for (unsigned int prefetch : { 1U, 3U, kFrames, kFrames * 2 }) {
+			for (unsigned int repeat : { 1U, 3U }) {
+				int ret = testOrder(prefetch, repeat);
+				if (ret != TestPass)
+					return ret;
+			}
+		}
+
+		return testStop();
+	}
+
+	void cleanup() override
+	{
+		buffer_.reset();
+
+		if (!directory_.empty())
+			std::filesystem::remove_all(directory_);
+	}
+
+private:
+	std::filesystem::path directory_;
+	std::filesystem::path sequence_;
+	std::unique_ptr<FrameBuffer> buffer_;
+};
+
+TEST_REGISTER(ImagePrefetchTest)
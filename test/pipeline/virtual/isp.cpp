@@ -0,0 +1,303 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Virtual pipeline software ISP test
+ *
+ * Capture the raw Bayer frames of the virtual sensor along with the frames
+ * processed by the software ISP, and check that the colour bars test pattern
+ * is recovered in the processed output.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <libcamera/camera.h>
+#include <libcamera/camera_manager.h>
+#include <libcamera/control_ids.h>
+#include <libcamera/formats.h>
+#include <libcamera/framebuffer_allocator.h>
+
+#include <libcamera/base/event_dispatcher.h>
+#include <libcamera/base/thread.h>
+#include <libcamera/base/timer.h>
+
+#include "libcamera/internal/formats.h"
+#include "libcamera/internal/mapped_framebuffer.h"
+
+#include "test.h"
+
+using namespace libcamera;
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace {
+
+class VirtualIspTest : public Test
+{
+protected:
+	void requestComplete([[maybe_unused]] Request *request)
+	{
+		completed_++;
+		dispatcher_->interrupt();
+	}
+
+	int init() override
+	{
+		cm_ = std::make_unique<CameraManager>();
+		if (cm_->start()) {
+			cout << "Failed to start camera manager" << endl;
+			return TestFail;
+		}
+
+		camera_ = cm_->get("Virtual4");
+		if (!camera_) {
+			cout << "Virtual raw camera not available" << endl;
+			return TestSkip;
+		}
+
+		dispatcher_ = Thread::current()->eventDispatcher();
+
+		return TestPass;
+	}
+
+	int configure()
+	{
+		config_ = camera_->generateConfiguration({ StreamRole::Raw,
+							   StreamRole::Viewfinder });
+		if (!config_ || config_->size() != 2) {
+			cout << "Failed to generate configuration" << endl;
+			return TestFail;
+		}
+
+		/*
+		 * Without the software ISP, processed streams are produced
+		 * directly from the test pattern in NV12.
+		 */
+		StreamConfiguration &cfg = config_->at(1);
+		if (cfg.pixelFormat == formats::NV12) {
+			cout << "Software ISP not available" << endl;
+			return TestSkip;
+		}
+
+		/* Select a packed RGB format to sample the output. */
+		const std::vector<PixelFormat> formats = cfg.formats().pixelformats();
+		for (const PixelFormat &format : { formats::XRGB8888, formats::RGB888 }) {
+			if (std::find(formats.begin(), formats.end(), format) != formats.end()) {
+				cfg.pixelFormat = format;
+				break;
+			}
+		}
+
+		if (cfg.pixelFormat != formats::XRGB8888 &&
+		    cfg.pixelFormat != formats::RGB888) {
+			cout << "No packed RGB output format" << endl;
+			return TestSkip;
+		}
+
+		if (config_->validate() != CameraConfiguration::Valid ||
+		    camera_->configure(config_.get())) {
+			cout << "Failed to configure the camera" << endl;
+			return TestFail;
+		}
+
+		if (PixelFormatInfo::info(config_->at(0).pixelFormat).colourEncoding !=
+		    PixelFormatInfo::ColourEncodingRAW) {
+			cout << "Raw stream not configured" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	/*
+	 * Sample the centre of the colour bars on the middle line of the
+	 * processed frame, as { R, G, B } triplets. The packed RGB formats are
+	 * stored in BGR(X) order in memory.
+	 */
+	std::vector<std::array<uint8_t, 3>> sampleBars(FrameBuffer *buffer)
+	{
+		static constexpr unsigned int kBars = 8;
+
+		const StreamConfiguration &cfg = config_->at(1);
+		unsigned int bpp = cfg.pixelFormat == formats::XRGB8888 ? 4 : 3;
+
+		MappedFrameBuffer map(buffer, MappedFrameBuffer::MapFlag::Read);
+		const uint8_t *line = map.planes()[0].data() +
+				      cfg.size.height / 2 * cfg.stride;
+
+		std::vector<std::array<uint8_t, 3>> bars;
+		for (unsigned int i = 0; i < kBars; ++i) {
+			unsigned int x = (2 * i + 1) * cfg.size.width / (2 * kBars);
+			const uint8_t *pixel = line + x * bpp;
+
+			bars.push_back({ pixel[2], pixel[1], pixel[0] });
+		}
+
+		return bars;
+	}
+
+	int checkRequest(Request *request)
+	{
+		if (request->status() != Request::RequestComplete) {
+			cout << "Request " << request->cookie() << " not completed"
+			     << endl;
+			return TestFail;
+		}
+
+		const FrameBuffer *raw = request->findBuffer(config_->at(0).stream());
+		const FrameBuffer *processed = request->findBuffer(config_->at(1).stream());
+		if (raw->metadata().status != FrameMetadata::FrameSuccess ||
+		    processed->metadata().status != FrameMetadata::FrameSuccess) {
+			cout << "Request " << request->cookie() << " buffers failed"
+			     << endl;
+			return TestFail;
+		}
+
+		if (raw->metadata().sequence != processed->metadata().sequence) {
+			cout << "Processed frame " << processed->metadata().sequence
+			     << " doesn't match raw frame " << raw->metadata().sequence
+			     << endl;
+			return TestFail;
+		}
+
+		/* The IPA reports the sensor controls it applied. */
+		const ControlList &metadata = request->metadata();
+		if (!metadata.contains(controls::ExposureTime.id()) ||
+		    !metadata.contains(controls::AnalogueGain.id())) {
+			cout << "IPA metadata missing for request "
+			     << request->cookie() << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		if (camera_->acquire()) {
+			cout << "Failed to acquire the camera" << endl;
+			return TestFail;
+		}
+
+		int ret = configure();
+		if (ret != TestPass)
+			return ret;
+
+		Stream *rawStream = config_->at(0).stream();
+		Stream *ispStream = config_->at(1).stream();
+
+		FrameBufferAllocator allocator(camera_);
+		if (allocator.allocate(rawStream) < 0 ||
+		    allocator.allocate(ispStream) < 0) {
+			cout << "Failed to allocate buffers" << endl;
+			return TestFail;
+		}
+
+		const auto &rawBuffers = allocator.buffers(rawStream);
+		const auto &ispBuffers = allocator.buffers(ispStream);
+		unsigned int count = std::min(rawBuffers.size(), ispBuffers.size());
+
+		std::vector<std::unique_ptr<Request>> requests;
+		for (unsigned int i = 0; i < count; ++i) {
+			std::unique_ptr<Request> request = camera_->createRequest(i);
+			if (!request ||
+			    request->addBuffer(rawStream, rawBuffers[i].get()) ||
+			    request->addBuffer(ispStream, ispBuffers[i].get())) {
+				cout << "Failed to create request" << endl;
+				return TestFail;
+			}
+
+			requests.push_back(std::move(request));
+		}
+
+		camera_->requestCompleted.connect(this, &VirtualIspTest::requestComplete);
+
+		if (camera_->start()) {
+			cout << "Failed to start camera" << endl;
+			return TestFail;
+		}
+
+		for (const std::unique_ptr<Request> &request : requests) {
+			if (camera_->queueRequest(request.get())) {
+				cout << "Failed to queue request" << endl;
+				return TestFail;
+			}
+		}
+
+		Timer timer;
+		timer.start(1s * requests.size());
+		while (timer.isRunning() && completed_ < requests.size())
+			dispatcher_->processEvents();
+
+		if (camera_->stop()) {
+			cout << "Failed to stop camera" << endl;
+			return TestFail;
+		}
+
+		if (completed_ < requests.size()) {
+			cout << "Only " << completed_ << " of " << requests.size()
+			     << " requests completed" << endl;
+			return TestFail;
+		}
+
+		for (const std::unique_ptr<Request> &request : requests) {
+			ret = checkRequest(request.get());
+			if (ret != TestPass)
+				return ret;
+		}
+
+		/*
+		 * The processed colours depend on the IPA algorithms, only
+		 * check the relative intensity of the colour components, on
+		 * the last frame to let the algorithms settle.
+		 */
+		enum { White, Yellow, Cyan, Green, Magenta, Red, Blue, Black };
+		enum { R, G, B };
+
+		std::vector<std::array<uint8_t, 3>> bars =
+			sampleBars(requests.back()->findBuffer(ispStream));
+
+		for (unsigned int c = R; c <= B; ++c) {
+			if (bars[White][c] <= bars[Black][c]) {
+				cout << "White bar not brighter than black bar" << endl;
+				return TestFail;
+			}
+		}
+
+		if (bars[Red][R] <= bars[Red][B] || bars[Red][R] <= bars[Red][G] ||
+		    bars[Green][G] <= bars[Green][R] || bars[Green][G] <= bars[Green][B] ||
+		    bars[Blue][B] <= bars[Blue][R] || bars[Blue][B] <= bars[Blue][G]) {
+			cout << "Primary colour bars not recovered" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	void cleanup() override
+	{
+		if (camera_) {
+			camera_->release();
+			camera_.reset();
+		}
+
+		cm_.reset();
+	}
+
+private:
+	std::unique_ptr<CameraManager> cm_;
+	std::shared_ptr<Camera> camera_;
+	std::unique_ptr<CameraConfiguration> config_;
+	EventDispatcher *dispatcher_;
+
+	std::atomic<unsigned int> completed_ = 0;
+};
+
+} /* namespace */
+
+TEST_REGISTER(VirtualIspTest)
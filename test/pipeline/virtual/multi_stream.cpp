@@ -0,0 +1,283 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Virtual pipeline multi-stream test
+ *
+ * Capture streams of different sizes and formats from a virtual camera, and
+ * check the scaled and converted streams against the full resolution NV12
+ * stream they are produced from.
+ */
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <string.h>
+#include <vector>
+
+#include <libcamera/camera.h>
+#include <libcamera/camera_manager.h>
+#include <libcamera/formats.h>
+#include <libcamera/framebuffer_allocator.h>
+
+#include <libcamera/base/event_dispatcher.h>
+#include <libcamera/base/thread.h>
+#include <libcamera/base/timer.h>
+
+#include "libcamera/internal/mapped_framebuffer.h"
+
+#include <libyuv/convert_argb.h>
+#include <libyuv/scale.h>
+
+#include "test.h"
+
+using namespace libcamera;
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace {
+
+class MultiStreamTest : public Test
+{
+protected:
+	void requestComplete([[maybe_unused]] Request *request)
+	{
+		completed_++;
+		dispatcher_->interrupt();
+	}
+
+	int init() override
+	{
+		cm_ = std::make_unique<CameraManager>();
+		if (cm_->start()) {
+			cout << "Failed to start camera manager" << endl;
+			return TestFail;
+		}
+
+		/* The first virtual camera supports a range of resolutions. */
+		camera_ = cm_->get("Virtual0");
+		if (!camera_) {
+			cout << "Virtual camera not available" << endl;
+			return TestSkip;
+		}
+
+		dispatcher_ = Thread::current()->eventDispatcher();
+
+		return TestPass;
+	}
+
+	int configure()
+	{
+		config_ = camera_->generateConfiguration({ StreamRole::VideoRecording,
+							   StreamRole::Viewfinder,
+							   StreamRole::Viewfinder });
+		if (!config_ || config_->size() != 3) {
+			cout << "Failed to generate configuration" << endl;
+			return TestFail;
+		}
+
+		const SizeRange sizes = config_->at(0).formats().range(formats::NV12);
+		if (sizes.min == sizes.max) {
+			cout << "Camera doesn't support scaling" << endl;
+			return TestSkip;
+		}
+
+		/*
+		 * Capture the source frame at the maximum resolution, along with
+		 * a scaled NV12 stream and a scaled XRGB8888 stream.
+		 */
+		config_->at(0).pixelFormat = formats::NV12;
+		config_->at(0).size = sizes.max;
+		config_->at(1).pixelFormat = formats::NV12;
+		config_->at(1).size = sizes.min;
+		config_->at(2).pixelFormat = formats::XRGB8888;
+		config_->at(2).size = sizes.min;
+
+		/* The colour spaces may be adjusted, but not the formats and sizes. */
+		if (config_->validate() == CameraConfiguration::Invalid ||
+		    config_->at(0).size != sizes.max ||
+		    config_->at(1).size != sizes.min ||
+		    config_->at(2).pixelFormat != formats::XRGB8888 ||
+		    camera_->configure(config_.get())) {
+			cout << "Failed to configure the camera" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	/*
+	 * Scale the \a source NV12 frame and convert it to the format of the
+	 * stream configuration \a cfg, as the pipeline handler does.
+	 */
+	std::vector<uint8_t> reference(const MappedFrameBuffer &source,
+				       const StreamConfiguration &src,
+				       const StreamConfiguration &cfg)
+	{
+		const Size &size = cfg.size;
+		std::vector<uint8_t> nv12(size.width * size.height * 3 / 2);
+		uint8_t *y = nv12.data();
+		uint8_t *uv = y + size.width * size.height;
+
+		libyuv::NV12Scale(source.planes()[0].data(), src.stride,
+				  source.planes()[1].data(), src.stride,
+				  src.size.width, src.size.height,
+				  y, size.width, uv, size.width,
+				  size.width, size.height,
+				  libyuv::FilterMode::kFilterBilinear);
+
+		if (cfg.pixelFormat == formats::NV12)
+			return nv12;
+
+		std::vector<uint8_t> argb(cfg.stride * size.height);
+		libyuv::NV12ToARGB(y, size.width, uv, size.width,
+				   argb.data(), cfg.stride,
+				   size.width, size.height);
+
+		return argb;
+	}
+
+	int checkRequest(Request *request)
+	{
+		if (request->status() != Request::RequestComplete) {
+			cout << "Request " << request->cookie() << " not completed"
+			     << endl;
+			return TestFail;
+		}
+
+		const StreamConfiguration &src = config_->at(0);
+		MappedFrameBuffer source(request->findBuffer(src.stream()),
+					 MappedFrameBuffer::MapFlag::Read);
+
+		for (unsigned int i = 1; i < config_->size(); i++) {
+			const StreamConfiguration &cfg = config_->at(i);
+			FrameBuffer *buffer = request->findBuffer(cfg.stream());
+
+			if (buffer->metadata().status != FrameMetadata::FrameSuccess ||
+			    buffer->metadata().sequence !=
+				    request->findBuffer(src.stream())->metadata().sequence) {
+				cout << "Stream " << i << " of request "
+				     << request->cookie() << " not captured" << endl;
+				return TestFail;
+			}
+
+			std::vector<uint8_t> expected = reference(source, src, cfg);
+
+			MappedFrameBuffer map(buffer, MappedFrameBuffer::MapFlag::Read);
+			size_t offset = 0;
+			for (const Span<uint8_t> &plane : map.planes()) {
+				if (memcmp(plane.data(), expected.data() + offset,
+					   plane.size())) {
+					cout << "Stream " << i << " " << cfg.toString()
+					     << " doesn't match the source frame" << endl;
+					return TestFail;
+				}
+
+				offset += plane.size();
+			}
+		}
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		if (camera_->acquire()) {
+			cout << "Failed to acquire the camera" << endl;
+			return TestFail;
+		}
+
+		int ret = configure();
+		if (ret != TestPass)
+			return ret;
+
+		FrameBufferAllocator allocator(camera_);
+		for (const StreamConfiguration &cfg : *config_) {
+			if (allocator.allocate(cfg.stream()) < 0) {
+				cout << "Failed to allocate buffers" << endl;
+				return TestFail;
+			}
+		}
+
+		std::vector<std::unique_ptr<Request>> requests;
+		for (unsigned int i = 0; i < kRequests; i++) {
+			std::unique_ptr<Request> request = camera_->createRequest(i);
+			if (!request) {
+				cout << "Failed to create request" << endl;
+				return TestFail;
+			}
+
+			for (const StreamConfiguration &cfg : *config_) {
+				Stream *stream = cfg.stream();
+				if (request->addBuffer(stream, allocator.buffers(stream)[i].get())) {
+					cout << "Failed to add buffer to request" << endl;
+					return TestFail;
+				}
+			}
+
+			requests.push_back(std::move(request));
+		}
+
+		camera_->requestCompleted.connect(this, &MultiStreamTest::requestComplete);
+
+		if (camera_->start()) {
+			cout << "Failed to start camera" << endl;
+			return TestFail;
+		}
+
+		for (const std::unique_ptr<Request> &request : requests) {
+			if (camera_->queueRequest(request.get())) {
+				cout << "Failed to queue request" << endl;
+				return TestFail;
+			}
+		}
+
+		Timer timer;
+		timer.start(1s * requests.size());
+		while (timer.isRunning() && completed_ < requests.size())
+			dispatcher_->processEvents();
+
+		if (camera_->stop()) {
+			cout << "Failed to stop camera" << endl;
+			return TestFail;
+		}
+
+		if (completed_ < requests.size()) {
+			cout << "Only " << completed_ << " of " << requests.size()
+			     << " requests completed" << endl;
+			return TestFail;
+		}
+
+		for (const std::unique_ptr<Request> &request : requests) {
+			ret = checkRequest(request.get());
+			if (ret != TestPass)
+				return ret;
+		}
+
+		return TestPass;
+	}
+
+	void cleanup() override
+	{
+		if (camera_) {
+			camera_->release();
+			camera_.reset();
+		}
+
+		cm_.reset();
+	}
+
+private:
+	static constexpr unsigned int kRequests = 2;
+
+	std::unique_ptr<CameraManager> cm_;
+	std::shared_ptr<Camera> camera_;
+	std::unique_ptr<CameraConfiguration> config_;
+	EventDispatcher *dispatcher_;
+
+	std::atomic<unsigned int> completed_ = 0;
+};
+
+} /* namespace */
+
+TEST_REGISTER(MultiStreamTest)
@@ -0,0 +1,358 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Virtual pipeline recording round-trip test
+ *
+ * Record frames from a virtual raw camera with the recording index writer used
+ * by 'cam --record', and parse the recording index back with the virtual
+ * pipeline handler configuration parser.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <variant>
+#include <vector>
+
+#include <libcamera/camera.h>
+#include <libcamera/camera_manager.h>
+#include <libcamera/control_ids.h>
+#include <libcamera/framebuffer_allocator.h>
+
+#include <libcamera/base/event_dispatcher.h>
+#include <libcamera/base/file.h>
+#include <libcamera/base/thread.h>
+#include <libcamera/base/timer.h>
+
+#include "libcamera/internal/camera.h"
+#include "libcamera/internal/mapped_framebuffer.h"
+
+#include "config_parser.h"
+#include "recording_writer.h"
+#include "test.h"
+
+using namespace libcamera;
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace {
+
+class RecordingTest : public Test
+{
+protected:
+	struct Capture {
+		uint32_t sequence;
+		uint64_t timestamp;
+	};
+
+	void requestComplete(Request *request)
+	{
+		if (request->status() == Request::RequestComplete) {
+			FrameBuffer *buffer = request->buffers().begin()->second;
+			Capture &capture = captures_[request->cookie()];
+
+			recordFrame(buffer, request);
+
+			capture.sequence = buffer->metadata().sequence;
+			capture.timestamp = request->metadata().get(controls::SensorTimestamp)
+						    .value_or(buffer->metadata().timestamp);
+		}
+
+		completed_++;
+		dispatcher_->interrupt();
+	}
+
+	int init() override
+	{
+		cm_ = std::make_unique<CameraManager>();
+		if (cm_->start()) {
+			cout << "Failed to start camera manager" << endl;
+			return TestFail;
+		}
+
+		/* Recordings are limited to raw Bayer frames. */
+		camera_ = cm_->get("Virtual4");
+		if (!camera_) {
+			cout << "Virtual raw camera not available" << endl;
+			return TestSkip;
+		}
+
+		char directory[] = "/tmp/libcamera.recording.XXXXXX";
+		if (!mkdtemp(directory)) {
+			cout << "Failed to create temporary directory" << endl;
+			return TestFail;
+		}
+
+		directory_ = directory;
+		dispatcher_ = Thread::current()->eventDispatcher();
+
+		return TestPass;
+	}
+
+	/*
+	 * Append the frame to a single file, as 'cam --record' does with a
+	 * file pattern without a '#', and record its offset in the index.
+	 */
+	void recordFrame(FrameBuffer *buffer, Request *request)
+	{
+		off_t offset = frames_.tellp();
+
+		MappedFrameBuffer map(buffer, MappedFrameBuffer::MapFlag::Read);
+		for (unsigned int i = 0; i < map.planes().size(); ++i) {
+			const Span<uint8_t> &data = map.planes()[i];
+			size_t length = std::min<size_t>(buffer->metadata().planes()[i].bytesused,
+							 data.size());
+
+			frames_.write(reinterpret_cast<const char *>(data.data()), length);
+		}
+
+		frames_.flush();
+		recorder_.write(buffer, request, directory_ / "frames.bin", offset);
+	}
+
+	/* Select a control to record with the first request. */
+	unsigned int recordedControl(ControlList *controls)
+	{
+		for (const auto &[id, info] : camera_->controls()) {
+			const ControlValue &value = info.def();
+			if (value.isArray())
+				continue;
+
+			/* Only numerical and boolean controls are recorded. */
+			switch (value.type()) {
+			case ControlTypeBool:
+			case ControlTypeInteger32:
+			case ControlTypeInteger64:
+			case ControlTypeFloat:
+				break;
+			default:
+				continue;
+			}
+
+			controls->set(id->id(), value);
+			return id->id();
+		}
+
+		return 0;
+	}
+
+	int record()
+	{
+		if (camera_->acquire()) {
+			cout << "Failed to acquire the camera" << endl;
+			return TestFail;
+		}
+
+		config_ = camera_->generateConfiguration({ StreamRole::Raw });
+		if (!config_ || camera_->configure(config_.get())) {
+			cout << "Failed to configure the camera" << endl;
+			return TestFail;
+		}
+
+		Stream *stream = config_->at(0).stream();
+		allocator_ = std::make_unique<FrameBufferAllocator>(camera_);
+		if (allocator_->allocate(stream) < 0) {
+			cout << "Failed to allocate buffers" << endl;
+			return TestFail;
+		}
+
+		frames_.open(directory_ / "frames.bin", std::ios::binary);
+		if (!frames_ ||
+		    recorder_.open(directory_ / "stream0.yaml", config_->at(0))) {
+			cout << "Failed to open the recording files" << endl;
+			return TestFail;
+		}
+
+		for (const std::unique_ptr<FrameBuffer> &buffer : allocator_->buffers(stream)) {
+			std::unique_ptr<Request> request =
+				camera_->createRequest(requests_.size());
+			if (!request || request->addBuffer(stream, buffer.get())) {
+				cout << "Failed to create request" << endl;
+				return TestFail;
+			}
+
+			requests_.push_back(std::move(request));
+		}
+
+		control_ = recordedControl(&requests_[0]->controls());
+		captures_.resize(requests_.size());
+
+		camera_->requestCompleted.connect(this, &RecordingTest::requestComplete);
+
+		if (camera_->start()) {
+			cout << "Failed to start camera" << endl;
+			return TestFail;
+		}
+
+		for (std::unique_ptr<Request> &request : requests_) {
+			if (camera_->queueRequest(request.get())) {
+				cout << "Failed to queue request" << endl;
+				return TestFail;
+			}
+		}
+
+		Timer timer;
+		timer.start(500ms * requests_.size());
+		while (timer.isRunning() && completed_ < requests_.size())
+			dispatcher_->processEvents();
+
+		if (camera_->stop()) {
+			cout << "Failed to stop camera" << endl;
+			return TestFail;
+		}
+
+		for (const std::unique_ptr<Request> &request : requests_) {
+			if (request->status() != Request::RequestComplete) {
+				cout << "Request " << request->cookie()
+				     << " not completed" << endl;
+				return TestFail;
+			}
+		}
+
+		frames_.close();
+		if (!frames_) {
+			cout << "Failed to write the frames" << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int replay()
+	{
+		std::filesystem::path configPath = directory_ / "virtual.yaml";
+		std::ofstream(configPath)
+			<< "\"Replay\":" << endl
+			<< "  recording:" << endl
+			<< "    path: \"" << (directory_ / "stream0.yaml").string()
+			<< "\"" << endl;
+
+		File file(configPath.string());
+		if (!file.open(File::OpenModeFlag::ReadOnly)) {
+			cout << "Failed to open configuration file" << endl;
+			return TestFail;
+		}
+
+		std::vector<std::unique_ptr<VirtualCameraData>> cameras =
+			ConfigParser().parseConfigFile(file, camera_->_d()->pipe());
+		if (cameras.size() != 1) {
+			cout << "Failed to parse the recording" << endl;
+			return TestFail;
+		}
+
+		const auto *recording =
+			std::get_if<RecordingFrames>(&cameras[0]->config_.frame);
+		if (!recording) {
+			cout << "Camera doesn't replay a recording" << endl;
+			return TestFail;
+		}
+
+		const StreamConfiguration &cfg = config_->at(0);
+		if (recording->format != cfg.pixelFormat ||
+		    recording->size != cfg.size || recording->stride != cfg.stride) {
+			cout << "Recorded format " << recording->format << "/"
+			     << recording->size << " doesn't match " << cfg.toString()
+			     << endl;
+			return TestFail;
+		}
+
+		if (recording->frames.size() != requests_.size()) {
+			cout << "Recorded " << recording->frames.size() << " frames, expected "
+			     << requests_.size() << endl;
+			return TestFail;
+		}
+
+		std::ifstream frames(directory_ / "frames.bin", std::ios::binary);
+		std::vector<char> data(cfg.frameSize);
+
+		for (unsigned int i = 0; i < requests_.size(); ++i) {
+			const RecordedFrame &frame = recording->frames[i];
+			const Capture &capture = captures_[i];
+
+			if (frame.file != directory_ / "frames.bin" ||
+			    frame.offset != static_cast<size_t>(i) * cfg.frameSize) {
+				cout << "Frame " << i << " recorded at " << frame.file
+				     << ":" << frame.offset << endl;
+				return TestFail;
+			}
+
+			if (frame.sequence != capture.sequence ||
+			    frame.timestamp != capture.timestamp) {
+				cout << "Frame " << i << " recorded with sequence "
+				     << frame.sequence << " and timestamp "
+				     << frame.timestamp << endl;
+				return TestFail;
+			}
+
+			if (frame.controls.contains(control_) != (control_ && i == 0)) {
+				cout << "Request controls not recorded for frame " << i
+				     << endl;
+				return TestFail;
+			}
+
+			/* The buffers haven't been requeued and still hold the frames. */
+			FrameBuffer *buffer = requests_[i]->buffers().begin()->second;
+			MappedFrameBuffer map(buffer, MappedFrameBuffer::MapFlag::Read);
+
+			frames.seekg(frame.offset);
+			if (!frames.read(data.data(), data.size()) ||
+			    memcmp(data.data(), map.planes()[0].data(), data.size())) {
+				cout << "Frame " << i << " data mismatch" << endl;
+				return TestFail;
+			}
+		}
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		int ret = record();
+		if (ret != TestPass)
+			return ret;
+
+		return replay();
+	}
+
+	void cleanup() override
+	{
+		requests_.clear();
+		allocator_.reset();
+
+		if (camera_) {
+			camera_->release();
+			camera_.reset();
+		}
+
+		cm_.reset();
+
+		if (!directory_.empty())
+			std::filesystem::remove_all(directory_);
+	}
+
+private:
+	std::unique_ptr<CameraManager> cm_;
+	std::shared_ptr<Camera> camera_;
+	std::unique_ptr<CameraConfiguration> config_;
+	std::unique_ptr<FrameBufferAllocator> allocator_;
+	std::vector<std::unique_ptr<Request>> requests_;
+	EventDispatcher *dispatcher_;
+
+	std::filesystem::path directory_;
+	std::ofstream frames_;
+	RecordingWriter recorder_;
+	std::vector<Capture> captures_;
+	std::atomic<unsigned int> completed_ = 0;
+	unsigned int control_ = 0;
+};
+
+} /* namespace */
+
+TEST_REGISTER(RecordingTest)
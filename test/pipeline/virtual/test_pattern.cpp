@@ -0,0 +1,171 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Virtual pipeline test pattern generator test
+ *
+ * Check the NV12 frames copied from the pre-rendered test patterns against
+ * the scrolled template converted frame by frame.
+ */
+
+#include <iostream>
+#include <memory>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include <libcamera/base/memfd.h>
+#include <libcamera/base/shared_fd.h>
+
+#include <libcamera/formats.h>
+#include <libcamera/framebuffer.h>
+
+#include "libcamera/internal/formats.h"
+#include "libcamera/internal/mapped_framebuffer.h"
+
+#include <libyuv/convert_from_argb.h>
+
+#include "test.h"
+#include "test_pattern_generator.h"
+
+using namespace libcamera;
+using namespace std;
+
+namespace {
+
+constexpr unsigned int kARGBSize = 4;
+
+/* Expose the ARGB template of a test pattern to render the reference frames. */
+template<typename Generator>
+class ReferenceGenerator : public Generator
+{
+public:
+	std::vector<uint8_t> argb(const Size &size)
+	{
+		this->generateTemplate(size);
+
+		const uint8_t *data = this->template_.get();
+		return { data, data + size.width * size.height * kARGBSize };
+	}
+};
+
+} /* namespace */
+
+class TestPatternTest : public Test
+{
+protected:
+	std::unique_ptr<FrameBuffer> createBuffer(const Size &size)
+	{
+		const PixelFormatInfo &info = PixelFormatInfo::info(formats::NV12);
+
+		SharedFD fd(MemFd::create("test-pattern", info.frameSize(size, 1)));
+		if (!fd.isValid())
+			return nullptr;
+
+		std::vector<FrameBuffer::Plane> planes;
+		unsigned int offset = 0;
+
+		for (unsigned int i = 0; i < info.numPlanes(); i++) {
+			unsigned int length = info.planeSize(size, i, 1);
+			planes.push_back({ fd, offset, length });
+			offset += length;
+		}
+
+		return std::make_unique<FrameBuffer>(planes);
+	}
+
+	/*
+	 * Convert the template scrolled by \a offset columns to NV12, as the
+	 * generator did for every frame before pre-rendering the pattern.
+	 */
+	std::vector<uint8_t> reference(const std::vector<uint8_t> &argb,
+				       const Size &size, unsigned int offset)
+	{
+		const size_t rowSize = size.width * kARGBSize;
+		const size_t shift = offset * kARGBSize;
+		std::vector<uint8_t> scrolled(argb.size());
+
+		for (unsigned int y = 0; y < size.height; y++) {
+			const uint8_t *src = argb.data() + y * rowSize;
+			uint8_t *dst = scrolled.data() + y * rowSize;
+
+			memcpy(dst, src + shift, rowSize - shift);
+			memcpy(dst + rowSize - shift, src, shift);
+		}
+
+		std::vector<uint8_t> nv12(PixelFormatInfo::info(formats::NV12).frameSize(size, 1));
+		libyuv::ARGBToNV12(scrolled.data(), rowSize,
+				   nv12.data(), size.width,
+				   nv12.data() + size.width * size.height, size.width,
+				   size.width, size.height);
+
+		return nv12;
+	}
+
+	template<typename Generator>
+	int testPattern(const char *name, const Size &size)
+	{
+		Generator generator;
+		if (generator.configure(formats::NV12, size)) {
+			cerr << "Failed to configure " << name << " generator" << endl;
+			return TestFail;
+		}
+
+		std::vector<uint8_t> argb = ReferenceGenerator<Generator>().argb(size);
+
+		std::unique_ptr<FrameBuffer> buffer = createBuffer(size);
+		if (!buffer) {
+			cerr << "Failed to create buffer" << endl;
+			return TestFail;
+		}
+
+		MappedFrameBuffer map(buffer.get(), MappedFrameBuffer::MapFlag::Read);
+		const auto &planes = map.planes();
+		const size_t ySize = planes[0].size();
+
+		/*
+		 * Cover even and odd offsets, and wrap around the width of the
+		 * pattern.
+		 */
+		for (unsigned int frame = 1; frame <= size.width + 2; frame++) {
+			if (generator.generateFrame(size, buffer.get())) {
+				cerr << "Failed to generate " << name << " frame "
+				     << frame << endl;
+				return TestFail;
+			}
+
+			unsigned int offset = frame % size.width;
+			std::vector<uint8_t> expected = reference(argb, size, offset);
+
+			if (memcmp(planes[0].data(), expected.data(), ySize) ||
+			    memcmp(planes[1].data(), expected.data() + ySize,
+				   planes[1].size())) {
+				cerr << "Frame " << frame << " of " << name
+				     << " doesn't match the pattern at offset "
+				     << offset << endl;
+				return TestFail;
+			}
+		}
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		const Size sizes[] = { { 64, 16 }, { 48, 10 } };
+
+		for (const Size &size : sizes) {
+			int ret = testPattern<ColorBarsGenerator>("color bars", size);
+			if (ret != TestPass)
+				return ret;
+
+			ret = testPattern<DiagonalLinesGenerator>("diagonal lines", size);
+			if (ret != TestPass)
+				return ret;
+		}
+
+		return TestPass;
+	}
+};
+
+TEST_REGISTER(TestPatternTest)
@@ -298,6 +298,62 @@ class SimpleCaptureMethods(CameraTesterBase):
 
         cam.stop()
 
+    def test_batch(self):
+        cm = self.cm
+        cam = self.cam
+
+        camconfig = cam.generate_configuration([libcam.StreamRole.StillCapture])
+        self.assertTrue(camconfig.size == 1)
+
+        cam.configure(camconfig)
+
+        stream = camconfig.at(0).stream
+
+        allocator = libcam.FrameBufferAllocator(cam)
+        num_bufs = allocator.allocate(stream)
+        self.assertTrue(num_bufs > 1)
+
+        reqs = []
+        for i in range(num_bufs):
+            req = cam.create_request(i)
+            self.assertIsNotNone(req)
+
+            req.add_buffer(stream, allocator.buffers(stream)[i])
+
+            reqs.append(req)
+
+        cam.start()
+
+        # A batch containing the same request twice must be rejected
+        libcam.log_set_level('Camera', 'FATAL')
+        with self.assertRaises(RuntimeError):
+            cam.queue_requests([reqs[0], reqs[1], reqs[0]])
+        libcam.log_set_level('Camera', 'INFO')
+
+        cam.queue_requests(reqs)
+
+        reqs = None
+        gc.collect()
+
+        sel = selectors.DefaultSelector()
+        sel.register(cm.event_fd, selectors.EVENT_READ)
+
+        reqs = []
+
+        while len(reqs) < num_bufs:
+            sel.select()
+            reqs += cm.get_ready_requests()
+
+        self.assertTrue(len(reqs) == num_bufs)
+
+        for i, req in enumerate(reqs):
+            self.assertTrue(i == req.cookie)
+
+        reqs = None
+        gc.collect()
+
+        cam.stop()
+
 
 # Recursively expand slist's objects into olist, using seen to track already
 # processed objects.
@@ -0,0 +1,213 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Serialize and deserialize control lists in delta sessions
+ */
+
+#include <iostream>
+#include <vector>
+
+#include <libcamera/control_ids.h>
+#include <libcamera/controls.h>
+
+#include "libcamera/internal/byte_stream_buffer.h"
+#include "libcamera/internal/control_serializer.h"
+
+#include "serialization_test.h"
+#include "test.h"
+
+using namespace std;
+using namespace libcamera;
+
+class ControlDeltaSerializationTest : public Test
+{
+protected:
+	int run() override
+	{
+		ControlSerializer serializer(ControlSerializer::Role::Worker);
+		ControlSerializer deserializer(ControlSerializer::Role::Proxy);
+		std::vector<uint8_t> data;
+
+		ControlList list(controls::controls);
+		list.set(controls::ExposureTime, 10000);
+		list.set(controls::AnalogueGain, 2.0f);
+		list.set(controls::ColourGains, { 1.5f, 1.2f });
+		list.set(controls::SensorTimestamp, 1000);
+
+		/* The first list of a session is fully serialized. */
+		if (serialize(serializer, list, data) != ControlSerializer::binarySize(list)) {
+			cerr << "First list of a session should be fully serialized"
+			     << endl;
+			return TestFail;
+		}
+
+		if (!check(deserializer, list, data))
+			return TestFail;
+
+		/* Changing a single control should produce a smaller packet. */
+		list.set(controls::SensorTimestamp, 2000);
+
+		if (serialize(serializer, list, data) >= ControlSerializer::binarySize(list)) {
+			cerr << "Delta packet isn't smaller than the full list"
+			     << endl;
+			return TestFail;
+		}
+
+		if (!check(deserializer, list, data))
+			return TestFail;
+
+		/* Removed controls must be removed from the reconstructed list. */
+		ControlList shorter(controls::controls);
+		shorter.set(controls::ExposureTime, 10000);
+		shorter.set(controls::AnalogueGain, 2.0f);
+		shorter.set(controls::ColourGains, { 1.5f, 1.2f });
+
+		serialize(serializer, shorter, data);
+		if (!check(deserializer, shorter, data))
+			return TestFail;
+
+		/* Changing all controls falls back to a full synchronization. */
+		list.set(controls::ExposureTime, 20000);
+		list.set(controls::AnalogueGain, 4.0f);
+		list.set(controls::ColourGains, { 1.8f, 1.1f });
+		list.set(controls::SensorTimestamp, 3000);
+
+		if (serialize(serializer, list, data) != ControlSerializer::binarySize(list)) {
+			cerr << "Full change should fall back to a full list"
+			     << endl;
+			return TestFail;
+		}
+
+		if (!check(deserializer, list, data))
+			return TestFail;
+
+		/*
+		 * An out of sequence delta packet can't be applied, only the
+		 * controls it carries must be returned.
+		 */
+		list.set(controls::SensorTimestamp, 4000);
+		serialize(serializer, list, data);
+
+		list.set(controls::SensorTimestamp, 5000);
+		serialize(serializer, list, data);
+
+		ByteStreamBuffer buffer(const_cast<const uint8_t *>(data.data()),
+					data.size());
+		ControlList newList = deserializer.deserialize<ControlList>(buffer);
+		if (!isPartial(newList, 5000)) {
+			cerr << "Out of sequence delta packet should produce a partial list"
+			     << endl;
+			return TestFail;
+		}
+
+		/*
+		 * The session recovers with the next periodic synchronization
+		 * packet, and all delta packets until then produce partial
+		 * lists.
+		 */
+		unsigned int rejected = 0;
+		for (unsigned int i = 0; i < kSyncInterval; ++i) {
+			list.set(controls::SensorTimestamp, 6000 + i);
+			serialize(serializer, list, data);
+
+			ByteStreamBuffer packet(const_cast<const uint8_t *>(data.data()),
+						data.size());
+			ControlList received = deserializer.deserialize<ControlList>(packet);
+			if (isPartial(received, 6000 + i)) {
+				rejected++;
+				continue;
+			}
+
+			if (!SerializationTest::equals(list, received)) {
+				cerr << "Resynchronized list doesn't match original"
+				     << endl;
+				return TestFail;
+			}
+
+			break;
+		}
+
+		if (rejected == kSyncInterval) {
+			cerr << "Session not resynchronized after a lost packet"
+			     << endl;
+			return TestFail;
+		}
+
+		/* Delta packets are accepted again after the resynchronization. */
+		list.set(controls::SensorTimestamp, 7000);
+		if (serialize(serializer, list, data) >= ControlSerializer::binarySize(list)) {
+			cerr << "Delta packets not resumed after resynchronization"
+			     << endl;
+			return TestFail;
+		}
+
+		if (!check(deserializer, list, data))
+			return TestFail;
+
+		/* Resetting both sides restarts the session with a full list. */
+		serializer.reset();
+		deserializer.reset();
+
+		if (serialize(serializer, list, data) != ControlSerializer::binarySize(list)) {
+			cerr << "First list after reset should be fully serialized"
+			     << endl;
+			return TestFail;
+		}
+
+		if (!check(deserializer, list, data))
+			return TestFail;
+
+		return TestPass;
+	}
+
+private:
+	static constexpr unsigned int kSession = 1;
+
+	/* Check that a list only carries the sensor timestamp. */
+	static bool isPartial(const ControlList &list, int64_t timestamp)
+	{
+		return list.size() == 1 &&
+		       list.get(controls::SensorTimestamp) == timestamp;
+	}
+	/* Maximum number of consecutive delta packets in a session */
+	static constexpr unsigned int kSyncInterval = 30;
+
+	size_t serialize(ControlSerializer &serializer, const ControlList &list,
+			 std::vector<uint8_t> &data)
+	{
+		data.resize(ControlSerializer::binarySize(list));
+		ByteStreamBuffer buffer(data.data(), data.size());
+
+		int ret = serializer.serialize(list, kSession, buffer);
+		if (ret || buffer.overflow()) {
+			cerr << "Failed to serialize ControlList" << endl;
+			data.clear();
+			return 0;
+		}
+
+		data.resize(buffer.offset());
+		return data.size();
+	}
+
+	bool check(ControlSerializer &deserializer, const ControlList &list,
+		   const std::vector<uint8_t> &data)
+	{
+		ByteStreamBuffer buffer(data.data(), data.size());
+
+		ControlList newList = deserializer.deserialize<ControlList>(buffer);
+		if (buffer.overflow()) {
+			cerr << "Overflow when deserializing ControlList" << endl;
+			return false;
+		}
+
+		if (!SerializationTest::equals(list, newList)) {
+			cerr << "Deserialized list doesn't match original" << endl;
+			return false;
+		}
+
+		return true;
+	}
+};
+
+TEST_REGISTER(ControlDeltaSerializationTest)
@@ -0,0 +1,431 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Copyright (C) 2026, Google Inc.
+ *
+ * Software converter tests and throughput benchmark
+ *
+ * The benchmark only runs when the test is invoked with the --benchmark
+ * argument, as done by 'meson test --benchmark'.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include <libcamera/base/event_dispatcher.h>
+#include <libcamera/base/memfd.h>
+#include <libcamera/base/message.h>
+#include <libcamera/base/shared_fd.h>
+#include <libcamera/base/thread.h>
+#include <libcamera/base/timer.h>
+#include <libcamera/base/utils.h>
+
+#include <libcamera/formats.h>
+#include <libcamera/framebuffer.h>
+#include <libcamera/stream.h>
+
+#include "libcamera/internal/converter.h"
+#include "libcamera/internal/formats.h"
+#include "libcamera/internal/framebuffer.h"
+#include "libcamera/internal/mapped_framebuffer.h"
+
+#include "test.h"
+
+using namespace libcamera;
+using namespace std;
+using namespace std::chrono_literals;
+
+namespace {
+
+uint8_t patternY(unsigned int x, unsigned int y)
+{
+	return (x + 3 * y) & 0xff;
+}
+
+uint8_t patternU(unsigned int x, [[maybe_unused]] unsigned int y)
+{
+	return (64 + x / 4) & 0xff;
+}
+
+uint8_t patternV([[maybe_unused]] unsigned int x, unsigned int y)
+{
+	return (192 - y / 4) & 0xff;
+}
+
+} /* namespace */
+
+class SoftwareConverterTest : public Test
+{
+protected:
+	int init() override
+	{
+		converter_ = ConverterFactoryBase::create("software");
+		if (!converter_) {
+			cerr << "Failed to create software converter" << endl;
+			return TestFail;
+		}
+
+		converter_->inputBufferReady.connect(this, &SoftwareConverterTest::inputDone);
+		converter_->outputBufferReady.connect(this, &SoftwareConverterTest::outputDone);
+
+		return TestPass;
+	}
+
+	int run() override
+	{
+		int ret = testConversion();
+		if (ret != TestPass)
+			return ret;
+
+		const std::vector<std::string> &arguments = args();
+		if (std::find(arguments.begin(), arguments.end(), "--benchmark") ==
+		    arguments.end())
+			return TestPass;
+
+		return benchmark();
+	}
+
+private:
+	std::unique_ptr<FrameBuffer> createBuffer(const PixelFormat &format,
+						  const Size &size)
+	{
+		const PixelFormatInfo &info = PixelFormatInfo::info(format);
+		auto [stride, frameSize] = converter_->strideAndFrameSize(format, size);
+
+		SharedFD fd(MemFd::create("software-converter", frameSize));
+		if (!fd.isValid())
+			return nullptr;
+
+		std::vector<FrameBuffer::Plane> planes;
+		unsigned int offset = 0;
+
+		for (unsigned int i = 0; i < info.numPlanes(); i++) {
+			unsigned int planeSize =
+				info.planeSize(size.height, i, info.stride(size.width, i));
+			planes.push_back({ fd, offset, planeSize });
+			offset += planeSize;
+		}
+
+		std::unique_ptr<FrameBuffer> buffer = std::make_unique<FrameBuffer>(planes);
+		buffer->_d()->metadata().status = FrameMetadata::FrameSuccess;
+
+		return buffer;
+	}
+
+	int configure(const StreamConfiguration &inputCfg,
+		      std::vector<StreamConfiguration> &outputCfgs)
+	{
+		std::vector<std::reference_wrapper<const StreamConfiguration>> cfgs;
+
+		streams_.resize(outputCfgs.size());
+
+		for (auto [i, cfg] : utils::enumerate(outputCfgs)) {
+			cfg.setStream(&streams_[i]);
+			std::tie(cfg.stride, cfg.frameSize) =
+				converter_->strideAndFrameSize(cfg.pixelFormat, cfg.size);
+			cfgs.push_back(cfg);
+		}
+
+		return converter_->configure(inputCfg, cfgs);
+	}
+
+	int convert(FrameBuffer *input, const std::map<const Stream *, FrameBuffer *> &outputs,
+		    unsigned int count)
+	{
+		EventDispatcher *dispatcher = Thread::current()->eventDispatcher();
+
+		inputFrames_ = 0;
+		outputFrames_ = 0;
+
+		if (converter_->start()) {
+			cerr << "Failed to start converter" << endl;
+			return TestFail;
+		}
+
+		/*
+		 * Queue the same buffers repeatedly, waiting for each frame to
+		 * complete as the output buffers are reused.
+		 */
+		for (unsigned int i = 0; i < count; i++) {
+			if (converter_->queueBuffers(input, outputs)) {
+				cerr << "Failed to queue buffers" << endl;
+				converter_->stop();
+				return TestFail;
+			}
+
+			/*
+			 * Completion is reported through a message posted to
+			 * this thread, dispatch it without waiting for another
+			 * event.
+			 */
+			Timer timeout;
+			timeout.start(5000ms);
+			while (timeout.isRunning() && inputFrames_ <= i) {
+				dispatcher->processEvents();
+				Thread::current()->dispatchMessages(Message::Type::InvokeMessage);
+			}
+		}
+
+		converter_->stop();
+
+		if (inputFrames_ != count || outputFrames_ != count * outputs.size()) {
+			cerr << "Completed " << inputFrames_ << " input and "
+			     << outputFrames_ << " output buffers, expected "
+			     << count << endl;
+			return TestFail;
+		}
+
+		return TestPass;
+	}
+
+	int testConversion()
+	{
+		const Size inputSize{ 640, 480 };
+
+		StreamConfiguration inputCfg;
+		inputCfg.pixelFormat = formats::YUYV;
+		inputCfg.size = inputSize;
+		std::tie(inputCfg.stride, inputCfg.frameSize) =
+			converter_->strideAndFrameSize(inputCfg.pixelFormat, inputSize);
+
+		std::unique_ptr<FrameBuffer> input = createBuffer(formats::YUYV, inputSize);
+		if (!input) {
+			cerr << "Failed to create input buffer" << endl;
+			return TestFail;
+		}
+
+		{
+			MappedFrameBuffer map(input.get(), MappedFrameBuffer::MapFlag::Write);
+			uint8_t *data = map.planes()[0].data();
+
+			for (unsigned int y = 0; y < inputSize.height; y++) {
+				uint8_t *line = data + y * inputCfg.stride;
+
+				for (unsigned int x = 0; x < inputSize.width; x += 2) {
+					line[x * 2] = patternY(x, y);
+					line[x * 2 + 1] = patternU(x, y);
+					line[x * 2 + 2] = patternY(x + 1, y);
+					line[x * 2 + 3] = patternV(x, y);
+				}
+			}
+		}
+
+		std::vector<StreamConfiguration> cfgs(4);
+		cfgs[0].pixelFormat = formats::NV12;
+		cfgs[0].size = inputSize;
+		cfgs[1].pixelFormat = formats::YUYV;
+		cfgs[1].size = inputSize;
+		cfgs[2].pixelFormat = formats::XRGB8888;
+		cfgs[2].size = { 320, 240 };
+		cfgs[3].pixelFormat = formats::YUV420;
+		cfgs[3].size = { 320, 240 };
+
+		if (configure(inputCfg, cfgs)) {
+			cerr << "Failed to configure converter" << endl;
+			return TestFail;
+		}
+
+		Rectangle crop{ 100, 50, 320, 240 };
+		if (converter_->setInputCrop(&streams_[3], &crop) ||
+		    crop != Rectangle(100, 50, 320, 240)) {
+			cerr << "Failed to set crop rectangle, got " << crop << endl;
+			return TestFail;
+		}
+
+		std::vector<std::unique_ptr<FrameBuffer>> buffers;
+		std::map<const Stream *, FrameBuffer *> outputs;
+
+		for (const StreamConfiguration &cfg : cfgs) {
+			std::unique_ptr<FrameBuffer> buffer =
+				createBuffer(cfg.pixelFormat, cfg.size);
+			if (!buffer) {
+				cerr << "Failed to create output buffer" << endl;
+				return TestFail;
+			}
+
+			outputs[cfg.stream()] = buffer.get();
+			buffers.push_back(std::move(buffer));
+		}
+
+		int ret = convert(input.get(), outputs, 1);
+		if (ret != TestPass)
+			return ret;
+
+		MappedFrameBuffer in(input.get(), MappedFrameBuffer::MapFlag::Read);
+		MappedFrameBuffer nv12(buffers[0].get(), MappedFrameBuffer::MapFlag::Read);
+		MappedFrameBuffer yuyv(buffers[1].get(), MappedFrameBuffer::MapFlag::Read);
+		MappedFrameBuffer xrgb(buffers[2].get(), MappedFrameBuffer::MapFlag::Read);
+		MappedFrameBuffer yuv420(buffers[3].get(), MappedFrameBuffer::MapFlag::Read);
+
+		/* Format conversion. */
+		for (unsigned int y = 0; y < inputSize.height; y++) {
+			for (unsigned int x = 0; x < inputSize.width; x++) {
+				const uint8_t *uv = nv12.planes()[1].data() +
+						    y / 2 * inputSize.width + x / 2 * 2;
+
+				if (nv12.planes()[0].data()[y * inputSize.width + x] != patternY(x, y) ||
+				    uv[0] != patternU(x & ~1, y & ~1) ||
+				    uv[1] != patternV(x & ~1, y & ~1)) {
+					cerr << "Invalid NV12 pixel at " << Point(x, y) << endl;
+					return TestFail;
+				}
+			}
+		}
+
+		/* Copy. */
+		if (memcmp(in.planes()[0].data(), yuyv.planes()[0].data(),
+			   in.planes()[0].size())) {
+			cerr << "Invalid YUYV frame" << endl;
+			return TestFail;
+		}
+
+		/* Scaling and conversion to RGB. */
+		for (unsigned int y = 0; y < cfgs[2].size.height; y++) {
+			for (unsigned int x = 0; x < cfgs[2].size.width; x++) {
+				const uint8_t *pixel = xrgb.planes()[0].data() +
+						       y * cfgs[2].stride + x * 4;
+				const unsigned int sx = 2 * x + 1;
+				const unsigned int sy = 2 * y + 1;
+
+				const double c = patternY(sx, sy);
+				const double u = patternU(sx & ~1, sy) - 128.0;
+				const double v = patternV(sx & ~1, sy) - 128.0;
+				const double rgb[3] = {
+					c + 1.402 * v,
+					c - 0.344136 * u - 0.714136 * v,
+					c + 1.772 * u,
+				};
+
+				for (unsigned int i = 0; i < 3; i++) {
+					double expected = std::clamp(rgb[i], 0.0, 255.0);
+					/* XRGB8888 is stored as B, G, R, X. */
+					double value = pixel[2 - i];
+
+					if (std::abs(value - expected) > 2.0) {
+						cerr << "Invalid RGB pixel at " << Point(x, y)
+						     << ": " << value << " != " << expected
+						     << endl;
+						return TestFail;
+					}
+				}
+			}
+		}
+
+		/* Cropping. */
+		const Size &size = cfgs[3].size;
+		const uint8_t *planeY = yuv420.planes()[0].data();
+		const uint8_t *planeU = yuv420.planes()[1].data();
+		const uint8_t *planeV = yuv420.planes()[2].data();
+
+		for (unsigned int y = 0; y < size.height; y++) {
+			for (unsigned int x = 0; x < size.width; x++) {
+				const unsigned int sx = crop.x + x;
+				const unsigned int sy = crop.y + y;
+				const unsigned int offset = y / 2 * size.width / 2 + x / 2;
+
+				if (planeY[y * size.width + x] != patternY(sx, sy) ||
+				    planeU[offset] != patternU(sx & ~1, sy & ~1) ||
+				    planeV[offset] != patternV(sx & ~1, sy & ~1)) {
+					cerr << "Invalid YUV420 pixel at " << Point(x, y) << endl;
+					return TestFail;
+				}
+			}
+		}
+
+		return TestPass;
+	}
+
+	int benchmark()
+	{
+		struct Scenario {
+			PixelFormat input;
+			PixelFormat output;
+			Size outputSize;
+		};
+
+		static const Scenario scenarios[] = {
+			{ formats::YUYV, formats::YUYV, { 1920, 1080 } },
+			{ formats::YUYV, formats::NV12, { 1920, 1080 } },
+			{ formats::YUYV, formats::NV12, { 1280, 720 } },
+			{ formats::YUYV, formats::XRGB8888, { 1280, 720 } },
+			{ formats::NV12, formats::YUV420, { 640, 480 } },
+		};
+
+		constexpr unsigned int kFrames = 10;
+		const Size inputSize{ 1920, 1080 };
+
+		cout << "Software converter throughput for " << inputSize
+		     << " input frames:" << endl;
+
+		for (const Scenario &scenario : scenarios) {
+			StreamConfiguration inputCfg;
+			inputCfg.pixelFormat = scenario.input;
+			inputCfg.size = inputSize;
+			std::tie(inputCfg.stride, inputCfg.frameSize) =
+				converter_->strideAndFrameSize(scenario.input, inputSize);
+
+			std::vector<StreamConfiguration> cfgs(1);
+			cfgs[0].pixelFormat = scenario.output;
+			cfgs[0].size = scenario.outputSize;
+
+			if (configure(inputCfg, cfgs)) {
+				cerr << "Failed to configure converter" << endl;
+				return TestFail;
+			}
+
+			std::unique_ptr<FrameBuffer> input =
+				createBuffer(scenario.input, inputSize);
+			std::unique_ptr<FrameBuffer> output =
+				createBuffer(scenario.output, scenario.outputSize);
+			if (!input || !output) {
+				cerr << "Failed to create buffers" << endl;
+				return TestFail;
+			}
+
+			auto start = std::chrono::steady_clock::now();
+
+			int ret = convert(input.get(), { { &streams_[0], output.get() } },
+					  kFrames);
+			if (ret != TestPass)
+				return ret;
+
+			std::chrono::duration<double> duration =
+				std::chrono::steady_clock::now() - start;
+			double fps = kFrames / duration.count();
+
+			cout << "  " << scenario.input << " -> " << scenario.output
+			     << " " << scenario.outputSize << ": " << std::fixed
+			     << std::setprecision(1) << fps << " fps, "
+			     << fps * scenario.outputSize.width * scenario.outputSize.height / 1e6
+			     << " Mpixel/s" << endl;
+		}
+
+		return TestPass;
+	}
+
+	void inputDone([[maybe_unused]] FrameBuffer *buffer)
+	{
+		inputFrames_++;
+	}
+
+	void outputDone(FrameBuffer *buffer)
+	{
+		if (buffer->metadata().status == FrameMetadata::FrameSuccess)
+			outputFrames_++;
+	}
+
+	std::unique_ptr<Converter> converter_;
+	std::vector<Stream> streams_;
+
+	unsigned int inputFrames_;
+	unsigned int outputFrames_;
+};
+
+TEST_REGISTER(SoftwareConverterTest)
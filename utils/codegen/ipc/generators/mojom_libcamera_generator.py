@@ -222,6 +222,9 @@ def IsControls(element):
 def IsEnum(element):
     return mojom.IsEnumKind(element.kind)
 
+def DeltaSession(element):
+    return getattr(element, 'delta_session', 0)
+
 
 # Only works the enum definition, not types
 def IsScoped(element):
@@ -415,6 +418,22 @@ def ValidateInterfaces(interfaces):
         ValidateZeroLength(method.response_parameters,
                            f'{method.mojom_name} response parameters', False)
 
+# Assign a unique control serializer delta session number to all parameters
+# with the delta attribute
+def AssignDeltaSessions(interfaces):
+    session = 1
+    for interface in interfaces:
+        for method in interface.methods:
+            for param in method.parameters + (method.response_parameters or []):
+                if param.attributes is None or 'delta' not in param.attributes:
+                    continue
+
+                if not mojom.IsStructKind(param.kind) or param.kind.mojom_name != 'ControlList':
+                    raise Exception(f'Parameter {param.mojom_name} of {method.mojom_name}: the delta attribute is only valid for ControlList')
+
+                param.delta_session = session
+                session += 1
+
 class Generator(generator.Generator):
     @staticmethod
     def GetTemplatePrefix():
@@ -429,6 +448,7 @@ class Generator(generator.Generator):
             'choose': Choose,
             'comma_sep': CommaSep,
             'default_value': GetDefaultValue,
+            'delta_session': DeltaSession,
             'has_default_fields': HasDefaultFields,
             'has_fd': HasFd,
             'is_async': IsAsync,
@@ -536,6 +556,7 @@ class Generator(generator.Generator):
            not args.libcamera_generate_core_serializer:
             ValidateNamespace(self.module.mojom_namespace)
             ValidateInterfaces(self.module.interfaces)
+            AssignDeltaSessions(self.module.interfaces)
             self.module_name = ModuleClassName(self.module)
 
         fileutil.EnsureDirectoryExists(os.path.dirname(args.libcamera_output_path))